@@ -35,8 +35,9 @@ include $(CLEAR_VARS)
 LOCAL_MODULE := beatsaber-hook_1_2_3
 LOCAL_SRC_FILES += $(call rwildcard,src/utils,*.cpp)
 LOCAL_SRC_FILES += $(call rwildcard,src/config,*.cpp)
+LOCAL_SRC_FILES += $(call rwildcard,src/inline-hook,*.cpp)
 LOCAL_SHARED_LIBRARIES += modloader
-LOCAL_LDLIBS += -llog
+LOCAL_LDLIBS += -llog -lz
 LOCAL_CFLAGS += -DVERSION='"1.2.3"' -isystem 'extern/libil2cpp/il2cpp/libil2cpp' -D'UNITY_2019' -Wall -Wextra -Werror -Wno-unused-function -DID='"beatsaber-hook"' -I'./shared' -isystem 'extern'
 LOCAL_C_INCLUDES += ./shared
 # rtti is needed for the function target member to actually work
@@ -37,11 +37,26 @@ LOCAL_MODULE := beatsaber-hook_0_0_0
 LOCAL_SRC_FILES += $(call rwildcard,src/utils,*.cpp)
 LOCAL_SRC_FILES += $(call rwildcard,src/config,*.cpp)
 LOCAL_SRC_FILES += $(call rwildcard,src/tests,*.cpp)
+LOCAL_SRC_FILES += $(call rwildcard,src/inline-hook,*.cpp)
 LOCAL_SHARED_LIBRARIES += modloader
-LOCAL_LDLIBS += -llog
+LOCAL_LDLIBS += -llog -lz
 LOCAL_CFLAGS += -DVERSION='"0.0.0"' -isystem 'extern/libil2cpp/il2cpp/libil2cpp' -D'UNITY_2019' -Wall -Wextra -Werror -Wno-unused-function -DID='"beatsaber-hook"' -I'./shared' -isystem 'extern'
 LOCAL_CFLAGS += -DTEST_CALLBACKS
 LOCAL_CFLAGS += -DTEST_SAFEPTR
+LOCAL_CFLAGS += -DTEST_METHOD_CACHE
+LOCAL_CFLAGS += -DTEST_DIRECT_INVOKE
+LOCAL_CFLAGS += -DTEST_ALLOCATIONS
+LOCAL_CFLAGS += -DTEST_RESOLUTION_CACHE
+LOCAL_CFLAGS += -DTEST_HOOK_REGISTRY
+LOCAL_CFLAGS += -DTEST_HOOK_MULTIPLEXER
+LOCAL_CFLAGS += -DTEST_HOOK_TRACKER
+LOCAL_CFLAGS += -DTEST_DEFERRED_LOGGING
+LOCAL_CFLAGS += -DTEST_PATTERN_SCANNER
+LOCAL_CFLAGS += -DTEST_MODULE_MAP
+LOCAL_CFLAGS += -DTEST_INSTRUCTION_ITERATION
+LOCAL_CFLAGS += -DTEST_INSTRUCTION_CLASSIFICATION
+LOCAL_CFLAGS += -DTEST_ASSEMBLY_FUNCTION
+LOCAL_CFLAGS += -DTEST_REGISTER_EVALUATOR
 LOCAL_C_INCLUDES += ./shared
 LOCAL_CPP_FEATURES += exceptions
 include $(BUILD_SHARED_LIBRARY)
@@ -28,8 +28,12 @@
  */
 
 #pragma once
+// Built into beatsaber-hook, so mods must not compile their own copy of And64InlineHook.cpp: a second copy would have its own
+// trampoline slab allocator, and define these symbols twice.
+#include <stddef.h>
 #include <stdint.h>
-#define A64_MAX_BACKUPS 1024
+// The rwx_size to pass to A64HookFunctionV along with a trampoline from A64AllocateTrampoline
+#define A64_TRAMPOLINE_SIZE 50u
 #ifdef __aarch64__
 #ifdef __cplusplus
 extern "C" {
@@ -40,6 +44,33 @@ extern "C" {
     void A64HookFunction(void *const symbol, void *const replace, void **result);
     void *A64HookFunctionV(void *const symbol, void *const replace,
                            void *const rwx, const uintptr_t rwx_size);
+    // Returns a trampoline created by A64HookFunction to the allocator. Only do this once nothing can call it anymore.
+    void A64FreeTrampoline(void *const trampoline);
+
+    // Allocates a trampoline slot (large enough for A64HookFunctionV), preferably within branch range of near.
+    void *A64AllocateTrampoline(const void *const near);
+    // Creates a stub that jumps to destination, preferably within branch range of near.
+    void *A64CreateDispatchStub(const void *const near, void *const destination);
+    // Atomically changes where a stub created by A64CreateDispatchStub jumps to.
+    void A64SetDispatchTarget(void *const stub, void *const destination);
+    // Undoes A64HookFunctionV(symbol, replace, ...) by atomically swapping the first instruction of symbol back to backup.
+    // Only possible when the hook was a single "B" that is still in place. Returns 1 on success, 0 otherwise.
+    // The trampoline and replace must stay valid until no thread can still be running them.
+    int A64RestoreFunction(void *const symbol, const void *const replace, const uint32_t backup);
+    // Redoes A64RestoreFunction(symbol, replace, backup), so that the trampoline of the original hook can be used again.
+    // Only succeeds if the first instruction of symbol is still backup. Returns 1 on success, 0 otherwise.
+    int A64ReapplyFunction(void *const symbol, const void *const replace, const uint32_t backup);
+
+    typedef struct A64HookRequest
+    {
+        void  *symbol;
+        void  *replace;
+        void **result;
+        void  *trampoline; // if not NULL, used (and owned from then on) instead of allocating a new trampoline
+    } A64HookRequest;
+    // Hooks every request like A64HookFunction, but makes each touched page writable and flushes it only once.
+    // Failed requests get a NULL *result. Returns the number of hooks installed, and the number of pages made writable in pages (if not NULL).
+    size_t A64HookFunctionBatch(A64HookRequest *const requests, const size_t count, size_t *const pages);
 
 #ifdef __cplusplus
 }
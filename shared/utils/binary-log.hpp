@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+
+/// @brief Captures printf style arguments as raw bytes, so that they can be formatted later (or elsewhere), and reads and
+/// writes the binary log files of deferred loggers. Does not depend on Android, so the decoder can be built for the host.
+/// Captured arguments are in native byte order: integers, characters and pointers take 8 bytes, floating point numbers
+/// are captured as a double, and strings are copied (as a 4 byte length followed by the characters).
+/// %n is ignored, and wide strings and characters are not supported.
+namespace Logging::BinaryLog {
+    /// @brief Returns the number of bytes CaptureArgs will write for fmt and args.
+    std::size_t ArgsSize(const char* fmt, va_list args) noexcept;
+    /// @brief Captures the arguments of fmt into out, which must have room for ArgsSize bytes.
+    /// @return The number of bytes written.
+    std::size_t CaptureArgs(const char* fmt, va_list args, char* out) noexcept;
+    /// @brief Formats fmt with arguments captured by CaptureArgs, appending the result to out.
+    /// Gives the same result as vsnprintf would have with the original arguments.
+    void Format(const char* fmt, std::span<const char> args, std::string& out);
+
+    /// @brief The first bytes of every binary log file.
+    constexpr char magic[4] = {'B', 'S', 'B', 'L'};
+    constexpr uint8_t version = 1;
+    /// @brief Appends the file header, which names the logger the file belongs to.
+    void AppendHeader(std::string& out, std::string_view tag);
+    /// @brief Appends a format string, which the records that follow may refer to by id.
+    void AppendFormat(std::string& out, uint64_t id, std::string_view fmt);
+    /// @brief Appends one log line.
+    /// @param ms The time the line was logged, in milliseconds since the epoch.
+    /// @param level The Logging::Level of the line.
+    void AppendRecord(std::string& out, int64_t ms, uint8_t level, uint64_t formatId, std::string_view context, std::span<const char> args);
+    /// @brief Turns a binary log file into the same text the logger would have written to its text log.
+    /// @return False if in is not a binary log, or is truncated or corrupt (everything before that point is still written).
+    bool Decode(std::FILE* in, std::FILE* out);
+}
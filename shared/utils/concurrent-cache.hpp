@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace il2cpp_utils {
+    /// @brief An insert-only, read-mostly hash map with lock-free lookups and inserts.
+    /// Each bucket is an atomic singly linked list of immutable nodes. Nodes are only ever prepended, and are never removed
+    /// until the cache is destroyed, so readers never need a lock and never see a partially constructed entry.
+    /// Lookups are heterogeneous: any type L for which Hash{}(L) and KeyEqual{}(const Key&, L) are valid may be used, so callers can
+    /// look up with views (std::string_view, std::span) and only pay for the owning Key on a miss.
+    /// Key must be constructible from any L passed to emplace, and Hash{}(Key) is never called.
+    /// @tparam Key The owning key type stored in each node.
+    /// @tparam Value The mapped type. Should be cheap to copy (pointers in practice).
+    /// @tparam Hash The (transparent) hasher.
+    /// @tparam KeyEqual The (transparent) comparator, called as KeyEqual{}(storedKey, lookupKey).
+    /// @tparam BucketCount The number of buckets, must be a power of two. The table does not grow, chains just get longer.
+    template<class Key, class Value, class Hash, class KeyEqual, std::size_t BucketCount = 1024>
+    class ConcurrentCache {
+        static_assert(BucketCount != 0 && (BucketCount & (BucketCount - 1)) == 0, "BucketCount must be a power of two!");
+        struct Node {
+            const std::size_t hash;
+            const Key key;
+            const Value value;
+            Node* next;
+            template<class L>
+            Node(std::size_t hash_, const L& key_, const Value& value_) : hash(hash_), key(key_), value(value_), next(nullptr) {}
+        };
+        std::array<std::atomic<Node*>, BucketCount> buckets{};
+        std::atomic<std::size_t> count{0};
+
+        template<class L>
+        static const Node* search(const Node* start, const Node* end, std::size_t hash, const L& key) noexcept {
+            for (auto* node = start; node != end; node = node->next) {
+                if (node->hash == hash && KeyEqual{}(node->key, key)) {
+                    return node;
+                }
+            }
+            return nullptr;
+        }
+
+        public:
+        ConcurrentCache() = default;
+        ConcurrentCache(const ConcurrentCache&) = delete;
+        ConcurrentCache& operator=(const ConcurrentCache&) = delete;
+        ~ConcurrentCache() {
+            for (auto& bucket : buckets) {
+                auto* node = bucket.load(std::memory_order_relaxed);
+                while (node) {
+                    auto* next = node->next;
+                    delete node;
+                    node = next;
+                }
+            }
+        }
+
+        /// @brief Looks up the provided key without locking or allocating.
+        /// @param key The key to look up.
+        /// @return A pointer to the cached value, or nullptr if it was not found. The pointer remains valid for the lifetime of the cache.
+        template<class L>
+        const Value* find(const L& key) const noexcept {
+            auto hash = Hash{}(key);
+            auto* head = buckets[hash & (BucketCount - 1)].load(std::memory_order_acquire);
+            auto* node = search(head, nullptr, hash, key);
+            return node ? &node->value : nullptr;
+        }
+
+        /// @brief Inserts the provided key and value, unless an equal key already exists.
+        /// If another thread races us with an equal key, exactly one of the two entries wins and both callers observe it.
+        /// @param key The key to insert. An owning Key is constructed from it.
+        /// @param value The value to insert.
+        /// @return A reference to the value that is now in the cache for key.
+        template<class L>
+        const Value& emplace(const L& key, const Value& value) {
+            auto hash = Hash{}(key);
+            auto& bucket = buckets[hash & (BucketCount - 1)];
+            auto* head = bucket.load(std::memory_order_acquire);
+            if (auto* existing = search(head, nullptr, hash, key)) {
+                return existing->value;
+            }
+            auto* node = new Node(hash, key, value);
+            node->next = head;
+            // On failure, head is updated to the current list head. Only the nodes between it and our old head are new.
+            while (!bucket.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_acquire)) {
+                if (auto* existing = search(node->next, head, hash, key)) {
+                    delete node;
+                    return existing->value;
+                }
+                head = node->next;
+            }
+            count.fetch_add(1, std::memory_order_relaxed);
+            return node->value;
+        }
+
+        /// @brief Returns the number of entries in the cache. May be stale by the time it is used.
+        std::size_t size() const noexcept {
+            return count.load(std::memory_order_relaxed);
+        }
+    };
+}
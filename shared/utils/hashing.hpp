@@ -1,23 +1,53 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
 // TODO: Make this into a static class
 namespace il2cpp_utils {
+    // Mixes the hash of v into seed.
+    // Based off of boost::hash_combine, but using the 64 bit golden ratio and a murmur style finalizer on the input.
+    // Unlike a plain XOR this is order dependent, so (a, b) and (b, a) do not collide, and (x, x) does not collapse to 0.
+    inline void hash_combine_raw(std::size_t& seed, std::size_t h) noexcept {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        seed ^= h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    }
+    template<class T>
+    inline void hash_combine(std::size_t& seed, const T& v) noexcept {
+        hash_combine_raw(seed, std::hash<T>{}(v));
+    }
+    // Let a "sequence" type be any type that supports .size() and iteration and whose elements are hashable.
+    // Calculates a hash for a sequence.
+    // Any two sequences with equal elements hash the same, so a std::vector and a std::span over the same data may be used interchangeably.
+    template<class T>
+    std::size_t hash_seq(const T& seq) noexcept {
+        std::size_t seed = seq.size();
+        for (const auto& i : seq) {
+            hash_combine(seed, i);
+        }
+        return seed;
+    }
+
     // A hash function used to hash a pair of any kind
     struct hash_pair {
         template<class T1, class T2>
         size_t operator()(const std::pair<T1, T2>& p) const {
-            auto hash1 = std::hash<T1>{}(p.first);
-            auto hash2 = std::hash<T2>{}(p.second);
-            return hash1 ^ hash2;
+            std::size_t seed = std::hash<T1>{}(p.first);
+            hash_combine(seed, p.second);
+            return seed;
         }
     };
     // A hash function used to hash a pair of an object, pair
     struct hash_pair_3 {
         template<class T1, class T2, class T3>
         size_t operator()(const std::pair<T1, std::pair<T2, T3>>& p) const {
-            auto hash1 = std::hash<T1>{}(p.first);
-            auto hash2 = hash_pair{}(p.second);
-            return hash1 ^ hash2;
+            std::size_t seed = std::hash<T1>{}(p.first);
+            hash_combine_raw(seed, hash_pair{}(p.second));
+            return seed;
         }
     };
 }
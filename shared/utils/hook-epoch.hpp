@@ -0,0 +1,24 @@
+#pragma once
+
+/// @brief Tracks which threads are currently running installed hooks, so that whatever an uninstalled hook uses (its code,
+/// or state it reads) is only freed once every thread that could still be running it has left.
+/// Each thread announces itself on a counter of its own, so entering and leaving a hook never writes to shared memory.
+struct HookEpoch {
+    /// @brief Marks the calling thread as running a hook. Calls may nest.
+    static void Enter() noexcept;
+    /// @brief Marks the calling thread as having left the hook it entered last.
+    static void Exit() noexcept;
+    /// @brief Blocks until every thread that was running a hook when this was called has left it.
+    /// Must not be called from within a hook (it would wait for itself), use Defer instead.
+    static void Synchronize() noexcept;
+    /// @brief Runs func with arg on a background thread once every thread that is currently running a hook has left it.
+    static void Defer(void (*func)(void*), void* arg) noexcept;
+
+    /// @brief Enters on construction, and exits on destruction.
+    struct Guard {
+        Guard() noexcept { Enter(); }
+        ~Guard() noexcept { Exit(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+/// @brief Lets any number of hooks on the same target share a single patch.
+/// The first hook on a target patches it to jump to a small dispatch stub. All hooks on that target are then kept in a
+/// priority ordered chain: the stub jumps to the first hook, each hook's trampoline is the next hook, and the last hook's
+/// trampoline is the original function. Changing the chain only swaps pointers, with atomic stores ordered so that every
+/// intermediate state is callable, so calls never take a lock or walk through stacked prologue patches.
+/// Only hooks within this library share chains. Only available on aarch64.
+struct HookMultiplexer {
+    struct Request {
+        const char* name;
+        void* target;
+        void* replace;
+        /// @brief Where the function the hook should call to continue (its trampoline) is written.
+        void** orig;
+        int priority;
+    };
+    /// @brief Adds a hook to the chain of its target, patching the target if this is its first hook.
+    /// Hooks with a higher priority are called first. Among equal priorities, the most recently added hook is called first,
+    /// just as if each hook had patched the target again.
+    /// @return True if the hook was added.
+    static bool Add(const Request& request) noexcept;
+    /// @brief Adds many hooks at once, patching every new target with a single A64HookFunctionBatch call.
+    /// @param pages Set to the number of pages that were made writable, if not null.
+    /// @return The number of hooks added.
+    static std::size_t AddBatch(std::span<const Request> requests, std::size_t* pages) noexcept;
+    /// @brief Removes a hook from the chain of its target. Removing the last hook restores the original first instruction
+    /// of the target. Its stub and trampoline are never freed, since another thread may still be about to run them, but are
+    /// reused if the target is hooked again. Calls that already reached the removed hook finish normally; wait for them with
+    /// HookEpoch::Synchronize before freeing anything the hook itself uses.
+    /// @return True if the hook was found and removed.
+    static bool Remove(const void* target, const void* replace) noexcept;
+    /// @brief Returns the trampoline that runs the original code of target, or nullptr if target has no chain.
+    static void* GetOriginal(const void* target) noexcept;
+    /// @brief Returns the number of hooks in the chain of target.
+    static std::size_t Count(const void* target) noexcept;
+};
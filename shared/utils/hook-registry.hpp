@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// @brief A table of every hook installed by any copy of beatsaber-hook loaded in this process.
+/// The table is a single anonymous mapping that the first copy to use it creates, and publishes under a well-known
+/// environment variable (HookRegistry::envName) that later copies attach to, so no copy ever has to look at the others.
+/// Lookups never lock, allocate or touch the filesystem.
+/// The layout is versioned through the variable name: copies with a different layout use their own table.
+/// The published address is only used once it is confirmed to be a readable and writable anonymous mapping that holds a table of
+/// this process, since children inherit the variable (and anything may set it). Forked children unset it.
+struct HookRegistry {
+    static constexpr uint32_t magic = 0x42534852u; // "BSHR"
+    static constexpr uint32_t version = 1;
+    static constexpr const char* envName = "BS_HOOK_REGISTRY_V1";
+    static constexpr std::size_t capacity = 1u << 14;
+    /// @brief Longer names are truncated, so names are only for display: hooks are identified by target and hook.
+    static constexpr std::size_t maxNameLength = 47;
+
+    /// @brief One installed hook. Slots are claimed once and never move. A removed hook keeps its slot (so that probing
+    /// stays correct) and is revived if the same hook is added to the same target again.
+    struct Slot {
+        enum State : uint32_t {
+            Empty = 0,
+            Claimed = 1,
+            Published = 2
+        };
+        std::atomic<uint32_t> state;
+        std::atomic<uint32_t> live;
+        /// @brief Used to find the hook that was installed first on a target.
+        std::atomic<uint64_t> sequence;
+        // Written once before the slot is published
+        const void* target;
+        const void* hook;
+        /// @brief Identifies the copy of beatsaber-hook that added the hook, see Owner.
+        const void* owner;
+        std::atomic<const void*> orig;
+        /// @brief The first maxNameLength characters of the hook's name.
+        char name[maxNameLength + 1];
+    };
+
+    struct Table {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t capacity;
+        /// @brief The process the table belongs to, as a forked child inherits a copy of it (and the address of it).
+        int64_t process;
+        std::atomic<uint64_t> nextSequence;
+        std::atomic<uint64_t> count;
+        /// @brief Changes whenever a hook is added, removed or changed.
+        std::atomic<uint64_t> generation;
+        Slot slots[HookRegistry::capacity];
+    };
+
+    /// @brief Returns the process-wide table, creating or attaching to it on first use. Returns nullptr if it could not be mapped.
+    static Table* Get() noexcept;
+
+    /// @brief Returns the value of Slot::owner for hooks added by this copy of beatsaber-hook.
+    static const void* Owner() noexcept;
+    /// @brief Records that hook was installed on target, and continues to orig.
+    /// @param index Set to the index of the slot the hook was recorded in, if not null.
+    /// @return False if the table could not be mapped or is full.
+    static bool Add(const void* target, const void* hook, const void* orig, std::string_view name, uint32_t* index = nullptr) noexcept;
+    /// @brief Records that hook was removed from target.
+    /// @return True if it was found.
+    static bool Remove(const void* target, const void* hook) noexcept;
+    /// @brief Changes the orig recorded for hook on target.
+    /// @return True if it was found.
+    static bool SetOrig(const void* target, const void* hook, const void* orig) noexcept;
+    /// @brief Records that the hook in the slot at index (as returned by Add) was removed, without probing for it.
+    /// @param target Checked against the slot's target, so that a stale index does nothing.
+    /// @param hook Set to the slot's hook, if it was removed and hook is not null.
+    /// @return True if the slot held a live hook on target.
+    static bool RemoveAt(uint32_t index, const void* target, const void** hook = nullptr) noexcept;
+    /// @brief Changes the orig recorded in the slot at index (as returned by Add), without probing for it.
+    /// @return True if the slot held a live hook on target.
+    static bool SetOrigAt(uint32_t index, const void* target, const void* orig) noexcept;
+    /// @brief Returns a value that changes whenever the table does, or 0 if the table could not be mapped.
+    static uint64_t Generation() noexcept;
+    /// @brief Returns true if any hook is installed on target.
+    static bool IsHooked(const void* target) noexcept;
+    /// @brief Returns the orig of the hook that was installed first on target, or nullptr if target is not hooked.
+    static const void* GetOrig(const void* target) noexcept;
+
+    /// @brief Calls func with every installed hook on target.
+    template<typename F>
+    static void ForEach(const void* target, F&& func) {
+        auto* table = Get();
+        if (!table) return;
+        for (auto i = Bucket(target), n = std::size_t(0); n < capacity; i = (i + 1) & (capacity - 1), n++) {
+            auto& slot = table->slots[i];
+            auto state = slot.state.load(std::memory_order_acquire);
+            if (state == Slot::Empty) return;
+            if (state == Slot::Published && slot.target == target && slot.live.load(std::memory_order_acquire)) func(slot);
+        }
+    }
+    /// @brief Calls func with every installed hook.
+    template<typename F>
+    static void ForEach(F&& func) {
+        auto* table = Get();
+        if (!table) return;
+        for (auto& slot : table->slots) {
+            if (slot.state.load(std::memory_order_acquire) == Slot::Published && slot.live.load(std::memory_order_acquire)) func(slot);
+        }
+    }
+
+    private:
+    static std::size_t Bucket(const void* target) noexcept {
+        return static_cast<std::size_t>(((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(target)) >> 2) * 0x9E3779B97F4A7C15ull) >> (64 - 14));
+    }
+    static_assert(capacity == 1u << 14, "Bucket must produce indices below capacity");
+};
@@ -1,32 +1,62 @@
 #pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string_view>
-#include <string>
-#include <list>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 /// @brief Stores information about an installed hook.
 struct HookInfo {
-    const std::string name;
+    /// @brief Interned, so it is valid for the lifetime of the process.
+    /// Names read from the HookRegistry are cut to HookRegistry::maxNameLength, so they are only for display.
+    std::string_view name;
     const void* destination;
     const void* trampoline;
     const void* orig;
-    HookInfo(std::string_view name_, void* dst, void* src, void* orig_)
-        : name(name_.data()), destination(dst), trampoline(src), orig(orig_) {}
+    /// @brief Identifies this hook among the tracked hooks, see HookHandle.
+    uint32_t id = 0;
+    HookInfo(std::string_view name_, const void* dst, const void* src, const void* orig_);
     bool operator==(const HookInfo& other) const {
         return name == other.name && destination == other.destination && trampoline == other.trampoline && orig == other.orig;
     }
 };
 
+/// @brief Refers to a tracked hook, as returned by HookTracker::AddHook.
+struct HookHandle {
+    const void* destination;
+    uint32_t id;
+};
+
+/// @brief A view of the hooks of one location, as returned by HookTracker::GetHooks.
+/// It keeps the snapshot of the tracked hooks it was taken from alive, so it stays valid and unchanged for as long as it is held,
+/// even while other threads add or remove hooks.
+struct HookList {
+    std::span<const HookInfo> hooks;
+    std::shared_ptr<const void> snapshot;
+
+    auto begin() const noexcept { return hooks.begin(); }
+    auto end() const noexcept { return hooks.end(); }
+    std::size_t size() const noexcept { return hooks.size(); }
+    bool empty() const noexcept { return hooks.empty(); }
+    const HookInfo& front() const { return hooks.front(); }
+    const HookInfo& operator[](std::size_t index) const { return hooks[index]; }
+};
+
+/// @brief Tracks the hooks of every bs-hook library. All of its functions may be called from any thread.
+/// Queries read an immutable snapshot of the tracked hooks, which is only rebuilt (under a lock) after a hook was added or removed.
 struct HookTracker {
     /// @brief Adds a HookInfo to be tracked.
     /// @param info The HookInfo to track.
-    static void AddHook(HookInfo info) noexcept;
+    /// @returns A handle that can be used to remove it again.
+    static HookHandle AddHook(HookInfo info) noexcept;
     /// @brief Calls AddHook
     template<typename... TArgs>
-    static void AddHook(TArgs&&... args) noexcept {
-        AddHook(HookInfo(std::forward<TArgs>(args)...));
+    static HookHandle AddHook(TArgs&&... args) noexcept {
+        return AddHook(HookInfo(std::forward<TArgs>(args)...));
     }
-    /// @brief Stops tracking the provided HookInfo.
+    /// @brief Stops tracking the provided HookInfo, and uninstalls the hook if it is still installed by this library.
+    /// The hook is found by its destination and trampoline only, its name and orig are not compared.
     /// @param info The HookInfo to stop tracking.
     static void RemoveHook(HookInfo info) noexcept;
     /// @brief Calls RemoveHook
@@ -34,28 +64,44 @@ struct HookTracker {
     static void RemoveHook(TArgs&&... args) noexcept {
         RemoveHook(HookInfo(std::forward<TArgs>(args)...));
     }
+    /// @brief Stops tracking the hook the handle refers to, and uninstalls it if it is still installed by this library.
+    /// Does not wait for or rebuild the snapshot queries read.
+    /// @param handle The handle returned by AddHook.
+    static void RemoveHook(HookHandle handle) noexcept;
+    /// @brief Changes the original location recorded for the hook the handle refers to.
+    static void SetOrig(HookHandle handle, const void* orig) noexcept;
     /// @brief Stop tracking all hooks.
     static void RemoveHooks() noexcept;
     /// @brief Stop tracking all hooks at a certain offset.
     /// @param location The offset to check for any installed hooks.
     static void RemoveHooks(const void* const location) noexcept;
-    /// @brief Combines all HookTrackers from all bs-hook libraries together.
+    /// @brief Brings the snapshot of the tracked hooks up to date with the hooks of all bs-hook libraries (from the shared HookRegistry).
+    /// Every query does this itself, and it does nothing unless a hook was added or removed since the last time.
     static void CombineHooks() noexcept;
     /// @brief Checks to see if there are any hooks installed at the offset provided.
     /// Returns true if at least one hook is installed, false otherwise.
     /// @param location The offset to check for.
     /// @returns Whether there exists at least one hook acting on this location.
     static bool IsHooked(const void* const location) noexcept;
-    /// @brief Returns any hooks that access this location, or an empty list if there are none.
+    /// @brief Returns any hooks that access this location, ordered from first installed, or an empty list if there are none.
     /// @param location The offset to check for.
-    /// @returns An std::list<HookInfo> of hooks.
-    static const std::list<HookInfo> GetHooks(const void* const location) noexcept;
-    /// @brief Returns all hooks.
-    /// @returns The installed hooks.
-    static const std::unordered_map<const void*, std::list<HookInfo>>* GetHooks() noexcept;
+    /// @returns A view of the hooks as they were when this was called, which stays valid for as long as it is held.
+    static HookList GetHooks(const void* const location) noexcept;
+    /// @brief Calls func with the location and hooks (as a std::span<const HookInfo>) of every hooked location.
+    /// The spans are views of one snapshot, which is held until this returns. Hooks added or removed meanwhile (by func as well)
+    /// are not seen, and func may call any other function of HookTracker.
+    template<typename F>
+    static void ForEachHooked(F&& func) {
+        auto snapshot = Current();
+        for (auto& bucket : snapshot->buckets) {
+            if (!bucket.hooks.empty()) func(bucket.location, std::span<const HookInfo>(bucket.hooks));
+        }
+    }
     /// @brief Returns the original location of a function that may or may not be hooked.
     /// If the function is not hooked, it returns the input.
     /// If the function is hooked, it returns the first installed hook's original location.
+    /// If it was hooked by something that did not record the hook, the trampoline is found by tracing the pointer the hook's function
+    /// calls it through (see AssemblyFunction), and otherwise it returns the input.
     /// @param location The offset to get the original function for.
     /// @returns The returned address.
     template<typename T>
@@ -76,6 +122,19 @@ struct HookTracker {
     /// @returns Whether there exists an instruction hook acting on this location.
     static bool InstructionIsHooked(const void* const location) noexcept;
     private:
-    static std::unordered_map<const void*, std::list<HookInfo>> hooks;
+    struct Bucket {
+        const void* location;
+        std::vector<HookInfo> hooks;
+    };
+    // An open addressing table of hooked locations. The hooks of a location are kept together, so a query is a single
+    // probe and a view of them needs no copy. Never changed once published, a change publishes a new one instead.
+    struct Snapshot {
+        // The HookRegistry generation it was built from
+        uint64_t generation;
+        std::vector<Bucket> buckets;
+        const Bucket* Find(const void* location) const noexcept;
+    };
+    static std::shared_ptr<const Snapshot> current;
+    static std::shared_ptr<const Snapshot> Current() noexcept;
     static const void* GetOrigInternal(const void* const) noexcept;
 };
\ No newline at end of file
@@ -2,6 +2,11 @@
 
 #include "../inline-hook/And64InlineHook.hpp"
 #include "hook-tracker.hpp"
+#include "hook-multiplexer.hpp"
+#include "hook-epoch.hpp"
+#include <array>
+#include <limits>
+#include <span>
 #include <type_traits>
 #include <utility>
 #include "utils.h"
@@ -311,32 +316,81 @@ retval Hook_##name_::hook_##name_(__VA_ARGS__)
 //     static_assert(!std::is_same_v<R, R>, "Attempting to MAKE_HOOK_INSTANCE_AUTO with a static method! See MAKE_HOOK_STATIC_AUTO instead!"); \
 // };
 
+/// @brief What is actually installed for a hook T: calls T::hook() while inside a HookEpoch,
+/// so that uninstalling a hook can wait for every call that is still running it to return.
+template<typename T, typename F = typename T::funcType>
+struct HookEntry;
+
+template<typename T, typename R, typename... TArgs>
+struct HookEntry<T, R (*)(TArgs...)> {
+    static R entry(TArgs... args) {
+        HookEpoch::Guard guard;
+        return T::hook()(std::forward<TArgs>(args)...);
+    }
+};
+
 template<typename T, typename L, bool track = true>
-inline void __InstallHook(L& logger, void* addr) {
+inline void __InstallHook(L& logger, void* addr, [[maybe_unused]] int priority = 0) {
     #ifndef SUPPRESS_MACRO_LOGS
     logger.info("Installing hook: %s to offset: %p", T::name(), addr);
     #endif
     #ifdef __aarch64__
-    A64HookFunction(addr, (void*) T::hook(), (void**) T::trampoline());
+    // Every hook on addr shares one patch, see HookMultiplexer
+    if (!HookMultiplexer::Add({T::name(), addr, (void*) &HookEntry<T>::entry, (void**) T::trampoline(), priority})) {
+        #ifndef SUPPRESS_MACRO_LOGS
+        logger.error("Failed to install hook: %s to offset: %p", T::name(), addr);
+        #endif
+        return;
+    }
     if constexpr (track) {
-        HookTracker::AddHook(T::name(), addr, (void*) T::hook(), (void*) *T::trampoline());
+        HookTracker::AddHook(T::name(), addr, (void*) &HookEntry<T>::entry, HookMultiplexer::GetOriginal(addr));
     }
     #else
-    registerInlineHook((uint32_t) addr, (uint32_t) T::hook(), (uint32_t **) T::trampoline());
+    registerInlineHook((uint32_t) addr, (uint32_t) &HookEntry<T>::entry, (uint32_t **) T::trampoline());
     inlineHook((uint32_t) addr);
     #endif
 }
 
+template<typename T, typename L, bool track = true>
+inline bool __UninstallHook(L& logger, void* addr) {
+    #ifndef SUPPRESS_MACRO_LOGS
+    logger.info("Uninstalling hook: %s from offset: %p", T::name(), addr);
+    #endif
+    #ifdef __aarch64__
+    auto* orig = HookMultiplexer::GetOriginal(addr);
+    // Other hooks on addr keep working. The patch is only undone once the last one is removed.
+    if (!HookMultiplexer::Remove(addr, (void*) &HookEntry<T>::entry)) {
+        #ifndef SUPPRESS_MACRO_LOGS
+        logger.error("Failed to uninstall hook: %s from offset: %p, it is not installed there", T::name(), addr);
+        #endif
+        return false;
+    }
+    if constexpr (track) {
+        HookTracker::RemoveHook(T::name(), addr, (void*) &HookEntry<T>::entry, orig);
+    }
+    return true;
+    #else
+    // Freezes every other thread and moves any that are in the hooked instructions, so it is safe, but slow
+    if (inlineUnHook((uint32_t) addr) != ELE7EN_OK) {
+        #ifndef SUPPRESS_MACRO_LOGS
+        logger.error("Failed to uninstall hook: %s from offset: %p, it is not installed there", T::name(), addr);
+        #endif
+        return false;
+    }
+    return true;
+    #endif
+}
+
 template<typename T, typename L>
 requires (is_addr_hook<T> && !is_findCall_hook<T> && is_logger<L>)
-void InstallHook(L& logger) {
+void InstallHook(L& logger, int priority = 0) {
     // Install T assuming it is an address hook.
     auto addr = (void*) getRealOffset(T::addr());
-    __InstallHook<T>(logger, addr);
+    __InstallHook<T>(logger, addr, priority);
 }
 template<typename T, typename L>
 requires (is_findCall_hook<T> && !is_addr_hook<T> && is_logger<L>)
-void InstallHook(L& logger) {
+void InstallHook(L& logger, int priority = 0) {
     // Install T assuming it is a hook that should call FindMethod.
     auto info = T::getInfo();
     if (!info) {
@@ -346,7 +400,7 @@ void InstallHook(L& logger) {
         SAFE_ABORT();
     }
     auto addr = (void*) info->methodPointer;
-    __InstallHook<T>(logger, addr);
+    __InstallHook<T>(logger, addr, priority);
 }
 template<typename T, typename L>
 requires (is_findCall_hook<T> && !is_addr_hook<T> && is_logger<L>)
@@ -361,14 +415,14 @@ void InstallOrigHook(L& logger) {
     }
     auto addr = (void*) info->methodPointer;
     auto* origAddr = const_cast<void*>(HookTracker::GetOrig(addr));
-    if (origAddr != addr) { \
-        auto* hooks = const_cast<std::unordered_map<const void*, std::list<HookInfo>>*>(HookTracker::GetHooks());
-        auto itr = hooks->find(addr);
-        if (itr != hooks->end() && itr->second.size() > 0) {
-            itr->second.front().orig = (void*) *T::trampoline();
+    if (origAddr != addr) {
+        auto hooks = HookTracker::GetHooks(addr);
+        if (!hooks.empty()) {
+            HookTracker::SetOrig({addr, hooks.front().id}, (void*) *T::trampoline());
         }
     }
-    __InstallHook<T, L, false>(logger, addr);
+    // Orig hooks are called after every other hook, right before the original code
+    __InstallHook<T, L, false>(logger, addr, std::numeric_limits<int>::min());
 }
 template<typename T, typename L>
 requires (is_hook<T> && is_logger<L>)
@@ -383,10 +437,116 @@ void InstallHookDirect(L& logger, void* dst) {
     __InstallHook<T>(logger, dst);
 }
 
+/// @brief Uninstalls a hook installed with InstallHook or InstallBatch, restoring the original instructions if it was
+/// the last hook on its target. Calls of the hook that are still running finish normally.
+/// @return True if the hook was uninstalled.
+template<typename T, typename L>
+requires (is_addr_hook<T> && !is_findCall_hook<T> && is_logger<L>)
+bool UninstallHook(L& logger) {
+    auto addr = (void*) getRealOffset(T::addr());
+    return __UninstallHook<T>(logger, addr);
+}
+template<typename T, typename L>
+requires (is_findCall_hook<T> && !is_addr_hook<T> && is_logger<L>)
+bool UninstallHook(L& logger) {
+    auto info = T::getInfo();
+    if (!info) {
+        #ifndef SUPPRESS_MACRO_LOGS
+        logger.error("Attempting to uninstall hook: %s, but method could not be found!", T::name());
+        #endif
+        return false;
+    }
+    return __UninstallHook<T>(logger, (void*) info->methodPointer);
+}
+template<typename T, typename L>
+requires (is_hook<T> && is_logger<L>)
+bool UninstallHookDirect(L& logger, void* dst) {
+    if (!dst) {
+        #ifndef SUPPRESS_MACRO_LOGS
+        logger.error("Attempting to uninstall direct hook: %s, but was uninstalling from an invalid destination!", T::name());
+        #endif
+        return false;
+    }
+    return __UninstallHook<T>(logger, dst);
+}
+
+/// @brief A hook waiting to be installed as part of a batch.
+struct BatchHook {
+    const char* name;
+    /// @brief Returns the address to install the hook to, or nullptr if it could not be found.
+    void* (*resolve)();
+    void* hook;
+    void** trampoline;
+    /// @brief The resolved address, set by ResolveBatch.
+    void* target = nullptr;
+};
+
+/// @brief Timing and page statistics from InstallResolvedBatch.
+struct BatchStats {
+    std::size_t installed;
+    std::size_t pages;
+    long long resolveUs;
+    long long patchUs;
+};
+
+/// @brief Resolves the target of every hook, on the calling thread or split across several threads.
+/// @param hooks The hooks to resolve.
+/// @param parallel Whether to resolve on multiple threads. Only use this if every resolve function is thread safe.
+/// @return The time spent, in microseconds.
+long long ResolveBatch(std::span<BatchHook> hooks, bool parallel) noexcept;
+/// @brief Installs and tracks every hook that has a resolved target.
+/// Every page that is patched is made writable and flushed once, instead of once per hook.
+BatchStats InstallResolvedBatch(std::span<BatchHook> hooks) noexcept;
+
+template<typename T>
+requires (is_addr_hook<T> && !is_findCall_hook<T>)
+void* __ResolveHookTarget() {
+    return (void*) getRealOffset(T::addr());
+}
+template<typename T>
+requires (is_findCall_hook<T> && !is_addr_hook<T>)
+void* __ResolveHookTarget() {
+    auto info = T::getInfo();
+    return info ? (void*) info->methodPointer : nullptr;
+}
+
+/// @brief Installs all of the provided hooks at once. All targets are resolved first, then all hooks are written
+/// with a single permission change and cache flush per page, which is much faster than installing them one at a time.
+/// Hooks on the same target are still installed in the order provided.
+/// @tparam Ts The hook types, as made by a MAKE_HOOK... macro (Hook_name).
+/// @param logger The logger to use.
+/// @param parallelResolve Whether to resolve targets on multiple threads.
+template<typename... Ts, typename L>
+requires (is_logger<L> && ... && ((is_addr_hook<Ts> && !is_findCall_hook<Ts>) || (is_findCall_hook<Ts> && !is_addr_hook<Ts>)))
+void InstallBatch(L& logger, bool parallelResolve = false) {
+    std::array<BatchHook, sizeof...(Ts)> hooks{BatchHook{Ts::name(), &__ResolveHookTarget<Ts>, (void*) &HookEntry<Ts>::entry, (void**) Ts::trampoline(), nullptr}...};
+    [[maybe_unused]] auto resolveUs = ResolveBatch(hooks, parallelResolve);
+    for (auto& hook : hooks) {
+        if (!hook.target) {
+            #ifndef SUPPRESS_MACRO_LOGS
+            logger.critical("Attempting to install hook: %s, but method could not be found!", hook.name);
+            #endif
+            SAFE_ABORT();
+        }
+        #ifndef SUPPRESS_MACRO_LOGS
+        logger.debug("Installing hook: %s to offset: %p", hook.name, hook.target);
+        #endif
+    }
+    [[maybe_unused]] auto stats = InstallResolvedBatch(hooks);
+    #ifndef SUPPRESS_MACRO_LOGS
+    logger.info("Installed %zu/%zu hooks in %lld us (resolve: %lld us, patch: %lld us, %zu pages)",
+        stats.installed, hooks.size(), resolveUs + stats.patchUs, resolveUs, stats.patchUs, stats.pages);
+    #endif
+}
+
 // Installs the provided hook using the logger provided.
 // This properly specializes based off of whichever MAKE_HOOK macro you used, but is only valid if the name is from a MAKE_HOOK... macro.
 #define INSTALL_HOOK(logger, name) ::Hooking::InstallHook<Hook_##name>(logger);
 
+// Installs the provided hook using the logger provided, with a priority.
+// Hooks on the same method with a higher priority are called first. Hooks installed with INSTALL_HOOK have a priority of 0.
+#define INSTALL_HOOK_PRIORITY(logger, name, priority) ::Hooking::InstallHook<Hook_##name>(logger, priority);
+
 // Installs the provided hook using the logger provided to the address specified directly.
 // This is only valid if the name is from a MAKE_HOOK... macro.
 #define INSTALL_HOOK_DIRECT(logger, name, addr) ::Hooking::InstallHookDirect<Hook_##name>(logger, addr);
@@ -396,9 +556,15 @@ void InstallHookDirect(L& logger, void* dst) {
 // This also ensures HookTracker validity after the hooking process.
 #define INSTALL_HOOK_ORIG(logger, name) ::Hooking::InstallOrigHook<Hook_##name>(logger);
 
-// TODO: Not yet implemented
-#define UNINSTALL_HOOK(logger, name) void
+// Installs all of the provided hooks at once, using the logger provided.
+// Unlike INSTALL_HOOK, this takes the full hook type names (Hook_name), as made by MAKE_HOOK... macros with fixed offsets or method lookups.
+#define INSTALL_HOOKS(logger, ...) ::Hooking::InstallBatch<__VA_ARGS__>(logger);
+
+// Uninstalls the provided hook using the logger provided. The hook may be installed again afterwards.
+// This is only valid if the name is from a MAKE_HOOK... macro, and the hook was installed with INSTALL_HOOK, INSTALL_HOOK_PRIORITY or INSTALL_HOOKS.
+#define UNINSTALL_HOOK(logger, name) ::Hooking::UninstallHook<Hook_##name>(logger);
 
-// TODO: Not yet implemented
-#define UNINSTALL_HOOK_DIRECT(logger, name, addr) void
+// Uninstalls the provided hook using the logger provided from the address specified directly.
+// This is only valid if the name is from a MAKE_HOOK... macro, and the hook was installed with INSTALL_HOOK_DIRECT.
+#define UNINSTALL_HOOK_DIRECT(logger, name, addr) ::Hooking::UninstallHookDirect<Hook_##name>(logger, addr);
 }
\ No newline at end of file
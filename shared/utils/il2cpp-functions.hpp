@@ -3,9 +3,11 @@
 
 #pragma pack(push)
 
+#include <chrono>
 #include <cstddef>
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
 #include "logging.hpp"
 
 #if !defined(UNITY_2019) && __has_include("il2cpp-runtime-stats.h")
@@ -391,14 +393,14 @@ class il2cpp_functions {
     static void CheckS_GlobalMetadata() {
         if (!s_GlobalMetadataHeader) {
             static auto& logger = getFuncLogger();
-            s_GlobalMetadata = *(il2cpp_functions::s_GlobalMetadataPtr);
-            s_GlobalMetadataHeader = *(il2cpp_functions::s_GlobalMetadataHeaderPtr);
-            logger.debug("sanity: %X (should be 0xFAB11BAF)", s_GlobalMetadataHeader->sanity);
-            logger.debug("version: %i", s_GlobalMetadataHeader->version);
+            s_GlobalMetadata = *Resolve(il2cpp_functions::s_GlobalMetadataPtr);
+            s_GlobalMetadataHeader = *Resolve(il2cpp_functions::s_GlobalMetadataHeaderPtr);
+            BS_LOG_DEBUG(logger, "sanity: %X (should be 0xFAB11BAF)", s_GlobalMetadataHeader->sanity);
+            BS_LOG_DEBUG(logger, "version: %i", s_GlobalMetadataHeader->version);
             assert(s_GlobalMetadataHeader->sanity == 0xFAB11BAF);
-            logger.debug("typeDefinitionsOffset: %i", s_GlobalMetadataHeader->typeDefinitionsOffset);
-            logger.debug("exportedTypeDefinitionsOffset: %i", s_GlobalMetadataHeader->exportedTypeDefinitionsOffset);
-            logger.debug("nestedTypesOffset: %i", s_GlobalMetadataHeader->nestedTypesOffset);
+            BS_LOG_DEBUG(logger, "typeDefinitionsOffset: %i", s_GlobalMetadataHeader->typeDefinitionsOffset);
+            BS_LOG_DEBUG(logger, "exportedTypeDefinitionsOffset: %i", s_GlobalMetadataHeader->exportedTypeDefinitionsOffset);
+            BS_LOG_DEBUG(logger, "nestedTypesOffset: %i", s_GlobalMetadataHeader->nestedTypesOffset);
             // TODO: use il2cpp_functions::defaults to define the il2cpp_defaults variable mentioned in il2cpp-class-internals.h
         }
     }
@@ -410,14 +412,50 @@ class il2cpp_functions {
     static const Il2CppGenericContainer* MetadataCache_GetGenericContainerFromIndex(GenericContainerIndex index);
     static const Il2CppGenericParameter* MetadataCache_GetGenericParameterFromIndex(GenericParameterIndex index);
     static Il2CppClass* MetadataCache_GetNestedTypeFromIndex(NestedTypeIndex index);
+    // Like MetadataCache_GetNestedTypeFromIndex, but does not create the Il2CppClass*
+    static TypeDefinitionIndex MetadataCache_GetNestedTypeDefinitionIndexFromIndex(NestedTypeIndex index);
     static TypeDefinitionIndex MetadataCache_GetIndexForTypeDefinition(const Il2CppClass* typeDefinition);
 
     // Whether all of the il2cpp functions have been initialized or not
     static bool initialized;
     // Initializes all of the IL2CPP functions via dlopen and dlsym for use.
+    // After EnableLazyInit, only points them at stubs that resolve them on first call (see there).
     static void Init();
 
+    // Makes Init lazy, so that a mod pays only for the functions it uses: every function pointer above starts out as a stub that
+    // resolves it (by dlsym, or by tracing xrefs for the non-API functions) the first time it is called, then overwrites itself with
+    // what it found. If warmAll, a background thread resolves all of them right after Init.
+    // defaults is still found by Init, since it is read rather than called. Anything that needs a function's real address (to compare
+    // it against nullptr, or to hook it) must Resolve it first. Has no effect once Init has run.
+    static void EnableLazyInit(bool warmAll = false);
+    // Resolves slot (one of the pointers above) if it is still a lazy stub, and returns what it now holds, which is nullptr if it
+    // could not be found. Costs nothing unless EnableLazyInit was called.
+    // Unlike calling a pointer directly, which is a plain load that may race with a stub (or the warming thread) on another thread
+    // writing it, this is an acquire load, so it is race free.
+    template<class F>
+    static F Resolve(F& slot) {
+        if (lazy) resolveSlot((void**)(&slot));
+        // Paired with the release store that resolving does, which may have happened on another thread
+        return __atomic_load_n(&slot, __ATOMIC_ACQUIRE);
+    }
+    // Resolves every function that has not been yet, on the calling thread.
+    static void ResolveAll();
+
+    struct ResolutionTime {
+        const char* name;
+        bool resolved;
+        bool found;
+        // How long dlsym or the xref trace took, including resolving any functions a trace starts from for the first time
+        std::chrono::nanoseconds time;
+    };
+    // Every function Init resolves (and the pointers it finds along with them), in that order
+    static std::vector<ResolutionTime> GetResolutionTimes();
+
     static LoggerContextObject& getFuncLogger();
+
+  private:
+    static bool lazy;
+    static void resolveSlot(void** slot);
 };
 
 #pragma pack(pop)
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string_view>
+#include "il2cpp-functions.hpp"
+
+namespace il2cpp_utils {
+    /// @brief A flat (namespace, name) -> TypeDefinitionIndex index over every type in every loaded image, nested types included.
+    /// Once built, GetClassFromName uses it on a cache miss instead of calling class_from_name on every image.
+    /// The index is opt-in: call BuildAsync() early (for example, in load) to build it eagerly on a background thread,
+    /// or EnableLazy() to have the first GetClassFromName cache miss build it.
+    struct ClassIndex {
+        /// @brief Builds the index on the calling thread if it has not been built yet.
+        /// If another thread is already building it, blocks until it is done.
+        static void Build() noexcept;
+        /// @brief Starts building the index on a detached background thread, if it has not been started already.
+        static void BuildAsync() noexcept;
+        /// @brief Makes GetClassFromName build the index the first time it misses its cache.
+        static void EnableLazy() noexcept;
+        /// @brief Returns true if the index has been built and may be used.
+        static bool IsBuilt() noexcept;
+        /// @brief Returns true if GetClassFromName should use the index (it is built, being built, or lazy building is enabled).
+        static bool IsEnabled() noexcept;
+        /// @brief Finds the TypeDefinitionIndex of the type with the provided namespace and name.
+        /// Nested types are named "Parent/Nested" and use the namespace of their outermost declaring type.
+        /// @param namespaze The namespace of the type.
+        /// @param name The name of the type.
+        /// @return The TypeDefinitionIndex, or kTypeDefinitionIndexInvalid if it was not found or the index is not built.
+        static TypeDefinitionIndex Find(std::string_view namespaze, std::string_view name) noexcept;
+    };
+}
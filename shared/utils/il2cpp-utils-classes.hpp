@@ -6,6 +6,8 @@
 #include "il2cpp-type-check.hpp"
 #include "il2cpp-functions.hpp"
 #include "il2cpp-utils-methods.hpp"
+#include <array>
+#include <functional>
 #include <optional>
 #include <vector>
 
@@ -126,18 +128,30 @@ namespace il2cpp_utils {
         }
     }
 
-    inline auto ExtractTypes() {
-        return ::std::vector<const Il2CppType*>();
+    // Returns the Il2CppType* of each argument, in order, without allocating.
+    // Any argument whose type could not be determined is nullptr.
+    template<typename... TArgs>
+    ::std::array<const Il2CppType*, sizeof...(TArgs)> ExtractTypes(TArgs&&... args) {
+        return {ExtractType(args)...};
     }
 
-    template<typename T, typename... TArgs>
-    ::std::vector<const Il2CppType*> ExtractTypes(T&& arg, TArgs&&... args) {
-        auto* tFirst = ExtractType(arg);
-        auto tOthers = ExtractTypes(args...);
-        if (tFirst) tOthers.insert(tOthers.begin(), tFirst);
-        return tOthers;
+    // Returns true if every type in types was successfully extracted.
+    template<::std::size_t N>
+    bool ExtractedAllTypes(const ::std::array<const Il2CppType*, N>& types) {
+        for (auto* t : types) {
+            if (!t) return false;
+        }
+        return true;
     }
 
+    // Called with the namespace, name and TypeDefinitionIndex of a type. Nested types are named "Parent/Nested" and their name is a temporary.
+    using TypeNameCallback = ::std::function<void(const char* namespaze, ::std::string_view name, TypeDefinitionIndex index, bool nested)>;
+
+    // Calls onType for the top level type at the given TypeDefinitionIndex and (if img is not corlib) all of its nested types,
+    // the same way il2cpp populates an image's nameToClassHashTable. Does nothing if index is a nested type.
+    // Only reads metadata, does not create any Il2CppClass*.
+    void ForEachTypeName(const Il2CppImage* img, TypeDefinitionIndex index, const TypeNameCallback& onType);
+
     // Adds the given TypeDefinitionIndex to the class hash table of a given image
     // Mainly used in LogClasses
     void AddTypeToNametoClassHashTable(const Il2CppImage* img, TypeDefinitionIndex index);
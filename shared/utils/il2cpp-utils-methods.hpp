@@ -4,12 +4,18 @@
 #pragma pack(push)
 
 #include "il2cpp-functions.hpp"
+#include "il2cpp-tabledefs.h"
 #include "logging.hpp"
+#include <array>
+#include <span>
 #include <vector>
 #include "il2cpp-utils-exceptions.hpp"
 #include "il2cpp-utils-classes.hpp"
 #include "utils.h"
 
+// Defined by libil2cpp (or typedefs.h), only needed where a managed exception is caught
+struct Il2CppExceptionWrapper;
+
 #if __has_include(<concepts>)
 #include <concepts>
 #ifndef BS_HOOK_NO_CONCEPTS
@@ -133,16 +139,67 @@ namespace il2cpp_utils {
         }
     }
 
-    inline auto ExtractValues() {
-        return ::std::vector<void*>();
+    // Returns the values to pass to runtime_invoke for each argument, in order, without allocating.
+    template<class... TArgs>
+    ::std::array<void*, sizeof...(TArgs)> ExtractValues(TArgs&& ...args) {
+        return {ExtractValue(args)...};
     }
 
-    template<class T, class... TArgs>
-    ::std::vector<void*> ExtractValues(T&& arg, TArgs&& ...args) {
-        auto* firstVal = ExtractValue(arg);
-        auto otherVals = ExtractValues(args...);
-        otherVals.insert(otherVals.begin(), firstVal);  // inserts at front
-        return otherVals;
+    template<class T>
+    // Converts an argument to what a method called through its methodPointer expects: the decayed value itself.
+    // Value types are passed by value, reference types as pointers. ref/out parameters must be passed as explicit pointers.
+    auto ExtractDirectValue(T&& arg) {
+        return static_cast<::std::decay_t<T>>(arg);
+    }
+
+    template<class T>
+    // Converts an instance to the this pointer method->methodPointer expects. Methods declared on a value type take a pointer to the
+    // value itself, so a boxed value type is passed as its data, which follows the object header. Other methods (such as an
+    // Object method the value type does not override) take the object, so it is passed as is.
+    void* ExtractDirectInstance(T&& instance, const MethodInfo* method) {
+        using Dt = ::std::decay_t<T>;
+        if constexpr (::std::is_same_v<Dt, Il2CppType*> || ::std::is_same_v<Dt, Il2CppClass*>) {
+            return nullptr;
+        } else if constexpr (::std::is_pointer_v<Dt>) {
+            if constexpr (::std::is_base_of_v<Il2CppObject, ::std::remove_cv_t<::std::remove_pointer_t<Dt>>>) {
+                auto* object = static_cast<const Il2CppObject*>(instance);
+                if (object && method->klass->valuetype && object->klass->valuetype) {
+                    return const_cast<Il2CppObject*>(object + 1);
+                }
+            }
+            return const_cast<void*>(static_cast<const void*>(instance));
+        } else {
+            return const_cast<Dt*>(&instance);
+        }
+    }
+
+    template<class TOut = void, class TWrapper = Il2CppExceptionWrapper, class... TArgs>
+    // Calls method->methodPointer directly, as TOut(TArgs..., const MethodInfo*) for static methods and TOut(void*, TArgs..., const MethodInfo*) otherwise.
+    // Does not box, allocate, or go through runtime_invoke. Runs the static constructor of the declaring class first, if needed.
+    // If a managed exception escapes the method, it is caught, written to exc and a value initialized TOut is returned.
+    // Without C++ exception support, managed exceptions can NOT be caught and will terminate!
+    TOut InvokeDirect(const MethodInfo* method, void* inst, Il2CppException** exc, TArgs... args) {
+        auto* klass = method->klass;
+        if (klass->has_cctor && !klass->cctor_finished) {
+            il2cpp_functions::Init();
+            il2cpp_functions::runtime_class_init(klass);
+        }
+        #if __has_feature(cxx_exceptions)
+        try {
+        #endif
+            if ((method->flags & METHOD_ATTRIBUTE_STATIC) != 0) {
+                return reinterpret_cast<TOut (*)(TArgs..., const MethodInfo*)>(method->methodPointer)(args..., method);
+            } else {
+                return reinterpret_cast<TOut (*)(void*, TArgs..., const MethodInfo*)>(method->methodPointer)(inst, args..., method);
+            }
+        #if __has_feature(cxx_exceptions)
+        } catch (TWrapper& wrapper) {
+            if (exc) *exc = wrapper.ex;
+            if constexpr (!::std::is_same_v<TOut, void>) {
+                return TOut{};
+            }
+        }
+        #endif
     }
 
     #if __has_feature(cxx_exceptions)
@@ -185,11 +242,11 @@ namespace il2cpp_utils {
 
     bool IsConvertible(const Il2CppType* to, const Il2CppType* from, bool asArgs = true);
 
-    // Returns if a given MethodInfo's parameters match the Il2CppType vector
-    bool ParameterMatch(const MethodInfo* method, ::std::vector<const Il2CppType*> argTypes);
+    // Returns if a given MethodInfo's parameters match the Il2CppType span
+    bool ParameterMatch(const MethodInfo* method, ::std::span<const Il2CppType* const> argTypes);
 
-    // Returns if a given MethodInfo's parameters match the Il2CppType vector and generic types vector
-    bool ParameterMatch(const MethodInfo* method, ::std::vector<Il2CppClass*> genTypes, ::std::vector<const Il2CppType*> argTypes);
+    // Returns if a given MethodInfo's parameters match the Il2CppType span and generic types span
+    bool ParameterMatch(const MethodInfo* method, ::std::span<Il2CppClass* const> genTypes, ::std::span<const Il2CppType* const> argTypes);
 
     /// @brief Calls RunMethod, but throws a RunMethodException on failure.
     /// If checkTypes is false, does not perform type checking and instead is an unsafe wrapper around runtime_invoke.
@@ -246,6 +303,48 @@ namespace il2cpp_utils {
             return *res;
         }
     }
+
+    /// @brief Calls RunMethodDirect, but throws a RunMethodException on failure.
+    /// Calls the method through its methodPointer instead of runtime_invoke, so TOut must be the exact native return type.
+    /// @tparam TOut The output to return. Defaults to void.
+    /// @tparam checkTypes Whether to check types or not. Defaults to true.
+    /// @tparam T The instance type (either an actual instance or an Il2CppClass*/Il2CppType*).
+    /// @tparam TArgs The argument types, passed to the method exactly as provided.
+    /// @param instance The instance or Il2CppClass*/Il2CppType* to invoke with.
+    /// @param method The MethodInfo* to invoke.
+    /// @param params The arguments to pass into the function.
+    template<class TOut = void, bool checkTypes = true, class T, class... TArgs>
+    TOut RunMethodDirectThrow(T&& instance, const MethodInfo* method, TArgs&& ...params) {
+        static auto& logger = getLogger();
+        if (!method) {
+            throw RunMethodException("Method cannot be null!", nullptr);
+        }
+
+        if constexpr (checkTypes && sizeof...(TArgs) > 0) {
+            auto typeVec = ExtractTypes(params...);
+            if (!ParameterMatch(method, typeVec)) {
+                throw RunMethodException("Parameters do not match!", method);
+            }
+        }
+
+        void* inst = ExtractDirectInstance(instance, method);
+        Il2CppException* exp = nullptr;
+        auto throwIfFailed = [&]() {
+            if (exp) {
+                logger.error("%s: Failed with exception: %s", il2cpp_functions::method_get_name(method),
+                    il2cpp_utils::ExceptionToString(exp).c_str());
+                throw RunMethodException(exp, method);
+            }
+        };
+        if constexpr (::std::is_same_v<TOut, void>) {
+            InvokeDirect<void>(method, inst, &exp, ExtractDirectValue(::std::forward<TArgs>(params))...);
+            throwIfFailed();
+        } else {
+            auto ret = InvokeDirect<TOut>(method, inst, &exp, ExtractDirectValue(::std::forward<TArgs>(params))...);
+            throwIfFailed();
+            return ret;
+        }
+    }
     #else
     /// @brief Instantiates a generic MethodInfo* from the provided Il2CppClasses.
     /// @return MethodInfo* for RunMethod calls, will be nullptr on failure
@@ -266,11 +365,11 @@ namespace il2cpp_utils {
     }
 
     bool IsConvertible(const Il2CppType* to, const Il2CppType* from, bool asArgs = true);
-    // Returns if a given MethodInfo's parameters match the Il2CppType vector
-    bool ParameterMatch(const MethodInfo* method, ::std::vector<const Il2CppType*> argTypes);
+    // Returns if a given MethodInfo's parameters match the Il2CppType span
+    bool ParameterMatch(const MethodInfo* method, ::std::span<const Il2CppType* const> argTypes);
 
-    // Returns if a given MethodInfo's parameters match the Il2CppType vector and generic types vector
-    bool ParameterMatch(const MethodInfo* method, ::std::vector<Il2CppClass*> genTypes, ::std::vector<const Il2CppType*> argTypes);
+    // Returns if a given MethodInfo's parameters match the Il2CppType span and generic types span
+    bool ParameterMatch(const MethodInfo* method, ::std::span<Il2CppClass* const> genTypes, ::std::span<const Il2CppType* const> argTypes);
     #endif
 
     // Function made by zoller27osu, modified by Sc2ad
@@ -290,7 +389,7 @@ namespace il2cpp_utils {
 
         if constexpr (checkTypes && sizeof...(TArgs) > 0) {
             auto typeVec = ExtractTypes(params...);
-            RET_NULLOPT_UNLESS(logger, typeVec.size() == sizeof...(TArgs));
+            RET_NULLOPT_UNLESS(logger, ExtractedAllTypes(typeVec));
             RET_NULLOPT_UNLESS(logger, ParameterMatch(method, typeVec));
         }
 
@@ -343,6 +442,41 @@ namespace il2cpp_utils {
         return RunMethod<TOut, false>(static_cast<Il2CppClass*>(nullptr), method, params...);
     }
 
+    template<class TOut = Il2CppObject*, bool checkTypes = true, class T, class... TArgs>
+    // Runs a MethodInfo with the specified parameters and instance, with return type TOut, by calling its methodPointer directly.
+    // Unlike RunMethod, this does not box value types or go through runtime_invoke, but TOut must be the exact native return type.
+    // Arguments are passed exactly as provided (ref/out parameters as explicit pointers, which will fail type checking).
+    // A value type instance may be passed by value, as a pointer to its data, or boxed (see ExtractDirectInstance).
+    // Assumes a static method if instance == nullptr. May fail due to exception or mismatched types, hence the ::std::optional.
+    // For methods returning void, use InvokeDirect or RunMethodDirectThrow.
+    ::std::optional<TOut> RunMethodDirect(T&& instance, const MethodInfo* method, TArgs&& ...params) {
+        static_assert(!::std::is_same_v<TOut, void>, "RunMethodDirect cannot return void! Use InvokeDirect or RunMethodDirectThrow instead.");
+        static auto& logger = getLogger();
+        RET_NULLOPT_UNLESS(logger, method);
+
+        if constexpr (checkTypes && sizeof...(TArgs) > 0) {
+            auto typeVec = ExtractTypes(params...);
+            RET_NULLOPT_UNLESS(logger, ExtractedAllTypes(typeVec));
+            RET_NULLOPT_UNLESS(logger, ParameterMatch(method, typeVec));
+        }
+
+        void* inst = ExtractDirectInstance(instance, method);  // null is allowed (for T = Il2CppType* or Il2CppClass*)
+        Il2CppException* exp = nullptr;
+        auto ret = InvokeDirect<TOut>(method, inst, &exp, ExtractDirectValue(::std::forward<TArgs>(params))...);
+        if (exp) {
+            logger.error("%s: Failed with exception: %s", il2cpp_functions::method_get_name(method),
+                il2cpp_utils::ExceptionToString(exp).c_str());
+            return ::std::nullopt;
+        }
+        return ret;
+    }
+
+    template<class TOut = Il2CppObject*, bool checkTypes = true, class... TArgs>
+    // Simply forwards arguments to RunMethodDirect<TOut, checkTypes>(static_cast<Il2CppClass*>(nullptr), ...)
+    ::std::optional<TOut> RunStaticMethodDirect(const MethodInfo* method, TArgs&& ...params) {
+        return RunMethodDirect<TOut, checkTypes>(static_cast<Il2CppClass*>(nullptr), method, ::std::forward<TArgs>(params)...);
+    }
+
     template<class TOut = Il2CppObject*, bool checkTypes = true, class T, class... TArgs>
     // Runs a (static) method with the specified method name, with return type TOut.
     // Checks the types of the parameters against the candidate methods.
@@ -355,11 +489,11 @@ namespace il2cpp_utils {
         static auto& logger = getLogger();
         if constexpr (checkTypes) {
             auto types = ExtractTypes(params...);
-            if (types.size() != sizeof...(TArgs)) {
+            if (!ExtractedAllTypes(types)) {
                 logger.warning("ExtractTypes for method %s failed!", methodName.data());
                 return ::std::nullopt;
             }
-            auto* method = RET_NULLOPT_UNLESS(logger, FindMethod(classOrInstance, NoArgClass<TOut>(), methodName, types));
+            auto* method = RET_NULLOPT_UNLESS(logger, FindMethod(classOrInstance, NoArgClass<TOut>(), methodName, ::std::vector<const Il2CppType*>(types.begin(), types.end())));
             return RunMethod<TOut, true>(classOrInstance, method, params...);
         }
         // TODO: We should probably change how FindMethod is called/isn't called
@@ -406,12 +540,12 @@ namespace il2cpp_utils {
     ::std::optional<TOut> RunGenericMethod(T&& classOrInstance, ::std::string_view methodName, ::std::vector<Il2CppClass*> genTypes, TArgs&& ...params) noexcept {
         static auto& logger = getLogger();
         auto types = ExtractTypes(params...);
-        if (types.size() != sizeof...(TArgs)) {
+        if (!ExtractedAllTypes(types)) {
             logger.warning("ExtractTypes for method %s failed!", methodName.data());
             return ::std::nullopt;
         }
 
-        auto* info = RET_NULLOPT_UNLESS(logger, FindMethod(classOrInstance, NoArgClass<TOut>(), methodName, genTypes, types));
+        auto* info = RET_NULLOPT_UNLESS(logger, FindMethod(classOrInstance, NoArgClass<TOut>(), methodName, genTypes, ::std::vector<const Il2CppType*>(types.begin(), types.end())));
         return RunGenericMethod<TOut>(classOrInstance, info, genTypes, params...);
     }
     template<class TOut = Il2CppObject*, class... TArgs>
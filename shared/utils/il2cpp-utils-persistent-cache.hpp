@@ -0,0 +1,39 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+#include "il2cpp-functions.hpp"
+
+namespace il2cpp_utils {
+    /// @brief An on-disk cache of class, method, field and property resolutions that persists across game launches.
+    /// Results are stored as (TypeDefinitionIndex, member index) pairs, which are stable for as long as libil2cpp.so and
+    /// global-metadata.dat stay the same. The cache file is tagged with a fingerprint of both, so it is automatically
+    /// ignored (and rewritten) after a game update. Every hit is validated against the live metadata before it is used.
+    /// GetClassFromName, FindMethod, FindMethodUnsafe, FindField and FindProperty consult it on an in-memory cache miss.
+    /// The cache is opt-in: call Enable() once, after il2cpp has been initialized (for example, in load).
+    /// Resolutions of generic instances are never persisted.
+    struct PersistentCache {
+        /// @brief Opens the cache file in the beatsaber-hook data directory and starts using it.
+        /// New resolutions are written back on Flush, or when the process exits.
+        static void Enable() noexcept;
+        /// @brief Returns true if Enable has been called.
+        static bool IsEnabled() noexcept;
+        /// @brief Writes all resolutions made since the last flush back to disk.
+        /// @return True on success (or if there was nothing to write).
+        static bool Flush() noexcept;
+
+        /// @brief Finds a class previously recorded with RecordClass. Returns nullptr on a miss or if the cache is disabled.
+        static Il2CppClass* FindClass(std::string_view namespaze, std::string_view name) noexcept;
+        static void RecordClass(std::string_view namespaze, std::string_view name, Il2CppClass* klass) noexcept;
+        /// @brief Finds a method by name and exact parameter types, looking in klass and its parents.
+        static const MethodInfo* FindMethod(const Il2CppClass* klass, std::string_view name, std::span<const Il2CppType* const> argTypes) noexcept;
+        static void RecordMethod(const Il2CppClass* klass, std::string_view name, std::span<const Il2CppType* const> argTypes, const MethodInfo* method) noexcept;
+        /// @brief Finds a method by name and parameter count, looking in klass and its parents.
+        static const MethodInfo* FindMethod(const Il2CppClass* klass, std::string_view name, int argsCount) noexcept;
+        static void RecordMethod(const Il2CppClass* klass, std::string_view name, int argsCount, const MethodInfo* method) noexcept;
+        static FieldInfo* FindField(const Il2CppClass* klass, std::string_view name) noexcept;
+        static void RecordField(const Il2CppClass* klass, std::string_view name, const FieldInfo* field) noexcept;
+        static const PropertyInfo* FindProperty(const Il2CppClass* klass, std::string_view name) noexcept;
+        static void RecordProperty(const Il2CppClass* klass, std::string_view name, const PropertyInfo* prop) noexcept;
+    };
+}
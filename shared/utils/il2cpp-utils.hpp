@@ -17,6 +17,8 @@
 #include "il2cpp-type-check.hpp"
 #include "il2cpp-utils-methods.hpp"
 #include "il2cpp-utils-classes.hpp"
+#include "il2cpp-utils-class-index.hpp"
+#include "il2cpp-utils-persistent-cache.hpp"
 #include "il2cpp-utils-exceptions.hpp"
 #include "il2cpp-utils-properties.hpp"
 #include "il2cpp-utils-fields.hpp"
@@ -579,8 +581,108 @@ namespace il2cpp_utils {
             return ::il2cpp_utils::FindMethod(klass, methodName, ::std::vector<Il2CppClass*>{}, ::std::vector<const Il2CppType*>{ExtractIndependentType<TArgs>()...});
         }
     };
+
+    template<class F>
+    class MethodHandle;
+
+    template<typename R, typename... TArgs>
+    /// @brief A resolved static method that is called directly through its methodPointer.
+    /// Performs no type checking, no boxing and does not go through runtime_invoke, so make sure the signature is correct!
+    /// Managed exceptions are NOT caught and propagate as il2cpp exception wrappers.
+    /// Use IL2CPP_METHOD_HANDLE to resolve one exactly once per call site.
+    /// @tparam R The return type
+    /// @tparam TArgs The parameter types
+    class MethodHandle<R (TArgs...)> {
+        using funcType = R (*)(TArgs..., const MethodInfo*);
+        const MethodInfo* info;
+        funcType ptr;
+        public:
+        constexpr MethodHandle() noexcept : info(nullptr), ptr(nullptr) {}
+        /// @brief Creates a handle around an already resolved MethodInfo*. The class's static constructor will be ran if it has not been already.
+        /// @param info_ The MethodInfo* to wrap, may be null.
+        explicit MethodHandle(const MethodInfo* info_) noexcept : info(info_), ptr(nullptr) {
+            if (info) {
+                il2cpp_functions::Init();
+                // runtime_invoke would have done this for us.
+                il2cpp_functions::runtime_class_init(info->klass);
+                ptr = reinterpret_cast<funcType>(info->methodPointer);
+            }
+        }
+        /// @brief Resolves the MethodInfo* matching R (TArgs...) via MethodTypeCheck::find.
+        static MethodHandle find(::std::string_view nameSpace, ::std::string_view className, ::std::string_view methodName) {
+            return MethodHandle(MethodTypeCheck<R (*)(TArgs...)>::find(nameSpace, className, methodName));
+        }
+        /// @brief Resolves the MethodInfo* matching R (TArgs...) via MethodTypeCheck::find.
+        static MethodHandle find(Il2CppClass* klass, ::std::string_view methodName) {
+            return MethodHandle(MethodTypeCheck<R (*)(TArgs...)>::find(klass, methodName));
+        }
+        /// @brief Returns the wrapped MethodInfo*, or nullptr if resolution failed.
+        constexpr const MethodInfo* get() const noexcept {
+            return info;
+        }
+        /// @brief Returns true if the handle is resolved and callable.
+        constexpr explicit operator bool() const noexcept {
+            return ptr != nullptr;
+        }
+        /// @brief Calls the method directly. Calling an unresolved handle will crash.
+        R operator()(TArgs... args) const {
+            return ptr(args..., info);
+        }
+    };
+
+    template<typename R, typename T, typename... TArgs>
+    /// @brief A resolved instance method that is called directly through its methodPointer.
+    /// Performs no type checking, no boxing and does not go through runtime_invoke, so make sure the signature is correct!
+    /// Managed exceptions are NOT caught and propagate as il2cpp exception wrappers.
+    /// For value types, the instance is a pointer to the unboxed value.
+    /// @tparam R The return type
+    /// @tparam T The instance type
+    /// @tparam TArgs The parameter types
+    class MethodHandle<R (T::*)(TArgs...)> {
+        using funcType = R (*)(T*, TArgs..., const MethodInfo*);
+        const MethodInfo* info;
+        funcType ptr;
+        public:
+        constexpr MethodHandle() noexcept : info(nullptr), ptr(nullptr) {}
+        /// @brief Creates a handle around an already resolved MethodInfo*.
+        /// @param info_ The MethodInfo* to wrap, may be null.
+        explicit MethodHandle(const MethodInfo* info_) noexcept : info(info_), ptr(info_ ? reinterpret_cast<funcType>(info_->methodPointer) : nullptr) {}
+        /// @brief Resolves the MethodInfo* matching R (T::*)(TArgs...) via MethodTypeCheck::find.
+        static MethodHandle find(::std::string_view nameSpace, ::std::string_view className, ::std::string_view methodName) {
+            return MethodHandle(MethodTypeCheck<R (T::*)(TArgs...)>::find(nameSpace, className, methodName));
+        }
+        /// @brief Resolves the MethodInfo* matching R (T::*)(TArgs...) via MethodTypeCheck::find.
+        static MethodHandle find(Il2CppClass* klass, ::std::string_view methodName) {
+            return MethodHandle(MethodTypeCheck<R (T::*)(TArgs...)>::find(klass, methodName));
+        }
+        /// @brief Returns the wrapped MethodInfo*, or nullptr if resolution failed.
+        constexpr const MethodInfo* get() const noexcept {
+            return info;
+        }
+        /// @brief Returns true if the handle is resolved and callable.
+        constexpr explicit operator bool() const noexcept {
+            return ptr != nullptr;
+        }
+        /// @brief Calls the method directly on instance. Calling an unresolved handle will crash.
+        R operator()(T* instance, TArgs... args) const {
+            return ptr(instance, args..., info);
+        }
+    };
 }
 
+/// @brief Resolves an il2cpp_utils::MethodHandle exactly once for this call site and returns a reference to it.
+/// The lookup is performed the first time this expression is evaluated (thread safe), every evaluation after that is free.
+/// Example: IL2CPP_METHOD_HANDLE("UnityEngine", "Time", "get_time", float())()
+/// @param namespaze The namespace of the class
+/// @param className The name of the class
+/// @param methodName The name of the method
+/// @param ... The signature, either R (TArgs...) for static methods or R (T::*)(TArgs...) for instance methods
+#define IL2CPP_METHOD_HANDLE(namespaze, className, methodName, ...) \
+([]() -> const ::il2cpp_utils::MethodHandle<__VA_ARGS__>& { \
+    static const auto handle = ::il2cpp_utils::MethodHandle<__VA_ARGS__>::find(namespaze, className, methodName); \
+    return handle; \
+}())
+
 #pragma pack(pop)
 
 #endif /* IL2CPP_UTILS_H */
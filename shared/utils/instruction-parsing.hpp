@@ -1,9 +1,13 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <iterator>
+#include <memory>
 #include <optional>
-#include <stack>
+#include <span>
 #include <unordered_map>
+#include <vector>
 #include "logging.hpp"
 #include "utils.h"
 #include <cassert>
@@ -26,6 +30,8 @@ public:
 class Instruction {
 public:
     Instruction(const int32_t* inst);
+    // Decodes inst, which must be in the module loaded at base (which is otherwise looked up with dladdr).
+    Instruction(const int32_t* inst, uintptr_t base);
 
     // ~~~ PUBLIC FIELDS ~~~
     // TODO: puzzle out and support 32-bit views of registers
@@ -121,29 +127,10 @@ public:
     // Stops search when a "ret" instruction (return) is encountered (unless the nth match is found first or "ret" matches pred).
     //   Will also disregard up to "rets" ret instructions that do not match pred, or an infinite number if rets is negative.
     // The search does not follow jumps.
+    // Returns this if it is the match, and otherwise a new Instruction that the caller must delete.
+    // InstructionRange's findNth does the same search without allocating at all.
     template<class UnaryPredicate>
-    Instruction* findNth(int n, UnaryPredicate pred, int rets = 0) {
-        auto inst = this;
-        decltype(n) matches = 0;
-        while (true) {
-            if (pred(inst)) {
-                matches++;
-                if (matches == n) return inst;
-            } else if ((rets >= 0) && inst->isReturn()) {
-                if (rets == 0) {
-                    Logger::get().debug("Breaking on offset %lX", ((uintptr_t)inst->addr) - getRealOffset(0));
-                    break;
-                }
-                rets--;
-            }
-            auto pc = inst->addr;
-            if (inst != this) delete inst;
-            inst = new Instruction(pc + 1);
-        }
-        Logger::get().error("Only found %i instructions matching this predicate!", matches);
-        usleep(10000);
-        return nullptr;
-    }
+    Instruction* findNth(int n, UnaryPredicate pred, int rets = 0);
     // e.g. BL(R). Unless the jump is indirect, the address which the instruction jumps to will be at ->imm.
     Instruction* findNthCall(int n, int rets = 0);
     // e.g. B(.eq/.ne)
@@ -176,7 +163,7 @@ public:
     }
 
 private:
-    const char* kind[3];  // strings describing the kind of instruction, from least to most specific
+    const char* kind[3] = {};  // strings describing the kind of instruction, from least to most specific
     uint8_t parseLevel;  // The lowest level we were able to parse at, 1-3 (subtract 1 for index of most specific string in 'kind')
     bool RdCanBeSP = false;
     bool Rs0CanBeSP = false;
@@ -186,8 +173,286 @@ private:
     int_fast8_t cond = -1;  // if set, a 4-bit int. See https://developer.arm.com/docs/ddi0596/a/a64-shared-pseudocode-functions/shared-functions-pseudocode#impl-shared.ConditionHolds.1
 };
 
+// The kind of an instruction as far as most searches through code care, which takes no more than its top bits to tell.
+enum class Opcode : uint8_t {
+    OTHER,
+    B,
+    BL,
+    B_COND,  // B.cond
+    CB,  // CBZ, CBNZ
+    TB,  // TBZ, TBNZ
+    BR,  // BR, and the pointer authenticating BRAA etc.
+    BLR,  // BLR, BLRAA etc.
+    RET,  // RET, RETAA, RETAB
+    BRK,  // which compilers put after calls that do not return
+    UDF,  // permanently undefined, e.g. the zeros that pad functions
+    ADR,
+    ADRP,
+    ADD_SUB_IMM,  // Add/subtract (immediate), e.g. ADD, SUBS, CMP (immediate), MOV (to/from SP)
+    LOAD_STORE,  // anything under Loads and Stores
+};
+
+// The bits that identify an Opcode: (code & mask) == value. These agree with how Instruction decodes the same encodings.
+struct OpcodeEncoding {
+    uint32_t mask;
+    uint32_t value;
+    Opcode opcode;
+};
+
+inline constexpr OpcodeEncoding opcodeEncodings[] = {
+    {0xFC000000, 0x14000000, Opcode::B},
+    {0xFC000000, 0x94000000, Opcode::BL},
+    {0xFF000010, 0x54000000, Opcode::B_COND},
+    {0x7E000000, 0x34000000, Opcode::CB},
+    {0x7E000000, 0x36000000, Opcode::TB},
+    {0xFFFF0000, 0xD61F0000, Opcode::BR},
+    {0xFFFF0000, 0xD63F0000, Opcode::BLR},
+    {0xFFFF0000, 0xD65F0000, Opcode::RET},
+    {0xFFE0001F, 0xD4200000, Opcode::BRK},
+    {0xFFFF0000, 0x00000000, Opcode::UDF},
+    {0x9F000000, 0x10000000, Opcode::ADR},
+    {0x9F000000, 0x90000000, Opcode::ADRP},
+    {0x1F800000, 0x11000000, Opcode::ADD_SUB_IMM},
+    {0x0A000000, 0x08000000, Opcode::LOAD_STORE},
+};
+
+// An instruction that is only classified (with a table lookup) rather than decoded: its operands are extracted from code when asked for.
+// Searches that only need to know "is this a BL/B/ADRP/... and where does it point" should use this over Instruction.
+class EncodedInstruction {
+public:
+    explicit EncodedInstruction(const int32_t* inst) noexcept : addr(inst), code(static_cast<uint32_t>(*inst)), opcode(classify(code)) {}
+
+    const int32_t* addr;
+    uint32_t code;
+    Opcode opcode;
+
+    static constexpr Opcode classify(uint32_t code) noexcept {
+        auto entry = opcodesByTopByte[code >> 24];
+        if (entry < scanFrom) return static_cast<Opcode>(entry);
+        // The first encoding that matches is the only one, so starting at the first one that might is enough
+        for (std::size_t i = entry - scanFrom; i < std::size(opcodeEncodings); i++) {
+            if ((code & opcodeEncodings[i].mask) == opcodeEncodings[i].value) return opcodeEncodings[i].opcode;
+        }
+        return Opcode::OTHER;
+    }
+
+    // Bits 4-0: Rd, or Rt for loads, stores, CB and TB
+    uint_fast8_t rd() const noexcept {
+        return code & 0x1F;
+    }
+    // Bits 9-5: Rn, which is also the register that BR, BLR and RET jump to
+    uint_fast8_t rn() const noexcept {
+        return (code >> 5) & 0x1F;
+    }
+    // Where a direct branch jumps to, or what ADR(P) computes. Empty for any other opcode.
+    std::optional<const int32_t*> label() const noexcept;
+
+    // The same as Instruction's predicates of the same names
+    bool isCall() const noexcept {
+        return opcode == Opcode::BL || opcode == Opcode::BLR;
+    }
+    bool isIndirectBranch() const noexcept {
+        return opcode == Opcode::BR || opcode == Opcode::BLR || opcode == Opcode::RET;
+    }
+    bool isReturn() const noexcept {
+        return opcode == Opcode::RET;
+    }
+    bool isPcRelAdr() const noexcept {
+        return opcode == Opcode::ADR || opcode == Opcode::ADRP;
+    }
+    // Whether Instruction would be a Instruction::DIR branch (which, unlike B.cond and TB, CB is not)
+    bool isDirectBranchWithoutLink() const noexcept {
+        return opcode == Opcode::B || opcode == Opcode::B_COND || opcode == Opcode::TB;
+    }
+    // Whether Instruction::hasImmOffsetOnReg could be true for some register
+    bool mayHaveImmOffset() const noexcept {
+        return opcode == Opcode::ADD_SUB_IMM || opcode == Opcode::LOAD_STORE;
+    }
+
+private:
+    // Entries from here on are scanFrom + the index of the first encoding in opcodeEncodings to check the rest of the bits against
+    static constexpr uint8_t scanFrom = 0x80;
+    static_assert(std::size(opcodeEncodings) < 0x100 - scanFrom);
+    // The Opcode of every encoding with a given top byte, unless the lower bits also matter (e.g. 0xD6 can be BR, BLR or RET)
+    static constexpr std::array<uint8_t, 256> opcodesByTopByte = []() {
+        std::array<uint8_t, 256> table{};
+        for (uint32_t top = 0; top < table.size(); top++) {
+            int first = -1;
+            int candidates = 0;
+            for (uint8_t i = 0; i < std::size(opcodeEncodings); i++) {
+                if (((top << 24) & opcodeEncodings[i].mask) != (opcodeEncodings[i].value & 0xFF000000)) continue;
+                if (first < 0) first = i;
+                candidates++;
+            }
+            if (first < 0) continue;
+            bool decided = candidates == 1 && !(opcodeEncodings[first].mask & 0x00FFFFFF);
+            table[top] = decided ? static_cast<uint8_t>(opcodeEncodings[first].opcode) : scanFrom + first;
+        }
+        return table;
+    }();
+};
+
+// Decodes the instructions from a starting address onwards one at a time, into the same Instruction, so iterating never allocates.
+// The end address (if any) is never decoded, since it may well be past the end of the code.
+class InstructionIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Instruction;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Instruction*;
+    using reference = Instruction&;
+
+    explicit InstructionIterator(const int32_t* pc, const int32_t* end = nullptr) : InstructionIterator(pc, end, getBase((uintptr_t)pc)) {}
+    // base is the base of the module pc is in
+    InstructionIterator(const int32_t* pc, const int32_t* end, uintptr_t base) : pc(pc), last(end), base(base) {
+        if (pc != last) current.emplace(pc, base);
+    }
+
+    Instruction& operator*() noexcept {
+        return *current;
+    }
+    Instruction* operator->() noexcept {
+        return &*current;
+    }
+    InstructionIterator& operator++() {
+        if (++pc == last) current.reset();
+        else current.emplace(pc, base);
+        return *this;
+    }
+    InstructionIterator operator++(int) {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
+    bool operator==(const InstructionIterator& other) const noexcept {
+        return pc == other.pc;
+    }
+    // Compares against the end of the code being iterated over
+    bool operator==(const int32_t* end) const noexcept {
+        return pc == end;
+    }
+
+private:
+    std::optional<Instruction> current;
+    const int32_t* pc;
+    const int32_t* last;
+    // The base of the module, which does not change from one instruction to the next
+    uintptr_t base;
+};
+
+// The instructions from start until end (or indefinitely without one), decoded as they are iterated over.
+class InstructionRange {
+public:
+    explicit InstructionRange(const int32_t* start, const int32_t* end = nullptr) : first(start), last(end), base(getBase((uintptr_t)start)) {}
+    explicit InstructionRange(const Instruction& start, const int32_t* end = nullptr) : InstructionRange(start.addr, end) {}
+
+    InstructionIterator begin() const {
+        return InstructionIterator(first, last, base);
+    }
+    // A sentinel: iterators compare equal to it at the end address
+    const int32_t* end() const noexcept {
+        return last;
+    }
+
+    // The same search as Instruction::findNth, but returns the match by value, so nothing is allocated.
+    // Also stops at the end of the range.
+    template<class UnaryPredicate>
+    std::optional<Instruction> findNth(int n, UnaryPredicate pred, int rets = 0) const {
+        decltype(n) matches = 0;
+        for (auto it = begin(); it != last; ++it) {
+            auto* inst = &*it;
+            if (pred(inst)) {
+                matches++;
+                if (matches == n) return *inst;
+            } else if ((rets >= 0) && inst->isReturn()) {
+                if (rets == 0) {
+                    BS_LOG_DEBUG(Logger::get(), "Breaking on offset %lX", ((uintptr_t)inst->addr) - getRealOffset(0));
+                    break;
+                }
+                rets--;
+            }
+        }
+        Logger::get().error("Only found %i instructions matching this predicate!", matches);
+        return std::nullopt;
+    }
+    // Like findNth, but pred takes a const EncodedInstruction&, so that only the match is ever decoded into an Instruction.
+    template<class UnaryPredicate>
+    std::optional<Instruction> findNthEncoded(int n, UnaryPredicate pred, int rets = 0) const {
+        decltype(n) matches = 0;
+        for (auto pc = first; pc != last; pc++) {
+            EncodedInstruction inst(pc);
+            if (pred(inst)) {
+                matches++;
+                if (matches == n) return Instruction(pc, base);
+            } else if ((rets >= 0) && inst.isReturn()) {
+                if (rets == 0) {
+                    BS_LOG_DEBUG(Logger::get(), "Breaking on offset %lX", ((uintptr_t)pc) - getRealOffset(0));
+                    break;
+                }
+                rets--;
+            }
+        }
+        Logger::get().error("Only found %i instructions matching this predicate!", matches);
+        return std::nullopt;
+    }
+    // These use findNthEncoded, so they only decode their match (and, for findNthImmOffsetOnReg, loads, stores, adds and subtracts).
+    // e.g. BL(R). Unless the jump is indirect, the address which the instruction jumps to will be at ->imm.
+    std::optional<Instruction> findNthCall(int n, int rets = 0) const;
+    // e.g. B(.eq/.ne)
+    std::optional<Instruction> findNthDirectBranchWithoutLink(int n, int rets = 0) const;
+    // e.g. ADR(P)
+    std::optional<Instruction> findNthPcRelAdr(int n, int rets = 0) const;
+    // Finds the nth (Load/store with an Immediate offset) or (Add/subtract immediate) that applies to register "reg".
+    std::optional<Instruction> findNthImmOffsetOnReg(int n, uint_fast8_t reg, int rets = 0) const;
+
+private:
+    const int32_t* first;
+    const int32_t* last;
+    // Looked up once, for every instruction in the range
+    uintptr_t base;
+};
+
+template<class UnaryPredicate>
+Instruction* Instruction::findNth(int n, UnaryPredicate pred, int rets) {
+    auto found = InstructionRange(*this).findNth(n, pred, rets);
+    if (!found) return nullptr;
+    if (found->addr == addr) return this;
+    return new Instruction(*found);
+}
+
 struct RegisterSet {
+    // What a register is known to hold. For CONSTANT and ADDRESS (computed PC-relatively, so somewhere in a module) regs is the value,
+    // and for LOADED_FROM it is the address the value was loaded from (since what is there may well change).
+    enum Kind : uint8_t {
+        UNKNOWN, CONSTANT, ADDRESS, LOADED_FROM
+    };
+
     int_fast64_t regs[Register::TOTAL_NUMBER] = {0};
+    Kind kinds[Register::TOTAL_NUMBER] = {};
+
+    // regs[reg] if it is known to be of that kind. SP and the zero register (31) are never known.
+    std::optional<int64_t> valueOf(uint_fast8_t reg, Kind kind) const noexcept {
+        if (kinds[reg] != kind) return std::nullopt;
+        return regs[reg];
+    }
+    void set(uint_fast8_t reg, Kind kind, int64_t value) noexcept {
+        if (reg == Register::SP) return;
+        kinds[reg] = kind;
+        regs[reg] = value;
+    }
+    void forget(uint_fast8_t reg) noexcept {
+        kinds[reg] = UNKNOWN;
+    }
+    // Keeps only what other agrees with, e.g. where two branches meet. Returns whether anything was forgotten.
+    bool meet(const RegisterSet& other) noexcept {
+        bool changed = false;
+        for (uint_fast8_t i = 0; i < Register::TOTAL_NUMBER; i++) {
+            if (kinds[i] == UNKNOWN || (kinds[i] == other.kinds[i] && regs[i] == other.regs[i])) continue;
+            kinds[i] = UNKNOWN;
+            changed = true;
+        }
+        return changed;
+    }
 };
 
 struct PSTATE {
@@ -207,46 +472,148 @@ struct ProgramState {
     PSTATE pstate;
 };
 
-struct ParseState;
+// A run of instructions that is only ever entered at its start and left at its end.
+struct BasicBlock {
+    const int32_t* start;
+    const int32_t* end;  // one past the last instruction
+    // Indices into AssemblyFunction::Blocks(), in order of address
+    std::vector<std::size_t> successors;
+    std::vector<std::size_t> predecessors;
+
+    bool contains(const int32_t* pc) const noexcept {
+        return pc >= start && pc < end;
+    }
+};
+
+// The control flow graph of the function at an entry address: every instruction reachable from it without following calls, split into
+// basic blocks. A B is taken to be a tail call (rather than an edge) when it jumps to before the entry or to the start of another symbol,
+// and a BR to leave the function unless it is a switch over the kind of jump table that EvalSwitch reads.
+// Building one decodes the whole function once, so get them through Get, which keeps every one it builds.
+class AssemblyFunction {
+public:
+    // A BR through a jump table of 32-bit offsets from the table, and where each case (from 0) jumps to.
+    struct Switch {
+        const int32_t* branch;
+        const uint32_t* table;
+        std::vector<const int32_t*> targets;
+    };
+
+    explicit AssemblyFunction(const int32_t* entry);
+    // The function at entry, which is only built the first time any thread asks for it.
+    static std::shared_ptr<const AssemblyFunction> Get(const int32_t* entry);
+    // Forgets every function built so far, such as after their code was patched or unloaded.
+    static void ClearCache() noexcept;
 
-class InstructionTree : Instruction {
-  public:
-    InstructionTree *noBranch;
-    InstructionTree *branch;
+    const int32_t* entry;
 
-    InstructionTree(const int32_t* inst);
-    // Note: this must be done in a stack frontier fashion to prevent StackOverflow
-    void PopulateChildren(ParseState& parseState);
-    ~InstructionTree() {
-        if (noBranch) delete noBranch;
-        if (branch) delete branch;
+    // In order of address
+    std::span<const BasicBlock> Blocks() const noexcept {
+        return blocks;
+    }
+    // The block that pc is in, or nullptr if it is not part of the function
+    const BasicBlock* BlockAt(const int32_t* pc) const noexcept;
+    // Every instruction of the function, in order of address
+    std::span<const EncodedInstruction> Instructions() const noexcept {
+        return instructions;
+    }
+    // Every BL and BLR, in order of address
+    std::span<const int32_t* const> Calls() const noexcept {
+        return calls;
     }
+    // Every B that was taken to be a tail call, in order of address
+    std::span<const int32_t* const> TailCalls() const noexcept {
+        return tailCalls;
+    }
+    std::span<const Switch> Switches() const noexcept {
+        return switches;
+    }
+
+    // The same search as InstructionRange(from).findNthEncoded, answered from the instructions classified when the function was built
+    // (a linear search may run past the end of the function, or into code it never reaches, which is then read from memory as usual).
+    template<class UnaryPredicate>
+    std::optional<Instruction> FindNthEncoded(const int32_t* from, int n, UnaryPredicate pred, int rets = 0) const;
+    // The instruction that last set reg before pc, if only one can have: looking back through pc's block, and then through its
+    // predecessor for as long as there is just the one. Calls set x0 to x18, so reaching one first finds nothing for those.
+    std::optional<Instruction> FindDefinition(const int32_t* pc, uint_fast8_t reg) const;
+
+    // The same as the free functions of the same names with entry as their inst, only searching with FindNthEncoded.
+    decltype(Instruction::result) ExtractAddress(int pcRelN, int offsetN) const;
+    std::optional<Instruction> EvalSwitch(int pcRelN, int offsetN, int switchCaseValue) const;
+
+    std::string toString() const;
+    friend std::ostream& operator<<(std::ostream& os, const AssemblyFunction& func);
+private:
+    std::vector<BasicBlock> blocks;
+    std::vector<EncodedInstruction> instructions;
+    std::vector<const int32_t*> calls;
+    std::vector<const int32_t*> tailCalls;
+    std::vector<Switch> switches;
+    // Looked up once, for every Instruction decoded from the function
+    uintptr_t base;
 };
 
-struct ParseState {
-    // Note: this uses twice the memory that a 2D bitset would, but is far easier/faster to edit
-    std::array<std::bitset<Register::TOTAL_NUMBER>, Register::TOTAL_NUMBER> dependencyMap;
-    std::unordered_map<const int32_t*, InstructionTree*> codeToInstTree;  // the set of all instructions and their corresponding trees
-    std::unordered_map<const int32_t*, decltype(dependencyMap)> functionCandidates;  // the set of instructions that were jumped to
-    std::unordered_map<const int32_t*, decltype(dependencyMap)> otherJumps;
-    std::stack<std::pair<InstructionTree*, decltype(dependencyMap)>> frontier;  // points that still need ProcessRegisterDependencies run on them
-
-    ParseState() {
-        for (uint_fast8_t i = 0; i < dependencyMap.size(); i++) {
-            dependencyMap[i] = decltype(dependencyMap)::value_type(1 << i);
+template<class UnaryPredicate>
+std::optional<Instruction> AssemblyFunction::FindNthEncoded(const int32_t* from, int n, UnaryPredicate pred, int rets) const {
+    auto inst = std::lower_bound(instructions.begin(), instructions.end(), from, [](const EncodedInstruction& inst, const int32_t* pc) {
+        return inst.addr < pc;
+    });
+    auto pc = from;
+    decltype(n) matches = 0;
+    for (; inst != instructions.end() && inst->addr == pc; ++inst, ++pc) {
+        if (pred(*inst)) {
+            matches++;
+            if (matches == n) return Instruction(pc, base);
+        } else if ((rets >= 0) && inst->isReturn()) {
+            if (rets == 0) {
+                Logger::get().error("Only found %i instructions matching this predicate!", matches);
+                return std::nullopt;
+            }
+            rets--;
         }
     }
+    return InstructionRange(pc).findNthEncoded(n - matches, pred, rets);
+}
+
+// A global address that a function uses, or a call whose target it knows, as RegisterEvaluator resolved them.
+struct Xref {
+    enum Kind : uint8_t {
+        ADDRESS,  // computed into a register, by an ADR, or an ADD to what an ADRP (or ADR) computed
+        LOAD,  // read from
+        STORE,  // written to
+        CALL,  // called, or jumped to by a tail call
+        CALL_THROUGH,  // where the pointer that is called (or jumped to) was loaded from
+    };
+    const int32_t* at;  // the instruction
+    Kind kind;
+    uintptr_t address;
 };
 
-class AssemblyFunction {
+// Evaluates which registers hold constants and global addresses through every block of a function, walking its branches (again, where
+// they loop back) until what is known at the start of each block stops changing. Resolves the targets of ADRP/ADR, ADD/SUB (immediate),
+// MOV (register and wide immediate), loads and stores with an immediate offset, and calls, without counting which ADRP and which offset.
+// Flags are not evaluated, so both ways of every conditional branch are taken; anything else that sets a register makes it unknown.
+class RegisterEvaluator {
 public:
-    InstructionTree* instructions;
+    // function must outlive the evaluator
+    explicit RegisterEvaluator(const AssemblyFunction& function);
+
+    // Every Xref in the function, in order of address
+    std::span<const Xref> Xrefs() const noexcept {
+        return xrefs;
+    }
+    // The Xrefs of a kind, in order of address
+    std::vector<Xref> Xrefs(Xref::Kind kind) const;
+    // The registers just before the instruction at pc, as far as they are known however control got there
+    std::optional<RegisterSet> StateBefore(const int32_t* pc) const;
 
-    AssemblyFunction(const int32_t* inst);
-    std::string toString() const;
-    friend std::ostream& operator<<(std::ostream& os, const AssemblyFunction& func);
 private:
-    ParseState parseState;
+    // Evaluates inst on state, adding whatever it references to found (if any)
+    void Step(const EncodedInstruction& inst, RegisterSet& state, std::vector<Xref>* found) const;
+
+    const AssemblyFunction& function;
+    // The registers at the start of each block, or nothing for blocks that were never reached
+    std::vector<std::optional<RegisterSet>> blockStates;
+    std::vector<Xref> xrefs;
 };
 
 #define ONES(N) ((1ull << (N)) - 1ull)
@@ -289,7 +656,7 @@ To Replicate(From bits, int M, int N = sizeof(To) * CHAR_BIT) {
     // The overlap should all match since N % M == 0 means that N - M*a % M == 0
     replicatedBits |= (replicatedBits << (N - repSize));
     if (N != M) {
-        Logger::get().debug("Replicate %s * %i = %s", std::bitset<sizeof(From)*CHAR_BIT>(bits).to_string().c_str(), N / M,
+        BS_LOG_DEBUG(Logger::get(), "Replicate %s * %i = %s", std::bitset<sizeof(From)*CHAR_BIT>(bits).to_string().c_str(), N / M,
             std::bitset<sizeof(To)*CHAR_BIT>(replicatedBits).to_string().c_str());
     }
     return replicatedBits;
@@ -331,7 +698,7 @@ T ROR(T x, int N, unsigned shift) {
     shift %= N;
     T ret = LSR(x, N, shift) | LSL(x, N, N - shift);
     if ((ret == 0) && (x != 0)) {
-        Logger::get().debug("%s ROR %i (-%i) returned %s!", std::bitset<sizeof(T)*CHAR_BIT>(x).to_string().c_str(), shift, N - shift,
+        BS_LOG_DEBUG(Logger::get(), "%s ROR %i (-%i) returned %s!", std::bitset<sizeof(T)*CHAR_BIT>(x).to_string().c_str(), shift, N - shift,
             std::bitset<sizeof(T)*CHAR_BIT>(ret).to_string().c_str());
         SAFE_ABORT();
     }
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+
+class LoggerBuffer;
+struct iovec;
+
+namespace Logging {
+    /// @brief Queues preformatted log lines for LoggerBuffer files, which a single background thread writes out with writev.
+    /// Every thread that logs gets its own fixed size ring, so queueing a line never takes a lock or allocates.
+    /// If a thread's ring is full the line is dropped and counted instead of blocking the thread,
+    /// and the writer notes how many lines were dropped in the global log.
+    /// Files are kept open between writes, and rotated once they reach LoggerBuffer::maxFileSize.
+    /// Lines from one thread are written in order. Lines from different threads may be written slightly out of order.
+    /// Instead of a line, a thread may queue a deferred record (see Reserve), which the writer formats.
+    struct LogQueue {
+        /// @brief The size of each thread's ring, in bytes.
+        static constexpr std::size_t ringSize = 32 * 1024;
+        /// @brief The most rings that may exist at once. Lines from threads beyond this are dropped.
+        static constexpr std::size_t maxRings = 64;
+        /// @brief The largest record or line that may be queued, in bytes.
+        static constexpr std::size_t maxRecordSize = ringSize / 2 - 32;
+
+        /// @brief Turns a deferred record into output, on the writer thread.
+        /// line receives text (ending in a newline) for the global log, raw receives bytes for the file of buffer.
+        /// Either may be left empty.
+        using Formatter = void (*)(LoggerBuffer& buffer, std::span<const char> record, std::string& line, std::string& raw);
+
+        /// @brief Queues the concatenation of parts (which should end with a newline) to be written to the file of buffer
+        /// and the global log. Lines longer than half a ring are truncated.
+        /// @return False if the line was dropped.
+        static bool Push(LoggerBuffer& buffer, std::initializer_list<std::string_view> parts) noexcept;
+        /// @brief Reserves room for a deferred record of at most size (up to maxRecordSize) bytes in the calling thread's ring.
+        /// The record must be filled in and committed before the thread queues anything else.
+        /// @return Where to write the record, or nullptr if it was dropped (or is larger than maxRecordSize).
+        static char* Reserve(std::size_t size) noexcept;
+        /// @brief Queues the record last reserved on the calling thread, which formatter turns into output for buffer.
+        /// @param size The size of the record, which may be less than what was reserved.
+        static void Commit(LoggerBuffer& buffer, Formatter formatter, std::size_t size) noexcept;
+        /// @brief Writes everything queued so far, on the calling thread.
+        static void Flush() noexcept;
+        /// @brief Returns the number of lines dropped so far.
+        static uint64_t Dropped() noexcept;
+        /// @brief Closes the file of buffer, so that the next write opens (and creates) it again.
+        static void Reopen(LoggerBuffer& buffer) noexcept;
+        /// @brief When the file of a LoggerBuffer is rotated, see the fields of LoggerBuffer with the same names.
+        struct FileLimits {
+            std::size_t maxFileSize;
+            uint32_t maxFileCount;
+            bool compressRotated;
+        };
+        /// @brief Writes everything queued so far (with the old settings of buffer), then switches buffer to a new, empty file at path,
+        /// deleting the files rotated out of path before. Both happen under the drain lock, so the writer never sees the settings change halfway.
+        /// @return False if the new file could not be created.
+        static bool Reconfigure(LoggerBuffer& buffer, std::string path, const FileLimits& limits) noexcept;
+        private:
+        /// @brief Starts the writer thread, if it is not running yet.
+        static void Start() noexcept;
+        /// @brief Writes out everything queued. Must hold the drain lock.
+        static void Drain() noexcept;
+        /// @brief Writes lines to the file of buffer, opening it if needed. Only called while draining.
+        static void Write(LoggerBuffer& buffer, iovec* lines, std::size_t count) noexcept;
+        /// @brief Closes the file of buffer and shifts it into the rotated files, compressing it in the background.
+        static void Rotate(LoggerBuffer& buffer) noexcept;
+    };
+}
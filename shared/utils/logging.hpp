@@ -15,6 +15,9 @@
 #include <mutex>
 #include "modloader/shared/modloader.hpp"
 #include "utils-functions.h"
+#include "log-queue.hpp"
+#include <atomic>
+#include <chrono>
 #include <thread>
 #include <unordered_set>
 #include <unordered_map>
@@ -27,8 +30,72 @@ namespace Logging {
         INFO = ANDROID_LOG_INFO,
         DEBUG = ANDROID_LOG_DEBUG
     };
+    /// @brief The bit of lvl in a logger's level mask.
+    constexpr uint32_t LevelBit(Level lvl) {
+        return 1u << lvl;
+    }
+    constexpr uint32_t AllLevels = LevelBit(CRITICAL) | LevelBit(ERROR) | LevelBit(WARNING) | LevelBit(INFO) | LevelBit(DEBUG);
+}
+
+namespace Logging {
+    /// @brief The state of one rate limited call site, see LoggerContextObject::every_n and the BS_LOG_EVERY_N macros.
+    /// Meant to be a function local static, which is constant initialized and never locks.
+    struct RateLimit {
+        /// @brief The number of calls so far.
+        std::atomic<uint64_t> calls = 0;
+        /// @brief The number of calls suppressed since the last report.
+        std::atomic<uint64_t> suppressed = 0;
+        /// @brief The second (of the steady clock) the current window started in.
+        std::atomic<int64_t> window = -1;
+        /// @brief The number of calls in the current window.
+        std::atomic<uint32_t> inWindow = 0;
+
+        /// @brief Returns true if the window moved on to a new second, in which case report is set to what was suppressed before.
+        bool NextWindow(uint64_t& report) noexcept {
+            auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            auto window = this->window.load(std::memory_order_relaxed);
+            if (now == window || !this->window.compare_exchange_strong(window, now, std::memory_order_relaxed)) return false;
+            inWindow.store(0, std::memory_order_relaxed);
+            report = suppressed.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+    };
 }
 
+/// @brief The lowest level that is compiled in. Lines logged through the BS_LOG macros below this level are removed at compile time,
+/// arguments and all. Defaults to logging every level. For example, release builds can pass -DBS_HOOK_MIN_LOG_LEVEL=ANDROID_LOG_INFO
+#ifndef BS_HOOK_MIN_LOG_LEVEL
+#define BS_HOOK_MIN_LOG_LEVEL ANDROID_LOG_DEBUG
+#endif
+
+/// @brief Logs at lvl with logger (a Logger or LoggerContextObject), unless lvl is below BS_HOOK_MIN_LOG_LEVEL or disabled on logger.
+/// Unlike calling logger.log directly, the arguments are only evaluated if the line is logged.
+#define BS_LOG(logger, lvl, ...) do { \
+    if constexpr (static_cast<int>(lvl) >= BS_HOOK_MIN_LOG_LEVEL) { \
+        if ((logger).isEnabled(lvl)) (logger).log(lvl, __VA_ARGS__); \
+    } \
+} while (0)
+#define BS_LOG_CRITICAL(logger, ...) BS_LOG(logger, Logging::CRITICAL, __VA_ARGS__)
+#define BS_LOG_ERROR(logger, ...) BS_LOG(logger, Logging::ERROR, __VA_ARGS__)
+#define BS_LOG_WARNING(logger, ...) BS_LOG(logger, Logging::WARNING, __VA_ARGS__)
+#define BS_LOG_INFO(logger, ...) BS_LOG(logger, Logging::INFO, __VA_ARGS__)
+#define BS_LOG_DEBUG(logger, ...) BS_LOG(logger, Logging::DEBUG, __VA_ARGS__)
+
+/// @brief Like BS_LOG, but only logs when check (a rate limit of logger, a LoggerContextObject) passes.
+/// Each use has its own Logging::RateLimit, named bs_rateLimit for check to refer to.
+#define BS_LOG_LIMITED(logger, lvl, check, ...) do { \
+    if constexpr (static_cast<int>(lvl) >= BS_HOOK_MIN_LOG_LEVEL) { \
+        static ::Logging::RateLimit bs_rateLimit; \
+        if ((logger).isEnabled(lvl) && (logger).check) (logger).log(lvl, __VA_ARGS__); \
+    } \
+} while (0)
+/// @brief Logs the first of every n lines from this call site.
+#define BS_LOG_EVERY_N(logger, lvl, n, ...) BS_LOG_LIMITED(logger, lvl, every_n(bs_rateLimit, n), __VA_ARGS__)
+/// @brief Logs at most perSecond lines from this call site each second, reporting how many were suppressed.
+#define BS_LOG_PER_SECOND(logger, lvl, perSecond, ...) BS_LOG_LIMITED(logger, lvl, at_most_per_second(bs_rateLimit, perSecond, lvl), __VA_ARGS__)
+/// @brief Logs the first n lines from this call site, and then only how many were suppressed (at most once a second).
+#define BS_LOG_FIRST_N(logger, lvl, n, ...) BS_LOG_LIMITED(logger, lvl, first_n(bs_rateLimit, n, lvl), __VA_ARGS__)
+
 #ifdef log
 #undef log
 #endif
@@ -40,17 +107,15 @@ namespace Logging {
 class Logger;
 
 /// @class Logger Buffer
-/// @brief A buffer for logger data. Used for logging to file in a buffered fashion.
+/// @brief The log file of a logger. Used for logging to file in a buffered fashion.
 /// Each LoggerBuffer exists to wrap around a single logger instance.
-/// Every time log is called on the instance, this buffer is updated (assuming options.toFile is true for the instance)
-/// Each buffer contains multiple messages that need to be written out, stored as an std::list
+/// Every time log is called on the instance, a line for this buffer is queued in Logging::LogQueue (assuming options.toFile is true for the instance)
 class LoggerBuffer {
     friend Logger;
+    friend Logging::LogQueue;
     public:
-    std::list<std::string> messages;
-    std::mutex messageLock;
     const ModInfo modInfo;
-    bool closed = false;
+    std::atomic_bool closed = false;
     static std::string get_logDir() {
         // Copy it
         static std::string d = string_format(LOG_PATH, Modloader::getApplicationId().c_str());
@@ -62,20 +127,50 @@ class LoggerBuffer {
         auto val = get_logDir() + modInfo.id + "_" + cpy + ".log";
         return val;
     }
-    std::size_t length();
+    /// @brief The path of the binary log, which deferred loggers write instead of get_path. See Logging::BinaryLog::Decode.
+    std::string get_binaryPath() {
+        auto val = get_path();
+        return val.substr(0, val.size() - 3) + "binlog";
+    }
+    /// @brief The size at which the file is rotated, in bytes, or 0 to let it grow without bound.
+    std::size_t maxFileSize = 8 * 1024 * 1024;
+    /// @brief The number of files kept, including the one being written. Rotated files are named <path>.1 (the newest) and up.
+    uint32_t maxFileCount = 4;
+    /// @brief Whether rotated files are compressed with gzip (and named <path>.1.gz and up).
+    bool compressRotated = true;
+    /// @brief Queues a line to be written to this buffer's file (and the global log).
     void addMessage(std::string_view msg);
+    /// @brief Writes every queued line, of every buffer.
     void flush();
     private:
     std::string path;
+    // Kept open by the LogQueue writer, along with how much has been written to it
+    int fd = -1;
+    std::size_t fileSize = 0;
+    // The formats already written to the binary log, only used by the LogQueue writer
+    std::unordered_set<uint64_t> binaryFormats;
     public:
     LoggerBuffer(const ModInfo info) : modInfo(info), path(get_path()) {}
 };
 
+/// @brief Returns the buffer of the global log, which receives the lines of every logger that logs to file.
+LoggerBuffer& get_global();
+
 /// @struct Logger Options
 /// @brief Provides various options for loggers, including silencing them and logging to file.
 struct LoggerOptions {
     bool silent = false;
     bool toFile = false;
+    /// @brief Whether formatting is left to the log writer thread. A logging call then only copies the format pointer and the
+    /// raw arguments (and %s strings) into the calling thread's ring. Formats must outlive the process, as literals do.
+    /// The file of a deferred logger is a binary log (at LoggerBuffer::get_binaryPath), the global log still receives text.
+    bool deferred = false;
+    /// @brief See LoggerBuffer::maxFileSize
+    std::size_t maxFileSize = 8 * 1024 * 1024;
+    /// @brief See LoggerBuffer::maxFileCount
+    uint32_t maxFileCount = 4;
+    /// @brief See LoggerBuffer::compressRotated
+    bool compressRotated = true;
     std::string contextSeparator = "::";
     LoggerOptions(bool silent_ = false, bool toFile_ = false) : silent(silent_), toFile(toFile_) {}
     LoggerOptions(std::string_view contextSeparator_, bool silent_ = false, bool toFile_ = false) :
@@ -83,10 +178,8 @@ struct LoggerOptions {
 };
 
 class LoggerContextObject;
-class Consumer;
 
 class Logger {
-    friend Consumer;
     friend LoggerBuffer;
     friend LoggerContextObject;
     public:
@@ -105,52 +198,58 @@ class Logger {
         ~Logger() = delete;
         void log(Logging::Level lvl, std::string str);
         __attribute__((format(printf, 3, 4))) void log(Logging::Level lvl, const char* fmt, ...) {
-            if (options.silent) {
+            if (!isEnabled(lvl)) {
                 return;
             }
             va_list lst;
             va_start(lst, fmt);
-            log(lvl, string_vformat(fmt, lst));
+            log_v(lvl, {}, fmt, lst);
+            va_end(lst);
         }
         __attribute__((format(printf, 2, 3))) void critical(const char* fmt, ...) {
-            if (options.silent) {
+            if (!isEnabled(Logging::CRITICAL)) {
                 return;
             }
             va_list lst;
             va_start(lst, fmt);
-            log(Logging::CRITICAL, string_vformat(fmt, lst));
+            log_v(Logging::CRITICAL, {}, fmt, lst);
+            va_end(lst);
         }
         __attribute__((format(printf, 2, 3))) void error(const char* fmt, ...) {
-            if (options.silent) {
+            if (!isEnabled(Logging::ERROR)) {
                 return;
             }
             va_list lst;
             va_start(lst, fmt);
-            log(Logging::ERROR, string_vformat(fmt, lst));
+            log_v(Logging::ERROR, {}, fmt, lst);
+            va_end(lst);
         }
         __attribute__((format(printf, 2, 3))) void warning(const char* fmt, ...) {
-            if (options.silent) {
+            if (!isEnabled(Logging::WARNING)) {
                 return;
             }
             va_list lst;
             va_start(lst, fmt);
-            log(Logging::WARNING, string_vformat(fmt, lst));
+            log_v(Logging::WARNING, {}, fmt, lst);
+            va_end(lst);
         }
         __attribute__((format(printf, 2, 3))) void info(const char* fmt, ...) {
-            if (options.silent) {
+            if (!isEnabled(Logging::INFO)) {
                 return;
             }
             va_list lst;
             va_start(lst, fmt);
-            log(Logging::INFO, string_vformat(fmt, lst));
+            log_v(Logging::INFO, {}, fmt, lst);
+            va_end(lst);
         }
         __attribute__((format(printf, 2, 3))) void debug(const char* fmt, ...) {
-            if (options.silent) {
+            if (!isEnabled(Logging::DEBUG)) {
                 return;
             }
             va_list lst;
             va_start(lst, fmt);
-            log(Logging::DEBUG, string_vformat(fmt, lst));
+            log_v(Logging::DEBUG, {}, fmt, lst);
+            va_end(lst);
         }
         /// @brief Flushes the buffer for this logger instance.
         void flush();
@@ -163,6 +262,8 @@ class Logger {
         static void closeAll();
         /// @brief Flush all open LoggerBuffer objects.
         static void flushAll();
+        /// @brief Returns the number of lines that were not written to file because they were logged faster than they could be written.
+        static uint64_t droppedCount();
         /// @brief Initialize this logger. Deletes existing file logs.
         /// This happens on default when this instance is constructed.
         /// This should also be called anytime the options field is modified.
@@ -171,14 +272,30 @@ class Logger {
         /// @brief Call this to silence logs from this logger. Should improve performance slightly.
         /// Note that this call causes ALL calls to this particular logger to be silent, including from other mods.
         /// Should only be used in particular cases.
-        constexpr void disable() {
+        void disable() {
             options.silent = true;
+            levelMask.fetch_or(silentBit, std::memory_order_relaxed);
         }
         /// @brief Call this to re-enable logs for this logger. Decreases performance slightly, but provides debug information.
         /// Note that this call causes ALL calls to this particular logger to be enabled again, including from other mods that want silence.
         /// Should only be used in particular cases.
-        constexpr void enable() {
+        void enable() {
             options.silent = false;
+            levelMask.fetch_and(~silentBit, std::memory_order_relaxed);
+        }
+        /// @brief Returns true if lines of lvl are logged (the logger is not silent, and lvl is in its level mask).
+        /// Costs a single relaxed load, so it is cheap enough to check before every line, as the BS_LOG macros do.
+        bool isEnabled(Logging::Level lvl) const {
+            return (levelMask.load(std::memory_order_relaxed) & (Logging::LevelBit(lvl) | silentBit)) == Logging::LevelBit(lvl);
+        }
+        /// @brief Sets which levels are logged, as a combination of Logging::LevelBit. Takes effect immediately, on every thread.
+        void setLevelMask(uint32_t mask) {
+            auto current = levelMask.load(std::memory_order_relaxed);
+            while (!levelMask.compare_exchange_weak(current, (current & silentBit) | (mask & Logging::AllLevels), std::memory_order_relaxed));
+        }
+        /// @brief Only logs lines of lvl and above.
+        void setMinLevel(Logging::Level lvl) {
+            setLevelMask(Logging::AllLevels & ~(Logging::LevelBit(lvl) - 1));
         }
         /// @brief Returns the current options for this logger
         const LoggerOptions getOptions() const {
@@ -201,6 +318,12 @@ class Logger {
     private:
         /// @brief The options associated with this logger
         LoggerOptions options;
+        /// @brief Set in levelMask while the logger is silent
+        static constexpr uint32_t silentBit = 1u << 31;
+        /// @brief The levels that are logged, along with silentBit
+        std::atomic<uint32_t> levelMask = Logging::AllLevels;
+        /// @brief Whether disabledContexts is not empty, so that WithContext does not have to lock to find out
+        std::atomic_bool hasDisabledContexts = false;
 
         std::unordered_set<std::string> disabledContexts;
         /// @brief All created contexts for this instance
@@ -214,10 +337,15 @@ class Logger {
         // This means that if a logger instance is disposed (for whatever reason) it needs to clear its buffer pointer from the buffers list.
         // This is done in the destructor, but for all intents and purposes, it doesn't need to happen at all.
         LoggerBuffer buffer;
-        static bool consumerStarted;
         static std::list<LoggerBuffer*> buffers;
         static std::mutex bufferMutex;
 
+        /// @brief Logs fmt formatted with lst, prefixed by context, deferring the formatting if options.deferred is set.
+        void log_v(Logging::Level lvl, std::string_view context, const char* fmt, va_list lst);
+        __attribute__((format(printf, 4, 5))) void log_deferred(Logging::Level lvl, std::string_view context, const char* fmt, ...);
+        /// @brief Formats a deferred record on the LogQueue writer thread. See Logging::LogQueue::Formatter.
+        static void format_deferred(LoggerBuffer& buffer, std::span<const char> record, std::string& line, std::string& raw);
+
         /// @brief Constructs a context with a parent. This is called by LoggerContextObject.WithContext.
         LoggerContextObject WithContext(LoggerContextObject* parent, std::string_view context);
         /// @brief Recurses over all children contexts and disables/enables if they start with context.
@@ -229,7 +357,6 @@ class Logger {
             // Emplace, lock is released
             Logger::buffers.push_back(&buffer);
         }
-        static void startConsumer();
 };
 
 class LoggerContextObject {
@@ -248,6 +375,11 @@ class LoggerContextObject {
     LoggerContextObject* parentContext = nullptr;
     std::list<LoggerContextObject*> childrenContexts;
 
+    /// @brief Logs how many lines a rate limited call site suppressed.
+    void reportSuppressed(Logging::Level lvl, uint64_t count) const {
+        log(lvl, "Suppressed %llu lines from a rate limited call site", static_cast<unsigned long long>(count));
+    }
+
     public:
     /// @brief Constructs a LoggerContextObject. Should only be called from Logger.WithContext or LoggerContextObject.WithContext
     /// @param l Logger instance to use
@@ -324,6 +456,34 @@ class LoggerContextObject {
         logger.contextMutex.unlock();
     }
 
+    /// @brief Returns true if lines of lvl are logged in this context.
+    bool isEnabled(Logging::Level lvl) const {
+        return enabled && logger.isEnabled(lvl);
+    }
+
+    /// @brief Returns true for the first of every n calls with state.
+    bool every_n(Logging::RateLimit& state, uint64_t n) const noexcept {
+        return n <= 1 || state.calls.fetch_add(1, std::memory_order_relaxed) % n == 0;
+    }
+    /// @brief Returns true for at most perSecond calls with state each second.
+    /// The first call of a second after calls were suppressed first logs how many, at lvl.
+    bool at_most_per_second(Logging::RateLimit& state, uint32_t perSecond, Logging::Level lvl = Logging::INFO) const {
+        uint64_t report;
+        if (state.NextWindow(report) && report > 0) reportSuppressed(lvl, report);
+        if (state.inWindow.fetch_add(1, std::memory_order_relaxed) < perSecond) return true;
+        state.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    /// @brief Returns true for the first n calls with state. Later calls are suppressed, and how many is logged at lvl,
+    /// at most once a second (by the first suppressed call of that second).
+    bool first_n(Logging::RateLimit& state, uint64_t n, Logging::Level lvl = Logging::INFO) const {
+        if (state.calls.fetch_add(1, std::memory_order_relaxed) < n) return true;
+        state.suppressed.fetch_add(1, std::memory_order_relaxed);
+        uint64_t report;
+        if (state.NextWindow(report) && report > 0) reportSuppressed(lvl, report);
+        return false;
+    }
+
     void log(Logging::Level lvl, std::string str) const {
         if (enabled) {
             logger.log(lvl, tag + str);
@@ -331,46 +491,46 @@ class LoggerContextObject {
     }
 
     void log_v(Logging::Level lvl, std::string_view fmt, va_list lst) const {
-        logger.log(lvl, tag + string_vformat(fmt, lst));
+        logger.log_v(lvl, tag, fmt.data(), lst);
     }
     
     __attribute__((format(printf, 3, 4))) void log(Logging::Level lvl, const char* fmt, ...) const {
-        if (enabled) {
+        if (isEnabled(lvl)) {
             va_list lst;
             va_start(lst, fmt);
             log_v(lvl, fmt, lst);
         }
     }
     __attribute__((format(printf, 2, 3))) void critical(const char* fmt, ...) const {
-        if (enabled) {
+        if (isEnabled(Logging::CRITICAL)) {
             va_list lst;
             va_start(lst, fmt);
             log_v(Logging::CRITICAL, fmt, lst);
         }
     }
     __attribute__((format(printf, 2, 3))) void error(const char* fmt, ...) const {
-        if (enabled) {
+        if (isEnabled(Logging::ERROR)) {
             va_list lst;
             va_start(lst, fmt);
             log_v(Logging::ERROR, fmt, lst);
         }
     }
     __attribute__((format(printf, 2, 3))) void warning(const char* fmt, ...) const {
-        if (enabled) {
+        if (isEnabled(Logging::WARNING)) {
             va_list lst;
             va_start(lst, fmt);
             log_v(Logging::WARNING, fmt, lst);
         }
     }
     __attribute__((format(printf, 2, 3))) void info(const char* fmt, ...) const {
-        if (enabled) {
+        if (isEnabled(Logging::INFO)) {
             va_list lst;
             va_start(lst, fmt);
             log_v(Logging::INFO, fmt, lst);
         }
     }
     __attribute__((format(printf, 2, 3))) void debug(const char* fmt, ...) const {
-        if (enabled) {
+        if (isEnabled(Logging::DEBUG)) {
             va_list lst;
             va_start(lst, fmt);
             log_v(Logging::DEBUG, fmt, lst);
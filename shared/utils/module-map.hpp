@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// @brief The memory mappings of the process (as listed in /proc/self/maps), parsed once and sorted for lookups by address or module name.
+/// A map is an immutable snapshot: Get returns the current one, which stays valid (as a std::shared_ptr) even after it is invalidated.
+/// Mappings only change when libraries are loaded or unloaded, so call Invalidate after doing either, or use GetWithModule.
+class ModuleMap {
+    public:
+    /// @brief One line of /proc/self/maps: [start, end), mapped from offset in the file of its module (if any).
+    struct Segment {
+        uintptr_t start;
+        uintptr_t end;
+        uintptr_t offset;
+        bool readable;
+        bool writable;
+        bool executable;
+        /// @brief Index of the module the segment belongs to in Modules(), or npos for anonymous memory.
+        std::size_t module;
+
+        bool Contains(uintptr_t address) const noexcept {
+            return address >= start && address < end;
+        }
+    };
+    /// @brief Every segment mapped from the same file: base is where the first one starts, end is where the last one ends.
+    struct Module {
+        std::string path;
+        uintptr_t base;
+        uintptr_t end;
+        /// @brief The module's segments are Segments()[firstSegment] to Segments()[lastSegment], along with whatever is mapped in between (anonymous memory, such as .bss).
+        std::size_t firstSegment;
+        std::size_t lastSegment;
+
+        /// @brief The file name, without the directory.
+        std::string_view Name() const noexcept {
+            auto slash = path.find_last_of('/');
+            return slash == std::string::npos ? std::string_view(path) : std::string_view(path).substr(slash + 1);
+        }
+        uintptr_t Size() const noexcept {
+            return end - base;
+        }
+    };
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /// @brief Returns the current map, parsing /proc/self/maps if there is none (or it was invalidated).
+    static std::shared_ptr<const ModuleMap> Get();
+    /// @brief Returns the current map if it has a module named name, and otherwise the map parsed again (such as when it was loaded since).
+    static std::shared_ptr<const ModuleMap> GetWithModule(std::string_view name);
+    /// @brief Drops the current map, so that the next Get parses /proc/self/maps again.
+    static void Invalidate() noexcept;
+    /// @brief Parses the text of a maps file.
+    static ModuleMap Parse(std::string_view maps);
+
+    /// @brief Returns the segment address is in, or nullptr if it is not mapped. O(log n).
+    const Segment* FindSegment(uintptr_t address) const noexcept;
+    /// @brief Returns the module address is in, or nullptr if it is not in one. O(log n).
+    const Module* FindModule(uintptr_t address) const noexcept;
+    /// @brief Returns the module with the given file name ("libil2cpp.so"), or path if name has a '/', or nullptr. O(log n).
+    /// If several are loaded under the same file name, returns the one at the lowest address.
+    const Module* FindModule(std::string_view name) const noexcept;
+
+    std::span<const Segment> Segments() const noexcept {
+        return segments;
+    }
+    /// @brief The segments of module, in order of address, including whatever is mapped between them (see Segment::module).
+    std::span<const Segment> Segments(const Module& module) const noexcept {
+        return std::span<const Segment>(segments).subspan(module.firstSegment, module.lastSegment - module.firstSegment + 1);
+    }
+    std::span<const Module> Modules() const noexcept {
+        return modules;
+    }
+
+    private:
+    // In order of address, as the kernel lists them
+    std::vector<Segment> segments;
+    // In order of base address
+    std::vector<Module> modules;
+    // Module indices, sorted by Name()
+    std::vector<std::size_t> byName;
+};
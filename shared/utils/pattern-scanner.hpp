@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// @brief A signature in the text form findPattern takes ("f8 5f ?? a9 ? 57"), parsed once into bytes and a mask.
+/// Scanning looks for the first and last fixed bytes of the pattern 16 candidates at a time (with NEON on the headset,
+/// SSE2 on x86 hosts, and memchr elsewhere), and only compares the whole pattern (masked, 16 bytes at a time) where both match.
+/// Every match is found in a single pass, without backtracking.
+class CompiledPattern {
+    public:
+    /// @brief Parses pattern: hex bytes separated by spaces, where ? or ?? matches any byte.
+    explicit CompiledPattern(std::string_view pattern);
+
+    /// @brief The length of the pattern in bytes.
+    std::size_t size() const noexcept {
+        return length;
+    }
+    /// @brief Returns the first address in [start, start + range) the whole pattern matches at, or 0 if there is none.
+    uintptr_t Find(uintptr_t start, std::size_t range) const noexcept {
+        auto* begin = reinterpret_cast<const uint8_t*>(start);
+        return reinterpret_cast<uintptr_t>(Find(begin, begin + range));
+    }
+    /// @brief Returns the first match in [begin, end), or nullptr.
+    const uint8_t* Find(const uint8_t* begin, const uint8_t* end) const noexcept;
+    /// @brief Calls func with every match in [start, start + range), in order, until it returns false.
+    template<typename F>
+    void ForEach(uintptr_t start, std::size_t range, F&& func) const {
+        auto* begin = reinterpret_cast<const uint8_t*>(start);
+        auto* end = begin + range;
+        for (auto* match = Find(begin, end); match; match = Find(match + 1, end)) {
+            if (!func(reinterpret_cast<uintptr_t>(match))) return;
+        }
+    }
+    /// @brief Returns true if the pattern matches at p, which must have size() readable bytes.
+    bool Matches(const uint8_t* p) const noexcept;
+
+    private:
+    friend class PatternSet;
+    // Padded with wildcards to a multiple of 16 bytes, so that they can be compared a vector at a time
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> mask;
+    std::size_t length = 0;
+    // Offsets of the first and last fixed bytes, which every candidate is checked against first
+    std::size_t first = 0;
+    std::size_t last = 0;
+    bool anyFixed = false;
+};
+
+/// @brief Several compiled patterns, all of which are found in a single pass over memory.
+/// The longest run of fixed bytes of every pattern (up to 8) goes into one Aho-Corasick automaton, and the whole pattern is only compared
+/// where its run is found. Bytes no anchor could start at are skipped by their first two bytes alone (16 at a time when anchors start with few different pairs). Large ranges are split across threads.
+class PatternSet {
+    public:
+    /// @brief Up to how many different pairs of bytes anchors can start with for them to be looked for 16 bytes at a time.
+    static constexpr std::size_t maxVectorPairs = 8;
+
+    explicit PatternSet(std::vector<CompiledPattern> patterns);
+
+    /// @brief The number of patterns.
+    std::size_t size() const noexcept {
+        return patterns.size();
+    }
+    const CompiledPattern& operator[](std::size_t index) const noexcept {
+        return patterns[index];
+    }
+    /// @brief Returns every match of every pattern in [start, start + range): the matches of patterns[i], in order, are in the result's [i].
+    /// Uses up to threads threads (0 for one per core) for ranges large enough to be worth it.
+    std::vector<std::vector<uintptr_t>> FindAll(uintptr_t start, std::size_t range, unsigned threads = 0) const;
+
+    private:
+    // Whether an anchor starts with p[0], p[1]
+    bool CouldStartAnchor(const uint8_t* p) const noexcept {
+        auto pair = p[0] | p[1] << 8;
+        return startPairs[pair / 64] >> pair % 64 & 1;
+    }
+    // Adds the matches starting in [from, to) to matches, where every pattern must also end by end
+    void Scan(const uint8_t* from, const uint8_t* to, const uint8_t* end, std::vector<std::vector<uintptr_t>>& matches) const;
+
+    std::vector<CompiledPattern> patterns;
+    // Where each pattern's anchor (a run of fixed bytes) starts, and how long it is
+    std::vector<std::pair<std::size_t, std::size_t>> anchors;
+    // The longest pattern, which is how far past its own range each thread has to look
+    std::size_t longest = 0;
+    // The automaton's transitions, 256 per state, as the index of the next state's first transition (with the low bit set if it ends an anchor)
+    std::vector<uint32_t> transitions;
+    // The patterns whose anchor ends at each state: outputs[outputStarts[state / 256]] until the next state's
+    std::vector<uint32_t> outputStarts;
+    std::vector<uint32_t> outputs;
+    // A bit for every pair of bytes an anchor starts with, which rules out almost every byte before walking the automaton
+    std::vector<uint64_t> startPairs;
+    // The same pairs, when there are few enough of them to compare against vectors (and no anchor is a single byte)
+    std::vector<uint16_t> vectorPairs;
+    // Patterns without any fixed bytes, which match everywhere
+    std::vector<uint32_t> unanchored;
+};
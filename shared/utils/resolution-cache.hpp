@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/// @brief A persistent uint64_t key -> (uint32_t, uint32_t) table, stored as an open addressed hash table in a file.
+/// Opening maps the file read only, so lookups of entries from a previous launch are lock-free and never copy the table.
+/// Entries recorded during this launch are kept in memory until Flush writes the merged table back out.
+/// Every file is tagged with a fingerprint, a file with a different fingerprint is ignored (and replaced on Flush),
+/// which is how stale data is invalidated.
+/// This class knows nothing about il2cpp, see il2cpp_utils::PersistentCache for that.
+class ResolutionCacheFile {
+    public:
+    struct Value {
+        uint32_t typeIndex;
+        uint32_t memberIndex;
+    };
+
+    ResolutionCacheFile() = default;
+    ResolutionCacheFile(const ResolutionCacheFile&) = delete;
+    ResolutionCacheFile& operator=(const ResolutionCacheFile&) = delete;
+    ~ResolutionCacheFile();
+
+    /// @brief Maps the cache at path, if it exists and matches the provided fingerprint.
+    /// Must be called before any other method, and only once.
+    /// @param path The path of the cache file. Its directory must exist.
+    /// @param fingerprint The fingerprint of the data the cache refers to.
+    /// @return True if an existing, valid cache was mapped. False if it was missing, corrupt, or stale.
+    bool Open(std::string_view path, uint64_t fingerprint) noexcept;
+    /// @brief Finds the value for the provided key, either from the mapped file or recorded this launch.
+    std::optional<Value> Find(uint64_t key) const noexcept;
+    /// @brief Records a value for the provided key, to be written on the next Flush.
+    void Record(uint64_t key, Value value) noexcept;
+    /// @brief Writes all mapped and recorded entries (along with any written to the file by someone else since Open) back to the file.
+    /// The new file is written to a temporary path and renamed over the old one, so readers never see a partial file.
+    /// @return True if the file was written, or if there was nothing new to write.
+    bool Flush() noexcept;
+    /// @brief Returns the number of entries that were mapped from the file.
+    std::size_t MappedCount() const noexcept;
+    /// @brief Returns the number of entries recorded this launch that are not yet flushed.
+    std::size_t PendingCount() const noexcept;
+
+    /// @brief Stable (across launches, builds and platforms) 64 bit FNV-1a hash of bytes, continuing from seed.
+    static constexpr uint64_t HashBytes(const void* data, std::size_t size, uint64_t seed = 0xcbf29ce484222325ULL) noexcept {
+        auto* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            seed ^= bytes[i];
+            seed *= 0x100000001b3ULL;
+        }
+        return seed;
+    }
+    /// @brief Stable hash of a string (including its length, so "ab" + "c" differs from "a" + "bc"), continuing from seed.
+    static uint64_t HashString(std::string_view str, uint64_t seed = 0xcbf29ce484222325ULL) noexcept {
+        uint64_t size = str.size();
+        return HashBytes(str.data(), str.size(), HashBytes(&size, sizeof(size), seed));
+    }
+    /// @brief Stable hash of a trivially copyable value, continuing from seed.
+    template<class T>
+    static uint64_t HashValue(const T& value, uint64_t seed = 0xcbf29ce484222325ULL) noexcept {
+        return HashBytes(&value, sizeof(T), seed);
+    }
+
+    private:
+    struct Header;
+    struct Entry;
+    static const Entry* EntriesOf(const Header* header) noexcept;
+    static std::optional<Value> FindIn(const Header* header, uint64_t key) noexcept;
+    static const Header* Map(const std::string& path, uint64_t fingerprint, std::size_t& mappedSize) noexcept;
+
+    std::string path;
+    uint64_t fingerprint = 0;
+    const Header* mapped = nullptr;
+    std::size_t mappedSize = 0;
+    mutable std::mutex pendingLock;
+    std::unordered_map<uint64_t, Value> pending;
+};
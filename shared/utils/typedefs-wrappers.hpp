@@ -249,7 +249,7 @@ struct SafePtr {
         // Otherwise, some other SafePtr is currently holding a reference to this instance, so keep it around.
         if (internalHandle.count() <= 1) {
             il2cpp_functions::Init();
-            if (!il2cpp_functions::GC_free) {
+            if (!il2cpp_functions::Resolve(il2cpp_functions::GC_free)) {
                 SAFE_ABORT();
             }
             il2cpp_functions::GC_free(internalHandle.__internal_get());
@@ -383,7 +383,7 @@ struct SafePtr {
     struct SafePointerWrapper {
         static SafePointerWrapper* New(T* instance) {
             il2cpp_functions::Init();
-            if (!il2cpp_functions::GarbageCollector_AllocateFixed) {
+            if (!il2cpp_functions::Resolve(il2cpp_functions::GarbageCollector_AllocateFixed)) {
                 #if __has_feature(cxx_exceptions)
                 throw CreatedTooEarlyException();
                 #else
@@ -140,7 +140,12 @@ typedef enum Il2CppDecimalCompareResult
 // self-typedef'd in il2cpp-api-types.h
 struct Il2CppException : public System::Exception {};
 
-// TODO: Il2CppExceptionWrapper?
+// Thrown by il2cpp when a managed exception escapes a method that was called directly through its methodPointer.
+// This must match libil2cpp's definition exactly (name and layout) so that catch clauses in our code match what il2cpp throws.
+struct Il2CppExceptionWrapper {
+    Il2CppException* ex;
+    Il2CppExceptionWrapper(Il2CppException* ex_) : ex(ex_) {}
+};
 
 #include "System/IOAsyncResult.hpp"
 typedef System::IOAsyncResult Il2CppIOAsyncResult;
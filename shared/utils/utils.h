@@ -18,6 +18,8 @@ namespace std {
 #endif
 #include <thread>
 #include <optional>
+#include <span>
+#include <vector>
 #include "hook-tracker.hpp"
 
 // For use in SAFE_ABORT/CRASH_UNLESS (& RET_UNLESS if possible)
@@ -276,6 +278,11 @@ void tabs(std::ostream& os, int tabs, int spacesPerTab = 2);
 // Logs the given stringstream and clears it.
 void print(std::stringstream& ss, Logging::Level lvl = Logging::INFO);
 
+/// @brief findUniquePatternInLibil2cpp for several patterns at once, in a single (multithreaded) pass over libil2cpp.so.
+/// Returns the first match of each pattern (or 0), and sets multiple[i] iff patterns[i] matched more than once.
+/// labels, if given, has a label for each pattern.
+std::vector<uintptr_t> findUniquePatternsInLibil2cpp(std::vector<bool>& multiple, std::span<const char* const> patterns, std::span<const char* const> labels = {});
+
 extern "C" {
 #endif /* __cplusplus */
 
@@ -290,6 +297,7 @@ uintptr_t getRealOffset(const void* offset);
 uintptr_t baseAddr(const char* soname);
 
 // Only wildcard is ? and ?? - both are handled the same way. They will skip exactly 1 byte (2 hex digits)
+// Parses the pattern on every call: to scan for the same pattern more than once, use CompiledPattern (pattern-scanner.hpp).
 uintptr_t findPattern(uintptr_t dwAddress, const char* pattern, uintptr_t dwSearchRangeLen = 0x1000000);
 // Same as findPattern but will continue scanning to make sure your pattern is sufficiently specific.
 // Each candidate will be logged. label should describe what you're looking for, like "Class::Init".
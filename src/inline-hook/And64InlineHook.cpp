@@ -33,6 +33,9 @@
 #include <android/log.h>
 #include <errno.h>
 #include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
 #include "../../shared/utils/logging.hpp"
 #ifdef __aarch64__
 
@@ -478,37 +481,162 @@ extern "C" {
 
     //-------------------------------------------------------------------------
 
-    static __attribute((aligned(__page_size))) uint32_t __insns_pool[A64_MAX_BACKUPS][A64_MAX_INSTRUCTIONS * 10];
+    // Trampolines are carved out of RWX slabs that are mapped on demand, as close to the hooked function as possible,
+    // so that the jump back from the trampoline can usually be a single "B" instead of LDR X17/BR X17.
+    // Free slots of each slab are kept in an intrusive list (the first 8 bytes of a free slot point to the next one).
+    static constexpr uintptr_t __slot_size  = A64_MAX_INSTRUCTIONS * 10 * sizeof(uint32_t);
+    static constexpr uintptr_t __slab_size  = 16 * __page_size;
+    static constexpr int64_t   __near_range = 128 * 1024 * 1024; // reach of "B"
+    static_assert(__slot_size % 8 == 0, "8-byte align");
+    static_assert(A64_TRAMPOLINE_SIZE == A64_MAX_INSTRUCTIONS * 10u, "please fix A64_TRAMPOLINE_SIZE!");
 
-    //-------------------------------------------------------------------------
-
-    class A64HookInit
+    struct slab
     {
-    public:
-        A64HookInit()
-        {
-            __make_rwx(__insns_pool, sizeof(__insns_pool));
-            A64_LOGI("insns pool initialized.");
-        }
+        slab     *next;
+        uintptr_t base;
+        void     *free_list;
+        uintptr_t used;      // number of slots in use
+        uintptr_t untouched; // slots at the end that were never handed out
     };
-    static A64HookInit __init;
+    static slab       *__slabs = NULL;
+    static std::mutex  __slabs_lock;
 
-    //-------------------------------------------------------------------------
+    static inline bool __is_near(const uintptr_t base, const void *target)
+    {
+        if (target == NULL) return true;
+        auto t = static_cast<int64_t>(__uintval(target));
+        return llabs(static_cast<int64_t>(base) - t) < __near_range - static_cast<int64_t>(__slab_size) &&
+               llabs(static_cast<int64_t>(base + __slab_size) - t) < __near_range;
+    }
+
+    static void *__map_near(const uintptr_t hint, const void *target)
+    {
+        void *p = ::mmap(__ptr(hint), __slab_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED || __is_near(__uintval(p), target)) return p;
+        ::munmap(p, __slab_size);
+        return MAP_FAILED;
+    }
 
-    static uint32_t *FastAllocateTrampoline()
+    static slab *__map_slab(const void *target)
     {
-        static_assert((A64_MAX_INSTRUCTIONS * 10 * sizeof(uint32_t)) % 8 == 0, "8-byte align");
-        static volatile int32_t __index = -1;
+        void *mem = MAP_FAILED;
+        if (target != NULL) {
+            // Grow next to a full slab that is already near the target, so slabs for one library stay packed together.
+            for (auto s = __slabs; s != NULL && mem == MAP_FAILED; s = s->next) {
+                if (!__is_near(s->base, target)) continue;
+                mem = __map_near(s->base + __slab_size, target);
+                if (mem == MAP_FAILED) mem = __map_near(s->base - __slab_size, target);
+            } //for
+            // Otherwise try hints on both sides of the target, moving further away, until the kernel gives us one in range.
+            for (int64_t distance = 1 << 20; distance < __near_range / 2 && mem == MAP_FAILED; distance <<= 1) {
+                for (int64_t sign : {-1, 1}) {
+                    mem = __map_near(__align_down(static_cast<uintptr_t>(__intval(target) + sign * distance), __page_size), target);
+                    if (mem != MAP_FAILED) break;
+                } //for
+            } //for
+        } //if
+        if (mem == MAP_FAILED) {
+            mem = ::mmap(NULL, __slab_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) {
+                A64_LOGE("mmap failed with errno = %d, size = %zu", errno, static_cast<size_t>(__slab_size));
+                return NULL;
+            } //if
+        } //if
+        auto s       = new slab;
+        s->base      = __uintval(mem);
+        s->free_list = NULL;
+        s->used      = 0;
+        s->untouched = __slab_size / __slot_size;
+        s->next      = __slabs;
+        __slabs      = s;
+        A64_LOGI("mapped trampoline slab at %p for target %p", mem, target);
+        return s;
+    }
+
+    static uint32_t *__take_slot(slab *s)
+    {
+        void *slot = s->free_list;
+        if (slot != NULL) {
+            s->free_list = *static_cast<void **>(slot);
+        } else if (s->untouched > 0) {
+            slot = __ptr(s->base + (__slab_size / __slot_size - s->untouched) * __slot_size);
+            --s->untouched;
+        } else {
+            return NULL;
+        } //if
+        ++s->used;
+        return static_cast<uint32_t *>(slot);
+    }
 
-        int32_t i = __atomic_increase(&__index);
-        if (__predict_true(i >= 0 && i < __countof(__insns_pool))) {
-            return __insns_pool[i];
+    static uint32_t *FastAllocateTrampoline(const void *target)
+    {
+        std::lock_guard<std::mutex> lock(__slabs_lock);
+        slab *fallback = NULL;
+        for (auto s = __slabs; s != NULL; s = s->next) {
+            if (s->free_list == NULL && s->untouched == 0) continue;
+            if (__is_near(s->base, target)) return __take_slot(s);
+            if (fallback == NULL) fallback = s;
+        } //for
+        // Prefer a new slab near the target over a free slot far away, but never fail while any slot is free
+        auto s = __map_slab(target);
+        if (s != NULL && (fallback == NULL || __is_near(s->base, target))) return __take_slot(s);
+        if (s != NULL) {
+            // __map_slab pushed it to the front, take it back out
+            __slabs = s->next;
+            ::munmap(__ptr(s->base), __slab_size);
+            delete s;
         } //if
+        if (fallback != NULL) return __take_slot(fallback);
 
         A64_LOGE("failed to allocate trampoline!");
         return NULL;
     }
 
+    A64_JNIEXPORT void A64FreeTrampoline(void *const trampoline)
+    {
+        if (trampoline == NULL) return;
+        std::lock_guard<std::mutex> lock(__slabs_lock);
+        for (auto prev = &__slabs; *prev != NULL; prev = &(*prev)->next) {
+            auto s = *prev;
+            if (__uintval(trampoline) < s->base || __uintval(trampoline) >= s->base + __slab_size) continue;
+            *static_cast<void **>(trampoline) = s->free_list;
+            s->free_list = trampoline;
+            if (--s->used == 0) {
+                // Nothing references this slab anymore
+                *prev = s->next;
+                ::munmap(__ptr(s->base), __slab_size);
+                delete s;
+            } //if
+            return;
+        } //for
+        A64_LOGE("freeing trampoline %p that was not allocated here!", trampoline);
+    }
+
+    //-------------------------------------------------------------------------
+
+    A64_JNIEXPORT void *A64AllocateTrampoline(const void *const near)
+    {
+        return FastAllocateTrampoline(near);
+    }
+
+    A64_JNIEXPORT void *A64CreateDispatchStub(const void *const near, void *const destination)
+    {
+        auto stub = FastAllocateTrampoline(near);
+        if (stub == NULL) return NULL;
+        // Slots are 8-byte aligned, so the literal at stub + 2 is too, and can be swapped atomically
+        stub[0] = 0x58000051u; // LDR X17, #0x8
+        stub[1] = 0xd61f0220u; // BR X17
+        *reinterpret_cast<void **>(stub + 2) = destination;
+        __flush_cache(stub, 4 * sizeof(uint32_t));
+        return stub;
+    }
+
+    A64_JNIEXPORT void A64SetDispatchTarget(void *const stub, void *const destination)
+    {
+        // The destination is loaded as data, so changing it needs no instruction cache maintenance
+        __atomic_store_n(reinterpret_cast<void **>(static_cast<uint32_t *>(stub) + 2), destination, __ATOMIC_RELEASE);
+    }
+
     //-------------------------------------------------------------------------
 
     A64_JNIEXPORT void *A64HookFunctionV(void *const symbol, void *const replace,
@@ -574,20 +702,214 @@ extern "C" {
 
     //-------------------------------------------------------------------------
 
+    A64_JNIEXPORT int A64RestoreFunction(void *const symbol, const void *const replace, const uint32_t backup)
+    {
+        static constexpr uint_fast64_t mask = 0x03ffffffu;
+
+        auto original = static_cast<uint32_t *>(symbol);
+        auto pc_offset = static_cast<int64_t>(__intval(replace) - __intval(symbol)) >> 2;
+        if (llabs(pc_offset) >= (mask >> 1)) return 0; // the LDR X17/BR X17 form spans several instructions
+
+        if (__make_rwx(original, 1 * sizeof(uint32_t)) != 0) {
+            A64_LOGE("mprotect failed with errno = %d, p = %p, size = %zu",
+                     errno, original, 1 * sizeof(uint32_t));
+            return 0;
+        } //if
+        // Only undo our own patch: if someone else has hooked over it since, their hook must keep working
+        if (!__sync_cmpswap(original, static_cast<uint32_t>(0x14000000u | (pc_offset & mask)), backup)) return 0;
+        __flush_cache(symbol, 1 * sizeof(uint32_t));
+
+        A64_LOGI("inline hook %p->%p removed!", symbol, replace);
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+
+    A64_JNIEXPORT int A64ReapplyFunction(void *const symbol, const void *const replace, const uint32_t backup)
+    {
+        static constexpr uint_fast64_t mask = 0x03ffffffu;
+
+        auto original = static_cast<uint32_t *>(symbol);
+        auto pc_offset = static_cast<int64_t>(__intval(replace) - __intval(symbol)) >> 2;
+        if (llabs(pc_offset) >= (mask >> 1)) return 0;
+
+        if (__make_rwx(original, 1 * sizeof(uint32_t)) != 0) {
+            A64_LOGE("mprotect failed with errno = %d, p = %p, size = %zu",
+                     errno, original, 1 * sizeof(uint32_t));
+            return 0;
+        } //if
+        // The trampoline relocated backup, so it is only still valid if nothing has changed the instruction since
+        if (!__sync_cmpswap(original, backup, static_cast<uint32_t>(0x14000000u | (pc_offset & mask)))) return 0;
+        __flush_cache(symbol, 1 * sizeof(uint32_t));
+
+        A64_LOGI("inline hook %p->%p reapplied!", symbol, replace);
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+
     A64_JNIEXPORT void A64HookFunction(void *const symbol, void *const replace, void **result)
     {
         void *trampoline = NULL;
         if (result != NULL) {
-            trampoline = FastAllocateTrampoline();
+            trampoline = FastAllocateTrampoline(symbol);
             *result = trampoline;
             if (trampoline == NULL) return;
         } //if
 
-        trampoline = A64HookFunctionV(symbol, replace, trampoline, A64_MAX_INSTRUCTIONS * 10u);
-        if (trampoline == NULL && result != NULL) {
+        void *hooked = A64HookFunctionV(symbol, replace, trampoline, A64_TRAMPOLINE_SIZE);
+        if (hooked == NULL && result != NULL) {
+            A64FreeTrampoline(trampoline);
             *result = NULL;
         } //if
     }
+
+    //-------------------------------------------------------------------------
+
+    A64_JNIEXPORT size_t A64HookFunctionBatch(A64HookRequest *const requests, const size_t count, size_t *const pages)
+    {
+        static constexpr uint_fast64_t mask = 0x03ffffffu; // 0b00000011111111111111111111111111
+
+        struct patch
+        {
+            uint32_t *start;
+            uint32_t *end;
+            size_t    index;
+            bool      far; // needs LDR X17/BR X17 instead of B
+            bool      deferred;
+            bool      failed;
+        };
+        std::vector<patch> patches;
+        patches.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            auto original  = static_cast<uint32_t *>(requests[i].symbol);
+            auto pc_offset = static_cast<int64_t>(__intval(requests[i].replace) - __intval(original)) >> 2;
+            bool far       = llabs(pc_offset) >= (mask >> 1);
+            int32_t words  = far ? ((reinterpret_cast<uint64_t>(original + 2) & 7u) != 0u ? 5 : 4) : 1;
+            patches.push_back({original, original + words, i, far, false, false});
+        } //for
+
+        // Hooks whose bytes overlap an earlier hook in the batch (including a second hook on the same symbol) must see that
+        // hook's patch when building their trampoline, so they are installed one at a time afterwards, in order.
+        std::sort(patches.begin(), patches.end(), [](const patch &a, const patch &b) {
+            return a.start < b.start || (a.start == b.start && a.index < b.index);
+        });
+        uint32_t *furthest = NULL;
+        patch    *owner    = NULL;
+        for (auto &p : patches) {
+            if (owner != NULL && p.start < furthest) {
+                if (p.index < owner->index) {
+                    owner->deferred = true;
+                    owner = &p;
+                } else {
+                    p.deferred = true;
+                } //if
+                furthest = std::max(furthest, p.end);
+                continue;
+            } //if
+            owner    = &p;
+            furthest = p.end;
+        } //for
+
+        // Build every trampoline from the untouched original instructions before anything is patched
+        for (auto &p : patches) {
+            if (p.deferred) continue;
+            auto &req = requests[p.index];
+            if (req.result == NULL) {
+                A64FreeTrampoline(req.trampoline);
+                continue;
+            } //if
+            auto trampoline = req.trampoline != NULL ? static_cast<uint32_t *>(req.trampoline) : FastAllocateTrampoline(p.start);
+            *req.result = trampoline;
+            if (trampoline == NULL) {
+                p.failed = true;
+                continue;
+            } //if
+            __fix_instructions(p.start, static_cast<int32_t>(p.end - p.start), trampoline);
+        } //for
+
+        // Walk runs of patches on contiguous pages: one mprotect, all writes, one flush per run
+        size_t installed = 0, page_count = 0;
+        for (size_t run_begin = 0; run_begin < patches.size();) {
+            uintptr_t run_start = 0, run_end = 0;
+            size_t    run_stop  = run_begin;
+            uint32_t *lowest    = NULL, *highest = NULL;
+            for (; run_stop < patches.size(); ++run_stop) {
+                auto &p = patches[run_stop];
+                if (p.deferred || p.failed) continue;
+                auto page_start = __align_down(__uintval(p.start), __page_size);
+                auto page_end   = __page_align(__uintval(p.end));
+                if (lowest != NULL && page_start > run_end) break;
+                if (lowest == NULL) {
+                    run_start = page_start;
+                    lowest    = p.start;
+                } //if
+                run_end = std::max(run_end, page_end);
+                highest = std::max(highest, p.end);
+            } //for
+            if (lowest == NULL) break;
+
+            if (::mprotect(__ptr(run_start), run_end - run_start, PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+                A64_LOGE("mprotect failed with errno = %d, p = %p, size = %zu",
+                         errno, __ptr(run_start), static_cast<size_t>(run_end - run_start));
+                for (size_t i = run_begin; i < run_stop; ++i) {
+                    if (!patches[i].deferred) patches[i].failed = true;
+                } //for
+                run_begin = run_stop;
+                continue;
+            } //if
+            page_count += (run_end - run_start) / __page_size;
+
+            for (size_t i = run_begin; i < run_stop; ++i) {
+                auto &p = patches[i];
+                if (p.deferred || p.failed) continue;
+                auto original = p.start;
+                auto replace  = requests[p.index].replace;
+                if (p.far) {
+                    if (p.end - p.start == 5) {
+                        original[0] = A64_NOP;
+                        ++original;
+                    } //if
+                    original[0] = 0x58000051u; // LDR X17, #0x8
+                    original[1] = 0xd61f0220u; // BR X17
+                    *reinterpret_cast<int64_t *>(original + 2) = __intval(replace);
+                } else {
+                    auto pc_offset = static_cast<int64_t>(__intval(replace) - __intval(original)) >> 2;
+                    __sync_cmpswap(original, *original, 0x14000000u | (pc_offset & mask)); // "B" ADDR_PCREL26
+                } //if
+                ++installed;
+            } //for
+            __flush_cache(lowest, (highest - lowest) * sizeof(uint32_t));
+            run_begin = run_stop;
+        } //for
+
+        for (auto &p : patches) {
+            if (p.failed && requests[p.index].result != NULL) {
+                A64FreeTrampoline(*requests[p.index].result);
+                *requests[p.index].result = NULL;
+            } //if
+        } //for
+
+        // Install the overlapping hooks in their original order
+        std::sort(patches.begin(), patches.end(), [](const patch &a, const patch &b) { return a.index < b.index; });
+        for (auto &p : patches) {
+            if (!p.deferred) continue;
+            auto &req = requests[p.index];
+            if (req.trampoline != NULL && req.result != NULL) {
+                *req.result = A64HookFunctionV(req.symbol, req.replace, req.trampoline, A64_TRAMPOLINE_SIZE);
+                if (*req.result == NULL) A64FreeTrampoline(req.trampoline);
+            } else {
+                A64FreeTrampoline(req.trampoline);
+                A64HookFunction(req.symbol, req.replace, req.result);
+            } //if
+            if (req.result == NULL || *req.result != NULL) ++installed;
+            page_count += 1;
+        } //for
+
+        if (pages != NULL) *pages = page_count;
+        A64_LOGI("batch hooked %zu/%zu functions, touching %zu pages", installed, count, page_count);
+        return installed;
+    }
 }
 
 #endif // defined(__aarch64__)
\ No newline at end of file
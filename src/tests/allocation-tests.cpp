@@ -0,0 +1,61 @@
+#ifdef TEST_ALLOCATIONS
+#include "../../shared/utils/il2cpp-utils.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Must be ran in game, after il2cpp has been initialized.
+// Replaces the global allocator with one that counts allocations, then ensures that a type checked RunMethod/New
+// does not allocate anything on the C++ heap once its statics are initialized.
+
+static std::atomic_size_t allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (auto* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+template<class F>
+static std::size_t countAllocations(F&& func) {
+    auto before = allocationCount.load(std::memory_order_relaxed);
+    func();
+    return allocationCount.load(std::memory_order_relaxed) - before;
+}
+
+static void test() {
+    auto* intType = &classof(int)->byval_arg;
+    auto* abs = il2cpp_utils::FindMethod("System", "Math", "Abs", std::vector<Il2CppClass*>{}, std::vector<const Il2CppType*>{intType});
+    auto* compare = il2cpp_utils::FindMethodUnsafe("System", "Math", "Max", 2);
+    int arg = -5;
+    auto runAbs = [&]() {
+        auto res = il2cpp_utils::RunMethod<int>(static_cast<Il2CppClass*>(nullptr), abs, arg);
+        assert(res && *res == 5);
+    };
+    auto runMax = [&]() {
+        auto res = il2cpp_utils::RunMethod<int, false>(static_cast<Il2CppClass*>(nullptr), compare, arg, 3);
+        assert(res && *res == 3);
+    };
+    // Warm up function statics (loggers, type lookups)
+    runAbs();
+    runMax();
+    assert(countAllocations(runAbs) == 0);
+    assert(countAllocations(runMax) == 0);
+    auto types = il2cpp_utils::ExtractTypes(arg, 3, 4.0f);
+    assert(countAllocations([&]() { types = il2cpp_utils::ExtractTypes(arg, 3, 4.0f); }) == 0);
+    assert(il2cpp_utils::ExtractedAllTypes(types));
+    auto values = il2cpp_utils::ExtractValues(arg);
+    assert(countAllocations([&]() { values = il2cpp_utils::ExtractValues(arg); }) == 0);
+    assert(values[0] == &arg);
+}
+#endif
@@ -0,0 +1,167 @@
+#ifdef TEST_ASSEMBLY_FUNCTION
+#include "../../shared/utils/instruction-parsing.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Builds the control flow graph of a small hand-assembled function with a switch in it, then compares ExtractAddress over a synthetic
+// 256KB function each time against answering it from the cached AssemblyFunction.
+// Build with -DBS_HOOK_MIN_LOG_LEVEL=ANDROID_LOG_INFO to time decoding rather than the debug log of every instruction.
+
+static constexpr std::size_t kInstructions = 64 * 1024;
+// In the library itself, so that dladdr finds a base for it
+static int32_t code[kInstructions];
+static uint32_t table[4];
+static const void* slot;
+
+static int32_t offsetTo(const void* from, const void* to, int bits) {
+    auto words = (reinterpret_cast<intptr_t>(to) - reinterpret_cast<intptr_t>(from)) / 4;
+    return static_cast<int32_t>(words & ((1 << bits) - 1));
+}
+static int32_t b(const int32_t* from, const void* to) {
+    return 0x14000000 | offsetTo(from, to, 26);
+}
+static int32_t bl(const int32_t* from, const void* to) {
+    return (int32_t)0x94000000 | offsetTo(from, to, 26);
+}
+static int32_t bcond(const int32_t* from, const void* to, int cond) {
+    return 0x54000000 | (offsetTo(from, to, 19) << 5) | cond;
+}
+static int32_t cbz(const int32_t* from, const void* to, int rt) {
+    return 0x34000000 | (offsetTo(from, to, 19) << 5) | rt;
+}
+static int32_t adrp(const int32_t* from, const void* to, int rd) {
+    auto pages = (static_cast<intptr_t>(reinterpret_cast<uintptr_t>(to) >> 12) - static_cast<intptr_t>(reinterpret_cast<uintptr_t>(from) >> 12));
+    return (int32_t)0x90000000 | static_cast<int32_t>((pages & 3) << 29) | static_cast<int32_t>(((pages >> 2) & 0x7FFFF) << 5) | rd;
+}
+static int32_t lo12(const void* to) {
+    return reinterpret_cast<uintptr_t>(to) & 0xFFF;
+}
+
+// A switch over 4 cases (one of them a tail call), whose blocks all end up calling through slot
+static const int32_t* assemble(int32_t* at) {
+    auto f = at + 4;  // so that the tail call to at jumps to before the entry
+    f[0] = 0x71000C1F;  // cmp w0, #3
+    f[1] = bcond(f + 1, f + 12, 0b1000);  // b.hi default
+    f[2] = adrp(f + 2, table, 9);  // adrp x9, table
+    f[3] = 0x91000129 | (lo12(table) << 10);  // add x9, x9, :lo12:table
+    f[4] = (int32_t)0xB8A0592A;  // ldrsw x10, [x9, w0, uxtw #2]
+    f[5] = (int32_t)0x8B0A0129;  // add x9, x9, x10
+    f[6] = (int32_t)0xD61F0120;  // br x9
+    f[7] = 0x52800020;  // case 0: mov w0, #1
+    f[8] = b(f + 8, f + 13);
+    f[9] = 0x52800040;  // case 1: mov w0, #2
+    f[10] = cbz(f + 10, f + 12, 0);  // case 2
+    f[11] = b(f + 11, at);  // case 3: tail call
+    f[12] = 0x52800000;  // default: mov w0, #0
+    f[13] = adrp(f + 13, &slot, 8);  // adrp x8, slot
+    f[14] = (int32_t)0xF9400108 | ((lo12(&slot) / 8) << 10);  // ldr x8, [x8, :lo12:slot]
+    f[15] = (int32_t)0xD63F0100;  // blr x8
+    f[16] = (int32_t)0xD65F03C0;  // ret
+    // The next function, which a linear search can go on to
+    f[17] = bl(f + 17, at);
+    f[18] = (int32_t)0xD65F03C0;  // ret
+    int cases[] = {7, 9, 10, 11};
+    for (std::size_t i = 0; i < std::size(cases); i++) {
+        table[i] = static_cast<uint32_t>(reinterpret_cast<intptr_t>(f + cases[i]) - reinterpret_cast<intptr_t>(table));
+    }
+    return f;
+}
+
+static void checkGraph() {
+    auto f = assemble(code);
+    AssemblyFunction function(f);
+    std::vector<std::pair<std::ptrdiff_t, std::vector<std::ptrdiff_t>>> expected = {
+        {0, {2, 12}}, {2, {7, 9, 10, 11}}, {7, {13}}, {9, {10}}, {10, {11, 12}}, {11, {}}, {12, {13}}, {13, {}},
+    };
+    auto blocks = function.Blocks();
+    assert(blocks.size() == expected.size());
+    for (std::size_t i = 0; i < blocks.size(); i++) {
+        assert(blocks[i].start == f + expected[i].first);
+        std::vector<std::ptrdiff_t> successors;
+        for (auto successor : blocks[i].successors) successors.push_back(blocks[successor].start - f);
+        assert(successors == expected[i].second);
+        for (auto successor : blocks[i].successors) {
+            auto& predecessors = blocks[successor].predecessors;
+            assert(std::find(predecessors.begin(), predecessors.end(), i) != predecessors.end());
+        }
+    }
+    assert(function.BlockAt(f + 5) == &blocks[1] && !function.BlockAt(f + 17) && !function.BlockAt(code));
+    assert(function.Instructions().size() == 17);
+    assert(function.Calls().size() == 1 && function.Calls()[0] == f + 15);
+    assert(function.TailCalls().size() == 1 && function.TailCalls()[0] == f + 11);
+    assert(function.Switches().size() == 1 && function.Switches()[0].table == table);
+    assert(function.Switches()[0].targets == std::vector<const int32_t*>({f + 7, f + 9, f + 10, f + 11}));
+
+    // Definitions, within a block and through the only predecessor, but not where two blocks meet
+    auto load = function.FindDefinition(f + 15, 8);
+    assert(load && load->addr == f + 14);
+    auto page = function.FindDefinition(load->addr, 8);
+    assert(page && page->addr == f + 13);
+    auto offset = function.FindDefinition(f + 7, 10);
+    assert(offset && offset->addr == f + 4);
+    assert(!function.FindDefinition(f + 13, 0));
+
+    // The same answers as searching linearly, including past the ret
+    assert(function.ExtractAddress(1, 1) == reinterpret_cast<intptr_t>(table));
+    assert(function.ExtractAddress(2, 1) == reinterpret_cast<intptr_t>(&slot));
+    for (std::size_t i = 0; i < function.Switches()[0].targets.size(); i++) {
+        auto target = function.EvalSwitch(1, 1, i + 1);
+        assert(target && target->addr == function.Switches()[0].targets[i]);
+    }
+    auto call = function.FindNthEncoded(f, 2, std::mem_fn(&EncodedInstruction::isCall), 1);
+    auto linearCall = InstructionRange(f).findNthCall(2, 1);
+    assert(call && linearCall && call->addr == linearCall->addr && call->addr == f + 17);
+    assert(!function.FindNthEncoded(f, 2, std::mem_fn(&EncodedInstruction::isCall)));
+
+    // Only built once
+    assert(AssemblyFunction::Get(f) == AssemblyFunction::Get(f));
+}
+
+static void benchmark() {
+    checkGraph();
+
+    // One adrp and add in every 16 instructions, which are all reachable
+    for (std::size_t i = 0; i + 16 <= kInstructions; i += 16) {
+        auto f = code + i;
+        int32_t body[] = {
+            (int32_t)0xa9bf7bfd, (int32_t)0x910003fd, adrp(f + 2, &slot, 16), (int32_t)0x91000210 | (lo12(&slot) << 10),  // add x16, x16, :lo12:slot
+            (int32_t)0xf9400420, (int32_t)0xaa0103e0, bl(f + 6, code), (int32_t)0xeb01001f,
+            bcond(f + 8, f + 10, 0b0001), (int32_t)0xf9000020, (int32_t)0xb9400000, (int32_t)0x2a0103e0,
+            (int32_t)0xd503201f, (int32_t)0xd63f0200, cbz(f + 14, f + 16, 0), (int32_t)0xd503201f,
+        };
+        std::copy(std::begin(body), std::end(body), f);
+    }
+    code[kInstructions - 2] = cbz(code + kInstructions - 2, code + kInstructions - 1, 0);
+    code[kInstructions - 1] = (int32_t)0xd65f03c0;  // ret
+    AssemblyFunction::ClearCache();
+    // Init's pattern: several ExtractAddresses against the same function, here spread out over all of it
+    constexpr int kQueries = 16;
+    constexpr int kAdrps = kInstructions / 16;
+
+    auto before = std::chrono::steady_clock::now();
+    intptr_t linear = 0;
+    for (int i = 1; i <= kQueries; i++) linear += ExtractAddress(code, i * kAdrps / kQueries, 1);
+    auto linearTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    auto function = AssemblyFunction::Get(code);
+    auto buildTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    intptr_t cached = 0;
+    for (int i = 1; i <= kQueries; i++) cached += AssemblyFunction::Get(code)->ExtractAddress(i * kAdrps / kQueries, 1);
+    auto cachedTime = std::chrono::steady_clock::now() - before;
+
+    assert(linear == cached && function->Blocks().size() > 1 && function->Instructions().size() == kInstructions);
+    assert(function->Calls().size() == kInstructions / 16 * 2);
+
+    auto ms = [](auto duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    std::cout << kQueries << " ExtractAddress, each searching linearly: " << ms(linearTime) << " ms" << std::endl;
+    std::cout << "Building the AssemblyFunction (" << function->Blocks().size() << " blocks): " << ms(buildTime) << " ms" << std::endl;
+    std::cout << kQueries << " ExtractAddress from the cached AssemblyFunction: " << ms(cachedTime) << " ms" << std::endl;
+}
+#endif
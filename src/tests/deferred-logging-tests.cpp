@@ -0,0 +1,64 @@
+#ifdef TEST_DEFERRED_LOGGING
+#include "../../shared/utils/binary-log.hpp"
+#include "../../shared/utils/utils-functions.h"
+#include <cassert>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Compares what a logging call costs its caller today (formatting the line) against a deferred logger (capturing the arguments).
+
+static constexpr int kCalls = 100000;
+
+static std::string formatNow(const char* fmt, ...) {
+    va_list lst;
+    va_start(lst, fmt);
+    auto str = string_vformat(fmt, lst);
+    va_end(lst);
+    return str;
+}
+
+static std::size_t capture(char* out, const char* fmt, ...) {
+    va_list lst;
+    va_start(lst, fmt);
+    auto size = Logging::BinaryLog::ArgsSize(fmt, lst);
+    Logging::BinaryLog::CaptureArgs(fmt, lst, out);
+    va_end(lst);
+    return size;
+}
+
+static void checkRoundTrip(const char* expected, const char* fmt, std::size_t size, const char* args) {
+    std::string formatted;
+    Logging::BinaryLog::Format(fmt, std::span<const char>(args, size), formatted);
+    assert(formatted == expected);
+}
+
+static void benchmark() {
+    static constexpr const char* fmt = "Hooked %s at %p (offset %zx), %d of %u hooks, %.2f ms";
+    char args[256];
+    char expected[256];
+    auto size = capture(args, fmt, "SomeMethod", reinterpret_cast<void*>(0x7000001234), std::size_t(0x1234), -3, 17u, 1.25);
+    snprintf(expected, sizeof(expected), fmt, "SomeMethod", reinterpret_cast<void*>(0x7000001234), std::size_t(0x1234), -3, 17u, 1.25);
+    checkRoundTrip(expected, fmt, size, args);
+    static constexpr const char* starFmt = "%-*.*s|%hhd|%5c|%%|%lld";
+    size = capture(args, starFmt, 8, 3, "abcdef", 300, 'x', -1ll);
+    snprintf(expected, sizeof(expected), starFmt, 8, 3, "abcdef", 300, 'x', -1ll);
+    checkRoundTrip(expected, starFmt, size, args);
+
+    std::size_t sink = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kCalls; i++) {
+        sink += formatNow(fmt, "SomeMethod", reinterpret_cast<void*>(0x7000001234), std::size_t(i), i, 17u, 1.25).size();
+    }
+    auto formatNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / kCalls;
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kCalls; i++) {
+        sink += capture(args, fmt, "SomeMethod", reinterpret_cast<void*>(0x7000001234), std::size_t(i), i, 17u, 1.25);
+    }
+    auto captureNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / kCalls;
+    assert(sink > 0);
+    std::cout << "logging call site: " << formatNs << " ns formatting, " << captureNs << " ns capturing" << std::endl;
+}
+#endif
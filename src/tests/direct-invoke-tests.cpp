@@ -0,0 +1,92 @@
+#ifdef TEST_DIRECT_INVOKE
+#include "../../shared/utils/il2cpp-utils.hpp"
+#include <chrono>
+
+// Must be ran in game, after il2cpp has been initialized.
+// Compares RunMethod (runtime_invoke) against RunMethodDirect/InvokeDirect (methodPointer) for 0, 1, 4 and 8 arguments.
+// Also checks that a boxed value type instance reaches the value type's methods as its data.
+
+static constexpr int kIterations = 100000;
+
+struct TimeSpanValue {
+    int64_t ticks;
+};
+struct DateTimeValue {
+    uint64_t dateData;
+};
+
+template<class F>
+static double nsPerCall(F&& func) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kIterations; i++) {
+        func(i);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / kIterations;
+}
+
+static void benchmark() {
+    static auto logger = getLogger().WithContext("DirectInvokeBenchmark");
+    auto* intType = &classof(int)->byval_arg;
+    auto* kindType = &il2cpp_utils::GetClassFromName("System", "DateTimeKind")->byval_arg;
+    // 0 args, static
+    auto* tickCount = il2cpp_utils::FindMethodUnsafe("System", "Environment", "get_TickCount", 0);
+    // 1 arg, static
+    auto* abs = il2cpp_utils::FindMethod("System", "Math", "Abs", std::vector<Il2CppClass*>{}, std::vector<const Il2CppType*>{intType});
+    // 4 args, value type instance
+    auto* timeSpanCtor = il2cpp_utils::FindMethodUnsafe("System", "TimeSpan", ".ctor", 4);
+    // 8 args, value type instance
+    auto* dateTimeCtor = il2cpp_utils::FindMethod("System", "DateTime", ".ctor", std::vector<Il2CppClass*>{},
+        std::vector<const Il2CppType*>{intType, intType, intType, intType, intType, intType, intType, kindType});
+
+    auto invoke0 = nsPerCall([&](int) {
+        il2cpp_utils::RunStaticMethodUnsafe<int>(tickCount);
+    });
+    auto direct0 = nsPerCall([&](int) {
+        il2cpp_utils::RunStaticMethodDirect<int, false>(tickCount);
+    });
+    logger.info("0 args: runtime_invoke: %f ns/call, direct: %f ns/call", invoke0, direct0);
+
+    auto invoke1 = nsPerCall([&](int i) {
+        auto res = il2cpp_utils::RunStaticMethodUnsafe<int>(abs, -i);
+        assert(res && *res == i);
+    });
+    auto direct1 = nsPerCall([&](int i) {
+        auto res = il2cpp_utils::RunStaticMethodDirect<int, false>(abs, -i);
+        assert(res && *res == i);
+    });
+    logger.info("1 arg: runtime_invoke: %f ns/call, direct: %f ns/call", invoke1, direct1);
+
+    TimeSpanValue span{};
+    auto invoke4 = nsPerCall([&](int i) {
+        il2cpp_utils::RunMethodUnsafe(&span, timeSpanCtor, i, 1, 2, 3);
+    });
+    auto direct4 = nsPerCall([&](int i) {
+        il2cpp_utils::InvokeDirect<void>(timeSpanCtor, &span, nullptr, i, 1, 2, 3);
+    });
+    logger.info("4 args: runtime_invoke: %f ns/call, direct: %f ns/call", invoke4, direct4);
+
+    DateTimeValue date{};
+    auto invoke8 = nsPerCall([&](int i) {
+        il2cpp_utils::RunMethodUnsafe(&date, dateTimeCtor, 2000 + (i % 100), 1, 2, 3, 4, 5, 6, 1);
+    });
+    auto direct8 = nsPerCall([&](int i) {
+        il2cpp_utils::InvokeDirect<void>(dateTimeCtor, &date, nullptr, 2000 + (i % 100), 1, 2, 3, 4, 5, 6, 1);
+    });
+    logger.info("8 args: runtime_invoke: %f ns/call, direct: %f ns/call", invoke8, direct8);
+
+    // Int32.GetHashCode returns the value, which it reads through this
+    auto* getHashCode = il2cpp_utils::FindMethodUnsafe("System", "Int32", "GetHashCode", 0);
+    int value = 0x1234;
+    auto* boxed = il2cpp_functions::value_box(classof(int), &value);
+    auto fromBox = il2cpp_utils::RunMethodDirect<int, false>(boxed, getHashCode);
+    auto fromValue = il2cpp_utils::RunMethodDirect<int, false>(value, getHashCode);
+    auto fromInvoke = il2cpp_utils::RunMethodUnsafe<int>(boxed, getHashCode);
+    assert(fromBox && *fromBox == value);
+    assert(fromValue && *fromValue == value);
+    assert(fromInvoke && *fromInvoke == value);
+    (void)fromBox;
+    (void)fromValue;
+    (void)fromInvoke;
+}
+#endif
@@ -0,0 +1,71 @@
+#ifdef TEST_HOOK_MULTIPLEXER
+#include "../../shared/utils/hook-multiplexer.hpp"
+#include "../../shared/utils/hook-epoch.hpp"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Hooks and unhooks a function over and over while other threads keep calling it, the way a diagnostic hook is toggled
+// at runtime. Every call must run either the original or the hook, never a stub or trampoline that has gone away.
+
+static constexpr int kThreads = 4;
+static constexpr int kToggles = 2000;
+
+#ifdef __aarch64__
+__attribute__((noinline)) static int target(int x) {
+    asm volatile("");
+    return x + 1;
+}
+
+static int (*orig)(int) = nullptr;
+static int hooked(int x) {
+    HookEpoch::Guard guard;
+    return orig(x) + 100;
+}
+
+static void benchmark() {
+    // Called through a volatile pointer, so that the calls are not inlined or folded
+    static int (*volatile call)(int) = &target;
+    std::atomic_bool stop = false;
+    std::atomic<uint64_t> calls = 0;
+    std::atomic<uint64_t> wrong = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+        threads.emplace_back([&]() {
+            uint64_t count = 0;
+            for (int x = 0; !stop.load(std::memory_order_relaxed); x = (x + 1) & 0xFFFF, count++) {
+                auto result = call(x);
+                if (result != x + 1 && result != x + 101) wrong.fetch_add(1, std::memory_order_relaxed);
+            }
+            calls.fetch_add(count, std::memory_order_relaxed);
+        });
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kToggles; i++) {
+        bool added = HookMultiplexer::Add({"hooked", (void*) &target, (void*) &hooked, (void**) &orig, 0});
+        assert(added);
+        assert(call(1) == 102);
+        bool removed = HookMultiplexer::Remove((void*) &target, (void*) &hooked);
+        assert(removed);
+        assert(call(1) == 2);
+        (void)added;
+        (void)removed;
+    }
+    auto us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    stop = true;
+    for (auto& thread : threads) thread.join();
+    HookEpoch::Synchronize();
+
+    assert(wrong == 0);
+    assert(HookMultiplexer::Count((void*) &target) == 0);
+    std::cout << "multiplexer: " << us / kToggles << " us per hook and unhook, with " << calls << " calls from " << kThreads
+        << " threads meanwhile" << std::endl;
+}
+#else
+static void benchmark() {}
+#endif
+#endif
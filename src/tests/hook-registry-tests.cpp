@@ -0,0 +1,56 @@
+#ifdef TEST_HOOK_REGISTRY
+#include "../../shared/utils/hook-registry.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Measures lookups against a registry holding 1000 hooks, the way il2cpp_functions::Init and a diagnostics overlay query it.
+
+static constexpr int kHooks = 1000;
+static constexpr int kRounds = 100;
+
+static void benchmark() {
+    // Spread like method pointers in a large library
+    std::vector<const void*> targets;
+    for (int i = 0; i < kHooks; i++) {
+        targets.push_back(reinterpret_cast<const void*>(uintptr_t(0x7000000000) + uintptr_t(i) * 0x1a4));
+    }
+    for (int i = 0; i < kHooks; i++) {
+        auto name = "Hook" + std::to_string(i);
+        bool added = HookRegistry::Add(targets[i], reinterpret_cast<const void*>(uintptr_t(i) + 1), reinterpret_cast<const void*>(uintptr_t(i) + 2), name);
+        assert(added);
+        (void)added;
+    }
+    // A second hook on the same target must not change which orig is reported
+    bool added = HookRegistry::Add(targets[0], reinterpret_cast<const void*>(0x9999), nullptr, "Second");
+    assert(added);
+    assert(HookRegistry::GetOrig(targets[0]) == reinterpret_cast<const void*>(2));
+    bool removed = HookRegistry::Remove(targets[0], reinterpret_cast<const void*>(0x9999));
+    assert(removed);
+    assert(!HookRegistry::IsHooked(reinterpret_cast<const void*>(0x1234)));
+    (void)added;
+    (void)removed;
+
+    std::size_t hits = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < kRounds; r++) {
+        for (auto* target : targets) {
+            hits += HookRegistry::IsHooked(target);
+            hits += HookRegistry::GetOrig(target) != nullptr;
+        }
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+    assert(hits == std::size_t(2) * kHooks * kRounds);
+    std::cout << "registry: " << ns / (2.0 * kHooks * kRounds) << " ns per lookup with " << kHooks << " hooks" << std::endl;
+
+    for (int i = 0; i < kHooks; i++) {
+        bool removed = HookRegistry::Remove(targets[i], reinterpret_cast<const void*>(uintptr_t(i) + 1));
+        assert(removed);
+        (void)removed;
+    }
+    assert(!HookRegistry::IsHooked(targets[0]));
+}
+#endif
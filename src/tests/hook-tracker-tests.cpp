@@ -0,0 +1,85 @@
+#ifdef TEST_HOOK_TRACKER
+#include "../../shared/utils/hook-tracker.hpp"
+#include "../../shared/utils/module-map.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+
+// Traces the orig of a hand-assembled hook that HookTracker was not told about, whose trampoline is mapped after the ModuleMap was
+// cached (as the trampolines of hooks installed after il2cpp_functions::Init are), then times tracing it again.
+// Then removes tracked hooks the ways Hooking::UninstallHook and a diagnostic toggle do, and times removing them by handle.
+
+static constexpr int kRounds = 1000;
+static constexpr int kHooks = 1000;
+// The hooked function, and the hook's function, which calls its orig through origSlot
+alignas(8) static int32_t location[8];
+static int32_t hookFn[8];
+static const void* origSlot;
+// The functions a diagnostic toggle hooks
+static int32_t toggled[kHooks];
+
+static void benchmark() {
+    // ldr x17, #0x8; br x17; .quad hookFn
+    location[0] = 0x58000051;
+    location[1] = (int32_t)0xd61f0220;
+    *reinterpret_cast<const void**>(location + 2) = hookFn;
+    // adrp x8, origSlot; ldr x8, [x8, :lo12:origSlot]; blr x8; ret
+    auto pages = static_cast<intptr_t>((reinterpret_cast<uintptr_t>(&origSlot) >> 12) - (reinterpret_cast<uintptr_t>(hookFn) >> 12));
+    hookFn[0] = (int32_t)0x90000000 | static_cast<int32_t>((pages & 3) << 29) | static_cast<int32_t>(((pages >> 2) & 0x7FFFF) << 5) | 8;
+    hookFn[1] = (int32_t)0xF9400108 | static_cast<int32_t>(((reinterpret_cast<uintptr_t>(&origSlot) & 0xFFF) / 8) << 10);
+    hookFn[2] = (int32_t)0xD63F0100;
+    hookFn[3] = (int32_t)0xD65F03C0;
+
+    // Cached before the trampoline exists
+    ModuleMap::Get();
+    auto* trampoline = static_cast<int32_t*>(mmap(nullptr, 4096, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    assert(trampoline != MAP_FAILED);
+    // The relocated nops, then ldr x17, #0x8; br x17; .quad location + 4
+    trampoline[0] = (int32_t)0xd503201f;
+    trampoline[1] = (int32_t)0xd503201f;
+    trampoline[2] = 0x58000051;
+    trampoline[3] = (int32_t)0xd61f0220;
+    *reinterpret_cast<const void**>(trampoline + 4) = location + 4;
+    origSlot = trampoline;
+
+    assert(HookTracker::GetOrig(location) == trampoline);
+    assert(HookTracker::GetOrig(hookFn) == hookFn);
+
+    std::size_t found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kRounds; i++) {
+        found += HookTracker::GetOrig(location) == trampoline;
+    }
+    auto us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    assert(found == kRounds);
+    (void)found;
+    std::cout << "hook tracker: " << us / kRounds << " us to trace an unrecorded hook's orig" << std::endl;
+    munmap(trampoline, 4096);
+
+    // Found by destination and trampoline, even with a name longer than the registry keeps and an orig changed since
+    const std::string longName(100, 'x');
+    auto* target = location + 4;
+    auto first = HookTracker::AddHook(longName, target, hookFn, location);
+    HookTracker::AddHook("Second", target, hookFn + 1, location);
+    HookTracker::SetOrig(first, hookFn);
+    HookTracker::RemoveHook(longName, target, hookFn, location);
+    assert(HookTracker::GetHooks(target).size() == 1);
+    HookTracker::RemoveHook("Renamed", target, hookFn + 1, nullptr);
+    assert(!HookTracker::IsHooked(target));
+
+    std::vector<HookHandle> handles;
+    for (int i = 0; i < kHooks; i++) {
+        handles.push_back(HookTracker::AddHook("Toggled", &toggled[i], hookFn, location));
+    }
+    // Queried once, so that removing has a snapshot it could rebuild
+    assert(HookTracker::GetHooks(&toggled[1]).size() == 1);
+    start = std::chrono::high_resolution_clock::now();
+    for (auto& handle : handles) HookTracker::RemoveHook(handle);
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+    assert(!HookTracker::IsHooked(&toggled[0]) && HookTracker::GetHooks(&toggled[1]).empty());
+    std::cout << "hook tracker: " << ns / kHooks << " ns to remove a hook by handle" << std::endl;
+}
+#endif
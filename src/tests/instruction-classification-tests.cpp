@@ -0,0 +1,108 @@
+#ifdef TEST_INSTRUCTION_CLASSIFICATION
+#include "../../shared/utils/instruction-parsing.hpp"
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+
+// Checks EncodedInstruction against Instruction's full decoding, then compares searching a synthetic 4MB function with each.
+
+static_assert(EncodedInstruction::classify(0x94000010) == Opcode::BL);
+static_assert(EncodedInstruction::classify(0x17fffff0) == Opcode::B);
+static_assert(EncodedInstruction::classify(0x54000041) == Opcode::B_COND);
+static_assert(EncodedInstruction::classify(0x54000050) == Opcode::OTHER);  // o0 set: unallocated
+static_assert(EncodedInstruction::classify(0xb4000080) == Opcode::CB);
+static_assert(EncodedInstruction::classify(0x37080040) == Opcode::TB);
+static_assert(EncodedInstruction::classify(0xd61f0200) == Opcode::BR);
+static_assert(EncodedInstruction::classify(0xd63f0200) == Opcode::BLR);
+static_assert(EncodedInstruction::classify(0xd65f03c0) == Opcode::RET);
+static_assert(EncodedInstruction::classify(0x90000010) == Opcode::ADRP);
+static_assert(EncodedInstruction::classify(0x10000010) == Opcode::ADR);
+static_assert(EncodedInstruction::classify(0x91004000) == Opcode::ADD_SUB_IMM);
+static_assert(EncodedInstruction::classify(0x91804000) == Opcode::OTHER);  // with tags
+static_assert(EncodedInstruction::classify(0xf9400420) == Opcode::LOAD_STORE);
+static_assert(EncodedInstruction::classify(0xd503201f) == Opcode::OTHER);  // nop
+static_assert(EncodedInstruction::classify(0xaa0103e0) == Opcode::OTHER);  // mov (register)
+
+static constexpr std::size_t kInstructions = 1024 * 1024;
+// In the library itself, so that dladdr finds a base for it
+static int32_t code[kInstructions];
+
+// Every predicate that EncodedInstruction shares with Instruction agrees with it, on random encodings from the groups they look at.
+// (Instruction asserts on some unallocated encodings elsewhere, such as logical immediates.)
+static void checkAgreement() {
+    std::mt19937 rng(22);
+    for (std::size_t i = 0; i < kInstructions; i++) {
+        auto word = static_cast<uint32_t>(rng());
+        switch (i % 4) {
+            case 0:
+            case 1:  // Branches, Exception Generating and System instructions
+                word = (word & 0xE3FFFFFF) | 0x14000000;
+                break;
+            case 2:  // PC-rel. addressing and Add/subtract (immediate), with and without tags
+                word = (word & 0xE1FFFFFF) | 0x10000000;
+                break;
+            case 3:  // Loads and Stores
+                word = (word & 0xF5FFFFFF) | 0x08000000;
+                break;
+        }
+        // Instruction complains about B and BL that jump outside of the library, so keep them close
+        if ((word & 0x7C000000) == 0x14000000) word &= 0xFC00FFFF;
+        code[i] = static_cast<int32_t>(word);
+    }
+    for (std::size_t i = 0; i < kInstructions; i++) {
+        EncodedInstruction encoded(code + i);
+        Instruction decoded(code + i);
+        assert(encoded.isCall() == decoded.isCall());
+        assert(encoded.isIndirectBranch() == decoded.isIndirectBranch());
+        assert(encoded.isReturn() == decoded.isReturn());
+        assert(encoded.isPcRelAdr() == decoded.isPcRelAdr());
+        assert(encoded.isDirectBranchWithoutLink() == (decoded.branchType == Instruction::DIR));
+        for (uint_fast8_t reg = 0; reg < Register::TOTAL_NUMBER && !encoded.mayHaveImmOffset(); reg++) {
+            assert(!decoded.hasImmOffsetOnReg(reg));
+        }
+        // Instruction's CB label is missing the pc, and its ADRP only keeps 32 bits of the offset (so is off for pages more than 2GB away)
+        bool farAdrp = encoded.opcode == Opcode::ADRP && ((encoded.code >> 22) & 1) != ((encoded.code >> 23) & 1);
+        if (encoded.label() && encoded.opcode != Opcode::CB && !farAdrp) assert(encoded.label() == decoded.label);
+    }
+}
+
+static void benchmark() {
+    checkAgreement();
+
+    // Much the same function body as in instruction-iteration-tests: one BL and one BLR in every 16 instructions
+    static constexpr int32_t kBody[] = {
+        (int32_t)0xa9bf7bfd, (int32_t)0x910003fd, (int32_t)0x90000010, (int32_t)0x91004210,  // adrp x16, #0; add x16, x16, #0x10
+        (int32_t)0xf9400420, (int32_t)0xaa0103e0, (int32_t)0x94000010, (int32_t)0xeb01001f,
+        (int32_t)0x54000041, (int32_t)0xf9000020, (int32_t)0xb9400000, (int32_t)0x2a0103e0,
+        (int32_t)0xd503201f, (int32_t)0xd63f0200, (int32_t)0xb4000080, (int32_t)0x17fffff0,
+    };
+    for (std::size_t i = 0; i < kInstructions; i++) {
+        code[i] = kBody[i % std::size(kBody)];
+    }
+    code[kInstructions - 1] = (int32_t)0xd65f03c0;  // ret
+    int calls = kInstructions / std::size(kBody) * 2;
+    InstructionRange range(code);
+
+    auto before = std::chrono::steady_clock::now();
+    auto decoded = range.findNth(calls, std::mem_fn(&Instruction::isCall));
+    auto decodedTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    auto encoded = range.findNthCall(calls);
+    auto encodedTime = std::chrono::steady_clock::now() - before;
+
+    assert(decoded && encoded && decoded->addr == encoded->addr && encoded->addr == code + kInstructions - 3);
+    // ExtractAddress's search: an adrp, then the add to the register it set
+    auto adrp = range.findNthPcRelAdr(1);
+    assert(adrp && adrp->addr == code + 2);
+    auto add = InstructionRange(*adrp).findNthImmOffsetOnReg(1, adrp->Rd);
+    assert(add && add->addr == code + 3 && add->imm == 0x10);
+
+    auto ms = [](auto duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    auto perSecond = [](auto duration) { return kInstructions / std::chrono::duration<double>(duration).count() / 1e6; };
+    std::cout << "findNth(isCall), decoding every instruction: " << ms(decodedTime) << " ms (" << perSecond(decodedTime) << "M instructions/s)" << std::endl;
+    std::cout << "findNthCall, classifying every instruction: " << ms(encodedTime) << " ms (" << perSecond(encodedTime) << "M instructions/s)" << std::endl;
+}
+#endif
@@ -0,0 +1,119 @@
+#ifdef TEST_INSTRUCTION_ITERATION
+#include "../../shared/utils/instruction-parsing.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+// Decodes a synthetic 4MB function with InstructionRange, against the new Instruction per step findNth it replaced.
+// Build with -DBS_HOOK_MIN_LOG_LEVEL=ANDROID_LOG_INFO to time decoding rather than the debug log of every instruction.
+
+static constexpr std::size_t kInstructions = 1024 * 1024;
+// In the library itself, so that dladdr finds a base for it
+static int32_t code[kInstructions];
+
+// A function body's worth of common instructions that all parse fully, with two calls (BL and BLR) in it
+static constexpr int32_t kBody[] = {
+    (int32_t)0xa9bf7bfd,  // stp x29, x30, [sp, #-0x10]!
+    (int32_t)0x910003fd,  // mov x29, sp
+    (int32_t)0x90000010,  // adrp x16, #0
+    (int32_t)0x91004000,  // add x0, x0, #0x10
+    (int32_t)0xf9400420,  // ldr x0, [x1, #8]
+    (int32_t)0xaa0103e0,  // mov x0, x1
+    (int32_t)0x94000010,  // bl #0x40
+    (int32_t)0xeb01001f,  // cmp x0, x1
+    (int32_t)0x54000041,  // b.ne #8
+    (int32_t)0xf9000020,  // str x0, [x1]
+    (int32_t)0xb9400000,  // ldr w0, [x0]
+    (int32_t)0x2a0103e0,  // mov w0, w1
+    (int32_t)0xd503201f,  // nop
+    (int32_t)0xd63f0200,  // blr x16
+    (int32_t)0xb4000080,  // cbz x0, #0x10
+    (int32_t)0x17fffff0,  // b #-0x40
+};
+static constexpr int32_t kRet = (int32_t)0xd65f03c0;
+
+// The previous Instruction::findNth, which decodes every step into a new Instruction (looking up its base with dladdr)
+template<class UnaryPredicate>
+static Instruction* legacyFindNth(Instruction* start, int n, UnaryPredicate pred, int rets = 0) {
+    auto inst = start;
+    decltype(n) matches = 0;
+    while (true) {
+        if (pred(inst)) {
+            matches++;
+            if (matches == n) return inst;
+        } else if ((rets >= 0) && inst->isReturn()) {
+            if (rets == 0) break;
+            rets--;
+        }
+        auto pc = inst->addr;
+        if (inst != start) delete inst;
+        inst = new Instruction(pc + 1);
+    }
+    return nullptr;
+}
+
+static void checkIteration() {
+    // Iterating decodes the same thing as decoding each instruction on its own
+    std::size_t count = 0;
+    for (auto& inst : InstructionRange(code, code + std::size(kBody) * 2)) {
+        Instruction alone(inst.addr);
+        assert(inst.addr == code + count);
+        assert(inst.parsed && alone.parsed);
+        assert(inst.toString() == alone.toString());
+        count++;
+    }
+    assert(count == std::size(kBody) * 2);
+    assert(InstructionRange(code, code).begin() == code);
+
+    // findNth by value and by pointer find the same thing, and the pointer is this when the start matches
+    Instruction start(code);
+    auto call = InstructionRange(start).findNthCall(3);
+    auto* legacyCall = start.findNthCall(3);
+    assert(call && legacyCall && call->addr == legacyCall->addr && call->addr == code + std::size(kBody) + 6);
+    delete legacyCall;
+    assert(start.findNth(1, [](Instruction*) { return true; }) == &start);
+    // Stops at the end of the range, and at the ret
+    assert(!InstructionRange(start, code + 6).findNthCall(1));
+    assert(!InstructionRange(code + kInstructions - 1).findNthCall(1));
+}
+
+static void benchmark() {
+    for (std::size_t i = 0; i < kInstructions; i++) {
+        code[i] = kBody[i % std::size(kBody)];
+    }
+    code[kInstructions - 1] = kRet;
+    checkIteration();
+    // Every call, up to the ret: BL and BLR both count
+    int calls = 0;
+    for (std::size_t i = 0; i < kInstructions - 1; i++) {
+        calls += code[i] == kBody[6] || code[i] == kBody[13];
+    }
+
+    auto before = std::chrono::steady_clock::now();
+    Instruction legacyStart(code);
+    auto* legacy = legacyFindNth(&legacyStart, calls, [](Instruction* inst) { return inst->isCall(); });
+    auto legacyTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    auto found = InstructionRange(code).findNthCall(calls);
+    auto rangeTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    std::size_t decoded = 0;
+    for (auto& inst : InstructionRange(code, code + kInstructions)) {
+        decoded += inst.parsed;
+    }
+    auto iterateTime = std::chrono::steady_clock::now() - before;
+
+    assert(legacy && found && legacy->addr == found->addr);
+    assert(found->addr == code + kInstructions - 3);
+    assert(decoded == kInstructions);
+    delete legacy;
+
+    auto ms = [](auto duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    auto perSecond = [](auto duration) { return kInstructions / std::chrono::duration<double>(duration).count() / 1e6; };
+    std::cout << "new Instruction per step findNthCall: " << ms(legacyTime) << " ms (" << perSecond(legacyTime) << "M instructions/s)" << std::endl;
+    std::cout << "InstructionRange::findNthCall: " << ms(rangeTime) << " ms (" << perSecond(rangeTime) << "M instructions/s)" << std::endl;
+    std::cout << "InstructionRange iteration: " << ms(iterateTime) << " ms (" << perSecond(iterateTime) << "M instructions/s)" << std::endl;
+}
+#endif
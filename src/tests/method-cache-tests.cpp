@@ -0,0 +1,121 @@
+#ifdef TEST_METHOD_CACHE
+#include "../../shared/utils/concurrent-cache.hpp"
+#include "../../shared/utils/hashing.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Mirrors the shape of the FindMethod cache keys without needing il2cpp types
+struct BenchKeyView {
+    const void* klass;
+    std::string_view name;
+    std::span<const void* const> types;
+};
+struct BenchKey {
+    const void* klass;
+    std::string name;
+    std::vector<const void*> types;
+    BenchKey(const BenchKeyView& view) : klass(view.klass), name(view.name), types(view.types.begin(), view.types.end()) {}
+};
+struct BenchKeyHash {
+    std::size_t operator()(const BenchKeyView& key) const noexcept {
+        std::size_t seed = std::hash<const void*>{}(key.klass);
+        il2cpp_utils::hash_combine(seed, key.name);
+        il2cpp_utils::hash_combine_raw(seed, il2cpp_utils::hash_seq(key.types));
+        return seed;
+    }
+};
+struct BenchKeyEqual {
+    bool operator()(const BenchKey& stored, const BenchKeyView& key) const noexcept {
+        return stored.klass == key.klass && stored.name == key.name
+            && std::equal(stored.types.begin(), stored.types.end(), key.types.begin(), key.types.end());
+    }
+};
+
+namespace std {
+    template<class T> struct hash<std::vector<T>> {
+        std::size_t operator()(std::vector<T> const& seq) const noexcept {
+            return il2cpp_utils::hash_seq(seq);
+        }
+    };
+}
+
+// The old cache: an allocating key and a lock around every lookup
+typedef std::pair<std::string, std::vector<const void*>> OldInner;
+static std::unordered_map<std::pair<const void*, OldInner>, const void*, il2cpp_utils::hash_pair_3> oldCache;
+static std::mutex oldLock;
+static il2cpp_utils::ConcurrentCache<BenchKey, const void*, BenchKeyHash, BenchKeyEqual, 4096> newCache;
+
+static constexpr int kEntries = 2000;
+static constexpr int kLookups = 1000000;
+static const void* const kTypes[] = {(void*)0x10, (void*)0x20, (void*)0x30};
+static std::vector<std::string> names;
+
+static const void* oldFind(const void* klass, std::string_view name, const std::vector<const void*>& types) {
+    auto key = std::pair<const void*, OldInner>(klass, OldInner(name, types));
+    oldLock.lock();
+    auto itr = oldCache.find(key);
+    if (itr != oldCache.end()) {
+        oldLock.unlock();
+        return itr->second;
+    }
+    oldLock.unlock();
+    return nullptr;
+}
+
+static const void* newFind(const void* klass, std::string_view name, std::span<const void* const> types) {
+    auto* res = newCache.find(BenchKeyView{klass, name, types});
+    return res ? *res : nullptr;
+}
+
+static void populate() {
+    std::vector<const void*> types(std::begin(kTypes), std::end(kTypes));
+    for (int i = 0; i < kEntries; i++) {
+        names.emplace_back("Method_" + std::to_string(i));
+        auto* klass = (const void*)(uintptr_t)(0x1000 + (i % 37) * 0x100);
+        oldCache.emplace(std::pair<const void*, OldInner>(klass, OldInner(names.back(), types)), (const void*)(uintptr_t)(i + 1));
+        auto& val = newCache.emplace(BenchKeyView{klass, names.back(), kTypes}, (const void*)(uintptr_t)(i + 1));
+        assert(val == (const void*)(uintptr_t)(i + 1));
+        // Inserting again must return the existing entry
+        assert(newCache.emplace(BenchKeyView{klass, names.back(), kTypes}, nullptr) == val);
+    }
+    assert(newCache.size() == kEntries);
+}
+
+template<class F>
+static double runThreads(int threadCount, F&& lookup) {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&lookup, t]() {
+            for (int i = 0; i < kLookups; i++) {
+                int idx = (i * 7 + t) % kEntries;
+                auto* klass = (const void*)(uintptr_t)(0x1000 + (idx % 37) * 0x100);
+                auto* res = lookup(klass, names[idx]);
+                assert(res == (const void*)(uintptr_t)(idx + 1));
+                (void)res;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(kLookups) * threadCount);
+}
+
+static void benchmark() {
+    populate();
+    std::vector<const void*> types(std::begin(kTypes), std::end(kTypes));
+    for (int threads : {1, 2, 4, 8}) {
+        auto oldNs = runThreads(threads, [&types](const void* klass, std::string_view name) { return oldFind(klass, name, types); });
+        auto newNs = runThreads(threads, [](const void* klass, std::string_view name) { return newFind(klass, name, kTypes); });
+        std::cout << threads << " thread(s): mutex + unordered_map: " << oldNs << " ns/hit, ConcurrentCache: " << newNs << " ns/hit" << std::endl;
+    }
+}
+#endif
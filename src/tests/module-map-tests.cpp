@@ -0,0 +1,105 @@
+#ifdef TEST_MODULE_MAP
+#include "../../shared/utils/module-map.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Checks ModuleMap against a known maps file, then compares looking a module up in it against parsing /proc/self/maps every time.
+
+static constexpr const char* kMaps =
+    "5e34d000-5e34f000 r--p 00000000 fe:0f 3010    /system/bin/app_process64\n"
+    "7b1c200000-7b1c7a1000 r--p 00000000 fd:05 1105 /data/app/com.beatgames.beatsaber/lib/arm64/libil2cpp.so\n"
+    "7b1c7a1000-7b1dd84000 r-xp 005a0000 fd:05 1105 /data/app/com.beatgames.beatsaber/lib/arm64/libil2cpp.so\n"
+    "7b1dd84000-7b1de35000 rw-p 01b82000 fd:05 1105 /data/app/com.beatgames.beatsaber/lib/arm64/libil2cpp.so\n"
+    "7b1de35000-7b1e000000 rw-p 00000000 00:00 0    [anon:.bss]\n"
+    "7b1e000000-7b1e010000 r-xp 00000000 fd:05 2201 /data/data/com.beatgames.beatsaber/files/libmodloader.so\n"
+    "7b1e010000-7b1e011000 rw-p 00000000 00:00 0\n"
+    "7b1e011000-7b1e020000 r--p 00010000 fd:05 2201 /data/data/com.beatgames.beatsaber/files/libmodloader.so\n"
+    "7fe1200000-7fe1221000 rw-p 00000000 00:00 0    [stack]\n";
+
+// What baseAddr did before: fopen and strtok_r through /proc/self/maps until a line ends with soname
+static uintptr_t legacyBaseAddr(const char* soname) {
+    FILE* f = fopen("/proc/self/maps", "r");
+    if (!f) return 0;
+    char line[512];
+    char* state = nullptr;
+    while (fgets(line, sizeof(line), f)) {
+        char* base = strtok_r(line, "-", &state);
+        char* tok = nullptr;
+        for (int i = 0; i < 6; i++) tok = strtok_r(nullptr, "\t \n", &state);
+        if (tok && strlen(tok) >= strlen(soname) && strcmp(tok + strlen(tok) - strlen(soname), soname) == 0) {
+            fclose(f);
+            return strtoull(base, nullptr, 16);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static void checkParse() {
+    auto map = ModuleMap::Parse(kMaps);
+    assert(map.Segments().size() == 9);
+    assert(map.Modules().size() == 3);
+
+    auto* il2cpp = map.FindModule("libil2cpp.so");
+    assert(il2cpp && il2cpp->base == 0x7b1c200000 && il2cpp->end == 0x7b1de35000);
+    assert(il2cpp->Name() == "libil2cpp.so");
+    assert(map.FindModule("/data/app/com.beatgames.beatsaber/lib/arm64/libil2cpp.so") == il2cpp);
+    assert(!map.FindModule("/somewhere/else/libil2cpp.so"));
+    assert(!map.FindModule("il2cpp.so"));
+    assert(map.Segments(*il2cpp).size() == 3);
+
+    auto* code = map.FindSegment(0x7b1c7a1000 + 0x1234);
+    assert(code && code->executable && !code->writable && code->offset == 0x5a0000);
+    assert(map.FindModule(0x7b1c7a1000 + 0x1234) == il2cpp);
+    // The end of a segment belongs to the next one, and anonymous memory to no module
+    assert(map.FindSegment(0x7b1dd84000)->writable);
+    assert(map.FindSegment(0x7b1de35000) && !map.FindModule(0x7b1de35000));
+    assert(!map.FindSegment(0x1000) && !map.FindSegment(0x7fe1221000));
+
+    // A module split by other memory is still one module
+    auto* modloader = map.FindModule("libmodloader.so");
+    assert(modloader && modloader->base == 0x7b1e000000 && modloader->Size() == 0x20000);
+    assert(map.FindModule(0x7b1e011000) == modloader && !map.FindModule(0x7b1e010000));
+    assert(map.Segments(*modloader).size() == 3);
+}
+
+static void benchmark() {
+    checkParse();
+
+    // Something that is certainly mapped in this process
+    auto* self = ModuleMap::Get()->FindModule(reinterpret_cast<uintptr_t>(&checkParse));
+    assert(self);
+    std::string name(self->Name());
+    assert(legacyBaseAddr(name.c_str()) == self->base);
+
+    static constexpr int kLookups = 1000;
+    auto before = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; i++) {
+        assert(legacyBaseAddr(name.c_str()));
+    }
+    auto legacyTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; i++) {
+        assert(ModuleMap::Get()->FindModule(name));
+    }
+    auto cachedTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; i++) {
+        ModuleMap::Invalidate();
+        assert(ModuleMap::Get()->FindModule(name));
+    }
+    auto parseTime = std::chrono::steady_clock::now() - before;
+
+    auto us = [](auto duration) { return std::chrono::duration<double, std::micro>(duration).count() / kLookups; };
+    std::cout << ModuleMap::Get()->Segments().size() << " mappings" << std::endl;
+    std::cout << "fopen + strtok_r per lookup: " << us(legacyTime) << " us" << std::endl;
+    std::cout << "ModuleMap, parsed once: " << us(cachedTime) << " us" << std::endl;
+    std::cout << "ModuleMap, parsed every time: " << us(parseTime) << " us" << std::endl;
+}
+#endif
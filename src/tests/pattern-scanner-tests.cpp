@@ -0,0 +1,251 @@
+#ifdef TEST_PATTERN_SCANNER
+#include "../../shared/utils/pattern-scanner.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compares CompiledPattern and PatternSet against the byte at a time findPattern they replaced, over a synthetic 60MB libil2cpp.
+
+static constexpr std::size_t kBinarySize = 60 * 1024 * 1024;
+// find_GC_free's signature
+static constexpr const char* kPattern = "f8 5f bc a9 f6 57 01 a9 f4 4f 02 a9 "
+    "fd 7b 03 a9 fd c3 00 91 a0 08 00 b4 f3 03 00 aa ?? ?? ?? ?? 69 82 56 d3 4a ?? ?? 91 4b 0d 09 8b 49 55 40 f9 "
+    "0a 9c 9c 52 0a 04 a0 72 00 cc 74 92 68 fe 56 d3 6c 01 0a 8b 0a 03 84 52";
+
+// The previous findPattern, which walks the text pattern for every byte and steps back on a partial match
+static uintptr_t legacyFindPattern(uintptr_t dwAddress, const char* pattern, uintptr_t dwSearchRangeLen) {
+    #define in_range(x, a, b) (x >= a && x <= b)
+    #define get_bits(x) (in_range((x & (~0x20)), 'A', 'F') ? ((x & (~0x20)) - 'A' + 0xA): (in_range(x, '0', '9') ? x - '0': 0))
+    #define get_byte(x) (get_bits(x[0]) << 4 | get_bits(x[1]))
+
+    uintptr_t skippedStartBytes = 0;
+    while(pattern[0] == '\?') {
+        pattern += (pattern[1] == '\?') ? 3 : 2;
+        skippedStartBytes++;
+    }
+    uintptr_t match = 0;
+    uintptr_t len = strlen(pattern);
+    if (dwSearchRangeLen < len) {
+        return 0;
+    }
+    const char* pat = pattern;
+
+    for (uintptr_t pCur = dwAddress + skippedStartBytes; pCur < dwAddress + dwSearchRangeLen; pCur++) {
+        if (pat >= pattern + len || !pat[0] || !pat[1]) {
+            return match;
+        }
+        // char is unsigned on the headset
+        if (pat[0] == '\?' || *(uint8_t *)pCur == get_byte(pat)) {
+            if (!match) {
+                match = pCur - skippedStartBytes;
+            }
+            if (pat + 1 >= pattern + len) {
+                return match;
+            }
+            if (pat[0] != '\?' || pat[1] == '\?') {
+                pat += 3;
+            } else {
+                pat += 2;
+            }
+        }
+        else {
+            if (match) pCur = match + skippedStartBytes;
+            pat = pattern;
+            match = 0;
+        }
+    }
+    return 0;
+    #undef get_byte
+    #undef get_bits
+    #undef in_range
+}
+
+// Every match, checking every offset against the pattern's bytes
+static std::vector<std::size_t> referenceMatches(const std::vector<uint8_t>& data, const std::vector<int>& pattern) {
+    std::vector<std::size_t> matches;
+    for (std::size_t i = 0; i + pattern.size() <= data.size(); i++) {
+        bool matched = true;
+        for (std::size_t j = 0; j < pattern.size() && matched; j++) {
+            matched = pattern[j] < 0 || data[i + j] == pattern[j];
+        }
+        if (matched) matches.push_back(i);
+    }
+    return matches;
+}
+
+// Random patterns over a small alphabet, so that they match often, checked against referenceMatches
+static void checkMatches() {
+    std::mt19937 rng(18);
+    std::vector<uint8_t> data(4096 + 37);
+    for (auto& byte : data) byte = rng() % 3;
+    for (int round = 0; round < 500; round++) {
+        std::vector<int> pattern(1 + rng() % 40);
+        std::string text;
+        for (auto& byte : pattern) {
+            // Mostly fixed bytes, with wildcards of both spellings anywhere (including the ends)
+            auto kind = rng() % 8;
+            byte = kind == 0 ? -1 : static_cast<int>(rng() % 3);
+            const char hex[] = {'0', static_cast<char>('0' + byte), '\0'};
+            text += kind == 0 ? (rng() % 2 ? "?" : "??") : hex;
+            text += ' ';
+        }
+        CompiledPattern compiled(text);
+        assert(compiled.size() == pattern.size());
+        // Ranges that end anywhere, so that every tail length is covered
+        auto range = data.size() - rng() % 64;
+        std::vector<uint8_t> prefix(data.begin(), data.begin() + range);
+        auto expected = referenceMatches(prefix, pattern);
+        std::vector<std::size_t> found;
+        compiled.ForEach(reinterpret_cast<uintptr_t>(prefix.data()), prefix.size(), [&](uintptr_t match) {
+            found.push_back(match - reinterpret_cast<uintptr_t>(prefix.data()));
+            return true;
+        });
+        assert(found == expected);
+    }
+    // Only wildcards match at the start, and nothing matches in a range shorter than the pattern
+    uint8_t bytes[4] = {1, 2, 3, 4};
+    assert(CompiledPattern("?? ? ??").Find(bytes, bytes + 4) == bytes);
+    assert(!CompiledPattern("01 02 03 04 05").Find(bytes, bytes + 4));
+    assert(CompiledPattern("02 ?? 04").Find(bytes, bytes + 4) == bytes + 1);
+    assert(CompiledPattern("0A").Find(bytes, bytes + 4) == nullptr);
+}
+
+// Sets of random patterns, found all at once, against finding each of them on its own
+static void checkPatternSets() {
+    std::mt19937 rng(19);
+    // Large enough to be split across threads, with matches planted across every chunk boundary
+    std::vector<uint8_t> data(4 * 1024 * 1024 + 123);
+    for (auto& byte : data) byte = rng() % 4;
+    for (int round = 0; round < 20; round++) {
+        std::vector<CompiledPattern> patterns;
+        for (int i = 0, count = 1 + rng() % 8; i < count; i++) {
+            std::string text;
+            for (int j = 0, length = 1 + rng() % 24; j < length; j++) {
+                text += rng() % 6 ? std::string{'0', static_cast<char>('0' + rng() % 4)} : "??";
+                text += ' ';
+            }
+            patterns.emplace_back(text);
+            for (int chunks = 1; chunks <= 4; chunks++) {
+                auto boundary = data.size() / 4 * chunks - rng() % 24;
+                auto size = std::min(patterns.back().size(), data.size() - boundary);
+                for (std::size_t k = 0; k < size; k++) data[boundary + k] = text[k * 3] == '?' ? 0 : text[k * 3 + 1] - '0';
+            }
+        }
+        PatternSet set(patterns);
+        auto start = reinterpret_cast<uintptr_t>(data.data());
+        auto all = set.FindAll(start, data.size(), 4);
+        for (std::size_t i = 0; i < set.size(); i++) {
+            std::vector<uintptr_t> expected;
+            set[i].ForEach(start, data.size(), [&](uintptr_t match) {
+                expected.push_back(match);
+                return true;
+            });
+            assert(all[i] == expected);
+            assert(set.FindAll(start, data.size(), 1)[i] == expected);
+        }
+    }
+}
+
+static void benchmark() {
+    checkMatches();
+    checkPatternSets();
+
+    // Random AArch64-ish instructions: anything goes in the low bytes, while the top byte is one of a few opcodes
+    std::vector<uint8_t> binary(kBinarySize);
+    std::mt19937 rng(60);
+    static constexpr uint8_t opcodes[] = {0xa9, 0xf9, 0x91, 0xaa, 0x94, 0x52, 0xb4, 0x8b};
+    for (std::size_t i = 0; i < binary.size(); i += 4) {
+        auto word = rng();
+        memcpy(&binary[i], &word, 3);
+        binary[i + 3] = opcodes[word % std::size(opcodes)];
+    }
+    CompiledPattern compiled(kPattern);
+    // Near misses (the same prologue) throughout, and the function itself at 50MB
+    for (std::size_t offset = 1024 * 1024; offset < kBinarySize; offset += 1024 * 1024) {
+        memcpy(&binary[offset], "\xf8\x5f\xbc\xa9\xf6\x57\x01\xa9", 8);
+    }
+    static constexpr std::size_t planted = 50 * 1024 * 1024 + 0x1234 * 4;
+    for (std::size_t i = 0; i < compiled.size(); i++) {
+        auto text = kPattern + i * 3;
+        binary[planted + i] = text[0] == '?' ? 0x00 : static_cast<uint8_t>(std::stoul(std::string(text, 2), nullptr, 16));
+    }
+    auto start = reinterpret_cast<uintptr_t>(binary.data());
+
+    auto before = std::chrono::steady_clock::now();
+    auto legacy = legacyFindPattern(start, kPattern, binary.size());
+    auto legacyTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    auto found = CompiledPattern(kPattern).Find(start, binary.size());
+    auto compiledTime = std::chrono::steady_clock::now() - before;
+
+    // A whole findUniquePattern: every match in the binary, not just the first
+    before = std::chrono::steady_clock::now();
+    int matches = 0;
+    compiled.ForEach(start, binary.size(), [&](uintptr_t) {
+        matches++;
+        return true;
+    });
+    auto uniqueTime = std::chrono::steady_clock::now() - before;
+
+    assert(legacy == start + planted);
+    assert(found == start + planted);
+    assert(matches == 1);
+
+    auto ms = [](auto duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    std::cout << "legacy findPattern: " << ms(legacyTime) << " ms" << std::endl;
+    std::cout << "CompiledPattern::Find: " << ms(compiledTime) << " ms (" << ms(legacyTime) / ms(compiledTime) << "x)" << std::endl;
+    std::cout << "CompiledPattern::ForEach over " << kBinarySize / (1024 * 1024) << "MB: " << ms(uniqueTime) << " ms" << std::endl;
+
+    // Init's fallback sigscans and a few more from mods: one pass each against one pass for all of them
+    std::vector<std::string> signatures{kPattern,
+        "f5 0f 1d f8 f4 4f 01 a9 fd 7b 02 a9 fd 83 00 91 ?? ?? ?? ?? ?? ?? ?? ?? 1f 00 20 f1 f3 03 01 2a"};
+    for (int i = 0; i < 6; i++) {
+        std::string text = "ff 43 01 d1 ";
+        for (int j = 0; j < 16; j++) {
+            char hex[3];
+            snprintf(hex, sizeof(hex), "%02x", static_cast<unsigned>(rng() & 0xFF));
+            text += j % 5 == 4 ? "?? " : std::string(hex) + ' ';
+        }
+        signatures.push_back(text);
+    }
+    before = std::chrono::steady_clock::now();
+    for (auto& signature : signatures) {
+        legacy = legacyFindPattern(start, signature.c_str(), binary.size());
+        assert(!legacy || legacy == start + planted);
+    }
+    legacyTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    std::vector<std::vector<uintptr_t>> separate;
+    for (auto& signature : signatures) {
+        auto& matches = separate.emplace_back();
+        CompiledPattern(signature).ForEach(start, binary.size(), [&](uintptr_t match) {
+            matches.push_back(match);
+            return true;
+        });
+    }
+    auto separateTime = std::chrono::steady_clock::now() - before;
+
+    std::vector<CompiledPattern> compiledSignatures(signatures.begin(), signatures.end());
+    before = std::chrono::steady_clock::now();
+    auto single = PatternSet(compiledSignatures).FindAll(start, binary.size(), 1);
+    auto singleTime = std::chrono::steady_clock::now() - before;
+
+    before = std::chrono::steady_clock::now();
+    auto parallel = PatternSet(compiledSignatures).FindAll(start, binary.size());
+    auto parallelTime = std::chrono::steady_clock::now() - before;
+    assert(single == separate && parallel == separate);
+
+    std::cout << signatures.size() << " legacy findPattern passes: " << ms(legacyTime) << " ms" << std::endl;
+    std::cout << signatures.size() << " CompiledPattern passes: " << ms(separateTime) << " ms" << std::endl;
+    std::cout << "PatternSet, 1 thread: " << ms(singleTime) << " ms" << std::endl;
+    std::cout << "PatternSet, " << std::thread::hardware_concurrency() << " threads: " << ms(parallelTime) << " ms" << std::endl;
+}
+#endif
@@ -0,0 +1,133 @@
+#ifdef TEST_REGISTER_EVALUATOR
+#include "../../shared/utils/instruction-parsing.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+// Evaluates a hand-assembled function with branches, a loop and calls in it, then times evaluating a synthetic 256KB function.
+// Build with -DBS_HOOK_MIN_LOG_LEVEL=ANDROID_LOG_INFO to time decoding rather than the debug log of every instruction.
+
+static constexpr std::size_t kInstructions = 64 * 1024;
+// In the library itself, so that dladdr finds a base for it
+static int32_t code[kInstructions];
+// On pages of their own, so that an ADRP of one is never an ADRP of the other
+alignas(4096) static char global[4096];
+alignas(4096) static const void* pointer;
+
+static int32_t offsetTo(const void* from, const void* to, int bits) {
+    auto words = (reinterpret_cast<intptr_t>(to) - reinterpret_cast<intptr_t>(from)) / 4;
+    return static_cast<int32_t>(words & ((1 << bits) - 1));
+}
+static int32_t adrp(const int32_t* from, const void* to, int rd) {
+    auto pages = (static_cast<intptr_t>(reinterpret_cast<uintptr_t>(to) >> 12) - static_cast<intptr_t>(reinterpret_cast<uintptr_t>(from) >> 12));
+    return (int32_t)0x90000000 | static_cast<int32_t>((pages & 3) << 29) | static_cast<int32_t>(((pages >> 2) & 0x7FFFF) << 5) | rd;
+}
+// add xd, xn, #imm
+static int32_t add(int rd, int rn, int imm) {
+    return (int32_t)0x91000000 | (imm << 10) | (rn << 5) | rd;
+}
+// ldr xt, [xn, #offset]
+static int32_t ldr(int rt, int rn, int offset) {
+    return (int32_t)0xF9400000 | ((offset / 8) << 10) | (rn << 5) | rt;
+}
+static int32_t lo12(const void* to) {
+    return reinterpret_cast<uintptr_t>(to) & 0xFFF;
+}
+
+static const int32_t* assemble(int32_t* at) {
+    auto f = at + 4;  // so that there is something to call before it
+    f[0] = adrp(f, global, 8);
+    f[1] = add(8, 8, lo12(global));  // the address of global
+    f[2] = adrp(f + 2, &pointer, 9);
+    f[3] = ldr(9, 9, lo12(&pointer));  // loads pointer
+    f[4] = (int32_t)0xD282468A;  // movz x10, #0x1234
+    f[5] = (int32_t)0xF2AACF0A;  // movk x10, #0x5678, lsl #16
+    f[6] = (int32_t)0xAA0803EB;  // mov x11, x8
+    f[7] = (int32_t)0xF9000560;  // str x0, [x11, #8]
+    f[8] = adrp(f + 8, global, 14);
+    f[9] = 0x34000000 | (offsetTo(f + 9, f + 12, 19) << 5);  // cbz w0, f + 12
+    f[10] = adrp(f + 10, global, 12);
+    f[11] = 0x14000000 | offsetTo(f + 11, f + 13, 26);  // b f + 13
+    f[12] = adrp(f + 12, &pointer, 12);
+    f[13] = ldr(13, 12, 0);  // x12 depends on the way here, so this is unknown
+    f[14] = ldr(15, 14, 16);  // but x14 does not
+    f[15] = (int32_t)0xD63F0120;  // blr x9, which calls through pointer
+    f[16] = ldr(16, 14, 0);  // x14 was lost to the call
+    f[17] = adrp(f + 17, global, 19);
+    f[18] = (int32_t)0x94000000 | offsetTo(f + 18, at, 26);  // bl at
+    f[19] = add(20, 19, 32);  // x19 was not
+    f[20] = ldr(21, 20, 0);  // a loop that changes x20, so this is unknown
+    f[21] = add(20, 21, 8);
+    f[22] = (int32_t)0xB5000000 | (offsetTo(f + 22, f + 20, 19) << 5) | 20;  // cbnz x20, f + 20
+    f[23] = (int32_t)0xD65F03C0;  // ret
+    return f;
+}
+
+static void checkEvaluation() {
+    auto f = assemble(code);
+    AssemblyFunction function(f);
+    RegisterEvaluator evaluator(function);
+    auto g = reinterpret_cast<uintptr_t>(global);
+    auto p = reinterpret_cast<uintptr_t>(&pointer);
+    std::vector<std::tuple<std::ptrdiff_t, Xref::Kind, uintptr_t>> expected = {
+        {1, Xref::ADDRESS, g}, {3, Xref::LOAD, p}, {7, Xref::STORE, g + 8}, {14, Xref::LOAD, g + 16},
+        {15, Xref::CALL_THROUGH, p}, {18, Xref::CALL, reinterpret_cast<uintptr_t>(code)}, {19, Xref::ADDRESS, g + 32},
+    };
+    auto xrefs = evaluator.Xrefs();
+    assert(xrefs.size() == expected.size());
+    for (std::size_t i = 0; i < xrefs.size(); i++) {
+        assert(xrefs[i].at - f == std::get<0>(expected[i]));
+        assert(xrefs[i].kind == std::get<1>(expected[i]));
+        assert(xrefs[i].address == std::get<2>(expected[i]));
+    }
+    assert(evaluator.Xrefs(Xref::LOAD).size() == 2 && evaluator.Xrefs(Xref::LOAD)[1].at == f + 14);
+
+    auto movk = evaluator.StateBefore(f + 6);
+    assert(movk && movk->valueOf(10, RegisterSet::CONSTANT) == 0x56781234);
+    auto merged = evaluator.StateBefore(f + 13);
+    assert(merged && merged->kinds[12] == RegisterSet::UNKNOWN && merged->valueOf(14, RegisterSet::ADDRESS) == static_cast<int64_t>(g));
+    assert(merged->valueOf(9, RegisterSet::LOADED_FROM) == static_cast<int64_t>(p));
+    auto loop = evaluator.StateBefore(f + 20);
+    assert(loop && loop->kinds[20] == RegisterSet::UNKNOWN && loop->valueOf(19, RegisterSet::ADDRESS) == static_cast<int64_t>(g));
+    assert(!evaluator.StateBefore(code));
+
+    // What the hand-counted searches find, without counting
+    assert(ExtractAddress(f, 1, 1) == static_cast<int64_t>(g));
+    assert(ExtractAddress(f, 2, 1) == static_cast<int64_t>(p));
+}
+
+static void benchmark() {
+    checkEvaluation();
+
+    // An adrp, an add to it and a load from it in every 16 instructions, which are all reachable
+    for (std::size_t i = 0; i + 16 <= kInstructions; i += 16) {
+        auto f = code + i;
+        int32_t body[] = {
+            (int32_t)0xa9bf7bfd, (int32_t)0x910003fd, adrp(f + 2, global, 16), add(16, 16, 8),
+            ldr(0, 16, 8), (int32_t)0xaa0103e0, (int32_t)0x94000000 | offsetTo(f + 6, code, 26), (int32_t)0xeb01001f,
+            0x54000000 | (offsetTo(f + 8, f + 10, 19) << 5) | 0b0001, (int32_t)0xf9000020, (int32_t)0xb9400000, (int32_t)0x2a0103e0,
+            (int32_t)0xd503201f, (int32_t)0xd63f0200, 0x34000000 | (offsetTo(f + 14, f + 16, 19) << 5), (int32_t)0xd503201f,
+        };
+        std::copy(std::begin(body), std::end(body), f);
+    }
+    code[kInstructions - 2] = 0x34000000 | (offsetTo(code + kInstructions - 2, code + kInstructions - 1, 19) << 5);
+    code[kInstructions - 1] = (int32_t)0xd65f03c0;  // ret
+    AssemblyFunction function(code);
+
+    auto before = std::chrono::steady_clock::now();
+    RegisterEvaluator evaluator(function);
+    auto evaluateTime = std::chrono::steady_clock::now() - before;
+
+    // Every body's add and load, and both calls (the last BLR is through x16, which its BL lost)
+    assert(evaluator.Xrefs(Xref::ADDRESS).size() == kInstructions / 16);
+    assert(evaluator.Xrefs(Xref::LOAD).size() == kInstructions / 16);
+    assert(evaluator.Xrefs(Xref::CALL).size() == kInstructions / 16);
+
+    auto ms = [](auto duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    auto perSecond = [](auto duration) { return kInstructions / std::chrono::duration<double>(duration).count() / 1e6; };
+    std::cout << "RegisterEvaluator, " << evaluator.Xrefs().size() << " xrefs: " << ms(evaluateTime) << " ms (" << perSecond(evaluateTime)
+        << "M instructions/s)" << std::endl;
+}
+#endif
@@ -0,0 +1,124 @@
+#ifdef TEST_RESOLUTION_CACHE
+#include "../../shared/utils/resolution-cache.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Compares resolving every lookup from a fake metadata provider (shaped like GetClassFromName asking each image in turn)
+// against resolving it from a ResolutionCacheFile written by a previous "launch".
+
+// One fake image: a name -> type index table, like the per-image class hash table libil2cpp keeps
+struct FakeImage {
+    std::unordered_map<std::string, uint32_t> types;
+};
+
+static constexpr int kImages = 150;
+static constexpr int kTypesPerImage = 200;
+static constexpr int kLookups = 2000;
+static constexpr uint64_t kFingerprint = 0x1234;
+
+static std::vector<FakeImage> images;
+static std::vector<std::string> lookups;
+
+static void populate() {
+    images.resize(kImages);
+    uint32_t index = 0;
+    for (int i = 0; i < kImages; i++) {
+        for (int t = 0; t < kTypesPerImage; t++) {
+            images[i].types.emplace("Namespace" + std::to_string(i) + ".Type" + std::to_string(t), index++);
+        }
+    }
+    // Mods mostly look up types from the last images (the game's own assemblies)
+    for (int i = 0; i < kLookups; i++) {
+        int image = kImages - 1 - (i % 20);
+        lookups.emplace_back("Namespace" + std::to_string(image) + ".Type" + std::to_string(i % kTypesPerImage));
+    }
+}
+
+static uint32_t scan(const std::string& name) {
+    for (auto& image : images) {
+        auto itr = image.types.find(name);
+        if (itr != image.types.end()) return itr->second;
+    }
+    return UINT32_MAX;
+}
+
+template<class F>
+static double timeUs(F&& func) {
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static void benchmark() {
+    populate();
+    auto path = "/tmp/resolution-cache-test-" + std::to_string(getpid()) + ".bin";
+    unlink(path.c_str());
+
+    // First launch: no cache, resolve everything by scanning and record it
+    double coldUs;
+    {
+        ResolutionCacheFile cache;
+        bool opened = cache.Open(path, kFingerprint);
+        assert(!opened);
+        (void)opened;
+        coldUs = timeUs([&]() {
+            for (auto& name : lookups) {
+                auto key = ResolutionCacheFile::HashString(name);
+                if (!cache.Find(key)) cache.Record(key, {scan(name), 0});
+            }
+        });
+        bool flushed = false;
+        auto flushUs = timeUs([&]() { flushed = cache.Flush(); });
+        assert(flushed);
+        (void)flushed;
+        std::cout << "cold: " << coldUs << " us for " << kLookups << " lookups, flush: " << flushUs << " us" << std::endl;
+    }
+
+    // Second launch: everything should come from the mapped file
+    {
+        ResolutionCacheFile cache;
+        bool opened = false;
+        auto openUs = timeUs([&]() { opened = cache.Open(path, kFingerprint); });
+        assert(opened);
+        (void)opened;
+        assert(cache.MappedCount() > 0);
+        uint64_t sum = 0;
+        auto warmUs = timeUs([&]() {
+            for (auto& name : lookups) {
+                auto value = cache.Find(ResolutionCacheFile::HashString(name));
+                sum += value ? value->typeIndex : UINT32_MAX;
+            }
+        });
+        uint64_t expected = 0;
+        for (auto& name : lookups) expected += scan(name);
+        assert(sum == expected);
+        std::cout << "warm: open " << openUs << " us, " << warmUs << " us for " << kLookups << " lookups, "
+            << coldUs / warmUs << "x" << std::endl;
+    }
+
+    // A different fingerprint (a game update) must invalidate the cache
+    {
+        ResolutionCacheFile cache;
+        bool opened = cache.Open(path, kFingerprint + 1);
+        assert(!opened);
+        assert(!cache.Find(ResolutionCacheFile::HashString(lookups[0])));
+        cache.Record(1, {1, 2});
+        bool flushed = cache.Flush();
+        assert(flushed);
+        (void)opened;
+        (void)flushed;
+    }
+    {
+        ResolutionCacheFile cache;
+        bool opened = cache.Open(path, kFingerprint);
+        assert(!opened);
+        (void)opened;
+    }
+    unlink(path.c_str());
+}
+#endif
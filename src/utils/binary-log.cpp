@@ -0,0 +1,447 @@
+#include "../../shared/utils/binary-log.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <type_traits>
+#include <unordered_map>
+
+namespace Logging::BinaryLog {
+    namespace {
+        enum class Kind {
+            None,
+            Signed,
+            Unsigned,
+            Char,
+            Double,
+            String,
+            Pointer,
+            Count
+        };
+
+        enum class Length {
+            None,
+            Char,
+            Short,
+            Long,
+            LongLong,
+            IntMax,
+            Size,
+            PtrDiff,
+            LongDouble
+        };
+
+        // One conversion of a format string, such as %-8.*lld
+        struct Spec {
+            const char* start;
+            const char* end;
+            // Where the length modifier (if any) starts and ends, since Format replaces it
+            const char* lengthStart;
+            const char* lengthEnd;
+            Kind kind = Kind::None;
+            Length length = Length::None;
+            char conversion = 0;
+            // Number of * in the width and precision, which take an int argument each
+            int stars = 0;
+            bool starPrecision = false;
+            // -1 if there is no precision, or it is a *
+            int precision = -1;
+        };
+
+        // Parses the conversion starting at the % at fmt.
+        Spec parse(const char* fmt) {
+            Spec spec{fmt, fmt + 1, nullptr, nullptr};
+            auto* p = fmt + 1;
+            while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'') p++;
+            if (*p == '*') {
+                spec.stars++;
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') p++;
+            }
+            if (*p == '.') {
+                p++;
+                if (*p == '*') {
+                    spec.stars++;
+                    spec.starPrecision = true;
+                    p++;
+                } else {
+                    spec.precision = 0;
+                    while (*p >= '0' && *p <= '9') spec.precision = spec.precision * 10 + (*p++ - '0');
+                }
+            }
+            spec.lengthStart = p;
+            switch (*p) {
+                case 'h':
+                    spec.length = p[1] == 'h' ? Length::Char : Length::Short;
+                    p += p[1] == 'h' ? 2 : 1;
+                    break;
+                case 'l':
+                    spec.length = p[1] == 'l' ? Length::LongLong : Length::Long;
+                    p += p[1] == 'l' ? 2 : 1;
+                    break;
+                case 'q': spec.length = Length::LongLong; p++; break;
+                case 'j': spec.length = Length::IntMax; p++; break;
+                case 'z': spec.length = Length::Size; p++; break;
+                case 't': spec.length = Length::PtrDiff; p++; break;
+                case 'L': spec.length = Length::LongDouble; p++; break;
+                default: break;
+            }
+            spec.lengthEnd = p;
+            spec.conversion = *p;
+            if (*p) p++;
+            spec.end = p;
+            switch (spec.conversion) {
+                case 'd': case 'i': spec.kind = Kind::Signed; break;
+                case 'u': case 'o': case 'x': case 'X': spec.kind = Kind::Unsigned; break;
+                case 'c': spec.kind = Kind::Char; break;
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': spec.kind = Kind::Double; break;
+                case 's': spec.kind = Kind::String; break;
+                case 'p': spec.kind = Kind::Pointer; break;
+                case 'n': spec.kind = Kind::Count; break;
+                default: spec.kind = Kind::None; break;
+            }
+            return spec;
+        }
+
+        // Reads an integer argument, narrowed the way printf would narrow it
+        int64_t readSigned(Length length, va_list& args) {
+            switch (length) {
+                case Length::Char: return static_cast<signed char>(va_arg(args, int));
+                case Length::Short: return static_cast<short>(va_arg(args, int));
+                case Length::Long: return va_arg(args, long);
+                case Length::LongLong: return va_arg(args, long long);
+                case Length::IntMax: return va_arg(args, intmax_t);
+                case Length::Size: return static_cast<std::make_signed_t<std::size_t>>(va_arg(args, std::size_t));
+                case Length::PtrDiff: return va_arg(args, ptrdiff_t);
+                default: return va_arg(args, int);
+            }
+        }
+
+        uint64_t readUnsigned(Length length, va_list& args) {
+            switch (length) {
+                case Length::Char: return static_cast<unsigned char>(va_arg(args, unsigned int));
+                case Length::Short: return static_cast<unsigned short>(va_arg(args, unsigned int));
+                case Length::Long: return va_arg(args, unsigned long);
+                case Length::LongLong: return va_arg(args, unsigned long long);
+                case Length::IntMax: return va_arg(args, uintmax_t);
+                case Length::Size: return va_arg(args, std::size_t);
+                case Length::PtrDiff: return static_cast<std::make_unsigned_t<ptrdiff_t>>(va_arg(args, ptrdiff_t));
+                default: return va_arg(args, unsigned int);
+            }
+        }
+
+        // Walks the arguments of fmt, passing each one (as a 64 bit value or a string) to the sink.
+        template<typename Sink>
+        void walk(const char* fmt, va_list args, Sink&& sink) {
+            va_list copy;
+            va_copy(copy, args);
+            for (auto* p = strchr(fmt, '%'); p; p = strchr(p, '%')) {
+                if (p[1] == '%') {
+                    p += 2;
+                    continue;
+                }
+                auto spec = parse(p);
+                p = spec.end;
+                int precision = spec.precision;
+                for (int i = 0; i < spec.stars; i++) {
+                    int value = va_arg(copy, int);
+                    if (spec.starPrecision && i == spec.stars - 1) precision = value;
+                    sink.value(static_cast<uint64_t>(static_cast<int64_t>(value)));
+                }
+                switch (spec.kind) {
+                    case Kind::Signed:
+                        sink.value(static_cast<uint64_t>(readSigned(spec.length, copy)));
+                        break;
+                    case Kind::Unsigned:
+                        sink.value(readUnsigned(spec.length, copy));
+                        break;
+                    case Kind::Char:
+                        sink.value(static_cast<uint64_t>(static_cast<int64_t>(va_arg(copy, int))));
+                        break;
+                    case Kind::Double: {
+                        double value = spec.length == Length::LongDouble ? static_cast<double>(va_arg(copy, long double)) : va_arg(copy, double);
+                        uint64_t bits;
+                        memcpy(&bits, &value, sizeof(bits));
+                        sink.value(bits);
+                        break;
+                    }
+                    case Kind::String: {
+                        auto* str = va_arg(copy, const char*);
+                        if (!str) str = "(null)";
+                        // With a precision the string does not have to be terminated
+                        auto size = precision >= 0 ? strnlen(str, precision) : strlen(str);
+                        sink.string(str, size);
+                        break;
+                    }
+                    case Kind::Pointer:
+                        sink.value(reinterpret_cast<uintptr_t>(va_arg(copy, void*)));
+                        break;
+                    case Kind::Count:
+                        va_arg(copy, void*);
+                        break;
+                    case Kind::None:
+                        break;
+                }
+            }
+            va_end(copy);
+        }
+
+        template<typename... TArgs>
+        void append(std::string& out, const char* spec, TArgs... args) {
+            char small[128];
+            auto length = snprintf(small, sizeof(small), spec, args...);
+            if (length < 0) return;
+            if (static_cast<std::size_t>(length) < sizeof(small)) {
+                out.append(small, length);
+                return;
+            }
+            auto offset = out.size();
+            out.resize(offset + length + 1);
+            snprintf(out.data() + offset, length + 1, spec, args...);
+            out.resize(offset + length);
+        }
+
+        // Formats one conversion, passing the * arguments ahead of the value
+        template<typename T>
+        void appendValue(std::string& out, const char* spec, const int (&stars)[2], int starCount, T value) {
+            switch (starCount) {
+                case 0: append(out, spec, value); break;
+                case 1: append(out, spec, stars[0], value); break;
+                default: append(out, spec, stars[0], stars[1], value); break;
+            }
+        }
+
+        // Reads captured arguments back, returning zero (or an empty string) past the end
+        struct Reader {
+            std::span<const char> args;
+            std::size_t offset = 0;
+
+            uint64_t value() {
+                uint64_t value = 0;
+                if (offset + sizeof(value) <= args.size()) memcpy(&value, args.data() + offset, sizeof(value));
+                offset += sizeof(value);
+                return value;
+            }
+            std::string_view string() {
+                uint32_t size = 0;
+                if (offset + sizeof(size) <= args.size()) memcpy(&size, args.data() + offset, sizeof(size));
+                offset += sizeof(size);
+                if (offset > args.size()) return {};
+                size = static_cast<uint32_t>(std::min<std::size_t>(size, args.size() - offset));
+                std::string_view str(args.data() + offset, size);
+                offset += size;
+                return str;
+            }
+        };
+
+        template<typename T>
+        void put(std::string& out, T value) {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    }
+
+    std::size_t ArgsSize(const char* fmt, va_list args) noexcept {
+        struct {
+            std::size_t size = 0;
+            void value(uint64_t) { size += sizeof(uint64_t); }
+            void string(const char*, std::size_t length) { size += sizeof(uint32_t) + length; }
+        } sink;
+        walk(fmt, args, sink);
+        return sink.size;
+    }
+
+    std::size_t CaptureArgs(const char* fmt, va_list args, char* out) noexcept {
+        struct {
+            char* out;
+            char* start;
+            void value(uint64_t value) {
+                memcpy(out, &value, sizeof(value));
+                out += sizeof(value);
+            }
+            void string(const char* str, std::size_t length) {
+                auto size = static_cast<uint32_t>(length);
+                memcpy(out, &size, sizeof(size));
+                memcpy(out + sizeof(size), str, length);
+                out += sizeof(size) + length;
+            }
+        } sink{out, out};
+        walk(fmt, args, sink);
+        return sink.out - sink.start;
+    }
+
+    void Format(const char* fmt, std::span<const char> args, std::string& out) {
+        Reader reader{args};
+        std::string spec;
+        std::string str;
+        for (auto* p = fmt; *p;) {
+            auto* percent = strchr(p, '%');
+            if (!percent) {
+                out.append(p);
+                break;
+            }
+            out.append(p, percent - p);
+            if (percent[1] == '%') {
+                out.push_back('%');
+                p = percent + 2;
+                continue;
+            }
+            auto parsed = parse(percent);
+            p = parsed.end;
+            int stars[2] = {};
+            for (int i = 0; i < parsed.stars; i++) stars[i] = static_cast<int>(static_cast<int64_t>(reader.value()));
+            // Every captured integer is 64 bits, so the length modifier is replaced to match
+            spec.assign(parsed.start, parsed.lengthStart);
+            switch (parsed.kind) {
+                case Kind::Signed:
+                    spec.append("ll").push_back(parsed.conversion);
+                    appendValue(out, spec.c_str(), stars, parsed.stars, static_cast<long long>(reader.value()));
+                    break;
+                case Kind::Unsigned:
+                    spec.append("ll").push_back(parsed.conversion);
+                    appendValue(out, spec.c_str(), stars, parsed.stars, static_cast<unsigned long long>(reader.value()));
+                    break;
+                case Kind::Char:
+                    spec.push_back('c');
+                    appendValue(out, spec.c_str(), stars, parsed.stars, static_cast<int>(static_cast<int64_t>(reader.value())));
+                    break;
+                case Kind::Double: {
+                    auto bits = reader.value();
+                    double value;
+                    memcpy(&value, &bits, sizeof(value));
+                    spec.push_back(parsed.conversion);
+                    appendValue(out, spec.c_str(), stars, parsed.stars, value);
+                    break;
+                }
+                case Kind::String:
+                    str.assign(reader.string());
+                    spec.push_back('s');
+                    appendValue(out, spec.c_str(), stars, parsed.stars, str.c_str());
+                    break;
+                case Kind::Pointer:
+                    spec.push_back('p');
+                    appendValue(out, spec.c_str(), stars, parsed.stars, reinterpret_cast<void*>(static_cast<uintptr_t>(reader.value())));
+                    break;
+                case Kind::Count:
+                    break;
+                case Kind::None:
+                    // Not a conversion printf knows, keep it as is
+                    out.append(parsed.start, parsed.end);
+                    break;
+            }
+        }
+    }
+
+    // A binary log is the magic and version, followed by entries that each start with their kind:
+    // 'H' u16 length, tag
+    // 'F' u64 id, u32 length, format
+    // 'R' i64 ms, u8 level, u64 format id, u8 length, context, u32 length, arguments
+    void AppendHeader(std::string& out, std::string_view tag) {
+        out.append(magic, sizeof(magic));
+        put(out, version);
+        out.push_back('H');
+        auto size = static_cast<uint16_t>(std::min<std::size_t>(tag.size(), UINT16_MAX));
+        put(out, size);
+        out.append(tag.data(), size);
+    }
+
+    void AppendFormat(std::string& out, uint64_t id, std::string_view fmt) {
+        out.push_back('F');
+        put(out, id);
+        put(out, static_cast<uint32_t>(fmt.size()));
+        out.append(fmt);
+    }
+
+    void AppendRecord(std::string& out, int64_t ms, uint8_t level, uint64_t formatId, std::string_view context, std::span<const char> args) {
+        out.push_back('R');
+        put(out, ms);
+        put(out, level);
+        put(out, formatId);
+        auto contextSize = static_cast<uint8_t>(std::min<std::size_t>(context.size(), UINT8_MAX));
+        put(out, contextSize);
+        out.append(context.data(), contextSize);
+        put(out, static_cast<uint32_t>(args.size()));
+        out.append(args.data(), args.size());
+    }
+
+    namespace {
+        const char* levelName(uint8_t level) {
+            // The values of Logging::Level, which are the Android log priorities
+            switch (level) {
+                case 7: return "CRITICAL";
+                case 6: return "ERROR";
+                case 5: return "WARNING";
+                case 4: return "INFO";
+                case 3: return "DEBUG";
+                default: return "UNKNOWN";
+            }
+        }
+
+        template<typename T>
+        bool get(std::FILE* in, T& value) {
+            return fread(&value, sizeof(value), 1, in) == 1;
+        }
+
+        bool get(std::FILE* in, std::string& str, std::size_t size) {
+            str.resize(size);
+            return size == 0 || fread(str.data(), size, 1, in) == 1;
+        }
+    }
+
+    bool Decode(std::FILE* in, std::FILE* out) {
+        char fileMagic[sizeof(magic)];
+        uint8_t fileVersion;
+        if (fread(fileMagic, sizeof(fileMagic), 1, in) != 1 || memcmp(fileMagic, magic, sizeof(magic)) != 0 || !get(in, fileVersion) || fileVersion != version) {
+            return false;
+        }
+        std::string tag;
+        std::unordered_map<uint64_t, std::string> formats;
+        std::string context;
+        std::string args;
+        std::string line;
+        char kind;
+        while (get(in, kind)) {
+            switch (kind) {
+                case 'H': {
+                    uint16_t size;
+                    if (!get(in, size) || !get(in, tag, size)) return false;
+                    break;
+                }
+                case 'F': {
+                    uint64_t id;
+                    uint32_t size;
+                    if (!get(in, id) || !get(in, size) || !get(in, formats[id], size)) return false;
+                    break;
+                }
+                case 'R': {
+                    int64_t ms;
+                    uint8_t level;
+                    uint64_t id;
+                    uint8_t contextSize;
+                    uint32_t argsSize;
+                    if (!get(in, ms) || !get(in, level) || !get(in, id) || !get(in, contextSize) || !get(in, context, contextSize) ||
+                        !get(in, argsSize) || !get(in, args, argsSize)) {
+                        return false;
+                    }
+                    auto format = formats.find(id);
+                    if (format == formats.end()) return false;
+                    std::time_t second = ms / 1000;
+                    std::tm bt;
+                    localtime_r(&second, &bt);
+                    char time[32];
+                    auto timeLength = std::strftime(time, sizeof(time), "%m-%d %H:%M:%S", &bt);
+                    line.assign(time, timeLength);
+                    append(line, ".%03d ", static_cast<int>(ms % 1000));
+                    line.append(levelName(level)).append(" ").append(tag).append(": ").append(context);
+                    Format(format->second.c_str(), args, line);
+                    line.push_back('\n');
+                    fwrite(line.data(), 1, line.size(), out);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return feof(in);
+    }
+}
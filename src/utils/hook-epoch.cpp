@@ -0,0 +1,85 @@
+#include "../../shared/utils/hook-epoch.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+    // One per thread that ever ran a hook. Records are never freed, a record whose thread exited is reused by the next new thread.
+    struct ThreadRecord {
+        // Odd while the thread is running a hook
+        std::atomic<uint64_t> counter = 0;
+        std::atomic_bool inUse = true;
+        uint32_t depth = 0;
+        ThreadRecord* next = nullptr;
+    };
+
+    std::atomic<ThreadRecord*> records = nullptr;
+
+    ThreadRecord* acquireRecord() {
+        for (auto* record = records.load(std::memory_order_acquire); record; record = record->next) {
+            bool expected = false;
+            if (!record->inUse.load(std::memory_order_relaxed) && record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+        auto* record = new ThreadRecord();
+        record->next = records.load(std::memory_order_relaxed);
+        while (!records.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed));
+        return record;
+    }
+
+    // Hands the record back when its thread exits
+    struct RecordHolder {
+        ThreadRecord* record = nullptr;
+        ~RecordHolder() {
+            if (record) record->inUse.store(false, std::memory_order_release);
+        }
+    };
+    thread_local RecordHolder currentRecord;
+
+    ThreadRecord* current() {
+        auto* record = currentRecord.record;
+        if (!record) record = currentRecord.record = acquireRecord();
+        return record;
+    }
+}
+
+void HookEpoch::Enter() noexcept {
+    auto* record = current();
+    if (record->depth++ == 0) {
+        record->counter.store(record->counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        // The announcement must be visible before this thread reads any hook pointers
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void HookEpoch::Exit() noexcept {
+    auto* record = currentRecord.record;
+    if (--record->depth == 0) {
+        record->counter.store(record->counter.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
+
+void HookEpoch::Synchronize() noexcept {
+    // Pairs with the fence in Enter: any thread that has not announced itself yet will see the caller's earlier unlinking
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<std::pair<ThreadRecord*, uint64_t>> busy;
+    for (auto* record = records.load(std::memory_order_acquire); record; record = record->next) {
+        auto counter = record->counter.load(std::memory_order_acquire);
+        if (counter & 1) busy.emplace_back(record, counter);
+    }
+    for (auto& [record, counter] : busy) {
+        while (record->counter.load(std::memory_order_acquire) == counter) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void HookEpoch::Defer(void (*func)(void*), void* arg) noexcept {
+    std::thread([func, arg]() {
+        Synchronize();
+        func(arg);
+    }).detach();
+}
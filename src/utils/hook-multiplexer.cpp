@@ -0,0 +1,186 @@
+#include "../../shared/utils/hook-multiplexer.hpp"
+#ifdef __aarch64__
+#include "../../shared/inline-hook/And64InlineHook.hpp"
+#include "../../shared/utils/logging.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    struct ChainEntry {
+        const char* name;
+        void* replace;
+        void** orig;
+        int priority;
+        uint64_t sequence;
+    };
+
+    struct Chain {
+        void* stub;
+        void* original;
+        // The first instruction of the target before it was patched
+        uint32_t saved;
+        // Ordered from first called to last called. Only writers (holding chainsLock) look at this,
+        // calls only ever follow the stub and orig pointers.
+        std::vector<ChainEntry> entries;
+    };
+
+    std::mutex chainsLock;
+    // Node based, so the address of Chain::original stays valid for A64HookFunctionBatch to write to
+    std::unordered_map<const void*, Chain> chains;
+    // Chains whose target was restored. A thread can be between the patched instruction and a hook's HookEpoch::Guard,
+    // or running the original code straight from the stub, without anything recording it, so their stub and trampoline
+    // are never freed. They are reused if their target is hooked again instead.
+    std::unordered_map<const void*, Chain> retired;
+    uint64_t nextSequence = 0;
+
+    bool calledBefore(const ChainEntry& lhs, const ChainEntry& rhs) {
+        return lhs.priority > rhs.priority || (lhs.priority == rhs.priority && lhs.sequence > rhs.sequence);
+    }
+
+    // Must hold chainsLock
+    void link(Chain& chain, const HookMultiplexer::Request& request) {
+        static auto logger = Logger::get().WithContext("HookMultiplexer");
+        ChainEntry entry{request.name, request.replace, request.orig, request.priority, nextSequence++};
+        auto pos = std::upper_bound(chain.entries.begin(), chain.entries.end(), entry, calledBefore);
+        auto index = pos - chain.entries.begin();
+        // The new hook must be able to continue the chain before anything can call it
+        __atomic_store_n(entry.orig, pos == chain.entries.end() ? chain.original : pos->replace, __ATOMIC_RELEASE);
+        chain.entries.insert(pos, entry);
+        if (index == 0) {
+            A64SetDispatchTarget(chain.stub, entry.replace);
+        } else {
+            __atomic_store_n(chain.entries[index - 1].orig, entry.replace, __ATOMIC_RELEASE);
+        }
+        BS_LOG_DEBUG(logger, "Added %s at position %td of %zu (priority %i)", entry.name, index, chain.entries.size(), entry.priority);
+    }
+
+    // Must hold chainsLock. Returns the new chain and the trampoline it should be hooked with, or nullptr.
+    Chain* createChain(void* target, void*& trampoline) {
+        static auto logger = Logger::get().WithContext("HookMultiplexer");
+        trampoline = A64AllocateTrampoline(target);
+        // Until the first hook is linked, the stub simply runs the original code
+        auto* stub = trampoline ? A64CreateDispatchStub(target, trampoline) : nullptr;
+        if (!stub) {
+            logger.error("Failed to allocate a dispatch stub for %p!", target);
+            A64FreeTrampoline(trampoline);
+            return nullptr;
+        }
+        return &chains.emplace(target, Chain{stub, nullptr, *static_cast<const uint32_t*>(target), {}}).first->second;
+    }
+
+    void destroyChain(const void* target) {
+        auto itr = chains.find(target);
+        A64FreeTrampoline(itr->second.stub);
+        chains.erase(itr);
+    }
+
+    // Must hold chainsLock. Patches target to jump to the stub of its retired chain again, and returns that chain, or nullptr.
+    Chain* reviveChain(const void* target) {
+        static auto logger = Logger::get().WithContext("HookMultiplexer");
+        auto itr = retired.find(target);
+        if (itr == retired.end()) return nullptr;
+        // The stub still runs the original code, so it is callable as soon as the target jumps to it
+        if (!A64ReapplyFunction(const_cast<void*>(target), itr->second.stub, itr->second.saved)) {
+            BS_LOG_DEBUG(logger, "Could not reuse the chain of %p, its first instruction has changed", target);
+            return nullptr;
+        }
+        auto* chain = &chains.emplace(target, std::move(itr->second)).first->second;
+        retired.erase(itr);
+        return chain;
+    }
+}
+
+bool HookMultiplexer::Add(const Request& request) noexcept {
+    std::scoped_lock lock(chainsLock);
+    auto itr = chains.find(request.target);
+    Chain* chain;
+    if (itr != chains.end()) {
+        chain = &itr->second;
+    } else if (!(chain = reviveChain(request.target))) {
+        void* trampoline;
+        chain = createChain(request.target, trampoline);
+        if (!chain) return false;
+        chain->original = A64HookFunctionV(request.target, chain->stub, trampoline, A64_TRAMPOLINE_SIZE);
+        if (!chain->original) {
+            A64FreeTrampoline(trampoline);
+            destroyChain(request.target);
+            return false;
+        }
+    }
+    link(*chain, request);
+    return true;
+}
+
+std::size_t HookMultiplexer::AddBatch(std::span<const Request> requests, std::size_t* pages) noexcept {
+    std::scoped_lock lock(chainsLock);
+    std::vector<A64HookRequest> patches;
+    std::vector<const void*> created;
+    for (auto& request : requests) {
+        if (chains.contains(request.target) || reviveChain(request.target)) continue;
+        void* trampoline;
+        auto* chain = createChain(request.target, trampoline);
+        if (!chain) continue;
+        patches.push_back({request.target, chain->stub, &chain->original, trampoline});
+        created.push_back(request.target);
+    }
+    std::size_t written = 0;
+    if (pages) *pages = 0;
+    if (!patches.empty()) A64HookFunctionBatch(patches.data(), patches.size(), pages);
+    for (auto* target : created) {
+        if (!chains.find(target)->second.original) destroyChain(target);
+    }
+    for (auto& request : requests) {
+        auto itr = chains.find(request.target);
+        if (itr == chains.end()) continue;
+        link(itr->second, request);
+        written++;
+    }
+    return written;
+}
+
+bool HookMultiplexer::Remove(const void* target, const void* replace) noexcept {
+    static auto logger = Logger::get().WithContext("HookMultiplexer");
+    std::scoped_lock lock(chainsLock);
+    auto itr = chains.find(target);
+    if (itr == chains.end()) return false;
+    auto& chain = itr->second;
+    auto pos = std::find_if(chain.entries.begin(), chain.entries.end(), [replace](const ChainEntry& entry) { return entry.replace == replace; });
+    if (pos == chain.entries.end()) return false;
+    auto index = pos - chain.entries.begin();
+    // Calls that already reached the removed hook still continue through its orig, which is left as is
+    auto* next = pos + 1 == chain.entries.end() ? chain.original : (pos + 1)->replace;
+    if (index == 0) {
+        A64SetDispatchTarget(chain.stub, next);
+    } else {
+        __atomic_store_n(chain.entries[index - 1].orig, next, __ATOMIC_RELEASE);
+    }
+    BS_LOG_DEBUG(logger, "Removed %s from position %td of %zu", pos->name, index, chain.entries.size());
+    chain.entries.erase(pos);
+    if (!chain.entries.empty()) return true;
+    // Restoring the target is a single instruction swap if it was patched with a "B". Otherwise (or if something else has
+    // since patched over it) the chain stays in place as a passthrough to the original, and is reused by the next Add.
+    if (!A64RestoreFunction(const_cast<void*>(target), chain.stub, chain.saved)) {
+        BS_LOG_DEBUG(logger, "Left an empty chain in place for %p", target);
+        return true;
+    }
+    // Replaces any older retired chain of target (if reviving it failed), which simply stays mapped
+    retired.insert_or_assign(target, std::move(chain));
+    chains.erase(itr);
+    return true;
+}
+
+void* HookMultiplexer::GetOriginal(const void* target) noexcept {
+    std::scoped_lock lock(chainsLock);
+    auto itr = chains.find(target);
+    return itr != chains.end() ? itr->second.original : nullptr;
+}
+
+std::size_t HookMultiplexer::Count(const void* target) noexcept {
+    std::scoped_lock lock(chainsLock);
+    auto itr = chains.find(target);
+    return itr != chains.end() ? itr->second.entries.size() : 0;
+}
+#endif
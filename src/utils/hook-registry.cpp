@@ -0,0 +1,211 @@
+#include "../../shared/utils/hook-registry.hpp"
+#include "../../shared/utils/logging.hpp"
+#include "../../shared/utils/module-map.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+    // Whether [address, address + size) is in one readable and writable anonymous mapping
+    bool isAnonymousMapping(uintptr_t address, std::size_t size) {
+        auto map = ModuleMap::Get();
+        auto* segment = map->FindSegment(address);
+        if (!segment) {
+            // Mapped by another copy after the map was cached
+            ModuleMap::Invalidate();
+            map = ModuleMap::Get();
+            segment = map->FindSegment(address);
+        }
+        return segment && segment->module == ModuleMap::npos && segment->readable && segment->writable && size <= segment->end - address;
+    }
+
+    HookRegistry::Table* parse(const char* value) {
+        uintptr_t address;
+        if (!value || sscanf(value, "%" SCNxPTR, &address) != 1) return nullptr;
+        if (address % alignof(HookRegistry::Table) != 0 || !isAnonymousMapping(address, sizeof(HookRegistry::Table))) return nullptr;
+        auto* table = reinterpret_cast<HookRegistry::Table*>(address);
+        if (table->magic != HookRegistry::magic || table->version != HookRegistry::version || table->capacity != HookRegistry::capacity) return nullptr;
+        if (table->process != getpid()) return nullptr;
+        return table;
+    }
+
+    void forgetInChild() {
+        // Libraries this child loads use a table of their own, and anything it execs must not look for this one
+        unsetenv(HookRegistry::envName);
+    }
+
+    HookRegistry::Table* attach() {
+        static auto logger = Logger::get().WithContext("HookRegistry");
+        if (auto* table = parse(getenv(HookRegistry::envName))) return table;
+        // Anonymous mappings are zero filled, which is an empty table. Untouched pages are never committed.
+        auto* mapping = mmap(nullptr, sizeof(HookRegistry::Table), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            logger.error("Failed to map the hook registry! errno: %i", errno);
+            return nullptr;
+        }
+        auto* table = static_cast<HookRegistry::Table*>(mapping);
+        table->magic = HookRegistry::magic;
+        table->version = HookRegistry::version;
+        table->capacity = HookRegistry::capacity;
+        table->process = getpid();
+        char value[2 * sizeof(uintptr_t) + 1];
+        snprintf(value, sizeof(value), "%" PRIxPTR, reinterpret_cast<uintptr_t>(table));
+        // Libraries are loaded one at a time, but if another copy published its table first, use that one.
+        // A stale or foreign value (one that parse rejects) is replaced.
+        setenv(HookRegistry::envName, value, parse(getenv(HookRegistry::envName)) == nullptr);
+        auto* published = parse(getenv(HookRegistry::envName));
+        if (published != table) {
+            munmap(mapping, sizeof(HookRegistry::Table));
+            if (!published) logger.error("Failed to publish the hook registry!");
+            return published;
+        }
+        pthread_atfork(nullptr, nullptr, forgetInChild);
+        BS_LOG_DEBUG(logger, "Created the hook registry at %p", table);
+        return table;
+    }
+}
+
+HookRegistry::Table* HookRegistry::Get() noexcept {
+    static Table* table = attach();
+    return table;
+}
+
+namespace {
+    HookRegistry::Slot* find(HookRegistry::Table* table, const void* target, const void* hook, std::size_t bucket) {
+        for (auto i = bucket, n = std::size_t(0); n < HookRegistry::capacity; i = (i + 1) & (HookRegistry::capacity - 1), n++) {
+            auto& slot = table->slots[i];
+            auto state = slot.state.load(std::memory_order_acquire);
+            if (state == HookRegistry::Slot::Empty) return nullptr;
+            if (state == HookRegistry::Slot::Published && slot.target == target && slot.hook == hook) return &slot;
+        }
+        return nullptr;
+    }
+}
+
+const void* HookRegistry::Owner() noexcept {
+    // Every copy of the library has its own copy of this
+    static const char owner = 0;
+    return &owner;
+}
+
+bool HookRegistry::Add(const void* target, const void* hook, const void* orig, std::string_view name, uint32_t* index) noexcept {
+    static auto logger = Logger::get().WithContext("HookRegistry");
+    auto* table = Get();
+    if (!table) return false;
+    for (auto i = Bucket(target), n = std::size_t(0); n < capacity; i = (i + 1) & (capacity - 1), n++) {
+        auto& slot = table->slots[i];
+        auto state = slot.state.load(std::memory_order_acquire);
+        if (state == Slot::Empty && slot.state.compare_exchange_strong(state, Slot::Claimed, std::memory_order_acquire)) {
+            slot.target = target;
+            slot.hook = hook;
+            slot.owner = Owner();
+            slot.orig.store(orig, std::memory_order_relaxed);
+            slot.sequence.store(table->nextSequence.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+            auto length = std::min(name.size(), maxNameLength);
+            memcpy(slot.name, name.data(), length);
+            slot.name[length] = '\0';
+            slot.live.store(1, std::memory_order_relaxed);
+            slot.state.store(Slot::Published, std::memory_order_release);
+            table->count.fetch_add(1, std::memory_order_relaxed);
+            table->generation.fetch_add(1, std::memory_order_release);
+            if (index) *index = i;
+            return true;
+        }
+        // If someone else claimed the slot first, it may be for the same hook, so wait for it to be published
+        while (state == Slot::Claimed) state = slot.state.load(std::memory_order_acquire);
+        if (slot.target == target && slot.hook == hook) {
+            // Reinstalled after being removed
+            slot.orig.store(orig, std::memory_order_relaxed);
+            slot.sequence.store(table->nextSequence.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+            if (!slot.live.exchange(1, std::memory_order_release)) table->count.fetch_add(1, std::memory_order_relaxed);
+            table->generation.fetch_add(1, std::memory_order_release);
+            if (index) *index = i;
+            return true;
+        }
+    }
+    logger.error("The hook registry is full! Could not add: %.*s", static_cast<int>(name.size()), name.data());
+    return false;
+}
+
+bool HookRegistry::Remove(const void* target, const void* hook) noexcept {
+    auto* table = Get();
+    auto* slot = table ? find(table, target, hook, Bucket(target)) : nullptr;
+    if (!slot || !slot->live.exchange(0, std::memory_order_release)) return false;
+    table->count.fetch_sub(1, std::memory_order_relaxed);
+    table->generation.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+bool HookRegistry::SetOrig(const void* target, const void* hook, const void* orig) noexcept {
+    auto* table = Get();
+    auto* slot = table ? find(table, target, hook, Bucket(target)) : nullptr;
+    if (!slot || !slot->live.load(std::memory_order_acquire)) return false;
+    slot->orig.store(orig, std::memory_order_relaxed);
+    table->generation.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+namespace {
+    HookRegistry::Slot* at(HookRegistry::Table* table, uint32_t index, const void* target) {
+        if (!table || index >= HookRegistry::capacity) return nullptr;
+        auto& slot = table->slots[index];
+        if (slot.state.load(std::memory_order_acquire) != HookRegistry::Slot::Published || slot.target != target) return nullptr;
+        return &slot;
+    }
+}
+
+bool HookRegistry::RemoveAt(uint32_t index, const void* target, const void** hook) noexcept {
+    auto* table = Get();
+    auto* slot = at(table, index, target);
+    if (!slot || !slot->live.exchange(0, std::memory_order_release)) return false;
+    table->count.fetch_sub(1, std::memory_order_relaxed);
+    table->generation.fetch_add(1, std::memory_order_release);
+    if (hook) *hook = slot->hook;
+    return true;
+}
+
+bool HookRegistry::SetOrigAt(uint32_t index, const void* target, const void* orig) noexcept {
+    auto* table = Get();
+    auto* slot = at(table, index, target);
+    if (!slot || !slot->live.load(std::memory_order_acquire)) return false;
+    slot->orig.store(orig, std::memory_order_relaxed);
+    table->generation.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+uint64_t HookRegistry::Generation() noexcept {
+    auto* table = Get();
+    // Starts at 1, so that 0 can mean "no table"
+    return table ? table->generation.load(std::memory_order_acquire) + 1 : 0;
+}
+
+bool HookRegistry::IsHooked(const void* target) noexcept {
+    auto* table = Get();
+    if (!table) return false;
+    for (auto i = Bucket(target), n = std::size_t(0); n < capacity; i = (i + 1) & (capacity - 1), n++) {
+        auto& slot = table->slots[i];
+        auto state = slot.state.load(std::memory_order_acquire);
+        if (state == Slot::Empty) return false;
+        if (state == Slot::Published && slot.target == target && slot.live.load(std::memory_order_acquire)) return true;
+    }
+    return false;
+}
+
+const void* HookRegistry::GetOrig(const void* target) noexcept {
+    const void* orig = nullptr;
+    uint64_t first = UINT64_MAX;
+    ForEach(target, [&](const Slot& slot) {
+        auto sequence = slot.sequence.load(std::memory_order_relaxed);
+        if (sequence < first) {
+            first = sequence;
+            orig = slot.orig.load(std::memory_order_relaxed);
+        }
+    });
+    return orig;
+}
@@ -1,171 +1,286 @@
 #include "../../shared/utils/hook-tracker.hpp"
 #include "shared/utils/instruction-parsing.hpp"
+#include "../../shared/utils/hook-multiplexer.hpp"
+#include "../../shared/utils/hook-registry.hpp"
+#include "../../shared/utils/module-map.hpp"
+#include "../../shared/inline-hook/And64InlineHook.hpp"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_set>
 
-std::unordered_map<const void*, std::list<HookInfo>> HookTracker::hooks;
+namespace {
+    // Names are only ever added, so views of them stay valid
+    std::string_view intern(std::string_view name) {
+        static std::mutex namesLock;
+        static std::unordered_set<std::string> names;
+        std::lock_guard<std::mutex> lock(namesLock);
+        return *names.emplace(name).first;
+    }
 
-void HookTracker::AddHook(HookInfo info) noexcept {
-    auto itr = hooks.find(info.destination);
-    if (itr == hooks.end()) {
-        hooks.emplace(info.destination, std::list<HookInfo>()).first->second.emplace_back(info);
-    } else {
-        itr->second.emplace_back(info);
+    std::size_t bucketOf(const void* location, std::size_t size) {
+        return static_cast<std::size_t>(((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(location)) >> 2) * 0x9E3779B97F4A7C15ull) >> 32) & (size - 1);
     }
-}
 
-void HookTracker::RemoveHook(HookInfo info) noexcept {
-    auto itr = hooks.find(info.destination);
-    if (itr != hooks.end()) {
-        for (auto& item : itr->second) {
-            if (item == info) {
-                itr->second.remove(item);
-            }
-        }
+    // Guards HookTracker::current and everything below
+    std::mutex trackerLock;
+    // Hooks that could not be added to the HookRegistry, which are only tracked here.
+    // Their ids start after the registry's slot indices.
+    std::vector<HookInfo> unregistered;
+    uint32_t nextUnregisteredId = HookRegistry::capacity;
+
+    bool isOwn(const HookInfo& info) {
+        if (info.id >= HookRegistry::capacity) return true;
+        return HookRegistry::Get()->slots[info.id].owner == HookRegistry::Owner();
     }
 }
 
-void HookTracker::RemoveHooks() noexcept {
-    hooks.clear();
-}
+// Reset when an unregistered hook changes, and replaced by the next query when it is out of date
+std::shared_ptr<const HookTracker::Snapshot> HookTracker::current;
 
-void HookTracker::RemoveHooks(const void* const location) noexcept {
-    auto itr = hooks.find(location);
-    if (itr != hooks.end()) {
-        hooks.erase(itr);
+HookInfo::HookInfo(std::string_view name_, const void* dst, const void* src, const void* orig_)
+    : name(intern(name_)), destination(dst), trampoline(src), orig(orig_) {}
+
+const HookTracker::Bucket* HookTracker::Snapshot::Find(const void* location) const noexcept {
+    if (buckets.empty()) return nullptr;
+    for (auto i = bucketOf(location, buckets.size());; i = (i + 1) & (buckets.size() - 1)) {
+        auto& bucket = buckets[i];
+        if (bucket.location == location) return &bucket;
+        if (!bucket.location) return nullptr;
     }
 }
 
-bool HookTracker::IsHooked(const void* const location) noexcept {
-    CombineHooks();
-    auto itr = hooks.find(location);
-    if (itr != hooks.end()) {
-        return itr->second.size() > 0;
+std::shared_ptr<const HookTracker::Snapshot> HookTracker::Current() noexcept {
+    // Freed after unlocking, unless something else still holds it
+    std::shared_ptr<const Snapshot> old;
+    std::lock_guard<std::mutex> lock(trackerLock);
+    auto generation = HookRegistry::Generation();
+    if (current && current->generation == generation) return current;
+    // Every copy of beatsaber-hook records its hooks in the shared HookRegistry, so the snapshot is built from it
+    std::vector<std::pair<uint64_t, HookInfo>> live;
+    if (generation != 0) {
+        auto* slots = HookRegistry::Get()->slots;
+        HookRegistry::ForEach([&live, slots](const HookRegistry::Slot& slot) {
+            HookInfo info(slot.name, slot.target, slot.hook, slot.orig.load(std::memory_order_relaxed));
+            info.id = static_cast<uint32_t>(&slot - slots);
+            live.emplace_back(slot.sequence.load(std::memory_order_relaxed), info);
+        });
+        std::sort(live.begin(), live.end(), [](auto& lhs, auto& rhs) { return lhs.first < rhs.first; });
     }
-    return false;
+    // At most half full, with every hook at a location of its own
+    std::size_t size = 64;
+    while (size < (live.size() + unregistered.size()) * 2) size *= 2;
+    auto snapshot = std::make_shared<Snapshot>(Snapshot{generation, std::vector<Bucket>(size)});
+    auto add = [&buckets = snapshot->buckets](const HookInfo& info) {
+        auto i = bucketOf(info.destination, buckets.size());
+        while (buckets[i].location && buckets[i].location != info.destination) i = (i + 1) & (buckets.size() - 1);
+        buckets[i].location = info.destination;
+        buckets[i].hooks.push_back(info);
+    };
+    for (auto& [sequence, info] : live) add(info);
+    for (auto& info : unregistered) add(info);
+    old = std::exchange(current, snapshot);
+    return snapshot;
 }
 
-const std::list<HookInfo> HookTracker::GetHooks(const void* const location) noexcept {
-    CombineHooks();
-    auto itr = hooks.find(location);
-    if (itr != hooks.end()) {
-        return itr->second;
+HookHandle HookTracker::AddHook(HookInfo info) noexcept {
+    uint32_t index;
+    if (HookRegistry::Add(info.destination, info.trampoline, info.orig, info.name, &index)) {
+        // Picked up by the next query
+        return {info.destination, index};
     }
-    return std::list<HookInfo>();
+    std::shared_ptr<const Snapshot> old;
+    std::lock_guard<std::mutex> lock(trackerLock);
+    info.id = nextUnregisteredId++;
+    unregistered.push_back(info);
+    old = std::move(current);
+    return {info.destination, info.id};
 }
 
-const std::unordered_map<const void*, std::list<HookInfo>>* HookTracker::GetHooks() noexcept {
-    return &hooks;
+void HookTracker::RemoveHook(HookInfo info) noexcept {
+    // Identified by destination and trampoline only: the name recorded in the registry may be truncated, and the orig changed by SetOrig
+    if (!HookRegistry::Remove(info.destination, info.trampoline)) {
+        std::shared_ptr<const Snapshot> old;
+        std::lock_guard<std::mutex> lock(trackerLock);
+        auto erased = std::erase_if(unregistered, [&info](const HookInfo& hook) {
+            return hook.destination == info.destination && hook.trampoline == info.trampoline;
+        });
+        if (erased) old = std::move(current);
+    }
+    #ifdef __aarch64__
+    // Also unpatch it, if it is still installed (does nothing when called from Hooking::UninstallHook)
+    HookMultiplexer::Remove(info.destination, info.trampoline);
+    #endif
 }
 
-const void* HookTracker::GetOrigInternal(const void* const location) noexcept {
-    CombineHooks();
-    auto itr = hooks.find(location);
-    if (itr != hooks.end() && itr->second.size() > 0) {
-        return itr->second.front().orig;
+void HookTracker::RemoveHook(HookHandle handle) noexcept {
+    // Handles of registered hooks are slot indices, so neither this nor SetOrig needs to look at (or rebuild) the snapshot
+    const void* trampoline = nullptr;
+    if (handle.id < HookRegistry::capacity) {
+        if (!HookRegistry::RemoveAt(handle.id, handle.destination, &trampoline)) return;
+    } else {
+        std::shared_ptr<const Snapshot> old;
+        std::lock_guard<std::mutex> lock(trackerLock);
+        auto itr = std::find_if(unregistered.begin(), unregistered.end(), [id = handle.id](const HookInfo& hook) { return hook.id == id; });
+        if (itr == unregistered.end() || itr->destination != handle.destination) return;
+        trampoline = itr->trampoline;
+        unregistered.erase(itr);
+        old = std::move(current);
     }
-    return location;
+    #ifdef __aarch64__
+    // Also unpatch it, if it is still installed (does nothing when called from Hooking::UninstallHook)
+    HookMultiplexer::Remove(handle.destination, trampoline);
+    #endif
 }
 
-#ifndef LIBS_FILE_PATH
-#define LIBS_FILE_PATH "/sdcard/Android/data/%s/files/libs"
-#endif
-
-#define MOD_TEMP_PATH_FMT "/data/data/%s/"
-
-#include <dirent.h>
-
-void HookTracker::CombineHooks() noexcept {
-    static auto logger = Logger::get().WithContext("HookTracker");
-    auto libsFolder = string_format(LIBS_FILE_PATH, Modloader::getApplicationId().c_str());
-    auto tmpPath = string_format(MOD_TEMP_PATH_FMT, Modloader::getApplicationId().c_str());
-    DIR* dir = opendir(libsFolder.c_str());
-    if (dir == nullptr) {
-        logger.warning("Failed to open libs folder! At path: %s", libsFolder.c_str());
+void HookTracker::SetOrig(HookHandle handle, const void* orig) noexcept {
+    if (handle.id < HookRegistry::capacity) {
+        HookRegistry::SetOrigAt(handle.id, handle.destination, orig);
         return;
     }
-    struct dirent* dp;
-    while ((dp = readdir(dir)) != NULL) {
-        if (std::string(dp->d_name).starts_with("libbeatsaber-hook")) {
-            // Find and combine
-            auto path = tmpPath + dp->d_name;
-            auto* image = dlopen(path.c_str(), RTLD_LAZY | RTLD_LOCAL);
-            auto* err = dlerror();
-            if (image == nullptr || err != nullptr) {
-                logger.warning("Failed to dlopen: %s! %s", path.c_str(), err);
-                continue;
-            }
-            // Open the library, look for a function called: __HOOKTRACKER_GET_HOOKS
-            auto* getter = dlsym(image, "__HOOKTRACKER_GET_HOOKS");
-            if (getter == nullptr) {
-                logger.warning("Failed to find symbol: %s", "__HOOKTRACKER_GET_HOOKS");
-                continue;
-            }
-            // Of course, if the function returns something that is of a different HookInfo type, for example, this may cause all sorts of pain.
-            auto otherHooks = *reinterpret_cast<const std::unordered_map<const void*, std::list<HookInfo>>*(*)()>(getter)();
-            for (auto itr : otherHooks) {
-                // For each void*, find our match
-                auto match = hooks.find(itr.first);
-                if (match == hooks.end()) {
-                    hooks.insert({itr.first, itr.second});
-                } else {
-                    // Add only unique items
-                    for (auto item : itr.second) {
-                        bool unique = true;
-                        for (auto& existing : match->second) {
-                            if (existing == item) {
-                                unique = false;
-                                break;
-                            }
-                        }
-                        if (unique) {
-                            match->second.push_back(item);
-                        }
-                    }
-                }
-            }
-            dlclose(image);
+    std::shared_ptr<const Snapshot> old;
+    std::lock_guard<std::mutex> lock(trackerLock);
+    for (auto& hook : unregistered) {
+        if (hook.id == handle.id && hook.destination == handle.destination) {
+            hook.orig = orig;
+            old = std::move(current);
+        }
+    }
+}
+
+void HookTracker::RemoveHooks() noexcept {
+    // Only this library's hooks, the others are tracked by their own library
+    ForEachHooked([](const void*, std::span<const HookInfo> hooks) {
+        for (auto& hook : hooks) {
+            if (hook.id < HookRegistry::capacity && isOwn(hook)) HookRegistry::Remove(hook.destination, hook.trampoline);
         }
+    });
+    std::shared_ptr<const Snapshot> old;
+    std::lock_guard<std::mutex> lock(trackerLock);
+    unregistered.clear();
+    old = std::move(current);
+}
+
+void HookTracker::RemoveHooks(const void* const location) noexcept {
+    for (auto& hook : GetHooks(location)) {
+        if (hook.id < HookRegistry::capacity && isOwn(hook)) HookRegistry::Remove(hook.destination, hook.trampoline);
     }
+    std::shared_ptr<const Snapshot> old;
+    std::lock_guard<std::mutex> lock(trackerLock);
+    std::erase_if(unregistered, [location](const HookInfo& hook) { return hook.destination == location; });
+    old = std::move(current);
+}
+
+bool HookTracker::IsHooked(const void* const location) noexcept {
+    if (HookRegistry::IsHooked(location)) return true;
+    std::lock_guard<std::mutex> lock(trackerLock);
+    return std::any_of(unregistered.begin(), unregistered.end(), [location](const HookInfo& hook) { return hook.destination == location; });
 }
 
-extern "C" const void* __HOOKTRACKER_GET_HOOKS() {
-    return reinterpret_cast<const void*>(HookTracker::GetHooks());
+HookList HookTracker::GetHooks(const void* const location) noexcept {
+    auto snapshot = Current();
+    auto* bucket = snapshot->Find(location);
+    if (!bucket) return {};
+    return {std::span<const HookInfo>(bucket->hooks), std::move(snapshot)};
 }
 
-// Represents the number of instructions to search for the original (BLR)
+// Represents the number of instructions of a hook's function to search for the call to its original (BLR)
 #ifndef HOOKTRACKER_ORIG_SEARCH_COUNT
 #define HOOKTRACKER_ORIG_SEARCH_COUNT 500
 #endif
 
-// TODO: Implement and use this function
-const void* getOrigHelper(const void* const location, bool inTrampoline = false) noexcept {
-    // If we are a hook, we can't find our orig here, we must travel to our hook implementation.
-    Instruction inst(reinterpret_cast<const int32_t*>(location));
-    if (inst.isNOP()) {
-        inst = Instruction(reinterpret_cast<const int32_t*>(location) + 1);
+namespace {
+    // The most instructions a hook overwrites (and its trampoline relocates)
+    constexpr std::ptrdiff_t maxOverwritten = 5;
+
+    // The segment address is in, which stays valid while map is held. Trampolines and dispatch stubs (ours and other hookers') are
+    // usually mapped after the cached map was parsed, so a miss parses the mappings again once.
+    const ModuleMap::Segment* findSegment(std::shared_ptr<const ModuleMap>& map, uintptr_t address) noexcept {
+        if (auto* segment = map->FindSegment(address)) return segment;
+        ModuleMap::Invalidate();
+        map = ModuleMap::Get();
+        return map->FindSegment(address);
     }
-    if (inst.isLoad() && inst.size == 8 && inst.label == inst.addr + 2) {
-        // For hooks, label will always be 8 past address of function.
-        // This label points to the trampoline.
-        // However, this isn't necessarily all we need to do, since we could have MULTIPLE functions hooking this.
-        // So, we will need to recurse here as well.
-        return getOrigHelper(reinterpret_cast<const void*>(*inst.label), true);
+
+    // Where the hook installed at location (if any) jumps to: its LDR (literal) PC + 0x8 (possibly after a NOP) loads it from after the
+    // BR that follows, and a multiplexed hook's B goes to a dispatch stub that does the same.
+    const int32_t* hookDestination(const int32_t* location) noexcept {
+        auto* insn = reinterpret_cast<const uint32_t*>(location);
+        if ((insn[0] & 0xfc000000u) == 0x14000000u) {
+            auto* stub = insn + (static_cast<int32_t>(insn[0] << 6) >> 6);
+            auto map = ModuleMap::Get();
+            auto* segment = findSegment(map, reinterpret_cast<uintptr_t>(stub));
+            if (!segment || !segment->executable || reinterpret_cast<uintptr_t>(stub + 4) > segment->end) return nullptr;
+            if (stub[0] == 0x58000051u && stub[1] == 0xd61f0220u) return *reinterpret_cast<const int32_t* const*>(stub + 2);
+            // Hooks close enough to their function are just a B to it, which is checked for when its trampoline is found
+            return reinterpret_cast<const int32_t*>(stub);
+        }
+        Instruction inst(location);
+        if (inst.isNOP()) {
+            inst = Instruction(location + 1);
+        }
+        if (inst.isLoad() && inst.size == 8 && inst.label == inst.addr + 2) return *reinterpret_cast<const int32_t* const*>(*inst.label);
+        return nullptr;
+    }
+
+    // Whether the code at trampoline is one for the hook at location: after the instructions the hook overwrote, it jumps back to right
+    // after them (with a B, or a LDR X17, #0x8 and BR X17).
+    bool jumpsBackTo(const int32_t* trampoline, const int32_t* location) noexcept {
+        auto map = ModuleMap::Get();
+        auto* segment = findSegment(map, reinterpret_cast<uintptr_t>(trampoline));
+        if (!segment || !segment->executable) return false;
+        auto* end = std::min(trampoline + A64_TRAMPOLINE_SIZE, reinterpret_cast<const int32_t*>(segment->end));
+        for (auto* pc = trampoline; pc < end; pc++) {
+            EncodedInstruction inst(pc);
+            const int32_t* back;
+            if (inst.opcode == Opcode::B) {
+                back = *inst.label();
+            } else if (inst.code == 0x58000051u && pc + 3 < end && static_cast<uint32_t>(pc[1]) == 0xd61f0220u) {
+                back = *reinterpret_cast<const int32_t* const*>(pc + 2);
+            } else {
+                continue;
+            }
+            // Relocated branches jump elsewhere, but nothing else jumps to just past the hook
+            if (back > location && back <= location + maxOverwritten) return true;
+        }
+        return false;
     }
-    if (!inTrampoline) {
-        // If we are not in a trampoline and we are not hooked, we simply exit.
+
+    // The trampoline (as its hook's function calls it) of the hook at location that was installed without HookTracker knowing, if any
+    const void* getOrigHelper(const void* const location) noexcept {
+        auto* code = reinterpret_cast<const int32_t*>(location);
+        auto* destination = hookDestination(code);
+        if (!destination) return location;
+        // The hook's function calls its orig through a pointer to the trampoline, which it was given when it was installed
+        auto function = AssemblyFunction::Get(destination);
+        RegisterEvaluator evaluator(*function);
+        auto map = ModuleMap::Get();
+        for (auto& xref : evaluator.Xrefs(Xref::CALL_THROUGH)) {
+            if (xref.at - destination >= HOOKTRACKER_ORIG_SEARCH_COUNT) break;
+            auto* segment = findSegment(map, xref.address);
+            if (!segment || !segment->readable || xref.address + sizeof(void*) > segment->end) continue;
+            auto* trampoline = *reinterpret_cast<const int32_t* const*>(xref.address);
+            if (trampoline && jumpsBackTo(trampoline, code)) return trampoline;
+        }
+        // Most likely the orig is not called, or not through a pointer that can be traced this simply
         return location;
     }
-    // Look for all BLs in this function, if we find any, trace their remaining asm to see if they match the remaining instructions from our location
-    // We shall assume for the sake of simplicity that the original function is going to be called within 100 instructions
-    for (int i = 0; i < HOOKTRACKER_ORIG_SEARCH_COUNT; i++) {
-        if (inst.branchType == Instruction::BranchType::INDCALL) {
-            // Source register needs to be emulated/traced
-            // It should be from a LDR from a static field
-            // inst.Rs[0]
+}
+
+const void* HookTracker::GetOrigInternal(const void* const location) noexcept {
+    // The registry can answer this without bringing the snapshot up to date
+    if (auto* orig = HookRegistry::GetOrig(location)) return orig;
+    {
+        std::lock_guard<std::mutex> lock(trackerLock);
+        for (auto& hook : unregistered) {
+            if (hook.destination == location) return hook.orig;
         }
     }
-    // We can't find the orig function, but we know we are in a trampoline. Chances are the orig is not called or this function is too big.
+    return getOrigHelper(location);
+}
 
-    return location;
+void HookTracker::CombineHooks() noexcept {
+    Current();
 }
 
 const void* HookTracker::InstructionGetOrig(const void* const location) noexcept {
@@ -185,6 +300,14 @@ const void* HookTracker::InstructionGetOrig(const void* const location) noexcept
 }
 
 bool HookTracker::InstructionIsHooked(const void* const location) noexcept {
+    #ifdef __aarch64__
+    // Multiplexed hooks may instead be a single B to a nearby dispatch stub (LDR X17, #0x8; BR X17)
+    auto* insn = reinterpret_cast<const uint32_t*>(location);
+    if ((insn[0] & 0xfc000000u) == 0x14000000u) {
+        auto* stub = insn + (static_cast<int32_t>(insn[0] << 6) >> 6);
+        return stub[0] == 0x58000051u && stub[1] == 0xd61f0220u;
+    }
+    #endif
     // First actual instruction should be an LDR (literal) PC + 0x8
     Instruction inst(reinterpret_cast<const int32_t*>(location));
     if (inst.isNOP()) {
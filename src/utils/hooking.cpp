@@ -0,0 +1,71 @@
+#include "../../shared/utils/hooking.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#ifndef __aarch64__
+#include "../../shared/inline-hook/inlineHook.h"
+#endif
+
+namespace Hooking {
+    static long long elapsedUs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    long long ResolveBatch(std::span<BatchHook> hooks, bool parallel) noexcept {
+        auto start = std::chrono::steady_clock::now();
+        // Resolving is cheap once a class is cached, so only split large batches, and never into tiny pieces
+        std::size_t threadCount = parallel ? std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), hooks.size() / 32) : 0;
+        if (threadCount <= 1) {
+            for (auto& hook : hooks) {
+                hook.target = hook.resolve();
+            }
+            return elapsedUs(start);
+        }
+        // Lookups may allocate managed objects, so every worker must be attached to the domain
+        il2cpp_functions::Init();
+        auto* domain = il2cpp_functions::domain_get();
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (std::size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([hooks, domain, t, threadCount]() {
+                auto* thread = domain ? il2cpp_functions::thread_attach(domain) : nullptr;
+                for (std::size_t i = t; i < hooks.size(); i += threadCount) {
+                    hooks[i].target = hooks[i].resolve();
+                }
+                if (thread) il2cpp_functions::thread_detach(thread);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        return elapsedUs(start);
+    }
+
+    BatchStats InstallResolvedBatch(std::span<BatchHook> hooks) noexcept {
+        auto start = std::chrono::steady_clock::now();
+        BatchStats stats{0, 0, 0, 0};
+        #ifdef __aarch64__
+        std::vector<HookMultiplexer::Request> requests;
+        requests.reserve(hooks.size());
+        for (auto& hook : hooks) {
+            if (hook.target) requests.push_back({hook.name, hook.target, hook.hook, hook.trampoline, 0});
+        }
+        stats.installed = HookMultiplexer::AddBatch(requests, &stats.pages);
+        #else
+        for (auto& hook : hooks) {
+            if (hook.target) registerInlineHook((uint32_t) hook.target, (uint32_t) hook.hook, (uint32_t **) hook.trampoline);
+        }
+        // Patches every registered hook while the other threads are frozen once, instead of once per hook
+        inlineHookAll();
+        stats.installed = std::count_if(hooks.begin(), hooks.end(), [](const BatchHook& hook) { return hook.target != nullptr; });
+        #endif
+        stats.patchUs = elapsedUs(start);
+        #ifdef __aarch64__
+        for (auto& hook : hooks) {
+            if (hook.target && *hook.trampoline) {
+                HookTracker::AddHook(hook.name, hook.target, hook.hook, HookMultiplexer::GetOriginal(hook.target));
+            }
+        }
+        #endif
+        return stats;
+    }
+}
@@ -1,4 +1,11 @@
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
 
 #include "../../shared/utils/hooking.hpp"
 #include "../../shared/utils/il2cpp-functions.hpp"
@@ -355,6 +362,14 @@ Il2CppClass* il2cpp_functions::MetadataCache_GetNestedTypeFromIndex(NestedTypeIn
     return il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex(nestedTypeIndices[index]);
 }
 
+TypeDefinitionIndex il2cpp_functions::MetadataCache_GetNestedTypeDefinitionIndexFromIndex(NestedTypeIndex index) {
+    CheckS_GlobalMetadata();
+    IL2CPP_ASSERT(index >= 0 && static_cast<uint32_t>(index) <= s_GlobalMetadataHeader->nestedTypesCount / sizeof(TypeDefinitionIndex));
+    auto nestedTypeIndices = (const TypeDefinitionIndex*)((const char*)s_GlobalMetadata + s_GlobalMetadataHeader->nestedTypesOffset);
+
+    return nestedTypeIndices[index];
+}
+
 TypeDefinitionIndex il2cpp_functions::MetadataCache_GetIndexForTypeDefinition(const Il2CppClass* typeDefinition) {
     CheckS_GlobalMetadata();
     IL2CPP_ASSERT(typeDefinition->typeDefinition);
@@ -368,7 +383,7 @@ TypeDefinitionIndex il2cpp_functions::MetadataCache_GetIndexForTypeDefinition(co
 }
 
 char* il2cpp_functions::Type_GetName(const Il2CppType *type, Il2CppTypeNameFormat format) {
-    if (!il2cpp_functions::_Type_GetName_) return nullptr;
+    if (!il2cpp_functions::Resolve(il2cpp_functions::_Type_GetName_)) return nullptr;
     // TODO debug the ref/lifetime weirdness with _Type_GetName_ to avoid the need for explicit allocation
     const auto str = il2cpp_functions::_Type_GetName_(type, format);
     char* buffer = static_cast<char*>(il2cpp_functions::alloc(str.length() + 1));
@@ -376,37 +391,136 @@ char* il2cpp_functions::Type_GetName(const Il2CppType *type, Il2CppTypeNameForma
     return buffer;
 }
 
-static bool find_GC_free(const int32_t* Runtime_Shutdown) {
-    bool multipleMatches;
-    auto sigMatch = findUniquePatternInLibil2cpp(multipleMatches, "f8 5f bc a9 f6 57 01 a9 f4 4f 02 a9 "
-        "fd 7b 03 a9 fd c3 00 91 a0 08 00 b4 f3 03 00 aa ?? ?? ?? ?? 69 82 56 d3 4a ?? ?? 91 4b 0d 09 8b 49 55 40 f9 "
-        "0a 9c 9c 52 0a 04 a0 72 00 cc 74 92 68 fe 56 d3 6c 01 0a 8b 0a 03 84 52", "GC_free");
-    if (sigMatch && !multipleMatches) {
-        il2cpp_functions::GC_free = (decltype(il2cpp_functions::GC_free))sigMatch;
-    } else {
-        static auto logger = il2cpp_functions::getFuncLogger().WithContext("find_GC_free");
-        // xref tracing __WILL__ fail if Runtime_Shutdown is hooked by __ANY__ lib/mod, such as another bs-hook's file logger.
-        Instruction Runtime_Shutdown_inst(Runtime_Shutdown);
-        auto blr = RET_0_UNLESS(logger, Runtime_Shutdown_inst.findNth(1, std::mem_fn(&Instruction::isIndirectBranch)));
-        auto j2GC_FF = RET_0_UNLESS(logger, blr->findNthCall(5));  // BL(R)
-        if (blr != &Runtime_Shutdown_inst) delete blr;
-        Instruction GC_FreeFixed(RET_0_UNLESS(logger, j2GC_FF->label));
-        il2cpp_functions::GC_free = (decltype(il2cpp_functions::GC_free))RET_0_UNLESS(logger, GC_FreeFixed.label);
-        if (j2GC_FF != blr) delete j2GC_FF;
+// Signatures of GC functions that cannot always be traced to, which are scanned for all at once
+enum GCSignature { GC_FREE, GC_MALLOC_UNCOLLECTABLE, GC_SIGNATURE_COUNT };
+static constexpr const char* gcSignatures[GC_SIGNATURE_COUNT] = {
+    "f8 5f bc a9 f6 57 01 a9 f4 4f 02 a9 "
+    "fd 7b 03 a9 fd c3 00 91 a0 08 00 b4 f3 03 00 aa ?? ?? ?? ?? 69 82 56 d3 4a ?? ?? 91 4b 0d 09 8b 49 55 40 f9 "
+    "0a 9c 9c 52 0a 04 a0 72 00 cc 74 92 68 fe 56 d3 6c 01 0a 8b 0a 03 84 52",
+    "f5 0f 1d f8 f4 4f 01 a9 fd 7b 02 a9"
+    "fd 83 00 91 ?? ?? ?? ?? ?? ?? ?? ?? 1f 00 20 f1 f3 03 01 2a",
+};
+static constexpr const char* gcSignatureLabels[GC_SIGNATURE_COUNT] = {"GC_free", "GC_Malloc_Uncollectable"};
+
+struct GCSignatureMatches {
+    std::vector<uintptr_t> matches;
+    std::vector<bool> multiple;
+
+    uintptr_t unique(GCSignature signature) const {
+        return multiple[signature] ? 0 : matches[signature];
     }
-    return true;
+};
+// One pass over libil2cpp.so for every signature, the first time either is needed
+static const GCSignatureMatches& gcSignatureMatches() {
+    static const auto found = [] {
+        GCSignatureMatches result;
+        result.matches = findUniquePatternsInLibil2cpp(result.multiple, gcSignatures, gcSignatureLabels);
+        return result;
+    }();
+    return found;
 }
 
-static bool find_GC_SetWriteBarrier(const int32_t* set_wbarrier_field) {
-    if (!set_wbarrier_field) {
-        return false;
-    }
+// XREF TRACES
+// Each returns what it found (or nullptr), after resolving the API functions it starts from: in lazy mode, those may still be stubs.
+
+static void* trace_Class_Init() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_Class_Init");
+    // Class::Init. 0x846A68 in 1.5, 0x9EC0A4 in 1.7.0, 0xA6D1B8 in 1.8.0b1
+    auto* array_new_specific = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::array_new_specific));
+    Instruction ans((const int32_t*)HookTracker::GetOrig(array_new_specific));
+    Instruction Array_NewSpecific(RET_0_UNLESS(logger, ans.label));
+    BS_LOG_DEBUG(logger, "Array::NewSpecific offset: %lX", ((uintptr_t)Array_NewSpecific.addr) - getRealOffset(0));
+    auto j2Cl_I = RET_0_UNLESS(logger, InstructionRange(Array_NewSpecific).findNthCall(1));  // also the 113th call in Runtime::Init
+    return (void*)RET_0_UNLESS(logger, j2Cl_I.label);
+}
+
+static void* trace_MetadataCache_GetTypeInfoFromTypeIndex() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_MetadataCache_GetTypeInfoFromTypeIndex");
+    // MetadataCache::GetTypeInfoFromTypeIndex. offset 0x84F764 in 1.5, 0x9F5250 in 1.7.0, 0xA7A79C in 1.8.0b1
+    auto* custom_attrs_has_attr = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::custom_attrs_has_attr));
+    auto mchab = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(custom_attrs_has_attr)).findNthDirectBranchWithoutLink(1));
+    auto* MetadataCache_HasAttribute = RET_0_UNLESS(logger, mchab.label);
+    auto j2MC_GTIFTI = RET_0_UNLESS(logger, InstructionRange(MetadataCache_HasAttribute).findNthCall(1));
+    return (void*)RET_0_UNLESS(logger, j2MC_GTIFTI.label);
+}
+
+static void* trace_MetadataCache_GetTypeInfoFromTypeDefinitionIndex() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_MetadataCache_GetTypeInfoFromTypeDefinitionIndex");
+    // MetadataCache::GetTypeInfoFromTypeDefinitionIndex. offset 0x84FBA4 in 1.5, 0x9F5690 in 1.7.0, 0xA75958 in 1.8.0b1
+    auto* type_get_class_or_element_class = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::type_get_class_or_element_class));
+    auto tgoecb = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(type_get_class_or_element_class)).findNthDirectBranchWithoutLink(1));
+    auto* Type_GetClassOrElementClass = RET_0_UNLESS(logger, tgoecb.label);
+    auto j2MC_GTIFTDI = RET_0_UNLESS(logger, InstructionRange(Type_GetClassOrElementClass).findNthDirectBranchWithoutLink(5));
+    return (void*)RET_0_UNLESS(logger, j2MC_GTIFTDI.label);
+}
+
+static void* trace_Type_GetName() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_Type_GetName");
+    // Type::GetName. offset 0x8735DC in 1.5, 0xA1A458 in 1.7.0, 0xA7B634 in 1.8.0b1
+    auto* type_get_assembly_qualified_name = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::type_get_assembly_qualified_name));
+    auto j2T_GN = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(type_get_assembly_qualified_name)).findNthCall(1));
+    return (void*)RET_0_UNLESS(logger, j2T_GN.label);
+}
+
+static void* trace_Class_FromIl2CppType() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_Class_FromIl2CppType");
+    auto* class_from_il2cpp_type = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::class_from_il2cpp_type));
+    auto b = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(class_from_il2cpp_type)).findNthDirectBranchWithoutLink(1));
+    return (void*)RET_0_UNLESS(logger, b.label);
+}
+
+// The start of the case of Class::FromIl2CppType's switch for type. Both traces that read it share one decoding of its function.
+static std::optional<Instruction> classFromIl2CppTypeCase(Il2CppTypeEnum type) {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("classFromIl2CppTypeCase");
+    auto* Class_FromIl2CppType = RET_NULLOPT_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::Class_FromIl2CppType));
+    return AssemblyFunction::Get(reinterpret_cast<const int32_t*>(Class_FromIl2CppType))->EvalSwitch(1, 1, type);
+}
+
+static void* trace_GenericClass_GetClass() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_GenericClass_GetClass");
+    // GenericClass::GetClass. offset 0x88DF64 in 1.5, 0xA34F20 in 1.7.0, 0xA6E4EC in 1.8.0b1
+    auto caseStart = RET_0_UNLESS(logger, classFromIl2CppTypeCase(IL2CPP_TYPE_GENERICINST));
+    auto j2GC_GC = RET_0_UNLESS(logger, InstructionRange(caseStart).findNthDirectBranchWithoutLink(1));
+    BS_LOG_DEBUG(logger, "j2GC_GC: %s", j2GC_GC.toString().c_str());
+    return (void*)RET_0_UNLESS(logger, j2GC_GC.label);
+}
+
+static void* trace_Class_GetPtrClass() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_Class_GetPtrClass");
+    // Class::GetPtrClass.
+    auto ptrCase = RET_0_UNLESS(logger, classFromIl2CppTypeCase(IL2CPP_TYPE_PTR));
+    auto j2C_GPC = RET_0_UNLESS(logger, InstructionRange(ptrCase).findNthDirectBranchWithoutLink(1));
+    BS_LOG_DEBUG(logger, "j2C_GPC: %s", j2C_GPC.toString().c_str());
+    return (void*)RET_0_UNLESS(logger, j2C_GPC.label);
+}
+
+static void* trace_Assembly_GetAllAssemblies() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_Assembly_GetAllAssemblies");
+    // Assembly::GetAllAssemblies
+    auto* domain_get_assemblies = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::domain_get_assemblies));
+    auto j2A_GAA = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(domain_get_assemblies)).findNthCall(1));
+    return (void*)RET_0_UNLESS(logger, j2A_GAA.label);
+}
+
+static void* find_GC_free() {
+    if (auto sigMatch = gcSignatureMatches().unique(GC_FREE)) return (void*)sigMatch;
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("find_GC_free");
+    // xref tracing __WILL__ fail if Runtime_Shutdown is hooked by __ANY__ lib/mod, such as another bs-hook's file logger.
+    auto* shutdown = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::shutdown));
+    auto sdb = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(shutdown)).findNthDirectBranchWithoutLink(1));
+    auto* Runtime_Shutdown = RET_0_UNLESS(logger, sdb.label);
+    auto blr = RET_0_UNLESS(logger, InstructionRange(Runtime_Shutdown).findNthEncoded(1, std::mem_fn(&EncodedInstruction::isIndirectBranch)));
+    auto j2GC_FF = RET_0_UNLESS(logger, InstructionRange(blr).findNthCall(5));  // BL(R)
+    Instruction GC_FreeFixed(RET_0_UNLESS(logger, j2GC_FF.label));
+    return (void*)RET_0_UNLESS(logger, GC_FreeFixed.label);
+}
+
+static void* find_GC_SetWriteBarrier() {
     static auto logger = il2cpp_functions::getFuncLogger().WithContext("find_GC_SetWriteBarrier");
-    Instruction gc_wbarrier_start(set_wbarrier_field);
-    auto* swb = RET_0_UNLESS(logger, gc_wbarrier_start.findNthDirectBranchWithoutLink(1));
-    il2cpp_functions::GarbageCollector_SetWriteBarrier = (decltype(il2cpp_functions::GarbageCollector_SetWriteBarrier))RET_0_UNLESS(logger, swb->label);
-    if (swb != &gc_wbarrier_start) delete swb;
-    return true;
+    // GarbageCollector::SetWriteBarrier(void*)
+    auto* gc_wbarrier_set_field = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::gc_wbarrier_set_field));
+    auto swb = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(gc_wbarrier_set_field)).findNthDirectBranchWithoutLink(1));
+    return (void*)RET_0_UNLESS(logger, swb.label);
 }
 
 void* (*wrapped_gc_malloc_uncollectable)(size_t sz, long long type);
@@ -416,32 +530,60 @@ void* __wrapper_gc_malloc_uncollectable(size_t sz, [[maybe_unused]] void* desc)
     return wrapped_gc_malloc_uncollectable(sz, 2);
 }
 
-static bool trace_GC_AllocFixed(Instruction* DomainGetCurrent) {
+static void* trace_GC_AllocFixed() {
     static auto logger = il2cpp_functions::getFuncLogger().WithContext("trace_GC_AllocFixed");
+    auto* domain_get = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::domain_get));
+    auto DomainGetCurrent = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(domain_get)).findNthDirectBranchWithoutLink(1));
     // Domain::GetCurrent has a single bl to GarbageCollector::AllocateFixed
     // MetadataCache::InitializeGCSafe is 3rd bl after first b.ne, which is the 6th b(.lt, .ne), t(bz, nz), c(bz, nz)
-    Instruction domainGetCurrentImpl(RET_0_UNLESS(logger, DomainGetCurrent->label));
-    auto* gcAlloc = RET_0_UNLESS(logger, domainGetCurrentImpl.findNthCall(1));
-    il2cpp_functions::GarbageCollector_AllocateFixed = (decltype(il2cpp_functions::GarbageCollector_AllocateFixed))RET_0_UNLESS(logger, gcAlloc->label);
-    if (gcAlloc != &domainGetCurrentImpl) delete gcAlloc;
-    return true;
+    auto* domainGetCurrentImpl = RET_0_UNLESS(logger, DomainGetCurrent.label);
+    auto gcAlloc = RET_0_UNLESS(logger, InstructionRange(domainGetCurrentImpl).findNthCall(1));
+    return (void*)RET_0_UNLESS(logger, gcAlloc.label);
 }
 
-static bool find_GC_AllocFixed(Instruction* DomainGetCurrent) {
-    if (!trace_GC_AllocFixed(DomainGetCurrent)) {
-        bool multipleMatches;
-        auto sigMatch = findUniquePatternInLibil2cpp(multipleMatches, "f5 0f 1d f8 f4 4f 01 a9 fd 7b 02 a9"
-            "fd 83 00 91 ?? ?? ?? ?? ?? ?? ?? ?? 1f 00 20 f1 f3 03 01 2a", "GC_Malloc_Uncollectable");
+static void* find_GC_AllocFixed() {
+    // GarbageCollector::AllocateFixed(size_t, void*)
+    if (auto* traced = trace_GC_AllocFixed()) return traced;
+    auto sigMatch = gcSignatureMatches().unique(GC_MALLOC_UNCOLLECTABLE);
+    if (!sigMatch) return nullptr;
+    // We need to make a wrapper method instead and set that.
+    wrapped_gc_malloc_uncollectable = (decltype(wrapped_gc_malloc_uncollectable))sigMatch;
+    return (void*)&__wrapper_gc_malloc_uncollectable;
+}
 
-        if (sigMatch && !multipleMatches) {
-            // We need to make a wrapper method instead and set that.
-            wrapped_gc_malloc_uncollectable = (decltype(wrapped_gc_malloc_uncollectable))sigMatch;
-            il2cpp_functions::GarbageCollector_AllocateFixed = &__wrapper_gc_malloc_uncollectable;
-        } else {
-            return false;
-        }
-    }
-    return true;
+static void* find_il2cpp_defaults() {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("find_il2cpp_defaults");
+    auto* init_utf16 = RET_0_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::init_utf16));
+    auto j2R_I = RET_0_UNLESS(logger, InstructionRange((const int32_t*)HookTracker::GetOrig(init_utf16)).findNthCall(3));
+    auto* Runtime_Init = RET_0_UNLESS(logger, j2R_I.label);
+    // alternatively, could just get the 1st ADRP in Runtime::Init with dest reg x20 (or the 9th ADRP)
+    // We DO need to skip at least one ret, though.
+    auto ldr = RET_0_UNLESS(logger, InstructionRange(Runtime_Init).findNth(6, std::mem_fn(&Instruction::isLoad), 1));  // the load for the malloc that precedes our adrp
+    return (void*)ExtractAddress(ldr.addr, 1, 1);
+}
+
+// s_Il2CppMetadataRegistration, s_GlobalMetadata and s_GlobalMetadataHeader are all loaded by the same function, whose decode
+// AssemblyFunction caches, so the three traces share it
+static void* find_MetadataGlobal(const char* name, int nthAdrp) {
+    static auto logger = il2cpp_functions::getFuncLogger().WithContext("find_MetadataGlobal");
+    auto* GetTypeInfoFromTypeDefinitionIndex = RET_0_UNLESS(logger,
+        il2cpp_functions::Resolve(il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex));
+    auto typeInfoFromIndex = AssemblyFunction::Get(reinterpret_cast<const int32_t*>(GetTypeInfoFromTypeDefinitionIndex));
+    auto address = RET_0_UNLESS(logger, typeInfoFromIndex->ExtractAddress(nthAdrp, 1));
+    BS_LOG_DEBUG(logger, "%s found!", name);
+    return (void*)address;
+}
+
+static void* find_Il2CppMetadataRegistration() {
+    return find_MetadataGlobal("s_Il2CppMetadataRegistration", 4);
+}
+
+static void* find_GlobalMetadata() {
+    return find_MetadataGlobal("s_GlobalMetadata", 5);
+}
+
+static void* find_GlobalMetadataHeader() {
+    return find_MetadataGlobal("s_GlobalMetadataHeader", 3);
 }
 
 LoggerContextObject& il2cpp_functions::getFuncLogger() {
@@ -456,6 +598,421 @@ LoggerContextObject& il2cpp_functions::getFuncLogger() {
 //     shutdown_hook();
 // }
 
+// NOTE: Runtime.Shutdown is NOT CALLED even for exceptions!
+// There is practically no use in hooking this becuase of that.
+// Runtime.Shutdown (for file loggers)
+// if (Runtime_Shutdown) {
+//     logger.info("hook installing to: %p (offset %lX)", Runtime_Shutdown, ((uintptr_t)Runtime_Shutdown) - getRealOffset(0));
+//     INSTALL_HOOK_DIRECT(logger, shutdown_hook, (void*)Runtime_Shutdown);
+// } else {
+//     logger.critical("Failed to parse il2cpp_shutdown's implementation address! Could not install shutdown hook for closing file logs.");
+// }
+
+namespace {
+    // One of il2cpp_functions' pointers (or, for the few that are read rather than called, its data pointers) and how to find it
+    struct LazyFunction {
+        void** slot;
+        const char* name;
+        // dlsym'd from libil2cpp.so if not null, else traced
+        const char* symbol;
+        void* (*trace)();
+        // What slot holds until it is resolved in lazy mode, if it is a function pointer
+        void* stub;
+        // Whether Init crashes if it cannot be found
+        bool required;
+        // Only written under resolveMutex. resolved is also read without it, once the rest has been written.
+        std::atomic<bool> resolved;
+        bool found;
+        std::chrono::nanoseconds time;
+    };
+
+    // A function to put in slot until it is resolved, with the same signature, which resolves it and then calls what it found
+    template<auto* slot, class F = std::remove_pointer_t<std::remove_pointer_t<decltype(slot)>>>
+    struct LazyStub;
+    template<auto* slot, class R, class... TArgs>
+    struct LazyStub<slot, R(TArgs...)> {
+        static R call(TArgs... args) {
+            auto* function = il2cpp_functions::Resolve(*slot);
+            // Would have been a call to nullptr, had Init not been lazy
+            if (!function) SAFE_ABORT();
+            return function(std::forward<TArgs>(args)...);
+        }
+    };
+
+    #define LAZY_ENTRY(field, symbol, trace, stub, required) \
+        {(void**)(&il2cpp_functions::field), #field, symbol, trace, stub, required, {}, false, {}}
+    #define LAZY_STUB(field) reinterpret_cast<void*>(&LazyStub<&il2cpp_functions::field>::call)
+    #define API_FUNCTION_NAMED(field, symbol) LAZY_ENTRY(field, symbol, nullptr, LAZY_STUB(field), false)
+    #define API_FUNCTION(field) API_FUNCTION_NAMED(field, "il2cpp_" #field)
+    #define TRACED_FUNCTION(field, trace, required) LAZY_ENTRY(field, nullptr, trace, LAZY_STUB(field), required)
+    #define TRACED_POINTER(field, trace) LAZY_ENTRY(field, nullptr, trace, nullptr, true)
+
+    // In the order Init resolves them, which is also an order in which the traces find the functions they start from resolved.
+    // Built on first use rather than at load, in case Init is called from another file's static initializer.
+    std::span<LazyFunction> lazyFunctions() {
+        static LazyFunction functions[] = {
+            // Please verify that these have more than 1 instruction to their name before attempting to hook them!
+            API_FUNCTION(init),
+            API_FUNCTION(shutdown),
+            API_FUNCTION(init_utf16),
+            API_FUNCTION(set_config_dir),
+            API_FUNCTION(set_data_dir),
+            API_FUNCTION(set_temp_dir),
+            API_FUNCTION(set_commandline_arguments),
+            API_FUNCTION(set_commandline_arguments_utf16),
+            API_FUNCTION(set_config_utf16),
+            API_FUNCTION(set_config),
+            API_FUNCTION(set_memory_callbacks),
+            API_FUNCTION(get_corlib),
+            API_FUNCTION(add_internal_call),
+            API_FUNCTION(resolve_icall),
+            API_FUNCTION(alloc),
+            API_FUNCTION(free),
+            API_FUNCTION(array_class_get),
+            API_FUNCTION(array_length),
+            API_FUNCTION(array_get_byte_length),
+            API_FUNCTION(array_new),
+            API_FUNCTION(array_new_specific),
+            API_FUNCTION(array_new_full),
+            API_FUNCTION(bounded_array_class_get),
+            API_FUNCTION(array_element_size),
+            API_FUNCTION(assembly_get_image),
+            #ifdef UNITY_2019
+            API_FUNCTION(class_for_each),
+            #endif
+            API_FUNCTION(class_enum_basetype),
+            API_FUNCTION(class_is_generic),
+            API_FUNCTION(class_is_inflated),
+            API_FUNCTION(class_is_assignable_from),
+            API_FUNCTION(class_is_subclass_of),
+            API_FUNCTION(class_has_parent),
+            API_FUNCTION(class_from_il2cpp_type),
+            API_FUNCTION(class_from_name),
+            API_FUNCTION(class_from_system_type),
+            API_FUNCTION(class_get_element_class),
+            API_FUNCTION(class_get_events),
+            API_FUNCTION(class_get_fields),
+            API_FUNCTION(class_get_nested_types),
+            API_FUNCTION(class_get_interfaces),
+            API_FUNCTION(class_get_properties),
+            API_FUNCTION(class_get_property_from_name),
+            API_FUNCTION(class_get_field_from_name),
+            API_FUNCTION(class_get_methods),
+            API_FUNCTION(class_get_method_from_name),
+            API_FUNCTION(class_get_name),
+            #ifdef UNITY_2019
+            API_FUNCTION(type_get_name_chunked),
+            #endif
+            API_FUNCTION(class_get_namespace),
+            API_FUNCTION(class_get_parent),
+            API_FUNCTION(class_get_declaring_type),
+            API_FUNCTION(class_instance_size),
+            API_FUNCTION(class_num_fields),
+            API_FUNCTION(class_is_valuetype),
+            API_FUNCTION(class_value_size),
+            API_FUNCTION(class_is_blittable),
+            API_FUNCTION(class_get_flags),
+            API_FUNCTION(class_is_abstract),
+            API_FUNCTION(class_is_interface),
+            API_FUNCTION(class_array_element_size),
+            API_FUNCTION(class_from_type),
+            API_FUNCTION(class_get_type),
+            API_FUNCTION(class_get_type_token),
+            API_FUNCTION(class_has_attribute),
+            API_FUNCTION(class_has_references),
+            API_FUNCTION(class_is_enum),
+            API_FUNCTION(class_get_image),
+            API_FUNCTION(class_get_assemblyname),
+            API_FUNCTION(class_get_rank),
+            #ifdef UNITY_2019
+            API_FUNCTION(class_get_data_size),
+            API_FUNCTION(class_get_static_field_data),
+            #endif
+            API_FUNCTION(class_get_bitmap_size),
+            API_FUNCTION(class_get_bitmap),
+            API_FUNCTION(stats_dump_to_file),
+            API_FUNCTION(stats_get_value),
+            API_FUNCTION(domain_get),
+            API_FUNCTION(domain_assembly_open),
+            API_FUNCTION(domain_get_assemblies),
+            #ifdef UNITY_2019
+            API_FUNCTION(raise_exception),
+            #endif
+            API_FUNCTION(exception_from_name_msg),
+            API_FUNCTION(get_exception_argument_null),
+            API_FUNCTION(format_exception),
+            API_FUNCTION(format_stack_trace),
+            API_FUNCTION(unhandled_exception),
+            API_FUNCTION(field_get_flags),
+            API_FUNCTION(field_get_name),
+            API_FUNCTION(field_get_parent),
+            API_FUNCTION(field_get_offset),
+            API_FUNCTION(field_get_type),
+            API_FUNCTION(field_get_value),
+            API_FUNCTION(field_get_value_object),
+            API_FUNCTION(field_has_attribute),
+            API_FUNCTION(field_set_value),
+            API_FUNCTION(field_static_get_value),
+            API_FUNCTION(field_static_set_value),
+            API_FUNCTION(field_set_value_object),
+            #ifdef UNITY_2019
+            API_FUNCTION(field_is_literal),
+            #endif
+            API_FUNCTION(gc_collect),
+            API_FUNCTION(gc_collect_a_little),
+            API_FUNCTION(gc_disable),
+            API_FUNCTION(gc_enable),
+            API_FUNCTION(gc_is_disabled),
+            #ifdef UNITY_2019
+            API_FUNCTION(gc_get_max_time_slice_ns),
+            API_FUNCTION(gc_set_max_time_slice_ns),
+            API_FUNCTION(gc_is_incremental),
+            #endif
+            API_FUNCTION(gc_get_used_size),
+            API_FUNCTION(gc_get_heap_size),
+            API_FUNCTION(gc_wbarrier_set_field),
+            #ifdef UNITY_2019
+            API_FUNCTION(gc_has_strict_wbarriers),
+            API_FUNCTION(gc_set_external_allocation_tracker),
+            API_FUNCTION(gc_set_external_wbarrier_tracker),
+            API_FUNCTION(gc_foreach_heap),
+            API_FUNCTION(stop_gc_world),
+            API_FUNCTION(start_gc_world),
+            #endif
+            API_FUNCTION(gchandle_new),
+            API_FUNCTION(gchandle_new_weakref),
+            API_FUNCTION(gchandle_get_target),
+            API_FUNCTION(gchandle_free),
+            #ifdef UNITY_2019
+            API_FUNCTION(gchandle_foreach_get_target),
+            API_FUNCTION(object_header_size),
+            API_FUNCTION(array_object_header_size),
+            API_FUNCTION(offset_of_array_length_in_array_object_header),
+            API_FUNCTION(offset_of_array_bounds_in_array_object_header),
+            API_FUNCTION(allocation_granularity),
+            #endif
+            API_FUNCTION(unity_liveness_calculation_begin),
+            API_FUNCTION(unity_liveness_calculation_end),
+            API_FUNCTION(unity_liveness_calculation_from_root),
+            API_FUNCTION(unity_liveness_calculation_from_statics),
+            API_FUNCTION(method_get_return_type),
+            API_FUNCTION(method_get_declaring_type),
+            API_FUNCTION(method_get_name),
+            API_FUNCTION(method_get_from_reflection),
+            API_FUNCTION(method_get_object),
+            API_FUNCTION(method_is_generic),
+            API_FUNCTION(method_is_inflated),
+            API_FUNCTION(method_is_instance),
+            API_FUNCTION(method_get_param_count),
+            API_FUNCTION(method_get_param),
+            API_FUNCTION(method_get_class),
+            API_FUNCTION(method_has_attribute),
+            API_FUNCTION(method_get_flags),
+            API_FUNCTION(method_get_token),
+            API_FUNCTION(method_get_param_name),
+            API_FUNCTION(profiler_install),
+            API_FUNCTION(profiler_set_events),
+            API_FUNCTION(profiler_install_enter_leave),
+            API_FUNCTION(profiler_install_allocation),
+            API_FUNCTION(profiler_install_gc),
+            API_FUNCTION(profiler_install_fileio),
+            API_FUNCTION(profiler_install_thread),
+            API_FUNCTION(property_get_flags),
+            API_FUNCTION(property_get_get_method),
+            API_FUNCTION(property_get_set_method),
+            API_FUNCTION(property_get_name),
+            API_FUNCTION(property_get_parent),
+            API_FUNCTION(object_get_class),
+            API_FUNCTION(object_get_size),
+            API_FUNCTION(object_get_virtual_method),
+            API_FUNCTION(object_new),
+            API_FUNCTION(object_unbox),
+            API_FUNCTION(value_box),
+            API_FUNCTION(monitor_enter),
+            API_FUNCTION(monitor_try_enter),
+            API_FUNCTION(monitor_exit),
+            API_FUNCTION(monitor_pulse),
+            API_FUNCTION(monitor_pulse_all),
+            API_FUNCTION(monitor_wait),
+            API_FUNCTION(monitor_try_wait),
+            API_FUNCTION(runtime_invoke),
+            API_FUNCTION(runtime_invoke_convert_args),
+            API_FUNCTION(runtime_class_init),
+            API_FUNCTION(runtime_object_init),
+            API_FUNCTION(runtime_object_init_exception),
+            API_FUNCTION(runtime_unhandled_exception_policy_set),
+            API_FUNCTION(string_length),
+            API_FUNCTION(string_chars),
+            API_FUNCTION(string_new),
+            API_FUNCTION(string_new_len),
+            API_FUNCTION(string_new_utf16),
+            API_FUNCTION(string_new_wrapper),
+            API_FUNCTION(string_intern),
+            API_FUNCTION(string_is_interned),
+            API_FUNCTION(thread_current),
+            API_FUNCTION(thread_attach),
+            API_FUNCTION(thread_detach),
+            API_FUNCTION(thread_get_all_attached_threads),
+            API_FUNCTION(is_vm_thread),
+            API_FUNCTION(current_thread_walk_frame_stack),
+            API_FUNCTION(thread_walk_frame_stack),
+            API_FUNCTION(current_thread_get_top_frame),
+            API_FUNCTION(thread_get_top_frame),
+            API_FUNCTION(current_thread_get_frame_at),
+            API_FUNCTION(thread_get_frame_at),
+            API_FUNCTION(current_thread_get_stack_depth),
+            API_FUNCTION(thread_get_stack_depth),
+            #ifdef UNITY_2019
+            API_FUNCTION(override_stack_backtrace),
+            #endif
+            API_FUNCTION(type_get_object),
+            API_FUNCTION(type_get_type),
+            API_FUNCTION(type_get_class_or_element_class),
+            API_FUNCTION(type_get_name),
+            API_FUNCTION(type_is_byref),
+            API_FUNCTION(type_get_attrs),
+            API_FUNCTION(type_equals),
+            API_FUNCTION(type_get_assembly_qualified_name),
+            #ifdef UNITY_2019
+            API_FUNCTION(type_is_static),
+            API_FUNCTION(type_is_pointer_type),
+            #endif
+            API_FUNCTION(image_get_assembly),
+            API_FUNCTION(image_get_name),
+            API_FUNCTION(image_get_filename),
+            API_FUNCTION(image_get_entry_point),
+            API_FUNCTION(image_get_class_count),
+            API_FUNCTION(image_get_class),
+            API_FUNCTION(capture_memory_snapshot),
+            API_FUNCTION(free_captured_memory_snapshot),
+            API_FUNCTION(set_find_plugin_callback),
+            API_FUNCTION(register_log_callback),
+            API_FUNCTION(debugger_set_agent_options),
+            API_FUNCTION(is_debugger_attached),
+            #ifdef UNITY_2019
+            API_FUNCTION(register_debugger_agent_transport),
+            API_FUNCTION(debug_get_method_info),
+            #endif
+            API_FUNCTION(unity_install_unitytls_interface),
+            API_FUNCTION(custom_attrs_from_class),
+            API_FUNCTION(custom_attrs_from_method),
+            API_FUNCTION(custom_attrs_get_attr),
+            API_FUNCTION(custom_attrs_has_attr),
+            API_FUNCTION(custom_attrs_construct),
+            API_FUNCTION(custom_attrs_free),
+            #ifdef UNITY_2019
+            API_FUNCTION(class_set_userdata),
+            API_FUNCTION(class_get_userdata_offset),
+            #endif
+
+            // MANUALLY DEFINED CONST DEFINITIONS
+            API_FUNCTION_NAMED(class_get_type_const, "il2cpp_class_get_type"),
+            API_FUNCTION_NAMED(class_get_name_const, "il2cpp_class_get_name"),
+
+
+            // XREF TRACES
+            TRACED_FUNCTION(Class_Init, trace_Class_Init, true),
+            TRACED_FUNCTION(MetadataCache_GetTypeInfoFromTypeIndex, trace_MetadataCache_GetTypeInfoFromTypeIndex, true),
+            TRACED_FUNCTION(MetadataCache_GetTypeInfoFromTypeDefinitionIndex, trace_MetadataCache_GetTypeInfoFromTypeDefinitionIndex, true),
+            TRACED_FUNCTION(_Type_GetName_, trace_Type_GetName, true),
+            TRACED_FUNCTION(Class_FromIl2CppType, trace_Class_FromIl2CppType, true),
+            TRACED_FUNCTION(GenericClass_GetClass, trace_GenericClass_GetClass, true),
+            TRACED_FUNCTION(Class_GetPtrClass, trace_Class_GetPtrClass, true),
+            TRACED_FUNCTION(Assembly_GetAllAssemblies, trace_Assembly_GetAllAssemblies, true),
+            // Might not be found, which SafePtr checks for
+            TRACED_FUNCTION(GC_free, find_GC_free, false),
+            TRACED_FUNCTION(GarbageCollector_SetWriteBarrier, find_GC_SetWriteBarrier, false),
+            TRACED_FUNCTION(GarbageCollector_AllocateFixed, find_GC_AllocFixed, false),
+            TRACED_POINTER(defaults, find_il2cpp_defaults),
+            // FIELDS
+            TRACED_POINTER(s_Il2CppMetadataRegistrationPtr, find_Il2CppMetadataRegistration),
+            TRACED_POINTER(s_GlobalMetadataPtr, find_GlobalMetadata),
+            TRACED_POINTER(s_GlobalMetadataHeaderPtr, find_GlobalMetadataHeader),
+        };
+        return functions;
+    }
+
+    #undef TRACED_POINTER
+    #undef TRACED_FUNCTION
+    #undef API_FUNCTION
+    #undef API_FUNCTION_NAMED
+    #undef LAZY_STUB
+    #undef LAZY_ENTRY
+
+    void* imagehandle;
+    bool warmAllOnInit;
+    // Recursive, since traces resolve the functions they start from
+    std::recursive_mutex resolveMutex;
+
+    LazyFunction* findLazyFunction(void** slot) {
+        // Sorted by slot once, for Resolve to search
+        static const auto bySlot = [] {
+            std::vector<LazyFunction*> sorted;
+            for (auto& function : lazyFunctions()) sorted.push_back(&function);
+            std::sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) { return a->slot < b->slot; });
+            return sorted;
+        }();
+        auto it = std::lower_bound(bySlot.begin(), bySlot.end(), slot, [](auto* function, void** slot) { return function->slot < slot; });
+        return it != bySlot.end() && (*it)->slot == slot ? *it : nullptr;
+    }
+
+    bool resolve(LazyFunction& function) {
+        static auto logger = il2cpp_functions::getFuncLogger().WithContext("resolve");
+        std::lock_guard lock(resolveMutex);
+        if (function.resolved.load(std::memory_order_relaxed)) return function.found;
+        auto before = std::chrono::steady_clock::now();
+        auto* address = function.symbol ? dlsym(imagehandle, function.symbol) : function.trace();
+        function.time = std::chrono::steady_clock::now() - before;
+        function.found = address;
+        // Callers read slot without synchronizing, so it must never be seen half written
+        __atomic_store_n(function.slot, address, __ATOMIC_RELEASE);
+        function.resolved.store(true, std::memory_order_release);
+        if (!address) {
+            if (function.symbol) logger.error("Failed to load %s: %s", function.symbol, dlerror());
+            else logger.error("Failed to find %s!", function.name);
+        } else if (function.symbol) {
+            logger.info("Loaded: %s (%lld ns)", function.symbol, static_cast<long long>(function.time.count()));
+        } else {
+            logger.info("%s found! offset: %lX (%lld ns)", function.name, (uintptr_t)address - getRealOffset(0),
+                static_cast<long long>(function.time.count()));
+        }
+        return address;
+    }
+}
+
+bool il2cpp_functions::lazy;
+
+void il2cpp_functions::resolveSlot(void** slot) {
+    // Nothing is stubbed (and there is nothing to dlsym from) before Init
+    if (!imagehandle) return;
+    auto* function = findLazyFunction(slot);
+    if (function && !function->resolved.load(std::memory_order_acquire)) resolve(*function);
+}
+
+void il2cpp_functions::EnableLazyInit(bool warmAll) {
+    if (initialized) {
+        getFuncLogger().warning("EnableLazyInit called after Init, so every function has been resolved already");
+        return;
+    }
+    lazy = true;
+    warmAllOnInit = warmAll;
+}
+
+void il2cpp_functions::ResolveAll() {
+    Init();
+    for (auto& function : lazyFunctions()) resolve(function);
+}
+
+std::vector<il2cpp_functions::ResolutionTime> il2cpp_functions::GetResolutionTimes() {
+    std::lock_guard lock(resolveMutex);
+    std::vector<ResolutionTime> times;
+    times.reserve(lazyFunctions().size());
+    for (auto& function : lazyFunctions()) {
+        times.push_back({function.name, function.resolved.load(std::memory_order_relaxed), function.found, function.time});
+    }
+    return times;
+}
+
 // Autogenerated; modified by zoller27osu
 // Initializes all of the IL2CPP functions via dlopen and dlsym for use.
 void il2cpp_functions::Init() {
@@ -463,650 +1020,35 @@ void il2cpp_functions::Init() {
         return;
     }
     static auto logger = getFuncLogger().WithContext("Init");
-    logger.info("il2cpp_functions: Init: Initializing all IL2CPP Functions...");
+    logger.info("il2cpp_functions: Init: Initializing all IL2CPP Functions%s...", lazy ? " lazily" : "");
     dlerror();  // clears existing errors
     auto path = Modloader::getLibIl2CppPath();
-    void *imagehandle = dlopen(path.c_str(), RTLD_GLOBAL | RTLD_LAZY);
+    // Never closed, since lazy stubs may dlsym from it at any time
+    imagehandle = dlopen(path.c_str(), RTLD_GLOBAL | RTLD_LAZY);
     if (!imagehandle) {
         logger.error("Failed to dlopen %s: %s!", path.c_str(), dlerror());
         return;
     }
 
-    // Please verify that these have more than 1 instruction to their name before attempting to hook them!
-    *(void**)(&init) = dlsym(imagehandle, "il2cpp_init");
-    logger.info("Loaded: il2cpp_init, error: %s", dlerror());
-    *(void**)(&shutdown) = dlsym(imagehandle, "il2cpp_shutdown");
-    logger.info("Loaded: il2cpp_shutdown, error: %s", dlerror());
-    *(void**)(&init_utf16) = dlsym(imagehandle, "il2cpp_init_utf16");
-    logger.info("Loaded: il2cpp_init_utf16");
-    *(void**)(&set_config_dir) = dlsym(imagehandle, "il2cpp_set_config_dir");
-    logger.info("Loaded: il2cpp_set_config_dir");
-    *(void**)(&set_data_dir) = dlsym(imagehandle, "il2cpp_set_data_dir");
-    logger.info("Loaded: il2cpp_set_data_dir");
-    *(void**)(&set_temp_dir) = dlsym(imagehandle, "il2cpp_set_temp_dir");
-    logger.info("Loaded: il2cpp_set_temp_dir");
-    *(void**)(&set_commandline_arguments) = dlsym(imagehandle, "il2cpp_set_commandline_arguments");
-    logger.info("Loaded: il2cpp_set_commandline_arguments");
-    *(void**)(&set_commandline_arguments_utf16) = dlsym(imagehandle, "il2cpp_set_commandline_arguments_utf16");
-    logger.info("Loaded: il2cpp_set_commandline_arguments_utf16");
-    *(void**)(&set_config_utf16) = dlsym(imagehandle, "il2cpp_set_config_utf16");
-    logger.info("Loaded: il2cpp_set_config_utf16");
-    *(void**)(&set_config) = dlsym(imagehandle, "il2cpp_set_config");
-    logger.info("Loaded: il2cpp_set_config");
-    *(void**)(&set_memory_callbacks) = dlsym(imagehandle, "il2cpp_set_memory_callbacks");
-    logger.info("Loaded: il2cpp_set_memory_callbacks");
-    *(void**)(&get_corlib) = dlsym(imagehandle, "il2cpp_get_corlib");
-    logger.info("Loaded: il2cpp_get_corlib");
-    *(void**)(&add_internal_call) = dlsym(imagehandle, "il2cpp_add_internal_call");
-    logger.info("Loaded: il2cpp_add_internal_call");
-    *(void**)(&resolve_icall) = dlsym(imagehandle, "il2cpp_resolve_icall");
-    logger.info("Loaded: il2cpp_resolve_icall");
-    *(void**)(&alloc) = dlsym(imagehandle, "il2cpp_alloc");
-    logger.info("Loaded: il2cpp_alloc");
-    *(void**)(&free) = dlsym(imagehandle, "il2cpp_free");
-    logger.info("Loaded: il2cpp_free");
-    *(void**)(&array_class_get) = dlsym(imagehandle, "il2cpp_array_class_get");
-    logger.info("Loaded: il2cpp_array_class_get");
-    *(void**)(&array_length) = dlsym(imagehandle, "il2cpp_array_length");
-    logger.info("Loaded: il2cpp_array_length");
-    *(void**)(&array_get_byte_length) = dlsym(imagehandle, "il2cpp_array_get_byte_length");
-    logger.info("Loaded: il2cpp_array_get_byte_length");
-    *(void**)(&array_new) = dlsym(imagehandle, "il2cpp_array_new");
-    logger.info("Loaded: il2cpp_array_new");
-    *(void**)(&array_new_specific) = dlsym(imagehandle, "il2cpp_array_new_specific");
-    logger.info("Loaded: il2cpp_array_new_specific");
-    *(void**)(&array_new_full) = dlsym(imagehandle, "il2cpp_array_new_full");
-    logger.info("Loaded: il2cpp_array_new_full");
-    *(void**)(&bounded_array_class_get) = dlsym(imagehandle, "il2cpp_bounded_array_class_get");
-    logger.info("Loaded: il2cpp_bounded_array_class_get");
-    *(void**)(&array_element_size) = dlsym(imagehandle, "il2cpp_array_element_size");
-    logger.info("Loaded: il2cpp_array_element_size");
-    *(void**)(&assembly_get_image) = dlsym(imagehandle, "il2cpp_assembly_get_image");
-    logger.info("Loaded: il2cpp_assembly_get_image");
-    #ifdef UNITY_2019
-    *(void**)(&class_for_each) = dlsym(imagehandle, "il2cpp_class_for_each");
-    logger.info("Loaded: il2cpp_class_for_each");
-    #endif
-    *(void**)(&class_enum_basetype) = dlsym(imagehandle, "il2cpp_class_enum_basetype");
-    logger.info("Loaded: il2cpp_class_enum_basetype");
-    *(void**)(&class_is_generic) = dlsym(imagehandle, "il2cpp_class_is_generic");
-    logger.info("Loaded: il2cpp_class_is_generic");
-    *(void**)(&class_is_inflated) = dlsym(imagehandle, "il2cpp_class_is_inflated");
-    logger.info("Loaded: il2cpp_class_is_inflated");
-    *(void**)(&class_is_assignable_from) = dlsym(imagehandle, "il2cpp_class_is_assignable_from");
-    logger.info("Loaded: il2cpp_class_is_assignable_from");
-    *(void**)(&class_is_subclass_of) = dlsym(imagehandle, "il2cpp_class_is_subclass_of");
-    logger.info("Loaded: il2cpp_class_is_subclass_of");
-    *(void**)(&class_has_parent) = dlsym(imagehandle, "il2cpp_class_has_parent");
-    logger.info("Loaded: il2cpp_class_has_parent");
-    *(void**)(&class_from_il2cpp_type) = dlsym(imagehandle, "il2cpp_class_from_il2cpp_type");
-    logger.info("Loaded: il2cpp_class_from_il2cpp_type");
-    *(void**)(&class_from_name) = dlsym(imagehandle, "il2cpp_class_from_name");
-    logger.info("Loaded: il2cpp_class_from_name");
-    *(void**)(&class_from_system_type) = dlsym(imagehandle, "il2cpp_class_from_system_type");
-    logger.info("Loaded: il2cpp_class_from_system_type");
-    *(void**)(&class_get_element_class) = dlsym(imagehandle, "il2cpp_class_get_element_class");
-    logger.info("Loaded: il2cpp_class_get_element_class");
-    *(void**)(&class_get_events) = dlsym(imagehandle, "il2cpp_class_get_events");
-    logger.info("Loaded: il2cpp_class_get_events");
-    *(void**)(&class_get_fields) = dlsym(imagehandle, "il2cpp_class_get_fields");
-    logger.info("Loaded: il2cpp_class_get_fields");
-    *(void**)(&class_get_nested_types) = dlsym(imagehandle, "il2cpp_class_get_nested_types");
-    logger.info("Loaded: il2cpp_class_get_nested_types");
-    *(void**)(&class_get_interfaces) = dlsym(imagehandle, "il2cpp_class_get_interfaces");
-    logger.info("Loaded: il2cpp_class_get_interfaces");
-    *(void**)(&class_get_properties) = dlsym(imagehandle, "il2cpp_class_get_properties");
-    logger.info("Loaded: il2cpp_class_get_properties");
-    *(void**)(&class_get_property_from_name) = dlsym(imagehandle, "il2cpp_class_get_property_from_name");
-    logger.info("Loaded: il2cpp_class_get_property_from_name");
-    *(void**)(&class_get_field_from_name) = dlsym(imagehandle, "il2cpp_class_get_field_from_name");
-    logger.info("Loaded: il2cpp_class_get_field_from_name");
-    *(void**)(&class_get_methods) = dlsym(imagehandle, "il2cpp_class_get_methods");
-    logger.info("Loaded: il2cpp_class_get_methods");
-    *(void**)(&class_get_method_from_name) = dlsym(imagehandle, "il2cpp_class_get_method_from_name");
-    logger.info("Loaded: il2cpp_class_get_method_from_name");
-    *(void**)(&class_get_name) = dlsym(imagehandle, "il2cpp_class_get_name");
-    logger.info("Loaded: il2cpp_class_get_name");
-    #ifdef UNITY_2019
-    *(void**)(&type_get_name_chunked) = dlsym(imagehandle, "il2cpp_type_get_name_chunked");
-    logger.info("Loaded: il2cpp_type_get_name_chunked");
-    #endif
-    *(void**)(&class_get_namespace) = dlsym(imagehandle, "il2cpp_class_get_namespace");
-    logger.info("Loaded: il2cpp_class_get_namespace");
-    *(void**)(&class_get_parent) = dlsym(imagehandle, "il2cpp_class_get_parent");
-    logger.info("Loaded: il2cpp_class_get_parent");
-    *(void**)(&class_get_declaring_type) = dlsym(imagehandle, "il2cpp_class_get_declaring_type");
-    logger.info("Loaded: il2cpp_class_get_declaring_type");
-    *(void**)(&class_instance_size) = dlsym(imagehandle, "il2cpp_class_instance_size");
-    logger.info("Loaded: il2cpp_class_instance_size");
-    *(void**)(&class_num_fields) = dlsym(imagehandle, "il2cpp_class_num_fields");
-    logger.info("Loaded: il2cpp_class_num_fields");
-    *(void**)(&class_is_valuetype) = dlsym(imagehandle, "il2cpp_class_is_valuetype");
-    logger.info("Loaded: il2cpp_class_is_valuetype");
-    *(void**)(&class_value_size) = dlsym(imagehandle, "il2cpp_class_value_size");
-    logger.info("Loaded: il2cpp_class_value_size");
-    *(void**)(&class_is_blittable) = dlsym(imagehandle, "il2cpp_class_is_blittable");
-    logger.info("Loaded: il2cpp_class_is_blittable");
-    *(void**)(&class_get_flags) = dlsym(imagehandle, "il2cpp_class_get_flags");
-    logger.info("Loaded: il2cpp_class_get_flags");
-    *(void**)(&class_is_abstract) = dlsym(imagehandle, "il2cpp_class_is_abstract");
-    logger.info("Loaded: il2cpp_class_is_abstract");
-    *(void**)(&class_is_interface) = dlsym(imagehandle, "il2cpp_class_is_interface");
-    logger.info("Loaded: il2cpp_class_is_interface");
-    *(void**)(&class_array_element_size) = dlsym(imagehandle, "il2cpp_class_array_element_size");
-    logger.info("Loaded: il2cpp_class_array_element_size");
-    *(void**)(&class_from_type) = dlsym(imagehandle, "il2cpp_class_from_type");
-    logger.info("Loaded: il2cpp_class_from_type");
-    *(void**)(&class_get_type) = dlsym(imagehandle, "il2cpp_class_get_type");
-    logger.info("Loaded: il2cpp_class_get_type");
-    *(void**)(&class_get_type_token) = dlsym(imagehandle, "il2cpp_class_get_type_token");
-    logger.info("Loaded: il2cpp_class_get_type_token");
-    *(void**)(&class_has_attribute) = dlsym(imagehandle, "il2cpp_class_has_attribute");
-    logger.info("Loaded: il2cpp_class_has_attribute");
-    *(void**)(&class_has_references) = dlsym(imagehandle, "il2cpp_class_has_references");
-    logger.info("Loaded: il2cpp_class_has_references");
-    *(void**)(&class_is_enum) = dlsym(imagehandle, "il2cpp_class_is_enum");
-    logger.info("Loaded: il2cpp_class_is_enum");
-    *(void**)(&class_get_image) = dlsym(imagehandle, "il2cpp_class_get_image");
-    logger.info("Loaded: il2cpp_class_get_image");
-    *(void**)(&class_get_assemblyname) = dlsym(imagehandle, "il2cpp_class_get_assemblyname");
-    logger.info("Loaded: il2cpp_class_get_assemblyname");
-    *(void**)(&class_get_rank) = dlsym(imagehandle, "il2cpp_class_get_rank");
-    logger.info("Loaded: il2cpp_class_get_rank");
-    #ifdef UNITY_2019
-    *(void**)(&class_get_data_size) = dlsym(imagehandle, "il2cpp_class_get_data_size");
-    logger.info("Loaded: il2cpp_class_get_data_size");
-    *(void**)(&class_get_static_field_data) = dlsym(imagehandle, "il2cpp_class_get_static_field_data");
-    logger.info("Loaded: il2cpp_class_get_static_field_data");
-    #endif
-    *(void**)(&class_get_bitmap_size) = dlsym(imagehandle, "il2cpp_class_get_bitmap_size");
-    logger.info("Loaded: il2cpp_class_get_bitmap_size");
-    *(void**)(&class_get_bitmap) = dlsym(imagehandle, "il2cpp_class_get_bitmap");
-    logger.info("Loaded: il2cpp_class_get_bitmap");
-    *(void**)(&stats_dump_to_file) = dlsym(imagehandle, "il2cpp_stats_dump_to_file");
-    logger.info("Loaded: il2cpp_stats_dump_to_file");
-    *(void**)(&stats_get_value) = dlsym(imagehandle, "il2cpp_stats_get_value");
-    logger.info("Loaded: il2cpp_stats_get_value");
-    *(void**)(&domain_get) = dlsym(imagehandle, "il2cpp_domain_get");
-    logger.info("Loaded: il2cpp_domain_get");
-    *(void**)(&domain_assembly_open) = dlsym(imagehandle, "il2cpp_domain_assembly_open");
-    logger.info("Loaded: il2cpp_domain_assembly_open");
-    *(void**)(&domain_get_assemblies) = dlsym(imagehandle, "il2cpp_domain_get_assemblies");
-    logger.info("Loaded: il2cpp_domain_get_assemblies");
-    #ifdef UNITY_2019
-    *(void**)(&raise_exception) = dlsym(imagehandle, "il2cpp_raise_exception");
-    logger.info("Loaded: il2cpp_raise_exception");
-    #endif
-    *(void**)(&exception_from_name_msg) = dlsym(imagehandle, "il2cpp_exception_from_name_msg");
-    logger.info("Loaded: il2cpp_exception_from_name_msg");
-    *(void**)(&get_exception_argument_null) = dlsym(imagehandle, "il2cpp_get_exception_argument_null");
-    logger.info("Loaded: il2cpp_get_exception_argument_null");
-    *(void**)(&format_exception) = dlsym(imagehandle, "il2cpp_format_exception");
-    logger.info("Loaded: il2cpp_format_exception");
-    *(void**)(&format_stack_trace) = dlsym(imagehandle, "il2cpp_format_stack_trace");
-    logger.info("Loaded: il2cpp_format_stack_trace");
-    *(void**)(&unhandled_exception) = dlsym(imagehandle, "il2cpp_unhandled_exception");
-    logger.info("Loaded: il2cpp_unhandled_exception");
-    *(void**)(&field_get_flags) = dlsym(imagehandle, "il2cpp_field_get_flags");
-    logger.info("Loaded: il2cpp_field_get_flags");
-    *(void**)(&field_get_name) = dlsym(imagehandle, "il2cpp_field_get_name");
-    logger.info("Loaded: il2cpp_field_get_name");
-    *(void**)(&field_get_parent) = dlsym(imagehandle, "il2cpp_field_get_parent");
-    logger.info("Loaded: il2cpp_field_get_parent");
-    *(void**)(&field_get_offset) = dlsym(imagehandle, "il2cpp_field_get_offset");
-    logger.info("Loaded: il2cpp_field_get_offset");
-    *(void**)(&field_get_type) = dlsym(imagehandle, "il2cpp_field_get_type");
-    logger.info("Loaded: il2cpp_field_get_type");
-    *(void**)(&field_get_value) = dlsym(imagehandle, "il2cpp_field_get_value");
-    logger.info("Loaded: il2cpp_field_get_value");
-    *(void**)(&field_get_value_object) = dlsym(imagehandle, "il2cpp_field_get_value_object");
-    logger.info("Loaded: il2cpp_field_get_value_object");
-    *(void**)(&field_has_attribute) = dlsym(imagehandle, "il2cpp_field_has_attribute");
-    logger.info("Loaded: il2cpp_field_has_attribute");
-    *(void**)(&field_set_value) = dlsym(imagehandle, "il2cpp_field_set_value");
-    logger.info("Loaded: il2cpp_field_set_value");
-    *(void**)(&field_static_get_value) = dlsym(imagehandle, "il2cpp_field_static_get_value");
-    logger.info("Loaded: il2cpp_field_static_get_value");
-    *(void**)(&field_static_set_value) = dlsym(imagehandle, "il2cpp_field_static_set_value");
-    logger.info("Loaded: il2cpp_field_static_set_value");
-    *(void**)(&field_set_value_object) = dlsym(imagehandle, "il2cpp_field_set_value_object");
-    logger.info("Loaded: il2cpp_field_set_value_object");
-    #ifdef UNITY_2019
-    *(void**)(&field_is_literal) = dlsym(imagehandle, "il2cpp_field_is_literal");
-    logger.info("Loaded: il2cpp_field_is_literal");
-    #endif
-    *(void**)(&gc_collect) = dlsym(imagehandle, "il2cpp_gc_collect");
-    logger.info("Loaded: il2cpp_gc_collect");
-    *(void**)(&gc_collect_a_little) = dlsym(imagehandle, "il2cpp_gc_collect_a_little");
-    logger.info("Loaded: il2cpp_gc_collect_a_little");
-    *(void**)(&gc_disable) = dlsym(imagehandle, "il2cpp_gc_disable");
-    logger.info("Loaded: il2cpp_gc_disable");
-    *(void**)(&gc_enable) = dlsym(imagehandle, "il2cpp_gc_enable");
-    logger.info("Loaded: il2cpp_gc_enable");
-    *(void**)(&gc_is_disabled) = dlsym(imagehandle, "il2cpp_gc_is_disabled");
-    logger.info("Loaded: il2cpp_gc_is_disabled");
-    #ifdef UNITY_2019
-    *(void**)(&gc_get_max_time_slice_ns) = dlsym(imagehandle, "il2cpp_gc_get_max_time_slice_ns");
-    logger.info("Loaded: il2cpp_gc_get_max_time_slice_ns");
-    *(void**)(&gc_set_max_time_slice_ns) = dlsym(imagehandle, "il2cpp_gc_set_max_time_slice_ns");
-    logger.info("Loaded: il2cpp_gc_set_max_time_slice_ns");
-    *(void**)(&gc_is_incremental) = dlsym(imagehandle, "il2cpp_gc_is_incremental");
-    logger.info("Loaded: il2cpp_gc_is_incremental");
-    #endif
-    *(void**)(&gc_get_used_size) = dlsym(imagehandle, "il2cpp_gc_get_used_size");
-    logger.info("Loaded: il2cpp_gc_get_used_size");
-    *(void**)(&gc_get_heap_size) = dlsym(imagehandle, "il2cpp_gc_get_heap_size");
-    logger.info("Loaded: il2cpp_gc_get_heap_size");
-    *(void**)(&gc_wbarrier_set_field) = dlsym(imagehandle, "il2cpp_gc_wbarrier_set_field");
-    logger.info("Loaded: il2cpp_gc_wbarrier_set_field");
-    #ifdef UNITY_2019
-    *(void**)(&gc_has_strict_wbarriers) = dlsym(imagehandle, "il2cpp_gc_has_strict_wbarriers");
-    logger.info("Loaded: il2cpp_gc_has_strict_wbarriers");
-    *(void**)(&gc_set_external_allocation_tracker) = dlsym(imagehandle, "il2cpp_gc_set_external_allocation_tracker");
-    logger.info("Loaded: il2cpp_gc_set_external_allocation_tracker");
-    *(void**)(&gc_set_external_wbarrier_tracker) = dlsym(imagehandle, "il2cpp_gc_set_external_wbarrier_tracker");
-    logger.info("Loaded: il2cpp_gc_set_external_wbarrier_tracker");
-    *(void**)(&gc_foreach_heap) = dlsym(imagehandle, "il2cpp_gc_foreach_heap");
-    logger.info("Loaded: il2cpp_gc_foreach_heap");
-    *(void**)(&stop_gc_world) = dlsym(imagehandle, "il2cpp_stop_gc_world");
-    logger.info("Loaded: il2cpp_stop_gc_world");
-    *(void**)(&start_gc_world) = dlsym(imagehandle, "il2cpp_start_gc_world");
-    logger.info("Loaded: il2cpp_start_gc_world");
-    #endif
-    *(void**)(&gchandle_new) = dlsym(imagehandle, "il2cpp_gchandle_new");
-    logger.info("Loaded: il2cpp_gchandle_new");
-    *(void**)(&gchandle_new_weakref) = dlsym(imagehandle, "il2cpp_gchandle_new_weakref");
-    logger.info("Loaded: il2cpp_gchandle_new_weakref");
-    *(void**)(&gchandle_get_target) = dlsym(imagehandle, "il2cpp_gchandle_get_target");
-    logger.info("Loaded: il2cpp_gchandle_get_target");
-    *(void**)(&gchandle_free) = dlsym(imagehandle, "il2cpp_gchandle_free");
-    logger.info("Loaded: il2cpp_gchandle_free");
-    #ifdef UNITY_2019
-    *(void**)(&gchandle_foreach_get_target) = dlsym(imagehandle, "il2cpp_gchandle_foreach_get_target");
-    logger.info("Loaded: il2cpp_gchandle_foreach_get_target");
-    *(void**)(&object_header_size) = dlsym(imagehandle, "il2cpp_object_header_size");
-    logger.info("Loaded: il2cpp_object_header_size");
-    *(void**)(&array_object_header_size) = dlsym(imagehandle, "il2cpp_array_object_header_size");
-    logger.info("Loaded: il2cpp_array_object_header_size");
-    *(void**)(&offset_of_array_length_in_array_object_header) = dlsym(imagehandle, "il2cpp_offset_of_array_length_in_array_object_header");
-    logger.info("Loaded: il2cpp_offset_of_array_length_in_array_object_header");
-    *(void**)(&offset_of_array_bounds_in_array_object_header) = dlsym(imagehandle, "il2cpp_offset_of_array_bounds_in_array_object_header");
-    logger.info("Loaded: il2cpp_offset_of_array_bounds_in_array_object_header");
-    *(void**)(&allocation_granularity) = dlsym(imagehandle, "il2cpp_allocation_granularity");
-    logger.info("Loaded: il2cpp_allocation_granularity");
-    #endif
-    *(void**)(&unity_liveness_calculation_begin) = dlsym(imagehandle, "il2cpp_unity_liveness_calculation_begin");
-    logger.info("Loaded: il2cpp_unity_liveness_calculation_begin");
-    *(void**)(&unity_liveness_calculation_end) = dlsym(imagehandle, "il2cpp_unity_liveness_calculation_end");
-    logger.info("Loaded: il2cpp_unity_liveness_calculation_end");
-    *(void**)(&unity_liveness_calculation_from_root) = dlsym(imagehandle, "il2cpp_unity_liveness_calculation_from_root");
-    logger.info("Loaded: il2cpp_unity_liveness_calculation_from_root");
-    *(void**)(&unity_liveness_calculation_from_statics) = dlsym(imagehandle, "il2cpp_unity_liveness_calculation_from_statics");
-    logger.info("Loaded: il2cpp_unity_liveness_calculation_from_statics");
-    *(void**)(&method_get_return_type) = dlsym(imagehandle, "il2cpp_method_get_return_type");
-    logger.info("Loaded: il2cpp_method_get_return_type");
-    *(void**)(&method_get_declaring_type) = dlsym(imagehandle, "il2cpp_method_get_declaring_type");
-    logger.info("Loaded: il2cpp_method_get_declaring_type");
-    *(void**)(&method_get_name) = dlsym(imagehandle, "il2cpp_method_get_name");
-    logger.info("Loaded: il2cpp_method_get_name");
-    *(void**)(&method_get_from_reflection) = dlsym(imagehandle, "il2cpp_method_get_from_reflection");
-    logger.info("Loaded: il2cpp_method_get_from_reflection");
-    *(void**)(&method_get_object) = dlsym(imagehandle, "il2cpp_method_get_object");
-    logger.info("Loaded: il2cpp_method_get_object");
-    *(void**)(&method_is_generic) = dlsym(imagehandle, "il2cpp_method_is_generic");
-    logger.info("Loaded: il2cpp_method_is_generic");
-    *(void**)(&method_is_inflated) = dlsym(imagehandle, "il2cpp_method_is_inflated");
-    logger.info("Loaded: il2cpp_method_is_inflated");
-    *(void**)(&method_is_instance) = dlsym(imagehandle, "il2cpp_method_is_instance");
-    logger.info("Loaded: il2cpp_method_is_instance");
-    *(void**)(&method_get_param_count) = dlsym(imagehandle, "il2cpp_method_get_param_count");
-    logger.info("Loaded: il2cpp_method_get_param_count");
-    *(void**)(&method_get_param) = dlsym(imagehandle, "il2cpp_method_get_param");
-    logger.info("Loaded: il2cpp_method_get_param");
-    *(void**)(&method_get_class) = dlsym(imagehandle, "il2cpp_method_get_class");
-    logger.info("Loaded: il2cpp_method_get_class");
-    *(void**)(&method_has_attribute) = dlsym(imagehandle, "il2cpp_method_has_attribute");
-    logger.info("Loaded: il2cpp_method_has_attribute");
-    *(void**)(&method_get_flags) = dlsym(imagehandle, "il2cpp_method_get_flags");
-    logger.info("Loaded: il2cpp_method_get_flags");
-    *(void**)(&method_get_token) = dlsym(imagehandle, "il2cpp_method_get_token");
-    logger.info("Loaded: il2cpp_method_get_token");
-    *(void**)(&method_get_param_name) = dlsym(imagehandle, "il2cpp_method_get_param_name");
-    logger.info("Loaded: il2cpp_method_get_param_name");
-    *(void**)(&profiler_install) = dlsym(imagehandle, "il2cpp_profiler_install");
-    logger.info("Loaded: il2cpp_profiler_install");
-    *(void**)(&profiler_set_events) = dlsym(imagehandle, "il2cpp_profiler_set_events");
-    logger.info("Loaded: il2cpp_profiler_set_events");
-    *(void**)(&profiler_install_enter_leave) = dlsym(imagehandle, "il2cpp_profiler_install_enter_leave");
-    logger.info("Loaded: il2cpp_profiler_install_enter_leave");
-    *(void**)(&profiler_install_allocation) = dlsym(imagehandle, "il2cpp_profiler_install_allocation");
-    logger.info("Loaded: il2cpp_profiler_install_allocation");
-    *(void**)(&profiler_install_gc) = dlsym(imagehandle, "il2cpp_profiler_install_gc");
-    logger.info("Loaded: il2cpp_profiler_install_gc");
-    *(void**)(&profiler_install_fileio) = dlsym(imagehandle, "il2cpp_profiler_install_fileio");
-    logger.info("Loaded: il2cpp_profiler_install_fileio");
-    *(void**)(&profiler_install_thread) = dlsym(imagehandle, "il2cpp_profiler_install_thread");
-    logger.info("Loaded: il2cpp_profiler_install_thread");
-    *(void**)(&property_get_flags) = dlsym(imagehandle, "il2cpp_property_get_flags");
-    logger.info("Loaded: il2cpp_property_get_flags");
-    *(void**)(&property_get_get_method) = dlsym(imagehandle, "il2cpp_property_get_get_method");
-    logger.info("Loaded: il2cpp_property_get_get_method");
-    *(void**)(&property_get_set_method) = dlsym(imagehandle, "il2cpp_property_get_set_method");
-    logger.info("Loaded: il2cpp_property_get_set_method");
-    *(void**)(&property_get_name) = dlsym(imagehandle, "il2cpp_property_get_name");
-    logger.info("Loaded: il2cpp_property_get_name");
-    *(void**)(&property_get_parent) = dlsym(imagehandle, "il2cpp_property_get_parent");
-    logger.info("Loaded: il2cpp_property_get_parent");
-    *(void**)(&object_get_class) = dlsym(imagehandle, "il2cpp_object_get_class");
-    logger.info("Loaded: il2cpp_object_get_class");
-    *(void**)(&object_get_size) = dlsym(imagehandle, "il2cpp_object_get_size");
-    logger.info("Loaded: il2cpp_object_get_size");
-    *(void**)(&object_get_virtual_method) = dlsym(imagehandle, "il2cpp_object_get_virtual_method");
-    logger.info("Loaded: il2cpp_object_get_virtual_method");
-    *(void**)(&object_new) = dlsym(imagehandle, "il2cpp_object_new");
-    logger.info("Loaded: il2cpp_object_new");
-    *(void**)(&object_unbox) = dlsym(imagehandle, "il2cpp_object_unbox");
-    logger.info("Loaded: il2cpp_object_unbox");
-    *(void**)(&value_box) = dlsym(imagehandle, "il2cpp_value_box");
-    logger.info("Loaded: il2cpp_value_box");
-    *(void**)(&monitor_enter) = dlsym(imagehandle, "il2cpp_monitor_enter");
-    logger.info("Loaded: il2cpp_monitor_enter");
-    *(void**)(&monitor_try_enter) = dlsym(imagehandle, "il2cpp_monitor_try_enter");
-    logger.info("Loaded: il2cpp_monitor_try_enter");
-    *(void**)(&monitor_exit) = dlsym(imagehandle, "il2cpp_monitor_exit");
-    logger.info("Loaded: il2cpp_monitor_exit");
-    *(void**)(&monitor_pulse) = dlsym(imagehandle, "il2cpp_monitor_pulse");
-    logger.info("Loaded: il2cpp_monitor_pulse");
-    *(void**)(&monitor_pulse_all) = dlsym(imagehandle, "il2cpp_monitor_pulse_all");
-    logger.info("Loaded: il2cpp_monitor_pulse_all");
-    *(void**)(&monitor_wait) = dlsym(imagehandle, "il2cpp_monitor_wait");
-    logger.info("Loaded: il2cpp_monitor_wait");
-    *(void**)(&monitor_try_wait) = dlsym(imagehandle, "il2cpp_monitor_try_wait");
-    logger.info("Loaded: il2cpp_monitor_try_wait");
-    *(void**)(&runtime_invoke) = dlsym(imagehandle, "il2cpp_runtime_invoke");
-    logger.info("Loaded: il2cpp_runtime_invoke");
-    *(void**)(&runtime_invoke_convert_args) = dlsym(imagehandle, "il2cpp_runtime_invoke_convert_args");
-    logger.info("Loaded: il2cpp_runtime_invoke_convert_args");
-    *(void**)(&runtime_class_init) = dlsym(imagehandle, "il2cpp_runtime_class_init");
-    logger.info("Loaded: il2cpp_runtime_class_init");
-    *(void**)(&runtime_object_init) = dlsym(imagehandle, "il2cpp_runtime_object_init");
-    logger.info("Loaded: il2cpp_runtime_object_init");
-    *(void**)(&runtime_object_init_exception) = dlsym(imagehandle, "il2cpp_runtime_object_init_exception");
-    logger.info("Loaded: il2cpp_runtime_object_init_exception");
-    *(void**)(&runtime_unhandled_exception_policy_set) = dlsym(imagehandle, "il2cpp_runtime_unhandled_exception_policy_set");
-    logger.info("Loaded: il2cpp_runtime_unhandled_exception_policy_set");
-    *(void**)(&string_length) = dlsym(imagehandle, "il2cpp_string_length");
-    logger.info("Loaded: il2cpp_string_length");
-    *(void**)(&string_chars) = dlsym(imagehandle, "il2cpp_string_chars");
-    logger.info("Loaded: il2cpp_string_chars");
-    *(void**)(&string_new) = dlsym(imagehandle, "il2cpp_string_new");
-    logger.info("Loaded: il2cpp_string_new");
-    *(void**)(&string_new_len) = dlsym(imagehandle, "il2cpp_string_new_len");
-    logger.info("Loaded: il2cpp_string_new_len");
-    *(void**)(&string_new_utf16) = dlsym(imagehandle, "il2cpp_string_new_utf16");
-    logger.info("Loaded: il2cpp_string_new_utf16");
-    *(void**)(&string_new_wrapper) = dlsym(imagehandle, "il2cpp_string_new_wrapper");
-    logger.info("Loaded: il2cpp_string_new_wrapper");
-    *(void**)(&string_intern) = dlsym(imagehandle, "il2cpp_string_intern");
-    logger.info("Loaded: il2cpp_string_intern");
-    *(void**)(&string_is_interned) = dlsym(imagehandle, "il2cpp_string_is_interned");
-    logger.info("Loaded: il2cpp_string_is_interned");
-    *(void**)(&thread_current) = dlsym(imagehandle, "il2cpp_thread_current");
-    logger.info("Loaded: il2cpp_thread_current");
-    *(void**)(&thread_attach) = dlsym(imagehandle, "il2cpp_thread_attach");
-    logger.info("Loaded: il2cpp_thread_attach");
-    *(void**)(&thread_detach) = dlsym(imagehandle, "il2cpp_thread_detach");
-    logger.info("Loaded: il2cpp_thread_detach");
-    *(void**)(&thread_get_all_attached_threads) = dlsym(imagehandle, "il2cpp_thread_get_all_attached_threads");
-    logger.info("Loaded: il2cpp_thread_get_all_attached_threads");
-    *(void**)(&is_vm_thread) = dlsym(imagehandle, "il2cpp_is_vm_thread");
-    logger.info("Loaded: il2cpp_is_vm_thread");
-    *(void**)(&current_thread_walk_frame_stack) = dlsym(imagehandle, "il2cpp_current_thread_walk_frame_stack");
-    logger.info("Loaded: il2cpp_current_thread_walk_frame_stack");
-    *(void**)(&thread_walk_frame_stack) = dlsym(imagehandle, "il2cpp_thread_walk_frame_stack");
-    logger.info("Loaded: il2cpp_thread_walk_frame_stack");
-    *(void**)(&current_thread_get_top_frame) = dlsym(imagehandle, "il2cpp_current_thread_get_top_frame");
-    logger.info("Loaded: il2cpp_current_thread_get_top_frame");
-    *(void**)(&thread_get_top_frame) = dlsym(imagehandle, "il2cpp_thread_get_top_frame");
-    logger.info("Loaded: il2cpp_thread_get_top_frame");
-    *(void**)(&current_thread_get_frame_at) = dlsym(imagehandle, "il2cpp_current_thread_get_frame_at");
-    logger.info("Loaded: il2cpp_current_thread_get_frame_at");
-    *(void**)(&thread_get_frame_at) = dlsym(imagehandle, "il2cpp_thread_get_frame_at");
-    logger.info("Loaded: il2cpp_thread_get_frame_at");
-    *(void**)(&current_thread_get_stack_depth) = dlsym(imagehandle, "il2cpp_current_thread_get_stack_depth");
-    logger.info("Loaded: il2cpp_current_thread_get_stack_depth");
-    *(void**)(&thread_get_stack_depth) = dlsym(imagehandle, "il2cpp_thread_get_stack_depth");
-    logger.info("Loaded: il2cpp_thread_get_stack_depth");
-    #ifdef UNITY_2019
-    *(void**)(&override_stack_backtrace) = dlsym(imagehandle, "il2cpp_override_stack_backtrace");
-    logger.info("Loaded: il2cpp_override_stack_backtrace");
-    #endif
-    *(void**)(&type_get_object) = dlsym(imagehandle, "il2cpp_type_get_object");
-    logger.info("Loaded: il2cpp_type_get_object");
-    *(void**)(&type_get_type) = dlsym(imagehandle, "il2cpp_type_get_type");
-    logger.info("Loaded: il2cpp_type_get_type");
-    *(void**)(&type_get_class_or_element_class) = dlsym(imagehandle, "il2cpp_type_get_class_or_element_class");
-    logger.info("Loaded: il2cpp_type_get_class_or_element_class");
-    *(void**)(&type_get_name) = dlsym(imagehandle, "il2cpp_type_get_name");
-    logger.info("Loaded: il2cpp_type_get_name");
-    *(void**)(&type_is_byref) = dlsym(imagehandle, "il2cpp_type_is_byref");
-    logger.info("Loaded: il2cpp_type_is_byref");
-    *(void**)(&type_get_attrs) = dlsym(imagehandle, "il2cpp_type_get_attrs");
-    logger.info("Loaded: il2cpp_type_get_attrs");
-    *(void**)(&type_equals) = dlsym(imagehandle, "il2cpp_type_equals");
-    logger.info("Loaded: il2cpp_type_equals");
-    *(void**)(&type_get_assembly_qualified_name) = dlsym(imagehandle, "il2cpp_type_get_assembly_qualified_name");
-    logger.info("Loaded: il2cpp_type_get_assembly_qualified_name");
-    #ifdef UNITY_2019
-    *(void**)(&type_is_static) = dlsym(imagehandle, "il2cpp_type_is_static");
-    logger.info("Loaded: il2cpp_type_is_static");
-    *(void**)(&type_is_pointer_type) = dlsym(imagehandle, "il2cpp_type_is_pointer_type");
-    logger.info("Loaded: il2cpp_type_is_pointer_type");
-    #endif
-    *(void**)(&image_get_assembly) = dlsym(imagehandle, "il2cpp_image_get_assembly");
-    logger.info("Loaded: il2cpp_image_get_assembly");
-    *(void**)(&image_get_name) = dlsym(imagehandle, "il2cpp_image_get_name");
-    logger.info("Loaded: il2cpp_image_get_name");
-    *(void**)(&image_get_filename) = dlsym(imagehandle, "il2cpp_image_get_filename");
-    logger.info("Loaded: il2cpp_image_get_filename");
-    *(void**)(&image_get_entry_point) = dlsym(imagehandle, "il2cpp_image_get_entry_point");
-    logger.info("Loaded: il2cpp_image_get_entry_point");
-    *(void**)(&image_get_class_count) = dlsym(imagehandle, "il2cpp_image_get_class_count");
-    logger.info("Loaded: il2cpp_image_get_class_count");
-    *(void**)(&image_get_class) = dlsym(imagehandle, "il2cpp_image_get_class");
-    logger.info("Loaded: il2cpp_image_get_class");
-    *(void**)(&capture_memory_snapshot) = dlsym(imagehandle, "il2cpp_capture_memory_snapshot");
-    logger.info("Loaded: il2cpp_capture_memory_snapshot");
-    *(void**)(&free_captured_memory_snapshot) = dlsym(imagehandle, "il2cpp_free_captured_memory_snapshot");
-    logger.info("Loaded: il2cpp_free_captured_memory_snapshot");
-    *(void**)(&set_find_plugin_callback) = dlsym(imagehandle, "il2cpp_set_find_plugin_callback");
-    logger.info("Loaded: il2cpp_set_find_plugin_callback");
-    *(void**)(&register_log_callback) = dlsym(imagehandle, "il2cpp_register_log_callback");
-    logger.info("Loaded: il2cpp_register_log_callback");
-    *(void**)(&debugger_set_agent_options) = dlsym(imagehandle, "il2cpp_debugger_set_agent_options");
-    logger.info("Loaded: il2cpp_debugger_set_agent_options");
-    *(void**)(&is_debugger_attached) = dlsym(imagehandle, "il2cpp_is_debugger_attached");
-    logger.info("Loaded: il2cpp_is_debugger_attached");
-    #ifdef UNITY_2019
-    *(void**)(&register_debugger_agent_transport) = dlsym(imagehandle, "il2cpp_register_debugger_agent_transport");
-    logger.info("Loaded: il2cpp_register_debugger_agent_transport");
-    *(void**)(&debug_get_method_info) = dlsym(imagehandle, "il2cpp_debug_get_method_info");
-    logger.info("Loaded: il2cpp_debug_get_method_info");
-    #endif
-    *(void**)(&unity_install_unitytls_interface) = dlsym(imagehandle, "il2cpp_unity_install_unitytls_interface");
-    logger.info("Loaded: il2cpp_unity_install_unitytls_interface");
-    *(void**)(&custom_attrs_from_class) = dlsym(imagehandle, "il2cpp_custom_attrs_from_class");
-    logger.info("Loaded: il2cpp_custom_attrs_from_class");
-    *(void**)(&custom_attrs_from_method) = dlsym(imagehandle, "il2cpp_custom_attrs_from_method");
-    logger.info("Loaded: il2cpp_custom_attrs_from_method");
-    *(void**)(&custom_attrs_get_attr) = dlsym(imagehandle, "il2cpp_custom_attrs_get_attr");
-    logger.info("Loaded: il2cpp_custom_attrs_get_attr");
-    *(void**)(&custom_attrs_has_attr) = dlsym(imagehandle, "il2cpp_custom_attrs_has_attr");
-    logger.info("Loaded: il2cpp_custom_attrs_has_attr");
-    *(void**)(&custom_attrs_construct) = dlsym(imagehandle, "il2cpp_custom_attrs_construct");
-    logger.info("Loaded: il2cpp_custom_attrs_construct");
-    *(void**)(&custom_attrs_free) = dlsym(imagehandle, "il2cpp_custom_attrs_free");
-    logger.info("Loaded: il2cpp_custom_attrs_free");
-    #ifdef UNITY_2019
-    *(void**)(&class_set_userdata) = dlsym(imagehandle, "il2cpp_class_set_userdata");
-    logger.info("Loaded: il2cpp_class_set_userdata");
-    *(void**)(&class_get_userdata_offset) = dlsym(imagehandle, "il2cpp_class_get_userdata_offset");
-    logger.info("Loaded: il2cpp_class_get_userdata_offset");
-    #endif
-
-    // MANUALLY DEFINED CONST DEFINITIONS
-    *(void**)(&class_get_type_const) = dlsym(imagehandle, "il2cpp_class_get_type");
-    logger.info("Loaded: il2cpp_class_get_type CONST VERSION!");
-    *(void**)(&il2cpp_functions::class_get_name_const) = dlsym(imagehandle, "il2cpp_class_get_name");
-    logger.info("Loaded: il2cpp_class_get_name CONST VERSION!");
-
-    const char* err = dlerror();
-    if (err) {
-        logger.critical("A dlsym failed! dlerror: %s", err);
-    }
-
-    // XREF TRACES
-    // Class::Init. 0x846A68 in 1.5, 0x9EC0A4 in 1.7.0, 0xA6D1B8 in 1.8.0b1
-    Instruction ans((const int32_t*)HookTracker::GetOrig(array_new_specific));
-    Instruction Array_NewSpecific(CRASH_UNLESS(ans.label));
-    logger.debug("Array::NewSpecific offset: %lX", ((uintptr_t)Array_NewSpecific.addr) - getRealOffset(0));
-    auto j2Cl_I = CRASH_UNLESS(Array_NewSpecific.findNthCall(1));  // also the 113th call in Runtime::Init
-    Class_Init = (decltype(Class_Init))CRASH_UNLESS(j2Cl_I->label);
-    logger.debug("Class::Init found? offset: %lX", ((uintptr_t)Class_Init) - getRealOffset(0));
-    if (j2Cl_I != &Array_NewSpecific) delete j2Cl_I;
-    usleep(1000);  // 0.001s
-
-    // MetadataCache::GetTypeInfoFromTypeIndex. offset 0x84F764 in 1.5, 0x9F5250 in 1.7.0, 0xA7A79C in 1.8.0b1
-    Instruction caha((const int32_t*)HookTracker::GetOrig(custom_attrs_has_attr));
-    auto mchab = CRASH_UNLESS(caha.findNthDirectBranchWithoutLink(1));
-    Instruction MetadataCache_HasAttribute(CRASH_UNLESS(mchab->label));
-    if (mchab != &caha) delete mchab;
-    auto j2MC_GTIFTI = CRASH_UNLESS(MetadataCache_HasAttribute.findNthCall(1));
-    MetadataCache_GetTypeInfoFromTypeIndex = (decltype(MetadataCache_GetTypeInfoFromTypeIndex))CRASH_UNLESS(j2MC_GTIFTI->label);
-    logger.debug("MetadataCache::GetTypeInfoFromTypeIndex found? offset: %lX",
-        ((uintptr_t)MetadataCache_GetTypeInfoFromTypeIndex) - getRealOffset(0));
-    if (j2MC_GTIFTI != &MetadataCache_HasAttribute) delete j2MC_GTIFTI;
-    usleep(1000);  // 0.001s
-
-    // MetadataCache::GetTypeInfoFromTypeDefinitionIndex. offset 0x84FBA4 in 1.5, 0x9F5690 in 1.7.0, 0xA75958 in 1.8.0b1
-    Instruction tgcoec((const int32_t*)HookTracker::GetOrig(type_get_class_or_element_class));
-    auto tgoecb = CRASH_UNLESS(tgcoec.findNthDirectBranchWithoutLink(1));
-    Instruction Type_GetClassOrElementClass(CRASH_UNLESS(tgoecb->label));
-    if (tgoecb != &tgcoec) delete tgoecb;
-    auto j2MC_GTIFTDI = CRASH_UNLESS(Type_GetClassOrElementClass.findNthDirectBranchWithoutLink(5));
-    MetadataCache_GetTypeInfoFromTypeDefinitionIndex =
-        (decltype(MetadataCache_GetTypeInfoFromTypeDefinitionIndex))CRASH_UNLESS(j2MC_GTIFTDI->label);
-    logger.debug("MetadataCache::GetTypeInfoFromTypeDefinitionIndex found? offset: %lX",
-        ((uintptr_t)MetadataCache_GetTypeInfoFromTypeDefinitionIndex) - getRealOffset(0));
-    if (j2MC_GTIFTDI != &Type_GetClassOrElementClass) delete j2MC_GTIFTDI;
-    usleep(1000);  // 0.001s
-
-    // Type::GetName. offset 0x8735DC in 1.5, 0xA1A458 in 1.7.0, 0xA7B634 in 1.8.0b1
-    Instruction tanq((const int32_t*)HookTracker::GetOrig(type_get_assembly_qualified_name));
-    auto j2T_GN = CRASH_UNLESS(tanq.findNthCall(1));
-    _Type_GetName_ = (decltype(_Type_GetName_))CRASH_UNLESS(j2T_GN->label);
-    logger.debug("Type::GetName found? offset: %lX", ((uintptr_t)_Type_GetName_) - getRealOffset(0));
-    if (j2T_GN != &tanq) delete j2T_GN;
-    usleep(1000);  // 0.001s
-
-    // GenericClass::GetClass. offset 0x88DF64 in 1.5, 0xA34F20 in 1.7.0, 0xA6E4EC in 1.8.0b1
-    Instruction cfit((const int32_t*)HookTracker::GetOrig(class_from_il2cpp_type));
-    auto b = CRASH_UNLESS(cfit.findNthDirectBranchWithoutLink(1));
-    Class_FromIl2CppType = (decltype(Class_FromIl2CppType))CRASH_UNLESS(b->label);
-    if (b != &cfit) delete b;
-    auto caseStart = CRASH_UNLESS(EvalSwitch(Class_FromIl2CppType, 1, 1, IL2CPP_TYPE_GENERICINST));
-    auto j2GC_GC = CRASH_UNLESS(caseStart->findNthDirectBranchWithoutLink(1));
-    delete caseStart;
-    logger.debug("j2GC_GC: %s", j2GC_GC->toString().c_str());
-    GenericClass_GetClass = (decltype(GenericClass_GetClass))CRASH_UNLESS(j2GC_GC->label);
-    logger.debug("GenericClass::GetClass found? offset: %lX", ((uintptr_t)GenericClass_GetClass) - getRealOffset(0));
-    if (j2GC_GC != caseStart) delete j2GC_GC;
-    usleep(1000);  // 0.001s
-
-    // Class::GetPtrClass.
-    auto ptrCase = CRASH_UNLESS(EvalSwitch(Class_FromIl2CppType, 1, 1, IL2CPP_TYPE_PTR));
-    auto j2C_GPC = CRASH_UNLESS(ptrCase->findNthDirectBranchWithoutLink(1));
-    delete ptrCase;
-    logger.debug("j2C_GPC: %s", j2C_GPC->toString().c_str());
-    Class_GetPtrClass = (decltype(Class_GetPtrClass))CRASH_UNLESS(j2C_GPC->label);
-    logger.debug("Class::GetPtrClass(Il2CppClass*) found? offset: %lX", ((uintptr_t)Class_GetPtrClass) - getRealOffset(0));
-    if (j2C_GPC != ptrCase) delete j2C_GPC;
-    usleep(1000);  // 0.001s
-
-    // Assembly::GetAllAssemblies
-    Instruction dga((const int32_t*)HookTracker::GetOrig(domain_get_assemblies));
-    auto* j2A_GAA = CRASH_UNLESS(dga.findNthCall(1));    
-    Assembly_GetAllAssemblies = (decltype(Assembly_GetAllAssemblies))CRASH_UNLESS(j2A_GAA->label);
-    logger.debug("Assembly::GetAllAssemblies found? offset: %lX", ((uintptr_t)Assembly_GetAllAssemblies) - getRealOffset(0));
-    if (j2A_GAA != &dga) delete j2A_GAA;
-    usleep(1000);  // 0.001s
-
-
-    CRASH_UNLESS(shutdown);
-    // GC_free
-    Instruction sd((const int32_t*)HookTracker::GetOrig(shutdown));
-    auto sdb = CRASH_UNLESS(sd.findNthDirectBranchWithoutLink(1));
-    auto* Runtime_Shutdown = CRASH_UNLESS(sdb->label);
-    if (sdb != &sd) delete sdb;
-
-    if (find_GC_free(Runtime_Shutdown)) {
-        logger.debug("gc::GarbageCollector::FreeFixed found? offset: %lX", ((uintptr_t)GC_free) - getRealOffset(0));
-        usleep(1000);  // 0.001s
-    }
-
-    // GarbageCollector::SetWriteBarrier(void*)
-    if (find_GC_SetWriteBarrier((const int32_t*)HookTracker::GetOrig(gc_wbarrier_set_field))) {
-        logger.debug("GarbageCollector::SetWriteBarrier found? offset: %lX", ((uintptr_t)GarbageCollector_SetWriteBarrier) - getRealOffset(0));
-        usleep(1000);  // 0.001s
+    if (lazy) {
+        for (auto& function : lazyFunctions()) {
+            if (function.stub) *function.slot = function.stub;
+        }
+        // Read rather than called, so there is nothing to put a stub in front of
+        if (!resolve(*findLazyFunction((void**)(&defaults)))) SAFE_ABORT();
+        initialized = true;
+        if (warmAllOnInit) std::thread(ResolveAll).detach();
+        logger.info("il2cpp_functions: Init: Stubbed all il2cpp functions, which resolve on first call%s",
+            warmAllOnInit ? " (or on the warming thread)" : "");
+        return;
     }
 
-    // GarbageCollector::AllocateFixed(size_t, void*)
-    Instruction localDomainGet((const int32_t*)HookTracker::GetOrig(domain_get));
-    auto* inst = CRASH_UNLESS(localDomainGet.findNthDirectBranchWithoutLink(1));
-    if (find_GC_AllocFixed(inst)) {
-        logger.debug("GarbageCollector::AllocateFixed found? offset: %lX", ((uintptr_t)GarbageCollector_AllocateFixed) - getRealOffset(0));
-        usleep(1000);  // 0.001s
+    for (auto& function : lazyFunctions()) {
+        if (!resolve(function) && function.required) {
+            logger.critical("Could not find %s!", function.name);
+            SAFE_ABORT();
+        }
     }
-    if (inst != &localDomainGet) delete inst;
-
-    // il2cpp_defaults
-    Instruction iu16((const int32_t*)HookTracker::GetOrig(init_utf16));
-    auto j2R_I = CRASH_UNLESS(iu16.findNthCall(3));
-    Instruction Runtime_Init(CRASH_UNLESS(j2R_I->label));
-    if (j2R_I != &iu16) delete j2R_I;
-    // alternatively, could just get the 1st ADRP in Runtime::Init with dest reg x20 (or the 9th ADRP)
-    // We DO need to skip at least one ret, though.
-    auto ldr = CRASH_UNLESS(Runtime_Init.findNth(6, std::mem_fn(&Instruction::isLoad), 1));  // the load for the malloc that precedes our adrp
-    il2cpp_functions::defaults = (decltype(il2cpp_functions::defaults))ExtractAddress(ldr->addr, 1, 1);
-    logger.debug("il2cpp_defaults found? offset: %lX", ((uintptr_t)defaults) - getRealOffset(0));
-    if (ldr != &Runtime_Init) delete ldr;
-    usleep(1000);  // 0.001s
-
-    // FIELDS
-    // Extract locations of s_GlobalMetadataHeader, s_Il2CppMetadataRegistration, & s_GlobalMetadata
-    // TODO: refactor to reduce instruction re-parsing?
-    il2cpp_functions::s_GlobalMetadataHeaderPtr = (decltype(il2cpp_functions::s_GlobalMetadataHeaderPtr))CRASH_UNLESS(
-        ExtractAddress(il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex, 3, 1));
-    usleep(1000);  // 0.001s
-    il2cpp_functions::s_Il2CppMetadataRegistrationPtr = (decltype(il2cpp_functions::s_Il2CppMetadataRegistrationPtr))CRASH_UNLESS(
-        ExtractAddress(il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex, 4, 1));
-    usleep(1000);  // 0.001s
-    il2cpp_functions::s_GlobalMetadataPtr = (decltype(il2cpp_functions::s_GlobalMetadataPtr))CRASH_UNLESS(
-        ExtractAddress(il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex, 5, 1));
-    usleep(1000);  // 0.001s
-    logger.debug("All global constants found!");
-
-    // NOTE: Runtime.Shutdown is NOT CALLED even for exceptions!
-    // There is practically no use in hooking this becuase of that.
-    // Runtime.Shutdown (for file loggers)
-    // if (Runtime_Shutdown) {
-    //     logger.info("hook installing to: %p (offset %lX)", Runtime_Shutdown, ((uintptr_t)Runtime_Shutdown) - getRealOffset(0));
-    //     INSTALL_HOOK_DIRECT(logger, shutdown_hook, (void*)Runtime_Shutdown);
-    // } else {
-    //     logger.critical("Failed to parse il2cpp_shutdown's implementation address! Could not install shutdown hook for closing file logs.");
-    // }
-
-    dlclose(imagehandle);
     initialized = true;
     logger.info("il2cpp_functions: Init: Successfully loaded all il2cpp functions!");
     usleep(100);  // 0.0001s
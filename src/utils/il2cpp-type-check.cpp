@@ -1,6 +1,8 @@
 #include "../../shared/utils/il2cpp-type-check.hpp"
 #include "../../shared/utils/il2cpp-utils.hpp"
 #include "../../shared/utils/hashing.hpp"
+#include "../../shared/utils/il2cpp-utils-class-index.hpp"
+#include "../../shared/utils/il2cpp-utils-persistent-cache.hpp"
 #include <unordered_map>
 
 namespace il2cpp_utils {
@@ -27,6 +29,28 @@ namespace il2cpp_utils {
             return itr->second;
         }
         nameHashLock.unlock();
+        if (auto klass = PersistentCache::FindClass(name_space, type_name)) {
+            nameHashLock.lock();
+            namesToClassesCache.emplace(key, klass);
+            nameHashLock.unlock();
+            return klass;
+        }
+        if (ClassIndex::IsEnabled()) {
+            // Builds the index if this is the first miss (or waits for a background build to finish)
+            ClassIndex::Build();
+            auto index = ClassIndex::Find(name_space, type_name);
+            if (index != kTypeDefinitionIndexInvalid) {
+                auto klass = il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex(index);
+                if (klass) {
+                    nameHashLock.lock();
+                    namesToClassesCache.emplace(key, klass);
+                    nameHashLock.unlock();
+                    PersistentCache::RecordClass(name_space, type_name, klass);
+                    return klass;
+                }
+            }
+            // Fall back to asking every image, in case the index missed something
+        }
         auto dom = RET_0_UNLESS(logger, il2cpp_functions::domain_get());
         size_t assemb_count;
         const Il2CppAssembly** allAssemb = il2cpp_functions::domain_get_assemblies(dom, &assemb_count);
@@ -43,6 +67,7 @@ namespace il2cpp_utils {
                 nameHashLock.lock();
                 namesToClassesCache.emplace(key, klass);
                 nameHashLock.unlock();
+                PersistentCache::RecordClass(name_space, type_name, klass);
                 return klass;
             }
         }
@@ -78,7 +103,7 @@ namespace il2cpp_utils {
 
         auto* reflection_type = RET_0_UNLESS(logger, MakeGenericType(reinterpret_cast<Il2CppReflectionType*>(klassType), arr));
         auto* ret = RET_0_UNLESS(logger, il2cpp_functions::class_from_system_type(reflection_type));
-        logger.debug("Returning '%s'", ClassStandardName(ret).c_str());
+        BS_LOG_DEBUG(logger, "Returning '%s'", ClassStandardName(ret).c_str());
         return ret;
     }
 
@@ -108,7 +133,7 @@ namespace il2cpp_utils {
 
         auto* reflection_type = RET_0_UNLESS(logger, MakeGenericType(reinterpret_cast<Il2CppReflectionType*>(klassType), arr));
         auto* ret = RET_0_UNLESS(logger, il2cpp_functions::class_from_system_type(reflection_type));
-        logger.debug("Returning '%s'", ClassStandardName(ret).c_str());
+        BS_LOG_DEBUG(logger, "Returning '%s'", ClassStandardName(ret).c_str());
         return ret;
     }
 }
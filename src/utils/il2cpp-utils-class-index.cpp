@@ -0,0 +1,179 @@
+#include "../../shared/utils/il2cpp-utils-class-index.hpp"
+#include "../../shared/utils/il2cpp-utils.hpp"
+#include "../../shared/utils/hashing.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace il2cpp_utils {
+    namespace {
+        struct ClassIndexEntry {
+            std::size_t hash;
+            const char* namespaze;
+            const char* name;
+            uint16_t namespazeLength;
+            uint16_t nameLength;
+            TypeDefinitionIndex index;
+        };
+
+        // Nested type names are built on the fly, so they are stored here in large blocks instead of one allocation each.
+        class NameArena {
+            static constexpr std::size_t blockSize = 64 * 1024;
+            std::vector<std::unique_ptr<char[]>> blocks;
+            std::size_t used = blockSize;
+            public:
+            std::size_t bytes = 0;
+            const char* copy(std::string_view str) {
+                auto size = str.size() + 1;
+                if (size > blockSize) {
+                    blocks.emplace_back(new char[size]);
+                    bytes += size;
+                    std::memcpy(blocks.back().get(), str.data(), str.size());
+                    blocks.back()[str.size()] = '\0';
+                    return blocks.back().get();
+                }
+                if (used + size > blockSize) {
+                    blocks.emplace_back(new char[blockSize]);
+                    bytes += blockSize;
+                    used = 0;
+                }
+                auto* dst = blocks.back().get() + used;
+                std::memcpy(dst, str.data(), str.size());
+                dst[str.size()] = '\0';
+                used += size;
+                return dst;
+            }
+        };
+
+        struct ClassIndexTable {
+            std::unique_ptr<ClassIndexEntry[]> entries;
+            std::size_t mask = 0;
+            std::size_t count = 0;
+            std::size_t nestedCount = 0;
+            NameArena names;
+        };
+
+        std::size_t hashName(std::string_view namespaze, std::string_view name) noexcept {
+            std::size_t seed = std::hash<std::string_view>{}(namespaze);
+            hash_combine(seed, name);
+            return seed;
+        }
+
+        std::atomic<const ClassIndexTable*> builtTable = nullptr;
+        std::atomic_bool enabled = false;
+        std::once_flag buildFlag;
+
+        // Inserts entry unless an entry with the same namespace and name already exists. The first image to define a name wins,
+        // just like the linear scan over images in GetClassFromName.
+        bool insert(ClassIndexTable& table, const ClassIndexEntry& entry) {
+            for (auto i = entry.hash & table.mask;; i = (i + 1) & table.mask) {
+                auto& slot = table.entries[i];
+                if (!slot.name) {
+                    slot = entry;
+                    return true;
+                }
+                if (slot.hash == entry.hash && slot.nameLength == entry.nameLength && slot.namespazeLength == entry.namespazeLength
+                    && std::memcmp(slot.name, entry.name, entry.nameLength) == 0 && std::memcmp(slot.namespaze, entry.namespaze, entry.namespazeLength) == 0) {
+                    return false;
+                }
+            }
+        }
+
+        void buildTable() {
+            static auto logger = getLogger().WithContext("ClassIndex");
+            il2cpp_functions::Init();
+            auto start = std::chrono::steady_clock::now();
+            auto* table = new ClassIndexTable();
+            std::vector<ClassIndexEntry> entries;
+
+            auto* dom = il2cpp_functions::domain_get();
+            if (!dom) {
+                logger.error("Could not get domain, class index will be empty!");
+            }
+            std::size_t assembCount = 0;
+            auto** assembs = dom ? il2cpp_functions::domain_get_assemblies(dom, &assembCount) : nullptr;
+            auto onType = [table, &entries](const char* namespaze, std::string_view name, TypeDefinitionIndex index, bool nested) {
+                const char* pName = name.data();
+                if (nested) {
+                    pName = table->names.copy(name);
+                    table->nestedCount++;
+                }
+                std::string_view ns(namespaze);
+                entries.push_back({hashName(ns, name), namespaze, pName, static_cast<uint16_t>(ns.size()), static_cast<uint16_t>(name.size()), index});
+            };
+            for (std::size_t i = 0; i < assembCount; i++) {
+                if (!assembs[i]) continue;
+                auto* img = il2cpp_functions::assembly_get_image(assembs[i]);
+                if (!img) {
+                    logger.warning("Assembly with name: %s has a null image!", assembs[i]->aname.name);
+                    continue;
+                }
+                for (uint32_t index = 0; index < img->typeCount; index++) {
+                    ForEachTypeName(img, img->typeStart + index, onType);
+                }
+                for (uint32_t index = 0; index < img->exportedTypeCount; index++) {
+                    auto typeIndex = il2cpp_functions::MetadataCache_GetExportedTypeFromIndex(img->exportedTypeStart + index);
+                    if (typeIndex != kTypeIndexInvalid)
+                        ForEachTypeName(img, typeIndex, onType);
+                }
+            }
+
+            // Keep the load factor at or below 0.5 so probe sequences stay short
+            std::size_t capacity = 16;
+            while (capacity < entries.size() * 2) capacity <<= 1;
+            table->entries.reset(new ClassIndexEntry[capacity]());
+            table->mask = capacity - 1;
+            for (auto& entry : entries) {
+                if (insert(*table, entry)) table->count++;
+            }
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            logger.info("Built class index of %zu types (%zu nested, %zu duplicates) from %zu assemblies in %lld us, using %zu bytes (%zu table + %zu names)",
+                table->count, table->nestedCount, entries.size() - table->count, assembCount, static_cast<long long>(elapsed),
+                capacity * sizeof(ClassIndexEntry) + table->names.bytes, capacity * sizeof(ClassIndexEntry), table->names.bytes);
+            builtTable.store(table, std::memory_order_release);
+        }
+    }
+
+    void ClassIndex::Build() noexcept {
+        enabled = true;
+        std::call_once(buildFlag, buildTable);
+    }
+
+    void ClassIndex::BuildAsync() noexcept {
+        enabled = true;
+        if (IsBuilt()) return;
+        // If a build is already in progress, this thread simply waits for it in call_once and exits.
+        std::thread(&ClassIndex::Build).detach();
+    }
+
+    void ClassIndex::EnableLazy() noexcept {
+        enabled = true;
+    }
+
+    bool ClassIndex::IsBuilt() noexcept {
+        return builtTable.load(std::memory_order_acquire) != nullptr;
+    }
+
+    bool ClassIndex::IsEnabled() noexcept {
+        return enabled;
+    }
+
+    TypeDefinitionIndex ClassIndex::Find(std::string_view namespaze, std::string_view name) noexcept {
+        auto* table = builtTable.load(std::memory_order_acquire);
+        if (!table) return kTypeDefinitionIndexInvalid;
+        auto hash = hashName(namespaze, name);
+        for (auto i = hash & table->mask;; i = (i + 1) & table->mask) {
+            auto& slot = table->entries[i];
+            if (!slot.name) return kTypeDefinitionIndexInvalid;
+            if (slot.hash == hash && slot.nameLength == name.size() && slot.namespazeLength == namespaze.size()
+                && std::memcmp(slot.name, name.data(), name.size()) == 0 && std::memcmp(slot.namespaze, namespaze.data(), namespaze.size()) == 0) {
+                return slot.index;
+            }
+        }
+    }
+}
@@ -30,7 +30,7 @@ namespace il2cpp_utils {
         RET_V_UNLESS(logger, klass);
 
         if (loggedClasses.count(klass)) {
-            logger.debug("Already logged %p!", klass);
+            BS_LOG_DEBUG(logger, "Already logged %p!", klass);
             return;
         }
         loggedClasses.insert(klass);
@@ -51,7 +51,7 @@ namespace il2cpp_utils {
             }
         }
 
-        logger.debug("%i ======================CLASS INFO FOR CLASS: %s======================", indent, ClassStandardName(klass).c_str());
+        BS_LOG_DEBUG(logger, "%i ======================CLASS INFO FOR CLASS: %s======================", indent, ClassStandardName(klass).c_str());
         void* myIter = nullptr;
         if (!methodInit) {
             // log results of Class::Init
@@ -65,31 +65,31 @@ namespace il2cpp_utils {
             }
         }
 
-        logger.debug("Pointer: %p", klass);
-        logger.debug("Type Token: %i", il2cpp_functions::class_get_type_token(klass));
+        BS_LOG_DEBUG(logger, "Pointer: %p", klass);
+        BS_LOG_DEBUG(logger, "Type Token: %i", il2cpp_functions::class_get_type_token(klass));
         auto typeDefIdx = klass->generic_class ? klass->generic_class->typeDefinitionIndex : il2cpp_functions::MetadataCache_GetIndexForTypeDefinition(klass);
-        logger.debug("TypeDefinitionIndex: %i", typeDefIdx);
+        BS_LOG_DEBUG(logger, "TypeDefinitionIndex: %i", typeDefIdx);
         // Repair the typeDefinition value if it was null but we found one
         if (!klass->typeDefinition && typeDefIdx > 0) klass->typeDefinition = il2cpp_functions::MetadataCache_GetTypeDefinitionFromIndex(typeDefIdx);
-        logger.debug("Type definition: %p", klass->typeDefinition);
+        BS_LOG_DEBUG(logger, "Type definition: %p", klass->typeDefinition);
 
-        logger.debug("Assembly Name: %s", il2cpp_functions::class_get_assemblyname(klass));
+        BS_LOG_DEBUG(logger, "Assembly Name: %s", il2cpp_functions::class_get_assemblyname(klass));
 
         auto* typ = il2cpp_functions::class_get_type(klass);
         if (typ) {
-            logger.debug("Type name: %s", il2cpp_functions::type_get_name(typ));
+            BS_LOG_DEBUG(logger, "Type name: %s", il2cpp_functions::type_get_name(typ));
             if (auto* reflName = il2cpp_functions::Type_GetName(typ, IL2CPP_TYPE_NAME_FORMAT_REFLECTION)) {
-                logger.debug("Type reflection name: %s", reflName);
+                BS_LOG_DEBUG(logger, "Type reflection name: %s", reflName);
                 il2cpp_functions::free(reflName);
             }
-            logger.debug("Fully qualifed type name: %s", il2cpp_functions::type_get_assembly_qualified_name(typ));
+            BS_LOG_DEBUG(logger, "Fully qualifed type name: %s", il2cpp_functions::type_get_assembly_qualified_name(typ));
         }
-        logger.debug("Rank: %i", il2cpp_functions::class_get_rank(klass));
-        logger.debug("Flags: 0x%.8X", il2cpp_functions::class_get_flags(klass));
-        logger.debug("Event Count: %i", klass->event_count);
-        logger.debug("Method Count: %i", klass->method_count);
-        logger.debug("Is Generic: %i", il2cpp_functions::class_is_generic(klass));
-        logger.debug("Is Abstract: %i", il2cpp_functions::class_is_abstract(klass));
+        BS_LOG_DEBUG(logger, "Rank: %i", il2cpp_functions::class_get_rank(klass));
+        BS_LOG_DEBUG(logger, "Flags: 0x%.8X", il2cpp_functions::class_get_flags(klass));
+        BS_LOG_DEBUG(logger, "Event Count: %i", klass->event_count);
+        BS_LOG_DEBUG(logger, "Method Count: %i", klass->method_count);
+        BS_LOG_DEBUG(logger, "Is Generic: %i", il2cpp_functions::class_is_generic(klass));
+        BS_LOG_DEBUG(logger, "Is Abstract: %i", il2cpp_functions::class_is_abstract(klass));
 
         // Some methods, such as GenericClass::GetClass, may not initialize all fields in Il2CppClass, and thus not meet all implicit contracts defined by the comments in Il2CppClass's struct definition.
         // But unless we're blind, the only method that sets is_generic on non-methods is MetadataCache::FromTypeDefinition. That method also contains the only assignment of genericContainerIndex.
@@ -98,7 +98,7 @@ namespace il2cpp_utils {
         // 2. Even if is_generic wasn't set, a positive genericContainerIndex was intentionally set that way and is a valid index.
         if (klass->is_generic || klass->genericContainerIndex > 0) {
             auto* genContainer = il2cpp_functions::MetadataCache_GetGenericContainerFromIndex(klass->genericContainerIndex);
-            logger.debug("genContainer: idx %i, ownerIndex: %i, is_method: %i", klass->genericContainerIndex, genContainer->ownerIndex, genContainer->is_method);
+            BS_LOG_DEBUG(logger, "genContainer: idx %i, ownerIndex: %i, is_method: %i", klass->genericContainerIndex, genContainer->ownerIndex, genContainer->is_method);
             if (genContainer->ownerIndex != typeDefIdx) {
                 logger.error("genContainer ownerIndex mismatch!");
             }
@@ -106,7 +106,7 @@ namespace il2cpp_utils {
                 auto genParamIdx = genContainer->genericParameterStart + i;
                 auto* genParam = il2cpp_functions::MetadataCache_GetGenericParameterFromIndex(genParamIdx);
                 if (genParam) {
-                    logger.debug("genParam #%i, idx %i: ownerIdx %i, name %s, num %i, flags (see "
+                    BS_LOG_DEBUG(logger, "genParam #%i, idx %i: ownerIdx %i, name %s, num %i, flags (see "
                         "IL2CPP_GENERIC_PARAMETER_ATTRIBUTE_X in il2cpp-tabledefs.h) 0x%.2X", i, genParamIdx, genParam->ownerIndex,
                         il2cpp_functions::MetadataCache_GetStringFromIndex(genParam->nameIndex), genParam->num, genParam->flags);
                 } else {
@@ -114,31 +114,31 @@ namespace il2cpp_utils {
                 }
             }
         } else {
-            logger.debug("genericContainerIndex: %i", klass->genericContainerIndex);
+            BS_LOG_DEBUG(logger, "genericContainerIndex: %i", klass->genericContainerIndex);
         }
 
-        logger.debug("%i =========METHODS=========", indent);
+        BS_LOG_DEBUG(logger, "%i =========METHODS=========", indent);
         LogMethods(logger, klass);
-        logger.debug("%i =======END METHODS=======", indent);
+        BS_LOG_DEBUG(logger, "%i =======END METHODS=======", indent);
 
         auto* declaring = il2cpp_functions::class_get_declaring_type(klass);
-        logger.debug("declaring type: %p (%s)", declaring, declaring ? ClassStandardName(declaring).c_str() : "");
+        BS_LOG_DEBUG(logger, "declaring type: %p (%s)", declaring, declaring ? ClassStandardName(declaring).c_str() : "");
         if (declaring && logParents) LogClass(logger, declaring, logParents);
         auto* element = il2cpp_functions::class_get_element_class(klass);
-        logger.debug("element class: %p ('%s', self = %p)", element, element ? ClassStandardName(element).c_str() : "", klass);
+        BS_LOG_DEBUG(logger, "element class: %p ('%s', self = %p)", element, element ? ClassStandardName(element).c_str() : "", klass);
         if (element && element != klass && logParents) LogClass(logger, element, logParents);
 
-        logger.debug("%i =======PROPERTIES=======", indent);
+        BS_LOG_DEBUG(logger, "%i =======PROPERTIES=======", indent);
         LogProperties(logger, klass);
-        logger.debug("%i =====END PROPERTIES=====", indent);
-        logger.debug("%i =========FIELDS=========", indent);
+        BS_LOG_DEBUG(logger, "%i =====END PROPERTIES=====", indent);
+        BS_LOG_DEBUG(logger, "%i =========FIELDS=========", indent);
         LogFields(logger, klass);
-        logger.debug("%i =======END FIELDS=======", indent);
+        BS_LOG_DEBUG(logger, "%i =======END FIELDS=======", indent);
 
         auto* parent = il2cpp_functions::class_get_parent(klass);
-        logger.debug("parent: %p (%s)", parent, parent ? ClassStandardName(parent).c_str() : "");
+        BS_LOG_DEBUG(logger, "parent: %p (%s)", parent, parent ? ClassStandardName(parent).c_str() : "");
         if (parent && logParents) LogClass(logger, parent, logParents);
-        logger.debug("%i, ==================================================================================", indent);
+        BS_LOG_DEBUG(logger, "%i, ==================================================================================", indent);
         indent--;
     }
 
@@ -146,8 +146,9 @@ namespace il2cpp_utils {
     void BuildGenericsMap() {
         static auto logger = getLogger().WithContext("BuildGenericsMap");
         il2cpp_functions::Init();
-        auto* metadataReg = RET_V_UNLESS(logger, *il2cpp_functions::s_Il2CppMetadataRegistrationPtr);
-        logger.debug("metadataReg: %p, offset = %lX", metadataReg, ((uintptr_t)metadataReg) - getRealOffset(0));
+        auto* metadataRegPtr = RET_V_UNLESS(logger, il2cpp_functions::Resolve(il2cpp_functions::s_Il2CppMetadataRegistrationPtr));
+        auto* metadataReg = RET_V_UNLESS(logger, *metadataRegPtr);
+        BS_LOG_DEBUG(logger, "metadataReg: %p, offset = %lX", metadataReg, ((uintptr_t)metadataReg) - getRealOffset(0));
 
         int uncached_class_count = 0;
         for (int i=0; i < metadataReg->genericClassesCount; i++) {
@@ -163,7 +164,7 @@ namespace il2cpp_utils {
 
             classToGenericClassMap[typeDefClass][genClassName.c_str()] = genClass;
         }
-        logger.debug("uncached_class_count: %i (%f proportion of total)", uncached_class_count, uncached_class_count * 1.0 / metadataReg->genericClassesCount);
+        BS_LOG_DEBUG(logger, "uncached_class_count: %i (%f proportion of total)", uncached_class_count, uncached_class_count * 1.0 / metadataReg->genericClassesCount);
     }
 
     void LogClasses(LoggerContextObject& logger, std::string_view classPrefix, bool logParents) noexcept {
@@ -184,7 +185,7 @@ namespace il2cpp_utils {
                 logger.warning("Assembly %zu was null! Skipping.", i);
                 continue;
             }
-            logger.debug("Scanning assembly \"%s\"", assembs[i]->aname.name);
+            BS_LOG_DEBUG(logger, "Scanning assembly \"%s\"", assembs[i]->aname.name);
             auto* img = il2cpp_functions::assembly_get_image(assembs[i]);
             if (!img) {
                 logger.warning("Assembly's image was null! Skipping.");
@@ -192,7 +193,7 @@ namespace il2cpp_utils {
             }
 
             if (img->nameToClassHashTable == nullptr) {
-                logger.debug("Assembly's nameToClassHashTable is empty. Populating it instead.");
+                BS_LOG_DEBUG(logger, "Assembly's nameToClassHashTable is empty. Populating it instead.");
 
                 img->nameToClassHashTable = new Il2CppNameToTypeDefinitionIndexHashTable();
                 for (uint32_t index = 0; index < img->typeCount; index++) {
@@ -220,30 +221,56 @@ namespace il2cpp_utils {
         }
 
         usleep(1000);  // 0.001s
-        logger.debug("LogClasses:");
+        BS_LOG_DEBUG(logger, "LogClasses:");
         for ( const auto &pair : matches ) {
             LogClass(logger, pair.second, logParents);
             indent = -1;
             for ( const auto &genPair : classToGenericClassMap[pair.second] ) {
-                logger.debug("%s", genPair.first.c_str());
+                BS_LOG_DEBUG(logger, "%s", genPair.first.c_str());
             }
             usleep(1000);  // 0.001s
         }
-        logger.debug("LogClasses(\"%s\") is complete.", classPrefix.data());
-        logger.debug("maxIndent: %i", maxIndent);
+        BS_LOG_DEBUG(logger, "LogClasses(\"%s\") is complete.", classPrefix.data());
+        BS_LOG_DEBUG(logger, "maxIndent: %i", maxIndent);
     }
 
-    void AddTypeToNametoClassHashTable(const Il2CppImage* img, TypeDefinitionIndex index) {
+    static void ForEachNestedTypeName(const char* namespaze, const std::string& parentName, const Il2CppTypeDefinition* typeDefinition, const TypeNameCallback& onType) {
+        for (int i = 0; i < typeDefinition->nested_type_count; ++i) {
+            auto nestedIndex = il2cpp_functions::MetadataCache_GetNestedTypeDefinitionIndexFromIndex(typeDefinition->nestedTypesStart + i);
+            auto* nestedDefinition = il2cpp_functions::MetadataCache_GetTypeDefinitionFromIndex(nestedIndex);
+            std::string name = parentName + "/" + il2cpp_functions::MetadataCache_GetStringFromIndex(nestedDefinition->nameIndex);
+            onType(namespaze, name, nestedIndex, true);
+            ForEachNestedTypeName(namespaze, name, nestedDefinition, onType);
+        }
+    }
+
+    void ForEachTypeName(const Il2CppImage* img, TypeDefinitionIndex index, const TypeNameCallback& onType) {
         il2cpp_functions::Init();
         const Il2CppTypeDefinition* typeDefinition = il2cpp_functions::MetadataCache_GetTypeDefinitionFromIndex(index);
-        // don't add nested types
+        // don't add nested types, they are added through their declaring type
         if (typeDefinition->declaringTypeIndex != kTypeIndexInvalid)
             return;
 
+        auto* namespaze = il2cpp_functions::MetadataCache_GetStringFromIndex(typeDefinition->namespaceIndex);
+        auto* name = il2cpp_functions::MetadataCache_GetStringFromIndex(typeDefinition->nameIndex);
         if (img != il2cpp_functions::get_corlib())
-            AddNestedTypesToNametoClassHashTable(img, typeDefinition);
+            ForEachNestedTypeName(namespaze, name, typeDefinition, onType);
 
-        img->nameToClassHashTable->insert(std::make_pair(std::make_pair(il2cpp_functions::MetadataCache_GetStringFromIndex(typeDefinition->namespaceIndex), il2cpp_functions::MetadataCache_GetStringFromIndex(typeDefinition->nameIndex)), index));
+        onType(namespaze, name, index, false);
+    }
+
+    void AddTypeToNametoClassHashTable(const Il2CppImage* img, TypeDefinitionIndex index) {
+        ForEachTypeName(img, index, [img](const char* namespaze, std::string_view name, TypeDefinitionIndex typeIndex, bool nested) {
+            const char* pName = name.data();
+            if (nested) {
+                // Nested names are temporaries, so copy them somewhere that outlives the hash table
+                auto* copy = (char*)gc_alloc_specific(name.size() + 1 * sizeof(char));
+                memcpy(copy, name.data(), name.size());
+                copy[name.size()] = '\0';
+                pName = copy;
+            }
+            img->nameToClassHashTable->insert(std::make_pair(std::make_pair(namespaze, pName), typeIndex));
+        });
     }
 
     void AddNestedTypesToNametoClassHashTable(const Il2CppImage* img, const Il2CppTypeDefinition* typeDefinition) {
@@ -1,5 +1,6 @@
 #include "../../shared/utils/il2cpp-utils-fields.hpp"
 #include "../../shared/utils/hashing.hpp"
+#include "../../shared/utils/il2cpp-utils-persistent-cache.hpp"
 #include "../../shared/utils/utils.h"
 #include <unordered_map>
 #include "../../shared/utils/typedefs.h"
@@ -22,12 +23,20 @@ namespace il2cpp_utils {
             return itr->second;
         }
         nameFieldLock.unlock();
+        if (auto* persisted = PersistentCache::FindField(klass, fieldName)) {
+            nameFieldLock.lock();
+            classesNamesToFieldsCache.emplace(key, persisted);
+            nameFieldLock.unlock();
+            return persisted;
+        }
         auto field = il2cpp_functions::class_get_field_from_name(klass, fieldName.data());
         if (!field) {
             logger.error("could not find field %s in class '%s'!", fieldName.data(), ClassStandardName(klass).c_str());
-            LogFields(logger, klass);
+            static Logging::RateLimit listings;
+            if (logger.first_n(listings, 5)) LogFields(logger, klass);
             if (klass->parent != klass) field = FindField(klass->parent, fieldName);
         }
+        PersistentCache::RecordField(klass, fieldName, field);
         nameFieldLock.lock();
         classesNamesToFieldsCache.emplace(key, field);
         nameFieldLock.unlock();
@@ -52,7 +61,7 @@ namespace il2cpp_utils {
         name = name ? name : "__noname__";
         auto offset = il2cpp_functions::field_get_offset(field);
 
-        logger.debug("%s%s %s; // 0x%lx, flags: 0x%.4X", flagStr, typeStr, name, offset, flags);
+        BS_LOG_DEBUG(logger, "%s%s %s; // 0x%lx, flags: 0x%.4X", flagStr, typeStr, name, offset, flags);
     }
 
     void LogFields(LoggerContextObject& logger, Il2CppClass* klass, bool logParents) {
@@ -64,7 +73,7 @@ namespace il2cpp_utils {
         if (klass->name) il2cpp_functions::Class_Init(klass);
         if (logParents) logger.info("class name: %s", ClassStandardName(klass).c_str());
 
-        logger.debug("field_count: %i", klass->field_count);
+        BS_LOG_DEBUG(logger, "field_count: %i", klass->field_count);
         while ((field = il2cpp_functions::class_get_fields(klass, &myIter))) {
             LogField(logger, field);
         }
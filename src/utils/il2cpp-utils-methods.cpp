@@ -1,38 +1,64 @@
 #include "../../shared/utils/il2cpp-utils-methods.hpp"
 #include "../../shared/utils/hashing.hpp"
+#include "../../shared/utils/concurrent-cache.hpp"
+#include "../../shared/utils/il2cpp-utils-persistent-cache.hpp"
+#include <algorithm>
+#include <span>
 #include <sstream>
 #include "../../shared/utils/typedefs.h"
 
-namespace std {
-    // From https://www.boost.org/doc/libs/1_55_0/doc/html/hash/reference.html#boost.hash_combine
-    template<class T> void hash_combine(size_t& seed, T v) {
-        seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-    }
-
-    // Let a "sequence" type be any type that supports .size() and iteration and whose elements are hashable and support !=.
-    // Calculates a hash for a sequence.
-    template<class T> std::size_t hash_seq(T const& seq) noexcept {
-        std::size_t seed = seq.size();
-        for(auto i: seq) {
-            hash_combine(seed, i);
+namespace il2cpp_utils {
+    typedef decltype(MethodInfo::parameters_count) ParamCountType;
+    // Keys used for lookup. These only hold views, so building one never allocates.
+    struct MethodNameKeyView {
+        const Il2CppClass* klass;
+        std::string_view name;
+        ParamCountType argsCount;
+    };
+    struct MethodTypesKeyView {
+        const Il2CppClass* klass;
+        std::string_view name;
+        std::span<const Il2CppType* const> argTypes;
+    };
+    // Keys that are actually stored in the caches, only constructed on a miss.
+    struct MethodNameKey {
+        const Il2CppClass* klass;
+        std::string name;
+        ParamCountType argsCount;
+        MethodNameKey(const MethodNameKeyView& view) : klass(view.klass), name(view.name), argsCount(view.argsCount) {}
+    };
+    struct MethodTypesKey {
+        const Il2CppClass* klass;
+        std::string name;
+        std::vector<const Il2CppType*> argTypes;
+        MethodTypesKey(const MethodTypesKeyView& view) : klass(view.klass), name(view.name), argTypes(view.argTypes.begin(), view.argTypes.end()) {}
+    };
+    struct MethodKeyHash {
+        std::size_t operator()(const MethodNameKeyView& key) const noexcept {
+            std::size_t seed = std::hash<const Il2CppClass*>{}(key.klass);
+            hash_combine(seed, key.name);
+            hash_combine(seed, key.argsCount);
+            return seed;
         }
-        return seed;
-    }
-
-    // Specializes std::hash for std::vector
-    template<class T> struct hash<std::vector<T>> {
-        std::size_t operator()(std::vector<T> const& seq) const noexcept {
-            return hash_seq(seq);
+        std::size_t operator()(const MethodTypesKeyView& key) const noexcept {
+            std::size_t seed = std::hash<const Il2CppClass*>{}(key.klass);
+            hash_combine(seed, key.name);
+            hash_combine_raw(seed, hash_seq(key.argTypes));
+            return seed;
         }
     };
-}
-
-namespace il2cpp_utils {
-    static std::unordered_map<std::pair<const Il2CppClass*, std::pair<std::string, decltype(MethodInfo::parameters_count)>>, const MethodInfo*, hash_pair_3> classesNamesToMethodsCache;
-    typedef std::pair<std::string, std::vector<const Il2CppType*>> classesNamesTypesInnerPairType;
-    static std::unordered_map<std::pair<const Il2CppClass*, classesNamesTypesInnerPairType>, const MethodInfo*, hash_pair_3> classesNamesTypesToMethodsCache;
-    std::mutex classNamesMethodsLock;
-    std::mutex classTypesMethodsLock;
+    struct MethodKeyEqual {
+        bool operator()(const MethodNameKey& stored, const MethodNameKeyView& key) const noexcept {
+            return stored.klass == key.klass && stored.argsCount == key.argsCount && stored.name == key.name;
+        }
+        bool operator()(const MethodTypesKey& stored, const MethodTypesKeyView& key) const noexcept {
+            return stored.klass == key.klass && stored.name == key.name
+                && std::equal(stored.argTypes.begin(), stored.argTypes.end(), key.argTypes.begin(), key.argTypes.end());
+        }
+    };
+    // Both caches are insert-only and never take a lock, see concurrent-cache.hpp
+    static ConcurrentCache<MethodNameKey, const MethodInfo*, MethodKeyHash, MethodKeyEqual> classesNamesToMethodsCache;
+    static ConcurrentCache<MethodTypesKey, const MethodInfo*, MethodKeyHash, MethodKeyEqual, 4096> classesNamesTypesToMethodsCache;
 
     #if __has_feature(cxx_exceptions)
     const MethodInfo* MakeGenericMethod(const MethodInfo* info, std::vector<Il2CppClass*> types)
@@ -97,26 +123,24 @@ namespace il2cpp_utils {
         RET_DEFAULT_UNLESS(logger, klass);
 
         // Check Cache
-        auto innerPair = std::pair<std::string, decltype(MethodInfo::parameters_count)>(methodName, argsCount);
-        auto key = std::pair<const Il2CppClass*, decltype(innerPair)>(klass, innerPair);
-        classNamesMethodsLock.lock();
-        auto itr = classesNamesToMethodsCache.find(key);
-        if (itr != classesNamesToMethodsCache.end()) {
-            classNamesMethodsLock.unlock();
-            return itr->second;
+        MethodNameKeyView key{klass, methodName, static_cast<ParamCountType>(argsCount)};
+        if (auto* cached = classesNamesToMethodsCache.find(key)) {
+            return *cached;
+        }
+        if (auto* persisted = PersistentCache::FindMethod(klass, methodName, argsCount)) {
+            return classesNamesToMethodsCache.emplace(key, persisted);
         }
-        classNamesMethodsLock.unlock();
         // Recurses through klass's parents
         auto methodInfo = il2cpp_functions::class_get_method_from_name(klass, methodName.data(), argsCount);
         if (!methodInfo) {
             logger.error("could not find method %s with %i parameters in class '%s'!", methodName.data(), argsCount, ClassStandardName(klass).c_str());
-            LogMethods(logger, const_cast<Il2CppClass*>(klass), true);
+            // Listing every method of the class and its parents is slow, so only the first few misses do it
+            static Logging::RateLimit listings;
+            if (logger.first_n(listings, 5)) LogMethods(logger, const_cast<Il2CppClass*>(klass), true);
             RET_DEFAULT_UNLESS(logger, methodInfo);
         }
-        classNamesMethodsLock.lock();
-        classesNamesToMethodsCache.emplace(key, methodInfo);
-        classNamesMethodsLock.unlock();
-        return methodInfo;
+        PersistentCache::RecordMethod(klass, methodName, argsCount, methodInfo);
+        return classesNamesToMethodsCache.emplace(key, methodInfo);
     }
 
     #if __has_feature(cxx_exceptions)
@@ -153,15 +177,16 @@ namespace il2cpp_utils {
 
         // TODO: make cache work for generics (stratify by generics count?) and differing return types?
         // Check Cache
-        auto innerPair = classesNamesTypesInnerPairType(info.name, info.argTypes);
-        auto key = std::pair<Il2CppClass*, classesNamesTypesInnerPairType>(klass, innerPair);
-        classTypesMethodsLock.lock();
-        auto itr = classesNamesTypesToMethodsCache.find(key);
-        if (itr != classesNamesTypesToMethodsCache.end()) {
-            classTypesMethodsLock.unlock();
-            return itr->second;
+        MethodTypesKeyView key{klass, info.name, info.argTypes};
+        if (auto* cached = classesNamesTypesToMethodsCache.find(key)) {
+            return *cached;
+        }
+        // Persisted results only describe the basic match, which is all that is returned without generics or a return type
+        if (info.genTypes.empty() && !info.returnType) {
+            if (auto* persisted = PersistentCache::FindMethod(klass, info.name, info.argTypes)) {
+                return classesNamesTypesToMethodsCache.emplace(key, persisted);
+            }
         }
-        classTypesMethodsLock.unlock();
 
         void* myIter = nullptr;
         const MethodInfo* methodInfo = nullptr;  // basic match
@@ -184,7 +209,7 @@ namespace il2cpp_utils {
                     }
                     if (il2cpp_functions::class_is_assignable_from(info.returnType, returnClass)) {
                         if (returnMatch) {
-                            logger.debug("Multiple return type matches.");
+                            BS_LOG_DEBUG(logger, "Multiple return type matches.");
                             multipleReturnMatches = true;
                         }
                         else returnMatch = current;
@@ -219,13 +244,13 @@ namespace il2cpp_utils {
             }
             ss << ") in class '" << ClassStandardName(klass) << "'!";
             logger.error("%s", ss.str().c_str());
-            LogMethods(logger, klass);
+            // As in FindMethodUnsafe, only the first few misses list the class's methods
+            static Logging::RateLimit listings;
+            if (logger.first_n(listings, 5)) LogMethods(logger, klass);
             RET_DEFAULT_UNLESS(logger, !methodInfo || multipleBasicMatches);
         }
-        classTypesMethodsLock.lock();
-        classesNamesTypesToMethodsCache.emplace(key, methodInfo);
-        classTypesMethodsLock.unlock();
-        return methodInfo;
+        if (info.genTypes.empty()) PersistentCache::RecordMethod(klass, info.name, info.argTypes, methodInfo);
+        return classesNamesTypesToMethodsCache.emplace(key, methodInfo);
     }
 
     void LogMethods(LoggerContextObject& logger, Il2CppClass* klass, bool logParents) {
@@ -241,10 +266,10 @@ namespace il2cpp_utils {
         }
         if (logParents) logger.info("class name: %s", ClassStandardName(klass).c_str());
 
-        logger.debug("method_count: %i", klass->method_count);
+        BS_LOG_DEBUG(logger, "method_count: %i", klass->method_count);
         for (int i = 0; i < klass->method_count; i++) {
             if (klass->methods[i]) {
-                logger.debug("Method %i:", i);
+                BS_LOG_DEBUG(logger, "Method %i:", i);
                 LogMethod(logger, klass->methods[i]);
             } else {
                 logger.warning("Method: %i Does not exist!", i);
@@ -285,7 +310,7 @@ namespace il2cpp_utils {
         const auto& paramStrRef = paramStream.str();
         const char* paramStr = paramStrRef.c_str();
         // TODO: add <T> after methodName
-        logger.debug("%s%s %s(%s);", flagStr, retTypeStr, methodName, paramStr);
+        BS_LOG_DEBUG(logger, "%s%s %s(%s);", flagStr, retTypeStr, methodName, paramStr);
     }
 
     bool IsConvertible(const Il2CppType* to, const Il2CppType* from, bool asArgs) {
@@ -295,7 +320,7 @@ namespace il2cpp_utils {
         if (asArgs) {
             if (to->byref) {
                 if (!from->byref) {
-                    logger.debug("to (%s, %p) is ref/out while from (%s, %p) is not. Not convertible.",
+                    BS_LOG_DEBUG(logger, "to (%s, %p) is ref/out while from (%s, %p) is not. Not convertible.",
                         TypeGetSimpleName(to), to, TypeGetSimpleName(from), from);
                     return false;
                 }
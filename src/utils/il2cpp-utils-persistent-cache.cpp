@@ -0,0 +1,323 @@
+#include "../../shared/utils/il2cpp-utils-persistent-cache.hpp"
+#include "../../shared/utils/il2cpp-utils.hpp"
+#include "../../shared/utils/resolution-cache.hpp"
+#include "../../shared/config/config-utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <link.h>
+
+namespace il2cpp_utils {
+    namespace {
+        // Bump this whenever the meaning of keys or values changes, so old caches are ignored
+        constexpr uint64_t keySchemeVersion = 1;
+
+        enum class Kind : uint8_t {
+            Class = 1,
+            MethodTypes,
+            MethodCount,
+            Field,
+            Property
+        };
+
+        ResolutionCacheFile cacheFile;
+        std::atomic_bool enabled = false;
+        std::once_flag enableFlag;
+
+        struct BuildIdSearch {
+            uint64_t hash;
+            bool found;
+        };
+
+        int findBuildId(dl_phdr_info* info, size_t, void* data) {
+            if (!info->dlpi_name || !std::string_view(info->dlpi_name).ends_with("libil2cpp.so")) return 0;
+            auto* search = static_cast<BuildIdSearch*>(data);
+            for (int i = 0; i < info->dlpi_phnum; i++) {
+                auto& phdr = info->dlpi_phdr[i];
+                if (phdr.p_type != PT_NOTE) continue;
+                auto* note = reinterpret_cast<const char*>(info->dlpi_addr + phdr.p_vaddr);
+                auto* end = note + phdr.p_memsz;
+                while (note + sizeof(ElfW(Nhdr)) <= end) {
+                    auto* nhdr = reinterpret_cast<const ElfW(Nhdr)*>(note);
+                    auto* name = note + sizeof(ElfW(Nhdr));
+                    auto* desc = name + ((nhdr->n_namesz + 3) & ~3);
+                    if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 && std::memcmp(name, "GNU", 4) == 0) {
+                        search->hash = ResolutionCacheFile::HashBytes(desc, nhdr->n_descsz, search->hash);
+                        search->found = true;
+                        return 1;
+                    }
+                    note = desc + ((nhdr->n_descsz + 3) & ~3);
+                }
+            }
+            return 1;
+        }
+
+        // Identifies this exact libil2cpp.so and global-metadata.dat without reading either file in full.
+        uint64_t computeFingerprint() {
+            static auto logger = getLogger().WithContext("PersistentCache");
+            BuildIdSearch search{ResolutionCacheFile::HashValue(keySchemeVersion), false};
+            dl_iterate_phdr(findBuildId, &search);
+            if (!search.found) {
+                logger.warning("libil2cpp.so has no build id, falling back to its size");
+                search.hash = ResolutionCacheFile::HashValue(static_cast<uint64_t>(getLibil2cppSize()), search.hash);
+            }
+            il2cpp_functions::CheckS_GlobalMetadata();
+            auto* header = il2cpp_functions::s_GlobalMetadataHeader;
+            // The header holds the offset and size of every metadata table, so nearly any change to the metadata changes it.
+            auto hash = ResolutionCacheFile::HashBytes(header, sizeof(Il2CppGlobalMetadataHeader), search.hash);
+            auto* typeDefinitions = static_cast<const char*>(il2cpp_functions::s_GlobalMetadata) + header->typeDefinitionsOffset;
+            auto sampleSize = std::min<std::size_t>(header->typeDefinitionsCount, 64 * 1024);
+            return ResolutionCacheFile::HashBytes(typeDefinitions, sampleSize, hash);
+        }
+
+        void flushAtExit() {
+            cacheFile.Flush();
+        }
+
+        std::size_t typeDefinitionCount() {
+            il2cpp_functions::CheckS_GlobalMetadata();
+            return il2cpp_functions::s_GlobalMetadataHeader->typeDefinitionsCount / sizeof(Il2CppTypeDefinition);
+        }
+
+        // Only classes with a type definition of their own (so no generic instances, arrays or pointers) have a stable index.
+        bool typeIndexOf(const Il2CppClass* klass, TypeDefinitionIndex& index) {
+            if (!klass || klass->generic_class || !klass->typeDefinition) return false;
+            index = il2cpp_functions::MetadataCache_GetIndexForTypeDefinition(klass);
+            return index != kTypeDefinitionIndexInvalid;
+        }
+
+        Il2CppClass* classAt(uint32_t index) {
+            if (index >= typeDefinitionCount()) return nullptr;
+            return il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex(static_cast<TypeDefinitionIndex>(index));
+        }
+
+        // Hashes everything about type that matters for overload resolution, using only indices that are stable across launches.
+        bool hashType(const Il2CppType* type, uint64_t& seed) {
+            if (!type) return false;
+            seed = ResolutionCacheFile::HashValue(static_cast<uint8_t>(type->type), seed);
+            seed = ResolutionCacheFile::HashValue(static_cast<uint8_t>(type->byref), seed);
+            switch (type->type) {
+                case IL2CPP_TYPE_CLASS:
+                case IL2CPP_TYPE_VALUETYPE:
+                    seed = ResolutionCacheFile::HashValue(type->data.klassIndex, seed);
+                    return true;
+                case IL2CPP_TYPE_PTR:
+                case IL2CPP_TYPE_SZARRAY:
+                    return hashType(type->data.type, seed);
+                case IL2CPP_TYPE_ARRAY:
+                    seed = ResolutionCacheFile::HashValue(type->data.array->rank, seed);
+                    return hashType(type->data.array->etype, seed);
+                case IL2CPP_TYPE_VAR:
+                case IL2CPP_TYPE_MVAR:
+                    seed = ResolutionCacheFile::HashValue(type->data.genericParameterIndex, seed);
+                    return true;
+                case IL2CPP_TYPE_GENERICINST: {
+                    auto* genClass = type->data.generic_class;
+                    auto* genInst = genClass->context.class_inst;
+                    if (!genInst) return false;
+                    seed = ResolutionCacheFile::HashValue(genClass->typeDefinitionIndex, seed);
+                    seed = ResolutionCacheFile::HashValue(genInst->type_argc, seed);
+                    for (uint32_t i = 0; i < genInst->type_argc; i++) {
+                        if (!hashType(genInst->type_argv[i], seed)) return false;
+                    }
+                    return true;
+                }
+                default:
+                    // Everything else is fully described by its type enum
+                    return true;
+            }
+        }
+
+        std::optional<uint64_t> memberKey(Kind kind, const Il2CppClass* klass, std::string_view name) {
+            TypeDefinitionIndex owner;
+            if (!typeIndexOf(klass, owner)) return std::nullopt;
+            auto seed = ResolutionCacheFile::HashValue(kind);
+            seed = ResolutionCacheFile::HashValue(owner, seed);
+            return ResolutionCacheFile::HashString(name, seed);
+        }
+
+        std::optional<uint64_t> methodKey(const Il2CppClass* klass, std::string_view name, std::span<const Il2CppType* const> argTypes) {
+            auto key = memberKey(Kind::MethodTypes, klass, name);
+            if (!key) return std::nullopt;
+            auto seed = ResolutionCacheFile::HashValue(static_cast<uint64_t>(argTypes.size()), *key);
+            for (auto* type : argTypes) {
+                if (!hashType(type, seed)) return std::nullopt;
+            }
+            return seed;
+        }
+
+        std::optional<uint64_t> methodKey(const Il2CppClass* klass, std::string_view name, int argsCount) {
+            auto key = memberKey(Kind::MethodCount, klass, name);
+            if (!key) return std::nullopt;
+            return ResolutionCacheFile::HashValue(argsCount, *key);
+        }
+
+        // Returns the initialized declaring class of a cached member, as long as it is klass or one of its parents.
+        Il2CppClass* declaringClassOf(const Il2CppClass* klass, const ResolutionCacheFile::Value& value) {
+            auto* declaring = classAt(value.typeIndex);
+            if (!declaring) return nullptr;
+            for (auto* current = klass; current; current = (current->parent != current) ? current->parent : nullptr) {
+                if (current == declaring) {
+                    il2cpp_functions::Class_Init(declaring);
+                    return declaring;
+                }
+            }
+            return nullptr;
+        }
+
+        void record(std::optional<uint64_t> key, const Il2CppClass* declaring, uint32_t memberIndex) {
+            TypeDefinitionIndex index;
+            if (!key || !typeIndexOf(declaring, index)) return;
+            cacheFile.Record(*key, {static_cast<uint32_t>(index), memberIndex});
+        }
+
+        std::optional<uint32_t> methodIndexOf(const MethodInfo* method) {
+            auto* declaring = method->klass;
+            for (uint16_t i = 0; i < declaring->method_count; i++) {
+                if (declaring->methods[i] == method) return i;
+            }
+            return std::nullopt;
+        }
+
+        const MethodInfo* methodAt(const Il2CppClass* klass, std::string_view name, const ResolutionCacheFile::Value& value) {
+            auto* declaring = declaringClassOf(klass, value);
+            if (!declaring || !declaring->methods || value.memberIndex >= declaring->method_count) return nullptr;
+            auto* method = declaring->methods[value.memberIndex];
+            if (!method || name != method->name) return nullptr;
+            return method;
+        }
+    }
+
+    void PersistentCache::Enable() noexcept {
+        std::call_once(enableFlag, []() {
+            static auto logger = getLogger().WithContext("PersistentCache");
+            il2cpp_functions::Init();
+            auto dir = getDataDir(ID);
+            if (!direxists(dir)) {
+                mkpath(dir);
+            }
+            auto path = dir + "resolution-cache.bin";
+            if (cacheFile.Open(path, computeFingerprint())) {
+                logger.info("Loaded %zu cached resolutions from %s", cacheFile.MappedCount(), path.c_str());
+            } else {
+                logger.info("No valid resolution cache at %s, it will be created on the next flush", path.c_str());
+            }
+            std::atexit(flushAtExit);
+            enabled.store(true, std::memory_order_release);
+        });
+    }
+
+    bool PersistentCache::IsEnabled() noexcept {
+        return enabled.load(std::memory_order_acquire);
+    }
+
+    bool PersistentCache::Flush() noexcept {
+        if (!IsEnabled()) return true;
+        static auto logger = getLogger().WithContext("PersistentCache");
+        auto pending = cacheFile.PendingCount();
+        if (!cacheFile.Flush()) {
+            logger.error("Failed to write %zu new resolutions!", pending);
+            return false;
+        }
+        if (pending) BS_LOG_DEBUG(logger, "Wrote %zu new resolutions", pending);
+        return true;
+    }
+
+    static uint64_t classKey(std::string_view namespaze, std::string_view name) {
+        auto seed = ResolutionCacheFile::HashValue(Kind::Class);
+        seed = ResolutionCacheFile::HashString(namespaze, seed);
+        return ResolutionCacheFile::HashString(name, seed);
+    }
+
+    Il2CppClass* PersistentCache::FindClass(std::string_view namespaze, std::string_view name) noexcept {
+        if (!IsEnabled()) return nullptr;
+        auto value = cacheFile.Find(classKey(namespaze, name));
+        if (!value) return nullptr;
+        auto* klass = classAt(value->typeIndex);
+        if (!klass || !klass->name) return nullptr;
+        // Nested types are looked up as "Declaring/Nested", but are named just "Nested"
+        auto slash = name.rfind('/');
+        if (slash != std::string_view::npos) {
+            return name.substr(slash + 1) == klass->name ? klass : nullptr;
+        }
+        return (name == klass->name && namespaze == klass->namespaze) ? klass : nullptr;
+    }
+
+    void PersistentCache::RecordClass(std::string_view namespaze, std::string_view name, Il2CppClass* klass) noexcept {
+        if (!IsEnabled()) return;
+        record(classKey(namespaze, name), klass, 0);
+    }
+
+    const MethodInfo* PersistentCache::FindMethod(const Il2CppClass* klass, std::string_view name, std::span<const Il2CppType* const> argTypes) noexcept {
+        if (!IsEnabled()) return nullptr;
+        auto key = methodKey(klass, name, argTypes);
+        if (!key) return nullptr;
+        auto value = cacheFile.Find(*key);
+        if (!value) return nullptr;
+        auto* method = methodAt(klass, name, *value);
+        if (!method || !ParameterMatch(method, argTypes)) return nullptr;
+        return method;
+    }
+
+    void PersistentCache::RecordMethod(const Il2CppClass* klass, std::string_view name, std::span<const Il2CppType* const> argTypes, const MethodInfo* method) noexcept {
+        if (!IsEnabled() || !method) return;
+        if (auto index = methodIndexOf(method)) {
+            record(methodKey(klass, name, argTypes), method->klass, *index);
+        }
+    }
+
+    const MethodInfo* PersistentCache::FindMethod(const Il2CppClass* klass, std::string_view name, int argsCount) noexcept {
+        if (!IsEnabled()) return nullptr;
+        auto key = methodKey(klass, name, argsCount);
+        if (!key) return nullptr;
+        auto value = cacheFile.Find(*key);
+        if (!value) return nullptr;
+        auto* method = methodAt(klass, name, *value);
+        if (!method || (argsCount >= 0 && method->parameters_count != argsCount)) return nullptr;
+        return method;
+    }
+
+    void PersistentCache::RecordMethod(const Il2CppClass* klass, std::string_view name, int argsCount, const MethodInfo* method) noexcept {
+        if (!IsEnabled() || !method) return;
+        if (auto index = methodIndexOf(method)) {
+            record(methodKey(klass, name, argsCount), method->klass, *index);
+        }
+    }
+
+    FieldInfo* PersistentCache::FindField(const Il2CppClass* klass, std::string_view name) noexcept {
+        if (!IsEnabled()) return nullptr;
+        auto key = memberKey(Kind::Field, klass, name);
+        if (!key) return nullptr;
+        auto value = cacheFile.Find(*key);
+        if (!value) return nullptr;
+        auto* declaring = declaringClassOf(klass, *value);
+        if (!declaring || !declaring->fields || value->memberIndex >= declaring->field_count) return nullptr;
+        auto* field = declaring->fields + value->memberIndex;
+        return (field->name && name == field->name) ? field : nullptr;
+    }
+
+    void PersistentCache::RecordField(const Il2CppClass* klass, std::string_view name, const FieldInfo* field) noexcept {
+        if (!IsEnabled() || !field) return;
+        record(memberKey(Kind::Field, klass, name), field->parent, static_cast<uint32_t>(field - field->parent->fields));
+    }
+
+    const PropertyInfo* PersistentCache::FindProperty(const Il2CppClass* klass, std::string_view name) noexcept {
+        if (!IsEnabled()) return nullptr;
+        auto key = memberKey(Kind::Property, klass, name);
+        if (!key) return nullptr;
+        auto value = cacheFile.Find(*key);
+        if (!value) return nullptr;
+        auto* declaring = declaringClassOf(klass, *value);
+        if (!declaring || !declaring->properties || value->memberIndex >= declaring->property_count) return nullptr;
+        auto* prop = declaring->properties + value->memberIndex;
+        return (prop->name && name == prop->name) ? prop : nullptr;
+    }
+
+    void PersistentCache::RecordProperty(const Il2CppClass* klass, std::string_view name, const PropertyInfo* prop) noexcept {
+        if (!IsEnabled() || !prop) return;
+        record(memberKey(Kind::Property, klass, name), prop->parent, static_cast<uint32_t>(prop - prop->parent->properties));
+    }
+}
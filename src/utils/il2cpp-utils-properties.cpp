@@ -2,6 +2,7 @@
 #include "../../shared/utils/utils.h"
 #include <unordered_map>
 #include "../../shared/utils/hashing.hpp"
+#include "../../shared/utils/il2cpp-utils-persistent-cache.hpp"
 #include "../../shared/utils/typedefs.h"
 
 namespace il2cpp_utils {
@@ -22,12 +23,20 @@ namespace il2cpp_utils {
             return itr->second;
         }
         classPropertiesLock.unlock();
+        if (auto* persisted = PersistentCache::FindProperty(klass, propName)) {
+            classPropertiesLock.lock();
+            classesNamesToPropertiesCache.emplace(key, persisted);
+            classPropertiesLock.unlock();
+            return persisted;
+        }
         auto prop = il2cpp_functions::class_get_property_from_name(klass, propName.data());
         if (!prop) {
             logger.error("could not find property %s in class '%s'!", propName.data(), ClassStandardName(klass).c_str());
-            LogProperties(logger, klass);
+            static Logging::RateLimit listings;
+            if (logger.first_n(listings, 5)) LogProperties(logger, klass);
             if (klass->parent != klass) prop = FindProperty(klass->parent, propName);
         }
+        PersistentCache::RecordProperty(klass, propName, prop);
         classPropertiesLock.lock();
         classesNamesToPropertiesCache.emplace(key, prop);
         classPropertiesLock.unlock();
@@ -58,7 +67,7 @@ namespace il2cpp_utils {
         }
         auto typeStr = type ? TypeGetSimpleName(type) : "?type?";
 
-        logger.debug("%s%s %s { %s; %s; }; // flags: 0x%.4X", flagStr, typeStr, name, getterName, setterName, flags);
+        BS_LOG_DEBUG(logger, "%s%s %s { %s; %s; }; // flags: 0x%.4X", flagStr, typeStr, name, getterName, setterName, flags);
     }
 
     void LogProperties(LoggerContextObject& logger, Il2CppClass* klass, bool logParents) {
@@ -70,7 +79,7 @@ namespace il2cpp_utils {
         if (klass->name) il2cpp_functions::Class_Init(klass);
         if (logParents) logger.info("class name: %s", ClassStandardName(klass).c_str());
 
-        logger.debug("property_count: %i", klass->property_count);
+        BS_LOG_DEBUG(logger, "property_count: %i", klass->property_count);
         while ((prop = il2cpp_functions::class_get_properties(klass, &myIter))) {
             LogProperty(logger, prop);
         }
@@ -9,6 +9,7 @@
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
+#include <span>
 #include <sstream>
 
 // Please see comments in il2cpp-utils.hpp
@@ -35,7 +36,7 @@ namespace il2cpp_utils {
         return il2cpp_functions::class_get_type(il2cpp_functions::class_from_il2cpp_type(type));
     }
 
-    bool ParameterMatch(const MethodInfo* method, std::vector<Il2CppClass*> genTypes, std::vector<const Il2CppType*> argTypes) {
+    bool ParameterMatch(const MethodInfo* method, std::span<Il2CppClass* const> genTypes, std::span<const Il2CppType* const> argTypes) {
         static auto logger = getLogger().WithContext("ParameterMatch");
         il2cpp_functions::Init();
         if (method->parameters_count != argTypes.size()) {
@@ -58,19 +59,19 @@ namespace il2cpp_utils {
                     logger.warning("ParameterMatch was not supplied enough genTypes to determine type of parameter %i "
                         "(had %i, needed %i)!", i, genCount, genIdx);
                 } else {
-                    auto* klass = genTypes.at(genIdx);
+                    auto* klass = genTypes[genIdx];
                     paramType = (paramType->byref) ? &klass->this_arg : &klass->byval_arg;
                 }
             }
             // TODO: just because two parameter lists match doesn't necessarily mean this is the best match...
-            if (!(IsConvertible(paramType, argTypes.at(i)))) {
+            if (!(IsConvertible(paramType, argTypes[i]))) {
                 return false;
             }
         }
         return true;
     }
 
-    bool ParameterMatch(const MethodInfo* method, std::vector<const Il2CppType*> argTypes) {
+    bool ParameterMatch(const MethodInfo* method, std::span<const Il2CppType* const> argTypes) {
         return ParameterMatch(method, {}, argTypes);
     }
 
@@ -1,8 +1,11 @@
 ﻿#include "../../shared/utils/instruction-parsing.hpp"
+#include "../../shared/utils/module-map.hpp"
 #include "../../shared/utils/utils.h"
 #include <functional>
-#include <new>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <unordered_set>
 #include "../../shared/utils/logging.hpp"
 
 static const char* unalloc = "UNALLOCATED";
@@ -45,21 +48,18 @@ decltype(Instruction::result) ExtractAddress(Instruction* instWithResultAdr, Ins
     auto offset = *(instWithImmOffset->imm);
 
     auto jmp = jmpOff + offset;
-    logger.debug("offset: %lX, jmp: %lX (offset %lX)", offset, jmp, asOffset(jmp));
+    BS_LOG_DEBUG(logger, "offset: %lX, jmp: %lX (offset %lX)", offset, jmp, asOffset(jmp));
     return jmp;
 }
 
 decltype(Instruction::result) ExtractAddress(const int32_t* addr, int pcRelN, int offsetN) {
     static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("ExtractAddress");
-    Instruction funcInst(addr);
-    auto instAdrp = funcInst.findNthPcRelAdr(pcRelN);
-    RET_0_UNLESS(logger, instAdrp);
-    auto instOff = instAdrp->findNthImmOffsetOnReg(offsetN, instAdrp->Rd);
-    RET_0_UNLESS(logger, instOff);
-    logger.debug("adrp idx: %lu, offset instruction idx: %lu", instAdrp->addr - funcInst.addr, instOff->addr - funcInst.addr);
-    logger.debug("instAdrp: %s", instAdrp->toString().c_str());
-    logger.debug("instOff:  %s", instOff->toString().c_str());
-    return ExtractAddress(instAdrp, instOff);
+    auto instAdrp = RET_0_UNLESS(logger, InstructionRange(addr).findNthPcRelAdr(pcRelN));
+    auto instOff = RET_0_UNLESS(logger, InstructionRange(instAdrp).findNthImmOffsetOnReg(offsetN, instAdrp.Rd));
+    BS_LOG_DEBUG(logger, "adrp idx: %lu, offset instruction idx: %lu", instAdrp.addr - addr, instOff.addr - addr);
+    BS_LOG_DEBUG(logger, "instAdrp: %s", instAdrp.toString().c_str());
+    BS_LOG_DEBUG(logger, "instOff:  %s", instOff.toString().c_str());
+    return ExtractAddress(&instAdrp, &instOff);
 }
 
 decltype(Instruction::result) ExtractAddressFixed(const int32_t* inst, int idxOfInstWithResultAdr, int idxOfInstWithImmOffset) {
@@ -68,13 +68,18 @@ decltype(Instruction::result) ExtractAddressFixed(const int32_t* inst, int idxOf
     return ExtractAddress(&instWithResultAdr, &instWithImmOffset);
 }
 
-Instruction* EvalSwitch(const uint32_t* switchTable, int switchCaseValue) {
+// Where the switchTable entry for the given case: value jumps to, which is the same number of bytes on from the table
+static const int32_t* switchTarget(const uint32_t* switchTable, int switchCaseValue) {
     static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("EvalSwitch");
     auto stOffset = SignExtend<int64_t>(switchTable[switchCaseValue - 1], 32);
     auto jmpAddr = (int64_t)switchTable + stOffset;
-    logger.debug("jmp offset from switch table: %lX (-%lX); jmp: %lX (offset %lX)",
+    BS_LOG_DEBUG(logger, "jmp offset from switch table: %lX (-%lX); jmp: %lX (offset %lX)",
         stOffset, -stOffset, jmpAddr, asOffset(jmpAddr));
-    return new Instruction((const int32_t*)jmpAddr);
+    return (const int32_t*)jmpAddr;
+}
+
+Instruction* EvalSwitch(const uint32_t* switchTable, int switchCaseValue) {
+    return new Instruction(switchTarget(switchTable, switchCaseValue));
 }
 
 Instruction* EvalSwitch(const int32_t* inst, int pcRelN, int offsetN, int switchCaseValue) {
@@ -183,27 +188,81 @@ bool Instruction::hasImmOffsetOnReg(uint_fast8_t reg) {
     return false;
 }
 
+// Instruction's pointer API over InstructionRange's: this if it is the match, and otherwise a new Instruction
+static Instruction* foundAt(Instruction* start, std::optional<Instruction>&& found) {
+    if (!found) return nullptr;
+    if (found->addr == start->addr) return start;
+    return new Instruction(*found);
+}
+
 Instruction* Instruction::findNthCall(int n, int rets) {
-    return this->findNth(n, std::mem_fn(&Instruction::isCall), rets);
+    return foundAt(this, InstructionRange(*this).findNthCall(n, rets));
 }
 
 Instruction* Instruction::findNthDirectBranchWithoutLink(int n, int rets) {
-    return this->findNth(n, [](Instruction* inst){return inst->branchType == DIR;}, rets);
+    return foundAt(this, InstructionRange(*this).findNthDirectBranchWithoutLink(n, rets));
 }
 
 Instruction* Instruction::findNthPcRelAdr(int n, int rets) {
-    return this->findNth(n, std::mem_fn(&Instruction::isPcRelAdr), rets);
+    return foundAt(this, InstructionRange(*this).findNthPcRelAdr(n, rets));
 }
 
 Instruction* Instruction::findNthImmOffsetOnReg(int n, uint_fast8_t reg, int rets) {
-    return this->findNth(n, [reg](Instruction* inst){return inst->hasImmOffsetOnReg(reg);}, rets);
+    return foundAt(this, InstructionRange(*this).findNthImmOffsetOnReg(n, reg, rets));
+}
+
+std::optional<Instruction> InstructionRange::findNthCall(int n, int rets) const {
+    return findNthEncoded(n, std::mem_fn(&EncodedInstruction::isCall), rets);
+}
+
+std::optional<Instruction> InstructionRange::findNthDirectBranchWithoutLink(int n, int rets) const {
+    return findNthEncoded(n, std::mem_fn(&EncodedInstruction::isDirectBranchWithoutLink), rets);
+}
+
+std::optional<Instruction> InstructionRange::findNthPcRelAdr(int n, int rets) const {
+    return findNthEncoded(n, std::mem_fn(&EncodedInstruction::isPcRelAdr), rets);
 }
 
-Instruction::Instruction(const int32_t* inst) {
+std::optional<Instruction> InstructionRange::findNthImmOffsetOnReg(int n, uint_fast8_t reg, int rets) const {
+    // Only the instructions that could have an immediate offset are worth decoding
+    return findNthEncoded(n, [this, reg](const EncodedInstruction& inst) {
+        return inst.mayHaveImmOffset() && Instruction(inst.addr, base).hasImmOffsetOnReg(reg);
+    }, rets);
+}
+
+std::optional<const int32_t*> EncodedInstruction::label() const noexcept {
+    auto pc = reinterpret_cast<intptr_t>(addr);
+    // The signed offset in instructions in bits high through low, in bytes
+    auto offset = [this](int high, int low) {
+        return SignExtend<int64_t>(static_cast<uint64_t>(code >> low) & ONES(high - low + 1), high - low + 1) << 2;
+    };
+    switch (opcode) {
+        case Opcode::B:
+        case Opcode::BL:
+            return reinterpret_cast<const int32_t*>(pc + offset(25, 0));
+        case Opcode::B_COND:
+        case Opcode::CB:
+            return reinterpret_cast<const int32_t*>(pc + offset(23, 5));
+        case Opcode::TB:
+            return reinterpret_cast<const int32_t*>(pc + offset(18, 5));
+        case Opcode::ADR:
+        case Opcode::ADRP: {
+            // immhi:immlo, in bytes for ADR and in pages for ADRP
+            auto imm = SignExtend<int64_t>((static_cast<uint64_t>(code >> 5) & ONES(19)) << 2 | ((code >> 29) & 0b11), 21);
+            if (opcode == Opcode::ADR) return reinterpret_cast<const int32_t*>(pc + imm);
+            return reinterpret_cast<const int32_t*>((pc & ~intptr_t(0xFFF)) + (imm << 12));
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+Instruction::Instruction(const int32_t* inst) : Instruction(inst, getBase((uintptr_t)inst)) {}
+
+Instruction::Instruction(const int32_t* inst, uintptr_t base) {
     static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("Instruction");
     addr = inst;
     auto pc = (uintptr_t)inst;
-    auto base = getBase(pc);
     if (!base) {
         logger.critical("Instruction::Instruction: Could not get the .so base for pointer %p. "
             "It is likely not a valid pointer at all!", inst);
@@ -215,7 +274,7 @@ Instruction::Instruction(const int32_t* inst) {
     auto code = *inst;
     // https://developer.arm.com/docs/ddi0596/a/top-level-encodings-for-a64#top
     uint_fast8_t top0 = bits(code, 28, 25);  // op0 for top-level only
-    logger.debug("inst: ptr = 0x%lX (offset 0x%lX), bytes = %s (%X), top-level op0: %i",
+    BS_LOG_DEBUG(logger, "inst: ptr = 0x%lX (offset 0x%lX), bytes = %s (%X), top-level op0: %i",
         pc, pc - base, std::bitset<32>(code).to_string().c_str(), code, top0);
     // Bit patterns like 1x0x where x is any bit and all other bits must match are implemented by:
     // 1. (a & [1's where pattern has non-x]) == [pattern with x's as 0]
@@ -321,7 +380,7 @@ Instruction::Instruction(const int32_t* inst) {
                             }
                         }
                     }
-                    // logger.debug("op1 = 0, op0: %i, op2: %i (1xxx), op3: %i", op0, op2, op3);
+                    // BS_LOG_DEBUG(logger, "op1 = 0, op0: %i, op2: %i (1xxx), op3: %i", op0, op2, op3);
                 } else {
                     // https://developer.arm.com/docs/ddi0596/a/top-level-encodings-for-a64/data-processing-register#addsub_ext
                     kind[parseLevel++] = "Add/subtract (extended register)";
@@ -482,7 +541,7 @@ Instruction::Instruction(const int32_t* inst) {
                     }
                 }
             } else {
-                logger.debug("op1 = 1, op0: %i, op2: %i (0xxx), op3: %i", op0, op2, op3);
+                BS_LOG_DEBUG(logger, "op1 = 1, op0: %i, op2: %i (0xxx), op3: %i", op0, op2, op3);
             }
         }
     } else if ((top0 & 0b111) == 0b111) {  // x111
@@ -504,7 +563,7 @@ Instruction::Instruction(const int32_t* inst) {
             const uint_fast8_t ilh = 30, ill = 29, ihh = 23, ihl = 5;
             uint_fast8_t immlo = bits(code, ilh, ill);
             auto immhi = bits(code, ihh, ihl);
-            logger.debug("immhi: 0x%X (%i), immlo: 0x%X (%i)", immhi, immhi, immlo, immlo);
+            BS_LOG_DEBUG(logger, "immhi: 0x%X (%i), immlo: 0x%X (%i)", immhi, immhi, immlo, immlo);
             auto immI = (immhi << (ilh - ill + 1)) + immlo;
             uint_fast8_t immINumBits = ihh - ihl + 1 + ilh - ill + 1;
             if (op == 0b1) {
@@ -516,12 +575,12 @@ Instruction::Instruction(const int32_t* inst) {
             } else {
                 kind[parseLevel++] = "ADR";
             }
-            // logger.debug("imm initial: 0x%X (%i); immNumBits: %i", immI, immI, immINumBits);
+            // BS_LOG_DEBUG(logger, "imm initial: 0x%X (%i); immNumBits: %i", immI, immI, immINumBits);
             // the documentation calls this imm, but it's not exposed in the instruction string
             auto privateImm = SignExtend<int64_t>(immI, immINumBits);
             result = pc + privateImm;
             label = (decltype(label)::value_type) result;
-            // logger.debug("imm: 0x%lX; result: 0x%lX (offset 0x%lX)", privateImm, result, result - base);
+            // BS_LOG_DEBUG(logger, "imm: 0x%lX; result: 0x%lX (offset 0x%lX)", privateImm, result, result - base);
         } else if (op0 == 0b1) {
             numSourceRegisters = 1;
             Rs0CanBeSP = true;
@@ -585,9 +644,9 @@ Instruction::Instruction(const int32_t* inst) {
             bool logical = (op0 == 0b10);
             auto masks = DecodeBitMasks(N, imms, immr, sf ? 64 : 32, logical);
             if (masks) {
-                // logger.debug("N: %i, immr: 0x%X (%u), imms: 0x%X, wmask: 0x%lX, tmask: 0x%lX", N, immr, immr, imms, masks->first, masks->second);
+                // BS_LOG_DEBUG(logger, "N: %i, immr: 0x%X (%u), imms: 0x%X, wmask: 0x%lX, tmask: 0x%lX", N, immr, immr, imms, masks->first, masks->second);
             } else {
-                // logger.debug("N: %i, immr: 0x%X (%u), imms: 0x%X, invalid bitmasks", N, immr, immr, imms);
+                // BS_LOG_DEBUG(logger, "N: %i, immr: 0x%X (%u), imms: 0x%X, invalid bitmasks", N, immr, immr, imms);
                 valid = false;
             }
 
@@ -707,7 +766,7 @@ Instruction::Instruction(const int32_t* inst) {
                         kind[parseLevel++] = sf ? "UBFX - 64-bit" : "UBFX - 32-bit";
                     }
                 }
-                // logger.debug("sf == N == %i, opc: %i", sf, opc);
+                // BS_LOG_DEBUG(logger, "sf == N == %i, opc: %i", sf, opc);
             }
         } else {  // op1 == 1x
             if (op0 == 0b10) {
@@ -746,7 +805,7 @@ Instruction::Instruction(const int32_t* inst) {
                 } else {
                     kind[parseLevel++] = "B.cond";
                     label = (decltype(label)::value_type)(pc + (SignExtend<int64_t>(imm19, 19) << 2));
-                    // logger.debug("label: %lX", ((decltype(base))*label) - base);
+                    // BS_LOG_DEBUG(logger, "label: %lX", ((decltype(base))*label) - base);
                     branchType = DIR;
                 }
             }
@@ -772,7 +831,7 @@ Instruction::Instruction(const int32_t* inst) {
                             kind[parseLevel++] = "BR";
                         }
                     } else {
-                        logger.debug("TODO: BRA[A/AZ/B/BZ]! opc = 0, op3: %i, op4: %i", op3, op4);
+                        BS_LOG_DEBUG(logger, "TODO: BRA[A/AZ/B/BZ]! opc = 0, op3: %i, op4: %i", op3, op4);
                     }
                 } else if (opc == 0b1) {
                     branchType = INDCALL;
@@ -785,7 +844,7 @@ Instruction::Instruction(const int32_t* inst) {
                             kind[parseLevel++] = "BLR";
                         }
                     } else {
-                        logger.debug("TODO: BLRA[A/AZ/B/BZ]! opc = 0, op3: %i, op4: %i", op3, op4);
+                        BS_LOG_DEBUG(logger, "TODO: BLRA[A/AZ/B/BZ]! opc = 0, op3: %i, op4: %i", op3, op4);
                     }
                 } else if (opc == 0b10) {
                     branchType = RET;
@@ -796,10 +855,10 @@ Instruction::Instruction(const int32_t* inst) {
                             kind[parseLevel++] = "RET";
                         }
                     } else {
-                        logger.debug("TODO: RETAA/RETAB! opc = 0b10, op3: %i, op4: %i", op3, op4);
+                        BS_LOG_DEBUG(logger, "TODO: RETAA/RETAB! opc = 0b10, op3: %i, op4: %i", op3, op4);
                     }
                 } else {
-                    // logger.debug("opc: %i, op3: %i, op4: %i", opc, op3, op4);
+                    // BS_LOG_DEBUG(logger, "opc: %i, op3: %i, op4: %i", opc, op3, op4);
                 }
             } else if (op1 == 0b01000000110010) {
                 if (op2 == 0b11111) {
@@ -812,13 +871,13 @@ Instruction::Instruction(const int32_t* inst) {
                         // NOP
                         kind[parseLevel++] = nopSt;
                     } else {
-                        logger.debug("HINT instruction, CRm = %i, op2 = %i", CRm, op2);
+                        BS_LOG_DEBUG(logger, "HINT instruction, CRm = %i, op2 = %i", CRm, op2);
                     }
                 } else {
                     kind[parseLevel++] = unalloc;
                 }
             } else {
-                // logger.debug("op0 = 0b110, op1: %lu", op1);
+                // BS_LOG_DEBUG(logger, "op0 = 0b110, op1: %lu", op1);
             }
         } else if ((op0 & 0b11) == 0) {  // x00
             // https://developer.arm.com/docs/ddi0596/a/top-level-encodings-for-a64/branches-exception-generating-and-system-instructions#branch_imm
@@ -830,7 +889,7 @@ Instruction::Instruction(const int32_t* inst) {
             label = (decltype(label)::value_type)(pc + offset);
 
             int64_t off = ((decltype(base))*label) - base;
-            logger.debug("label: %lX", off);
+            BS_LOG_DEBUG(logger, "label: %lX", off);
             if ((off < 0) || (off >= 0x03000000)) {
                 logger.error("0x%lX is probably not a valid offset! Please investigate!", off);
             }
@@ -878,7 +937,7 @@ Instruction::Instruction(const int32_t* inst) {
                 kind[parseLevel++] = op ? "TBNZ" : "TBZ";
             }
         } else {
-            // logger.debug("op0: %u, op1: %s, op2: %u", op0, std::bitset<14>(op1).to_string().c_str(), op2);
+            // BS_LOG_DEBUG(logger, "op0: %u, op1: %s, op2: %u", op0, std::bitset<14>(op1).to_string().c_str(), op2);
         }
     } else if ((top0 & 0b101) == 0b100) {  // x1x0
         // https://developer.arm.com/docs/ddi0596/a/top-level-encodings-for-a64/loads-and-stores
@@ -901,14 +960,14 @@ Instruction::Instruction(const int32_t* inst) {
                 // https://developer.arm.com/docs/ddi0596/a/top-level-encodings-for-a64/loads-and-stores#ldst_pos
                 kind[parseLevel++] = "Load/store register (unsigned immediate)";
                 uint_fast16_t imm12 = bits(code, 21, 10);
-                // logger.debug("size: %i; imm12: 0x%lX", size, imm12);
+                // BS_LOG_DEBUG(logger, "size: %i; imm12: 0x%lX", size, imm12);
                 imm = ZeroExtend<int64_t>(imm12, 12) << size;
                 wback = false;
                 postindex = false;
                 hasImmOffset = true;
             } else if ((op3 & 0b100000) == 0) {  // 0xxxxx
                 uint_fast16_t imm9 = bits(code, 20, 12);
-                // logger.debug("size: %i; imm9: 0x%lX", size, imm9);
+                // BS_LOG_DEBUG(logger, "size: %i; imm9: 0x%lX", size, imm9);
                 imm = SignExtend<int64_t>(imm9, 9);
 
                 if (op4 == 0b11) {
@@ -924,7 +983,7 @@ Instruction::Instruction(const int32_t* inst) {
                     postindex = true;
                     hasImmOffset = true;
                 } else {
-                    // logger.debug("op0 = xx11, op2 = 0x, op3 = 0xxxxx, op4: %i", op4);
+                    // BS_LOG_DEBUG(logger, "op0 = xx11, op2 = 0x, op3 = 0xxxxx, op4: %i", op4);
                 }
             } else {
                 if (op4 == 0b10) {
@@ -1001,10 +1060,10 @@ Instruction::Instruction(const int32_t* inst) {
                             }
                         }
                     } else {
-                        logger.debug("TODO: STR/LDR (register, SIMD&FP)");
+                        BS_LOG_DEBUG(logger, "TODO: STR/LDR (register, SIMD&FP)");
                     }
                 } else {
-                    // logger.debug("op0 = xx11, op2 = 0x, op3 = 1xxxxx, op4: %i", op4);
+                    // BS_LOG_DEBUG(logger, "op0 = xx11, op2 = 0x, op3 = 1xxxxx, op4: %i", op4);
                 }
             }
 
@@ -1051,7 +1110,7 @@ Instruction::Instruction(const int32_t* inst) {
                         }
                     }
                 } else {
-                    // logger.debug("V: %i (TODO: SIMD&FP STR/LDR)", V);
+                    // BS_LOG_DEBUG(logger, "V: %i (TODO: SIMD&FP STR/LDR)", V);
                 }
             }
         } else if ((op0 & 0b11) == 0b10) {  // xx10
@@ -1064,13 +1123,14 @@ Instruction::Instruction(const int32_t* inst) {
             uint_fast8_t Rt2 = bits(code, 14, 10);  // cannot be SP
 
             static constexpr int scaleArr[] = {2, 4, 3};
-            int scale = scaleArr[opc];
+            // opc == 0b11 is unallocated
+            int scale = opc < std::size(scaleArr) ? scaleArr[opc] : 0;
             imm = SignExtend<int64_t>(imm7, 7) << scale;
 
             if (op2 == 0) {
                 // https://developer.arm.com/docs/ddi0596/a/top-level-encodings-for-a64/loads-and-stores#ldstnapair_offs
                 kind[parseLevel++] = "Load/store no-allocate pair (offset)";
-                // logger.debug("opc: %i, V: %i, L: %i", opc, V, L);
+                // BS_LOG_DEBUG(logger, "opc: %i, V: %i, L: %i", opc, V, L);
             } else {
                 if (op2 == 0b1) {
                     // https://developer.arm.com/docs/ddi0596/a/top-level-encodings-for-a64/loads-and-stores#ldstpair_post
@@ -1116,7 +1176,7 @@ Instruction::Instruction(const int32_t* inst) {
                         kind[parseLevel++] = "LDP - 64-bit";
                     }
                 } else {
-                    logger.debug("TODO: SIMD&FP LDP/STP. opc: %i, V: %i, L: %i", opc, V, L);
+                    BS_LOG_DEBUG(logger, "TODO: SIMD&FP LDP/STP. opc: %i, V: %i, L: %i", opc, V, L);
                 }
             }
         } else if (op0 == 0b1001 && op1 == 0 && (op2 & 0b10) != 0 && (op3 & 0b100000) != 0) {
@@ -1130,7 +1190,7 @@ Instruction::Instruction(const int32_t* inst) {
                 uint_fast8_t V = bits(code, 26, 26);
                 uint_fast32_t imm19 = bits(code, 23, 5);
                 uint_fast8_t rt = bits(code, 4, 0);
-                logger.debug("opc: %i, V: %i, imm19: %lu, rt: %i", opc, V, imm19, rt);
+                BS_LOG_DEBUG(logger, "opc: %i, V: %i, imm19: %lu, rt: %i", opc, V, imm19, rt);
 
                 // inst: ptr = 0x7F6D60C400 (offset 0x1A15400), bytes = 01011000000000000000000001010001 (58000051), top-level op0: 12
                 // op0: 5, op2: 0, op3: 0, op4: 0
@@ -1138,7 +1198,7 @@ Instruction::Instruction(const int32_t* inst) {
                     if (opc == 0b11) {
                         kind[parseLevel++] = unalloc;
                     } else {
-                        logger.debug("TODO: SIMD Load register literal");
+                        BS_LOG_DEBUG(logger, "TODO: SIMD Load register literal");
                     }
                 } else {
                     if (opc == 0b00) {
@@ -1165,7 +1225,7 @@ Instruction::Instruction(const int32_t* inst) {
                 }
             }
         } else {
-            // logger.debug("op0: %i, op2: %i, op3: %i, op4: %i", op0, op2, op3, op4);
+            // BS_LOG_DEBUG(logger, "op0: %i, op2: %i, op3: %i, op4: %i", op0, op2, op3, op4);
         }
     } else {
         logger.error("Our top-level bit patterns have a gap!");
@@ -1181,138 +1241,296 @@ Instruction::Instruction(const int32_t* inst) {
     }
 }
 
-/*
-void InstructionTree::Eval(ProgramState* state) {
-    // TODO: if instruction is indirect branch, use state to populate branch
-}
-*/
-
-InstructionTree* FindOrCreateInstruction(const int32_t* pc, ParseState& parseState, const char* msg) {
-    auto p = parseState.codeToInstTree.find(pc);
-    static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("FindOrCreateInstruction");
-    if (p != parseState.codeToInstTree.end()) {
-        logger.debug("not recursing: InstructionTree for %p (offset %lX) already exists", pc, asOffset((uintptr_t)pc));
-        return p->second;
-    } else {
-        logger.debug("%s (pc %p, offset %lX)", msg, pc, asOffset((uintptr_t)pc));
-        auto inst = new (std::nothrow) InstructionTree(pc);
-        parseState.frontier.push({inst, parseState.dependencyMap});  // the inserted depMap is a copy
-        parseState.codeToInstTree[pc] = inst;
-        return inst;
+// No function is anywhere near this long: past it, what is being decoded is most likely not code at all
+static constexpr std::size_t maxFunctionInstructions = 64 * 1024;
+// How many instructions before a BR to look through for the ones that make it a switch
+static constexpr std::ptrdiff_t switchSearchLength = 16;
+// More cases than any switch over a jump table has, in case a bound is misread
+static constexpr uint32_t maxSwitchCases = 4096;
+
+// The functions built by AssemblyFunction::Get
+static std::mutex functionsLock;
+static std::unordered_map<const int32_t*, std::shared_ptr<const AssemblyFunction>> functions;
+
+// The switch that the BR at br is, if the instructions before it are the usual ones for the kind of jump table EvalSwitch reads:
+//   cmp wIndex, #(cases - 1); b.hi default
+//   adrp xTable, table; add xTable, xTable, :lo12:table; ldrsw xOffset, [xTable, xIndex, lsl #2]; add xTarget, xTable, xOffset; br xTarget
+// with the last 5 in whatever order the compiler scheduled them in, among any others.
+static std::optional<AssemblyFunction::Switch> resolveSwitch(const int32_t* br, const ModuleMap::Segment& segment, const ModuleMap& map) {
+    auto first = std::max(br - switchSearchLength, reinterpret_cast<const int32_t*>(segment.start));
+    // The b.hi (or b.hs) to the default case, which the block that ends with br starts after
+    auto bound = br - 1;
+    while (bound > first && EncodedInstruction(bound).opcode != Opcode::B_COND) bound--;
+    if (bound <= first) return std::nullopt;
+    EncodedInstruction cond(bound);
+    EncodedInstruction cmp(bound - 1);
+    // cmp (immediate) is subs (immediate) to the zero register, here without its immediate shifted
+    if ((cmp.code & 0x7FC0001F) != 0x7100001F) return std::nullopt;
+    uint32_t limit = (cmp.code >> 10) & 0xFFF;
+    uint32_t cases;
+    switch (cond.code & 0xF) {
+        case 0b1000:  // hi: the last case is limit
+            cases = limit + 1;
+            break;
+        case 0b0010:  // hs
+            cases = limit;
+            break;
+        default:
+            return std::nullopt;
     }
-}
-
-void ProcessRegisterDependencies(Instruction* inst, uint_fast8_t Rd, decltype(ParseState::dependencyMap)& depMap) {
-    auto newDeps = decltype(ParseState::dependencyMap)::value_type();  // storage for the dependencies of a single register
-    for (uint_fast8_t i = 0; i < inst->numSourceRegisters; i++) {
-        auto Rs = inst->Rs[i];
-        if ((Rs < 0) || ((size_t)Rs >= depMap.max_size())) {
-            static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("ProcessRegisterDependencies");
-            logger.critical("Instruction is wrong! numSourceRegisters = %i but Rs[%i] = %i\n%s", inst->numSourceRegisters, i, Rs,
-                inst->toString().c_str());
-            SAFE_ABORT();
+    if (cases == 0 || cases > maxSwitchCases) return std::nullopt;
+
+    const uint32_t* table = nullptr;
+    bool loadsOffset = false;
+    for (auto pc = bound + 1; pc < br; pc++) {
+        EncodedInstruction inst(pc);
+        if (inst.opcode == Opcode::ADRP && !table) {
+            for (auto add = pc + 1; add < br; add++) {
+                EncodedInstruction next(add);
+                // add (immediate), 64-bit and unshifted, to the register the adrp set
+                if ((next.code & 0xFFC00000) == 0x91000000 && next.rn() == inst.rd()) {
+                    table = reinterpret_cast<const uint32_t*>(reinterpret_cast<uintptr_t>(*inst.label()) + ((next.code >> 10) & 0xFFF));
+                    break;
+                }
+            }
+        } else if ((inst.code & 0xFFE00C00) == 0xB8A00800) {  // ldrsw (register)
+            loadsOffset = true;
         }
-        newDeps |= depMap[Rs];
     }
-    depMap[Rd] = std::move(newDeps);
-}
-
-void ProcessRegisterDependencies(Instruction* inst, decltype(ParseState::dependencyMap)& depMap) {
-    if (inst->Rd >= 0) ProcessRegisterDependencies(inst, inst->Rd, depMap);
-    if (inst->Rd2 >= 0) ProcessRegisterDependencies(inst, inst->Rd2, depMap);
-}
-
-bool OnlySelfDeps(uint_fast8_t reg, decltype(ParseState::dependencyMap)& depMap) {
-    auto deps = depMap[reg];
-    return ((deps.count() == 1) && deps[reg]);
+    if (!table || !loadsOffset) return std::nullopt;
+    auto tableSegment = map.FindSegment(reinterpret_cast<uintptr_t>(table));
+    if (!tableSegment || !tableSegment->readable || reinterpret_cast<uintptr_t>(table + cases) > tableSegment->end) return std::nullopt;
+
+    AssemblyFunction::Switch found{br, table, {}};
+    found.targets.reserve(cases);
+    for (uint32_t i = 0; i < cases; i++) {
+        found.targets.push_back(switchTarget(table, i + 1));
+    }
+    return found;
 }
 
-std::string DepMapToString(decltype(ParseState::dependencyMap)& depMap) {
-    std::ostringstream ss;
-    ss << "{self deps: [";
-    for (uint_fast8_t i = 0; i < depMap.max_size(); i++) {
-        if ((i != 0) && ((i % 8) == 0)) {
-            ss << "|";
+AssemblyFunction::AssemblyFunction(const int32_t* entry) : entry(entry), base(getBase((uintptr_t)entry)) {
+    static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("AssemblyFunction");
+    auto map = ModuleMap::Get();
+    if (!map->FindSegment(reinterpret_cast<uintptr_t>(entry))) {
+        // Perhaps it was loaded since the map was parsed
+        ModuleMap::Invalidate();
+        map = ModuleMap::Get();
+    }
+    // Instructions can only be read up to the end of their segment
+    auto segmentOf = [&map](const int32_t* pc) -> const ModuleMap::Segment* {
+        auto segment = map->FindSegment(reinterpret_cast<uintptr_t>(pc));
+        return segment && segment->readable ? segment : nullptr;
+    };
+    auto isTailCall = [this, &segmentOf](const int32_t* target) {
+        if (target == this->entry) return false;
+        Dl_info info;
+        return target < this->entry || !segmentOf(target) || (dladdr(target, &info) && info.dli_saddr == target);
+    };
+
+    // Where each instruction that ends a run of instructions can go next (nowhere for a ret, tail call or BR that is not a switch)
+    std::unordered_map<const int32_t*, std::vector<const int32_t*>> jumps;
+    // Where control can enter from somewhere other than the instruction before, which every block has to start at
+    std::unordered_set<const int32_t*> leaders{entry};
+    // The runs decoded so far, as start -> end
+    std::map<const int32_t*, const int32_t*> runs;
+    std::vector<const int32_t*> frontier{entry};
+    auto follow = [&](const int32_t* target, std::vector<const int32_t*>& to) {
+        if (!segmentOf(target)) return;
+        to.push_back(target);
+        if (leaders.insert(target).second) frontier.push_back(target);
+    };
+
+    while (!frontier.empty() && instructions.size() < maxFunctionInstructions) {
+        auto pc = frontier.back();
+        frontier.pop_back();
+        auto next = runs.upper_bound(pc);
+        if (next != runs.begin() && pc < std::prev(next)->second) continue;  // already decoded, as part of an earlier run
+        auto segment = segmentOf(pc);
+        // A run stops at the next one, which starts at a leader so it will be a block of its own anyway
+        auto stop = next == runs.end() ? nullptr : next->first;
+        auto start = pc;
+        while (segment && pc != stop && instructions.size() < maxFunctionInstructions) {
+            if (reinterpret_cast<uintptr_t>(pc) >= segment->end) {
+                // Code can go on into the next mapping, as long as that is readable too
+                segment = segmentOf(pc);
+                continue;
+            }
+            auto& inst = instructions.emplace_back(pc++);
+            switch (inst.opcode) {
+                case Opcode::BL:
+                case Opcode::BLR:
+                    calls.push_back(inst.addr);
+                    continue;
+                case Opcode::B: {
+                    auto& to = jumps[inst.addr];
+                    auto target = *inst.label();
+                    if (isTailCall(target)) {
+                        tailCalls.push_back(inst.addr);
+                    } else {
+                        follow(target, to);
+                    }
+                    break;
+                }
+                case Opcode::B_COND:
+                case Opcode::CB:
+                case Opcode::TB: {
+                    auto& to = jumps[inst.addr];
+                    follow(*inst.label(), to);
+                    follow(pc, to);
+                    break;
+                }
+                case Opcode::BR: {
+                    auto& to = jumps[inst.addr];
+                    if (auto found = resolveSwitch(inst.addr, *segment, *map)) {
+                        for (auto target : found->targets) follow(target, to);
+                        switches.push_back(std::move(*found));
+                    } else {
+                        BS_LOG_DEBUG(logger, "BR at %p (offset %lX) is not a switch", inst.addr, asOffset((uintptr_t)inst.addr));
+                    }
+                    break;
+                }
+                case Opcode::RET:
+                case Opcode::BRK:
+                case Opcode::UDF:
+                    jumps[inst.addr];
+                    break;
+                default:
+                    continue;
+            }
+            break;
         }
-        if (depMap[i].none()) {
-            ss << " ";
-        } else if (OnlySelfDeps(i, depMap)) {
-            ss << "O";  // a loop
+        if (pc != start) runs.emplace(start, pc);
+    }
+    if (instructions.size() >= maxFunctionInstructions) {
+        logger.warning("Stopped building the function at %p (offset %lX) after %zu instructions", entry, asOffset((uintptr_t)entry),
+            instructions.size());
+    }
+
+    // Runs never overlap, so sorting them is all it takes to get every instruction in order
+    auto byAddress = [](const EncodedInstruction& lhs, const EncodedInstruction& rhs) { return lhs.addr < rhs.addr; };
+    std::sort(instructions.begin(), instructions.end(), byAddress);
+    std::sort(calls.begin(), calls.end());
+    std::sort(tailCalls.begin(), tailCalls.end());
+    std::sort(switches.begin(), switches.end(), [](const Switch& lhs, const Switch& rhs) { return lhs.branch < rhs.branch; });
+    for (auto& inst : instructions) {
+        if (blocks.empty() || inst.addr != blocks.back().end || leaders.contains(inst.addr)) {
+            blocks.push_back(BasicBlock{inst.addr, inst.addr + 1, {}, {}});
         } else {
-            ss << ">";  // deps are listed on right
+            blocks.back().end++;
         }
     }
-    ss << "]; ";
-    bool first = true;
-    for (uint_fast8_t i = 0; i < depMap.max_size(); i++) {
-        if (!OnlySelfDeps(i, depMap) && depMap[i].any()) {
-            if (!first) ss << "; ";
-            ss << Register(i, true) << " deps: ";
-            bool innerFirst = true;
-            for (uint_fast8_t dep = 0; dep < depMap[i].size(); dep++) {
-                if (!depMap[i][dep]) continue;
-                if (!innerFirst) ss << ", ";
-                ss << Register(dep, true);
-                innerFirst = false;
-            }
-            first = false;
+    auto blockStartingAt = [this](const int32_t* pc) -> std::optional<std::size_t> {
+        auto block = BlockAt(pc);
+        if (!block || block->start != pc) return std::nullopt;
+        return block - blocks.data();
+    };
+    for (std::size_t i = 0; i < blocks.size(); i++) {
+        auto& block = blocks[i];
+        auto jump = jumps.find(block.end - 1);
+        // A block that does not end with a jump runs into the next one
+        std::vector<const int32_t*> fallthrough{block.end};
+        for (auto target : jump != jumps.end() ? jump->second : fallthrough) {
+            if (auto successor = blockStartingAt(target)) block.successors.push_back(*successor);
         }
+        std::sort(block.successors.begin(), block.successors.end());
+        block.successors.erase(std::unique(block.successors.begin(), block.successors.end()), block.successors.end());
+        // In order of address, since i only goes up
+        for (auto successor : block.successors) blocks[successor].predecessors.push_back(i);
     }
-    ss << "}" << std::flush;
-    return ss.str();
+    BS_LOG_DEBUG(logger, "Function at %p (offset %lX): %zu instructions in %zu blocks, %zu calls, %zu tail calls, %zu switches", entry,
+        asOffset((uintptr_t)entry), instructions.size(), blocks.size(), calls.size(), tailCalls.size(), switches.size());
 }
 
-void InstructionTree::PopulateChildren(ParseState& parseState) {
-    auto pc = this->addr;
-    static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("PopulateChildren");
-    logger.debug("InstructionTree: %p, %s", pc, this->toString().c_str());
-    // If instruction was not fully parsed, stop.
-    if (!parsed || !valid) return;
-
-    if ((this->numSourceRegisters < 0) || (this->Rs[this->numSourceRegisters - 1] < 0)) {
-        logger.error("The Instruction constructor did not properly parse this instruction's source registers! Please fix!");
+std::shared_ptr<const AssemblyFunction> AssemblyFunction::Get(const int32_t* entry) {
+    {
+        std::lock_guard<std::mutex> lock(functionsLock);
+        auto found = functions.find(entry);
+        if (found != functions.end()) return found->second;
     }
+    // Built without the lock held, so that building one function does not hold up looking up others.
+    // If two threads build the same function at once, the first to finish is the one kept.
+    auto built = std::make_shared<const AssemblyFunction>(entry);
+    std::lock_guard<std::mutex> lock(functionsLock);
+    return functions.try_emplace(entry, std::move(built)).first->second;
+}
 
-    // if instruction is return, stop parsing.
-    if (isReturn()) return;
+void AssemblyFunction::ClearCache() noexcept {
+    // Freed after unlocking, unless something else still holds them
+    decltype(functions) old;
+    {
+        std::lock_guard<std::mutex> lock(functionsLock);
+        old.swap(functions);
+    }
+}
 
-    // populate parseState.dependencyMap using this' dest and source registers
-    ProcessRegisterDependencies(this, parseState.dependencyMap);
+const BasicBlock* AssemblyFunction::BlockAt(const int32_t* pc) const noexcept {
+    // The first block that starts after pc
+    auto block = std::upper_bound(blocks.begin(), blocks.end(), pc, [](const int32_t* pc, const BasicBlock& block) { return pc < block.start; });
+    if (block == blocks.begin()) return nullptr;
+    --block;
+    return block->contains(pc) ? &*block : nullptr;
+}
 
-    // if instruction is direct branch, address to jump to is in "label"
-    if (isDirectBranch()) {
-        CRASH_UNLESS(label);
-        const int32_t* addr = *label;
-        // Note: these do not edit the dependency map so there is no need to take a backup of it ourselves
-        branch = FindOrCreateInstruction(addr, parseState, "InstructionTree: recursing to branch location");
-        if (isCall()) {
-            parseState.functionCandidates.insert({addr, parseState.dependencyMap});  // the inserted depMap is a copy
+std::optional<Instruction> AssemblyFunction::FindDefinition(const int32_t* pc, uint_fast8_t reg) const {
+    auto block = BlockAt(pc);
+    // Every block can be reached from the entry, so following only predecessors can only go around in circles with the entry's block in
+    // the circle (where there are then two ways into it). Even so, never take more steps than there are blocks.
+    for (std::size_t steps = 0; block && steps < blocks.size(); steps++) {
+        for (auto def = pc; def-- > block->start;) {
+            Instruction inst(def, base);
+            if (inst.isCall() && reg <= 18) return std::nullopt;
+            if (!inst.parsed) {
+                // Whatever it is, it may well set Rd
+                if ((static_cast<uint32_t>(*def) & 0x1F) == reg) return std::nullopt;
+                continue;
+            }
+            // A store's Rd is the register it stores to the address in, which it at most writes back to
+            if (inst.isStore()) continue;
+            if (inst.Rd == reg || inst.Rd2 == reg) return inst;
         }
-    } else {
-        parseState.otherJumps.insert({pc, parseState.dependencyMap});
-    }
-    // unless instruction is unconditional branch, populate noBranch with next instruction in memory
-    if (!isUnconditionalBranch()) {
-        noBranch = FindOrCreateInstruction(pc + 1, parseState, "InstructionTree: recursing to next instruction");
+        if (block->predecessors.size() != 1) return std::nullopt;
+        block = &blocks[block->predecessors.front()];
+        pc = block->end;
     }
+    return std::nullopt;
 }
 
-InstructionTree::InstructionTree(const int32_t* pc): Instruction(pc) {
+decltype(Instruction::result) AssemblyFunction::ExtractAddress(int pcRelN, int offsetN) const {
+    static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("ExtractAddress");
+    auto instAdrp = RET_0_UNLESS(logger, FindNthEncoded(entry, pcRelN, std::mem_fn(&EncodedInstruction::isPcRelAdr)));
+    uint_fast8_t reg = instAdrp.Rd;
+    auto instOff = RET_0_UNLESS(logger, FindNthEncoded(instAdrp.addr, offsetN, [this, reg](const EncodedInstruction& inst) {
+        return inst.mayHaveImmOffset() && Instruction(inst.addr, base).hasImmOffsetOnReg(reg);
+    }));
+    BS_LOG_DEBUG(logger, "adrp idx: %lu, offset instruction idx: %lu", instAdrp.addr - entry, instOff.addr - entry);
+    return ::ExtractAddress(&instAdrp, &instOff);
+}
+
+std::optional<Instruction> AssemblyFunction::EvalSwitch(int pcRelN, int offsetN, int switchCaseValue) const {
+    static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("EvalSwitch");
+    auto switchTable = (const uint32_t*)RET_NULLOPT_UNLESS(logger, ExtractAddress(pcRelN, offsetN));
+    return Instruction(switchTarget(switchTable, switchCaseValue));
 }
 
 std::ostream& operator<<(std::ostream& os, const AssemblyFunction& func) {
     os << std::hex << std::uppercase;
-    os << "Function candidates: " << std::endl;
-    for (auto p : func.parseState.functionCandidates) {
-        os << "0x" << uintptr_t(p.first) << " (offset 0x" << asOffset((uintptr_t)p.first) << "): depMap "
-            << DepMapToString(p.second) << std::endl;
-    }
-    os << "Other jumps: " << std::endl;
-    for (auto p : func.parseState.otherJumps) {
-        os << "0x" << uintptr_t(p.first) << " (offset 0x" << asOffset((uintptr_t)p.first) << "): depMap "
-            << DepMapToString(p.second) << std::endl;
+    os << "Function at 0x" << uintptr_t(func.entry) << " (offset 0x" << asOffset((uintptr_t)func.entry) << "):" << std::endl;
+    for (std::size_t i = 0; i < func.blocks.size(); i++) {
+        auto& block = func.blocks[i];
+        os << std::dec << i << std::hex << ": offset 0x" << asOffset((uintptr_t)block.start) << " to 0x" << asOffset((uintptr_t)block.end) << ", to [";
+        for (auto successor : block.successors) {
+            os << (successor == block.successors.front() ? "" : ", ") << std::dec << successor;
+        }
+        os << "]" << std::endl;
     }
-    return os << std::nouppercase << std::dec;
+    os << "Calls at:";
+    for (auto call : func.calls) os << " 0x" << std::hex << asOffset((uintptr_t)call);
+    os << std::endl << "Tail calls at:";
+    for (auto call : func.tailCalls) os << " 0x" << std::hex << asOffset((uintptr_t)call);
+    os << std::endl << "Switches at:";
+    for (auto& found : func.switches) os << " 0x" << std::hex << asOffset((uintptr_t)found.branch) << " (" << std::dec << found.targets.size() << " cases)";
+    return os << std::endl << std::nouppercase << std::dec;
 }
 
 std::string AssemblyFunction::toString() const {
@@ -1321,16 +1539,214 @@ std::string AssemblyFunction::toString() const {
     return ss.str();
 }
 
-AssemblyFunction::AssemblyFunction(const int32_t* pc): parseState() {
-    static auto logger = Logger::get().WithContext("instruction-parsing").WithContext("AssemblyFunction");
-    logger.debug("Starting dependency map: %s", DepMapToString(parseState.dependencyMap).c_str());
-    auto root = new InstructionTree(pc);
-    parseState.frontier.push({root, std::move(parseState.dependencyMap)});
-    while (!parseState.frontier.empty()) {
-        auto p = parseState.frontier.top();
-        parseState.frontier.pop();
-
-        parseState.dependencyMap = std::move(p.second);
-        p.first->PopulateChildren(parseState);
+// Calls may set all of these (x0 to x18, and the link register x30) without restoring them
+static constexpr uint_fast8_t callerSaved[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, Register::RLINK};
+
+void RegisterEvaluator::Step(const EncodedInstruction& inst, RegisterSet& state, std::vector<Xref>* found) const {
+    auto code = inst.code;
+    auto rd = inst.rd();
+    auto rn = inst.rn();
+    bool sf = code >> 31;
+    auto report = [&](Xref::Kind kind, uintptr_t address) {
+        if (found) found->push_back(Xref{inst.addr, kind, address});
+    };
+    // A call (or jump) to whatever is in rn
+    auto reportJumpTo = [&](uint_fast8_t reg) {
+        if (auto address = state.valueOf(reg, RegisterSet::ADDRESS)) {
+            report(Xref::CALL, *address);
+        } else if (auto pointer = state.valueOf(reg, RegisterSet::LOADED_FROM)) {
+            report(Xref::CALL_THROUGH, *pointer);
+        }
+    };
+    // A load or store of rt at base + offset
+    auto access = [&](uint_fast8_t base, int64_t offset, bool load, bool pointerSized, bool simd) {
+        auto address = state.valueOf(base, RegisterSet::ADDRESS);
+        if (address) report(load ? Xref::LOAD : Xref::STORE, *address + offset);
+        if (!load || simd) return;
+        if (address && pointerSized) {
+            state.set(rd, RegisterSet::LOADED_FROM, *address + offset);
+        } else {
+            state.forget(rd);
+        }
+    };
+
+    switch (inst.opcode) {
+        case Opcode::ADR:
+            state.set(rd, RegisterSet::ADDRESS, reinterpret_cast<intptr_t>(*inst.label()));
+            report(Xref::ADDRESS, reinterpret_cast<uintptr_t>(*inst.label()));
+            return;
+        case Opcode::ADRP:
+            // Only a page, which the ADD or load after it makes an address
+            state.set(rd, RegisterSet::ADDRESS, reinterpret_cast<intptr_t>(*inst.label()));
+            return;
+        case Opcode::ADD_SUB_IMM: {
+            bool setsFlags = (code >> 29) & 1;
+            if (setsFlags && rd == Register::RZR) return;  // CMP, CMN
+            int64_t imm = ((code >> 10) & 0xFFF) << (((code >> 22) & 1) * 12);
+            if ((code >> 30) & 1) imm = -imm;
+            auto kind = state.kinds[rn];
+            if (rn == Register::SP || kind == RegisterSet::UNKNOWN || kind == RegisterSet::LOADED_FROM || (!sf && kind == RegisterSet::ADDRESS)) {
+                state.forget(rd);
+                return;
+            }
+            auto value = state.regs[rn] + imm;
+            state.set(rd, kind, sf ? value : static_cast<uint32_t>(value));
+            if (kind == RegisterSet::ADDRESS) report(Xref::ADDRESS, value);
+            return;
+        }
+        case Opcode::LOAD_STORE:
+            if ((code & 0x3B000000) == 0x39000000) {  // unsigned immediate offset
+                auto size = code >> 30;
+                auto opc = (code >> 22) & 3;
+                bool simd = (code >> 26) & 1;
+                if (!simd && size == 3 && opc >= 2) return;  // PRFM, or unallocated
+                auto scale = simd && (opc & 2) ? 4 : size;
+                access(rn, static_cast<int64_t>((code >> 10) & 0xFFF) << scale, opc != 0, !simd && size == 3 && opc == 1, simd);
+                return;
+            }
+            if ((code & 0x3B200C00) == 0x38000000) {  // unscaled immediate offset (LDUR, STUR)
+                auto size = code >> 30;
+                auto opc = (code >> 22) & 3;
+                bool simd = (code >> 26) & 1;
+                if (!simd && size == 3 && opc >= 2) return;  // PRFUM, or unallocated
+                access(rn, SignExtend<int64_t>(static_cast<int64_t>((code >> 12) & 0x1FF), 9), opc != 0, !simd && size == 3 && opc == 1, simd);
+                return;
+            }
+            if ((code & 0x3B000000) == 0x18000000) {  // literal
+                auto opc = code >> 30;
+                bool simd = (code >> 26) & 1;
+                if (!simd && opc == 3) return;  // PRFM
+                auto literal = reinterpret_cast<intptr_t>(inst.addr) + SignExtend<int64_t>(static_cast<int64_t>((code >> 5) & 0x7FFFF), 19) * 4;
+                report(Xref::LOAD, literal);
+                if (simd) return;
+                if (opc == 1) {
+                    state.set(rd, RegisterSet::LOADED_FROM, literal);
+                } else {
+                    state.forget(rd);
+                }
+                return;
+            }
+            // Anything else (pairs, register offsets, writing back the address) is not followed: whichever registers its fields could name
+            // may have been set
+            state.forget(rd);
+            state.forget((code >> 10) & 0x1F);
+            state.forget(rn);
+            return;
+        case Opcode::BL:
+            report(Xref::CALL, reinterpret_cast<uintptr_t>(*inst.label()));
+            for (auto reg : callerSaved) state.forget(reg);
+            return;
+        case Opcode::BLR:
+            reportJumpTo(rn);
+            for (auto reg : callerSaved) state.forget(reg);
+            return;
+        case Opcode::B: {
+            auto tailCalls = function.TailCalls();
+            if (std::binary_search(tailCalls.begin(), tailCalls.end(), inst.addr)) report(Xref::CALL, reinterpret_cast<uintptr_t>(*inst.label()));
+            return;
+        }
+        case Opcode::BR: {
+            auto switches = function.Switches();
+            bool isSwitch = std::any_of(switches.begin(), switches.end(), [&inst](const AssemblyFunction::Switch& candidate) {
+                return candidate.branch == inst.addr;
+            });
+            if (!isSwitch) reportJumpTo(rn);
+            return;
+        }
+        case Opcode::B_COND:
+        case Opcode::CB:
+        case Opcode::TB:
+        case Opcode::RET:
+        case Opcode::BRK:
+        case Opcode::UDF:
+            return;
+        default:
+            break;
+    }
+    if ((code & 0x7F800000) == 0x52800000) {  // MOVZ
+        auto shift = ((code >> 21) & 3) * 16;
+        state.set(rd, RegisterSet::CONSTANT, static_cast<int64_t>((code >> 5) & 0xFFFF) << shift);
+    } else if ((code & 0x7F800000) == 0x12800000) {  // MOVN
+        auto shift = ((code >> 21) & 3) * 16;
+        auto value = ~(static_cast<int64_t>((code >> 5) & 0xFFFF) << shift);
+        state.set(rd, RegisterSet::CONSTANT, sf ? value : static_cast<uint32_t>(value));
+    } else if ((code & 0x7F800000) == 0x72800000) {  // MOVK
+        auto shift = ((code >> 21) & 3) * 16;
+        if (auto value = state.valueOf(rd, RegisterSet::CONSTANT)) {
+            auto kept = *value & ~(static_cast<int64_t>(0xFFFF) << shift);
+            state.set(rd, RegisterSet::CONSTANT, kept | (static_cast<int64_t>((code >> 5) & 0xFFFF) << shift));
+        } else {
+            state.forget(rd);
+        }
+    } else if ((code & 0x7FE0FFE0) == 0x2A0003E0) {  // MOV (register), i.e. ORR with the zero register
+        auto rm = (code >> 16) & 0x1F;
+        auto kind = state.kinds[rm];
+        if (rm == Register::RZR) {
+            state.set(rd, RegisterSet::CONSTANT, 0);
+        } else if (sf || kind == RegisterSet::CONSTANT) {
+            state.set(rd, kind, sf ? state.regs[rm] : static_cast<uint32_t>(state.regs[rm]));
+        } else {
+            state.forget(rd);
+        }
+    } else {
+        // Nearly everything else that sets a general purpose register has it in Rd
+        state.forget(rd);
+    }
+}
+
+RegisterEvaluator::RegisterEvaluator(const AssemblyFunction& function) : function(function) {
+    auto blocks = function.Blocks();
+    auto instructions = function.Instructions();
+    blockStates.resize(blocks.size());
+    auto entryBlock = function.BlockAt(function.entry);
+    if (!entryBlock) return;
+    blockStates[entryBlock - blocks.data()] = RegisterSet();
+
+    auto run = [&](std::size_t i, RegisterSet& state, std::vector<Xref>* found) {
+        auto inst = std::lower_bound(instructions.begin(), instructions.end(), blocks[i].start, [](const EncodedInstruction& inst, const int32_t* pc) {
+            return inst.addr < pc;
+        });
+        for (; inst != instructions.end() && inst->addr < blocks[i].end; ++inst) Step(*inst, state, found);
+    };
+    // In order of address, so that a block's predecessors have mostly been evaluated already. Only blocks that loop back to an earlier one
+    // need another pass, and each one after that only happens if some register became unknown.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::size_t i = 0; i < blocks.size(); i++) {
+            if (!blockStates[i]) continue;
+            auto state = *blockStates[i];
+            run(i, state, nullptr);
+            for (auto successor : blocks[i].successors) {
+                auto& next = blockStates[successor];
+                bool updated = next ? next->meet(state) : (next = state, true);
+                if (updated && successor <= i) changed = true;
+            }
+        }
     }
+    for (std::size_t i = 0; i < blocks.size(); i++) {
+        if (!blockStates[i]) continue;
+        auto state = *blockStates[i];
+        run(i, state, &xrefs);
+    }
+}
+
+std::vector<Xref> RegisterEvaluator::Xrefs(Xref::Kind kind) const {
+    std::vector<Xref> ofKind;
+    std::copy_if(xrefs.begin(), xrefs.end(), std::back_inserter(ofKind), [kind](const Xref& xref) { return xref.kind == kind; });
+    return ofKind;
+}
+
+std::optional<RegisterSet> RegisterEvaluator::StateBefore(const int32_t* pc) const {
+    auto block = function.BlockAt(pc);
+    if (!block) return std::nullopt;
+    auto& start = blockStates[block - function.Blocks().data()];
+    if (!start) return std::nullopt;
+    auto state = *start;
+    auto instructions = function.Instructions();
+    auto inst = std::lower_bound(instructions.begin(), instructions.end(), block->start, [](const EncodedInstruction& inst, const int32_t* pc) {
+        return inst.addr < pc;
+    });
+    for (; inst != instructions.end() && inst->addr < pc; ++inst) Step(*inst, state, nullptr);
+    return state;
 }
@@ -0,0 +1,402 @@
+#include "../../shared/utils/log-queue.hpp"
+#include "../../shared/utils/logging.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <limits.h>
+#include <new>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <vector>
+#include <zlib.h>
+
+namespace Logging {
+    namespace {
+        // Each record is a header followed by its text, padded so that the next header is aligned.
+        // A record never wraps around the end of the ring: if it does not fit, a skip record fills the rest.
+        struct RecordHeader {
+            uint32_t length;
+            uint32_t reserved;
+            uint64_t buffer;
+            // Set for deferred records, which the writer formats
+            LogQueue::Formatter formatter;
+        };
+        constexpr uint32_t skipToStart = UINT32_MAX;
+        constexpr std::size_t recordAlignment = alignof(uint64_t);
+        static_assert(sizeof(RecordHeader) % recordAlignment == 0 && sizeof(RecordHeader) <= 32, "maxRecordSize leaves room for a header");
+        static_assert((LogQueue::ringSize & (LogQueue::ringSize - 1)) == 0, "ringSize must be a power of two");
+
+        constexpr std::size_t recordSize(std::size_t length) {
+            return (sizeof(RecordHeader) + length + recordAlignment - 1) & ~(recordAlignment - 1);
+        }
+
+        // Single producer (the thread that owns it), single consumer (whoever holds drainLock)
+        struct Ring {
+            std::atomic<uint64_t> head = 0;
+            std::atomic<uint64_t> tail = 0;
+            std::atomic<uint64_t> dropped = 0;
+            // Only used by the consumer
+            uint64_t reportedDropped = 0;
+            // Only used by the producer, where the record being reserved starts
+            uint64_t reserved = 0;
+            std::atomic_bool inUse = true;
+            Ring* next = nullptr;
+            alignas(recordAlignment) char data[LogQueue::ringSize];
+        };
+
+        // Rings are never freed, a ring whose thread exited is reused by the next new thread
+        std::atomic<Ring*> rings = nullptr;
+        std::atomic<std::size_t> ringCount = 0;
+        std::atomic<uint64_t> droppedWithoutRing = 0;
+        uint64_t reportedWithoutRing = 0;
+
+        std::mutex drainLock;
+        std::mutex wakeLock;
+        std::atomic_bool started = false;
+
+        // Never destroyed, since the writer thread may still be waiting on it while the process exits
+        std::condition_variable& wake() {
+            static auto* condition = new std::condition_variable();
+            return *condition;
+        }
+
+        Ring* acquireRing() {
+            for (auto* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+                bool expected = false;
+                if (!ring->inUse.load(std::memory_order_relaxed) && ring->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return ring;
+                }
+            }
+            if (ringCount.fetch_add(1, std::memory_order_relaxed) >= LogQueue::maxRings) {
+                ringCount.fetch_sub(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            auto* ring = new (std::nothrow) Ring();
+            if (!ring) return nullptr;
+            ring->next = rings.load(std::memory_order_relaxed);
+            while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed));
+            return ring;
+        }
+
+        // Hands the ring back when its thread exits
+        struct RingHolder {
+            Ring* ring = nullptr;
+            bool acquired = false;
+            ~RingHolder() {
+                if (ring) ring->inUse.store(false, std::memory_order_release);
+            }
+        };
+        thread_local RingHolder currentRing;
+
+        Ring* current() {
+            if (!currentRing.acquired) {
+                currentRing.ring = acquireRing();
+                currentRing.acquired = true;
+            }
+            return currentRing.ring;
+        }
+
+        bool writeAll(int fd, iovec* iov, std::size_t count) {
+            while (count > 0) {
+                auto written = writev(fd, iov, static_cast<int>(std::min<std::size_t>(count, IOV_MAX)));
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                // Skip what was written, which may end in the middle of a line
+                while (count > 0 && static_cast<std::size_t>(written) >= iov->iov_len) {
+                    written -= iov->iov_len;
+                    iov++;
+                    count--;
+                }
+                if (count > 0) {
+                    iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+                    iov->iov_len -= written;
+                }
+            }
+            return true;
+        }
+
+        // Finds room for a record of length bytes in the calling thread's ring, returning where its contents go
+        char* reserve(std::size_t length) {
+            auto* ring = current();
+            if (!ring) {
+                droppedWithoutRing.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            auto size = recordSize(length);
+            auto head = ring->head.load(std::memory_order_relaxed);
+            auto tail = ring->tail.load(std::memory_order_acquire);
+            auto offset = head & (LogQueue::ringSize - 1);
+            auto contiguous = LogQueue::ringSize - offset;
+            if (LogQueue::ringSize - (head - tail) < (size <= contiguous ? size : contiguous + size)) {
+                ring->dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            if (size > contiguous) {
+                reinterpret_cast<RecordHeader*>(ring->data + offset)->length = skipToStart;
+                head += contiguous;
+                offset = 0;
+            }
+            ring->reserved = head;
+            return ring->data + offset + sizeof(RecordHeader);
+        }
+
+        // Publishes the record reserve found room for
+        void commit(LoggerBuffer& buffer, LogQueue::Formatter formatter, std::size_t length) {
+            auto* ring = currentRing.ring;
+            auto head = ring->reserved;
+            auto* header = reinterpret_cast<RecordHeader*>(ring->data + (head & (LogQueue::ringSize - 1)));
+            header->length = static_cast<uint32_t>(length);
+            header->buffer = reinterpret_cast<uintptr_t>(&buffer);
+            header->formatter = formatter;
+            head += recordSize(length);
+            ring->head.store(head, std::memory_order_release);
+            if (head - ring->tail.load(std::memory_order_relaxed) > LogQueue::ringSize / 2) wake().notify_one();
+        }
+
+        // Set while a rotated file is being compressed, which must finish before the next rotation renames it
+        std::atomic_bool compressing = false;
+
+        void compress(const std::string& source, const std::string& target) {
+            int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+            // Fast rather than small, since this competes with the game for the CPU
+            auto out = in >= 0 ? gzopen(target.c_str(), "wb1") : nullptr;
+            bool ok = out != nullptr;
+            char chunk[64 * 1024];
+            while (ok) {
+                auto count = read(in, chunk, sizeof(chunk));
+                if (count < 0 && errno == EINTR) continue;
+                if (count <= 0) {
+                    ok = count == 0;
+                    break;
+                }
+                ok = gzwrite(out, chunk, static_cast<unsigned>(count)) == count;
+            }
+            if (out && gzclose(out) != Z_OK) ok = false;
+            if (in >= 0) close(in);
+            if (ok) {
+                unlink(source.c_str());
+            } else {
+                __android_log_print(Logging::ERROR, "QuestHook[Logging]", "Could not compress rotated log: %s! errno: %i", source.c_str(), errno);
+                unlink(target.c_str());
+                rename(source.c_str(), target.substr(0, target.size() - 3).c_str());
+            }
+        }
+
+        struct Batch {
+            LoggerBuffer* buffer;
+            std::vector<iovec> lines;
+        };
+    }
+
+    bool LogQueue::Push(LoggerBuffer& buffer, std::initializer_list<std::string_view> parts) noexcept {
+        std::size_t length = 0;
+        for (auto part : parts) length += part.size();
+        length = std::min(length, maxRecordSize);
+        Start();
+        auto* text = reserve(length);
+        if (!text) return false;
+        auto remaining = length;
+        for (auto part : parts) {
+            auto count = std::min(part.size(), remaining);
+            memcpy(text, part.data(), count);
+            text += count;
+            remaining -= count;
+        }
+        commit(buffer, nullptr, length);
+        return true;
+    }
+
+    char* LogQueue::Reserve(std::size_t size) noexcept {
+        Start();
+        return size <= maxRecordSize ? reserve(size) : nullptr;
+    }
+
+    void LogQueue::Commit(LoggerBuffer& buffer, Formatter formatter, std::size_t size) noexcept {
+        commit(buffer, formatter, size);
+    }
+
+    void LogQueue::Start() noexcept {
+        if (started.load(std::memory_order_relaxed) || started.exchange(true)) return;
+        __android_log_write(Logging::INFO, "QuestHook[Logging]", "Started log writer thread!");
+        std::thread([]() {
+            while (true) {
+                {
+                    std::scoped_lock lock(drainLock);
+                    Drain();
+                }
+                std::unique_lock lock(wakeLock);
+                // Woken early when a ring is getting full
+                wake().wait_for(lock, std::chrono::milliseconds(5));
+            }
+        }).detach();
+    }
+
+    void LogQueue::Flush() noexcept {
+        std::scoped_lock lock(drainLock);
+        Drain();
+    }
+
+    uint64_t LogQueue::Dropped() noexcept {
+        uint64_t dropped = droppedWithoutRing.load(std::memory_order_relaxed);
+        for (auto* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+            dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+    void LogQueue::Drain() noexcept {
+        // Kept between drains, so that draining does not allocate once warmed up.
+        // Never destroyed, since the writer thread may still be draining while the process exits.
+        static auto& batches = *new std::vector<Batch>();
+        static auto& consumed = *new std::vector<std::pair<Ring*, uint64_t>>();
+        static auto& dropNote = *new std::string();
+        // Output of deferred records. A deque, so that the strings never move while their lines are queued.
+        static auto& formatted = *new std::deque<std::string>();
+        std::size_t used = 0;
+        auto next = [&used]() -> std::string& {
+            if (used == formatted.size()) formatted.emplace_back();
+            auto& str = formatted[used++];
+            str.clear();
+            return str;
+        };
+        auto& global = get_global();
+        auto add = [](LoggerBuffer* buffer, iovec line) {
+            auto itr = std::find_if(batches.begin(), batches.end(), [buffer](const Batch& batch) { return batch.buffer == buffer; });
+            if (itr == batches.end()) itr = batches.insert(batches.end(), Batch{buffer, {}});
+            itr->lines.push_back(line);
+        };
+
+        uint64_t newlyDropped = 0;
+        for (auto* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+            auto tail = ring->tail.load(std::memory_order_relaxed);
+            auto head = ring->head.load(std::memory_order_acquire);
+            while (tail != head) {
+                auto offset = tail & (LogQueue::ringSize - 1);
+                auto* header = reinterpret_cast<RecordHeader*>(ring->data + offset);
+                if (header->length == skipToStart) {
+                    tail += LogQueue::ringSize - offset;
+                    continue;
+                }
+                auto* buffer = reinterpret_cast<LoggerBuffer*>(static_cast<uintptr_t>(header->buffer));
+                auto* data = ring->data + offset + sizeof(RecordHeader);
+                if (header->formatter) {
+                    auto& line = next();
+                    auto& raw = next();
+                    header->formatter(*buffer, std::span<const char>(data, header->length), line, raw);
+                    if (!raw.empty() && !buffer->closed) add(buffer, iovec{raw.data(), raw.size()});
+                    if (!line.empty() && !global.closed) add(&global, iovec{line.data(), line.size()});
+                } else {
+                    iovec line{data, header->length};
+                    if (!buffer->closed) add(buffer, line);
+                    if (!global.closed) add(&global, line);
+                }
+                tail += recordSize(header->length);
+            }
+            consumed.emplace_back(ring, tail);
+            auto dropped = ring->dropped.load(std::memory_order_relaxed);
+            newlyDropped += dropped - ring->reportedDropped;
+            ring->reportedDropped = dropped;
+        }
+        auto droppedNoRing = droppedWithoutRing.load(std::memory_order_relaxed);
+        newlyDropped += droppedNoRing - reportedWithoutRing;
+        reportedWithoutRing = droppedNoRing;
+        if (newlyDropped > 0 && !global.closed) {
+            dropNote = string_format("%llu log lines were dropped because they were logged faster than they could be written\n", static_cast<unsigned long long>(newlyDropped));
+            add(&global, iovec{dropNote.data(), dropNote.size()});
+        }
+
+        for (auto& batch : batches) {
+            if (batch.lines.empty()) continue;
+            Write(*batch.buffer, batch.lines.data(), batch.lines.size());
+            batch.lines.clear();
+        }
+        // Only now that the lines are written may producers overwrite them
+        for (auto& [ring, tail] : consumed) {
+            ring->tail.store(tail, std::memory_order_release);
+        }
+        consumed.clear();
+    }
+
+    void LogQueue::Write(LoggerBuffer& buffer, iovec* lines, std::size_t count) noexcept {
+        if (buffer.fd < 0) {
+            buffer.fd = open(buffer.path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+            struct stat st;
+            buffer.fileSize = buffer.fd >= 0 && fstat(buffer.fd, &st) == 0 ? st.st_size : 0;
+        }
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < count; i++) size += lines[i].iov_len;
+        if (buffer.fd < 0 || !writeAll(buffer.fd, lines, count)) {
+            __android_log_print(Logging::CRITICAL, "QuestHook[Logging]", "Could not write to file: %s! errno: %i", buffer.path.c_str(), errno);
+            return;
+        }
+        buffer.fileSize += size;
+        if (buffer.maxFileSize > 0 && buffer.fileSize >= buffer.maxFileSize) Rotate(buffer);
+    }
+
+    void LogQueue::Rotate(LoggerBuffer& buffer) noexcept {
+        close(buffer.fd);
+        buffer.fd = -1;
+        buffer.fileSize = 0;
+        // The next file is a new binary log, which needs its own header and formats
+        buffer.binaryFormats.clear();
+        auto& path = buffer.path;
+        if (buffer.maxFileCount <= 1) {
+            unlink(path.c_str());
+            return;
+        }
+        while (compressing.exchange(true, std::memory_order_acquire)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::string suffix = buffer.compressRotated ? ".gz" : "";
+        auto rotated = [&](uint32_t i) { return path + "." + std::to_string(i) + suffix; };
+        unlink(rotated(buffer.maxFileCount - 1).c_str());
+        for (auto i = buffer.maxFileCount - 1; i > 1; i--) {
+            rename(rotated(i - 1).c_str(), rotated(i).c_str());
+        }
+        auto pending = path + ".1";
+        if (rename(path.c_str(), pending.c_str()) != 0 || !buffer.compressRotated) {
+            compressing.store(false, std::memory_order_release);
+            return;
+        }
+        // Compressed in the background, so that the writer keeps draining meanwhile
+        std::thread([pending, target = rotated(1)]() {
+            compress(pending, target);
+            compressing.store(false, std::memory_order_release);
+        }).detach();
+    }
+
+    void LogQueue::Reopen(LoggerBuffer& buffer) noexcept {
+        std::scoped_lock lock(drainLock);
+        if (buffer.fd >= 0) close(buffer.fd);
+        buffer.fd = -1;
+        // A new binary log needs its own header and formats
+        buffer.binaryFormats.clear();
+    }
+
+    bool LogQueue::Reconfigure(LoggerBuffer& buffer, std::string path, const FileLimits& limits) noexcept {
+        std::scoped_lock lock(drainLock);
+        // Lines queued before this belong in the old file, written as they were queued (text or binary)
+        Drain();
+        if (buffer.fd >= 0) close(buffer.fd);
+        buffer.fd = -1;
+        buffer.fileSize = 0;
+        buffer.binaryFormats.clear();
+        buffer.path = std::move(path);
+        buffer.maxFileSize = limits.maxFileSize;
+        buffer.maxFileCount = limits.maxFileCount;
+        buffer.compressRotated = limits.compressRotated;
+        // A rotation of the old file may still be compressing into the files deleted here
+        while (compressing.exchange(true, std::memory_order_acquire)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        for (uint32_t i = 1; i < buffer.maxFileCount; i++) {
+            auto rotated = buffer.path + "." + std::to_string(i);
+            unlink(rotated.c_str());
+            unlink((rotated + ".gz").c_str());
+        }
+        compressing.store(false, std::memory_order_release);
+        buffer.fd = open(buffer.path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        return buffer.fd >= 0;
+    }
+}
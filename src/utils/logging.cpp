@@ -9,18 +9,17 @@
 #include <memory>
 #include "../../shared/utils/utils-functions.h"
 #include "../../shared/utils/utils.h"
+#include "../../shared/utils/binary-log.hpp"
 #include <fstream>
 #include <chrono>
+#include <cstring>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
 
 #ifndef VERSION
 #define VERSION "0.0.0"
 #endif
 
 std::list<LoggerBuffer*> Logger::buffers;
-bool Logger::consumerStarted = false;
 std::mutex Logger::bufferMutex;
 
 const char* get_level(Logging::Level level) {
@@ -43,12 +42,25 @@ const char* get_level(Logging::Level level) {
 
 bool createdGlobal = false;
 
+// Deletes the files rotated out of path by an earlier session
+static void delete_rotated(const std::string& path, uint32_t maxFileCount) {
+    for (uint32_t i = 1; i < maxFileCount; i++) {
+        auto rotated = path + "." + std::to_string(i);
+        for (auto& file : {rotated, rotated + ".gz"}) {
+            if (fileexists(file)) {
+                deletefile(file);
+            }
+        }
+    }
+}
+
 LoggerBuffer& get_global() {
     static LoggerBuffer g(ModInfo{"GlobalLog", VERSION});
     if (!createdGlobal) {
         if (fileexists(g.get_path())) {
             deletefile(g.get_path());
         }
+        delete_rotated(g.get_path(), g.maxFileCount);
         __android_log_print(Logging::INFO, "QuestHook[Logging]", "Created get_global() log at path: %s", g.get_path().c_str());
         createdGlobal = true;
     }
@@ -62,145 +74,78 @@ Logger& Logger::get() {
 }
 
 void LoggerBuffer::flush() {
-    if (length() == 0) {
-        // If we have nothing to write, exit early.
-        return;
-    }
-    // We can open the file without locking path, because it is only created on initialization.
-    std::ofstream file(path, std::ios::app);
-    if (!file.is_open()) {
-        __android_log_print(Logging::CRITICAL, Logger::get().tag.c_str(), "Could not open file: %s when flushing buffer!", path.c_str());
-    }
-    // Then, iterate over all messages and write each of them to the file.
-    // We already must hold the lock for this call.
-    // Assuming we always append to the END of the list, we could theoretically get away without locking on this call (except for length 1)
-    messageLock.lock();
-    for (; !messages.empty(); messages.pop_front()) {
-        file << messages.front().c_str() << '\n';
-    }
-    messageLock.unlock();
-    file.close();
-}
-
-std::size_t LoggerBuffer::length() {
-    if (closed) {
-        // Ignore messages to write if we are closed.
-        return 0;
-    }
-    return messages.size();
+    Logging::LogQueue::Flush();
 }
 
 void LoggerBuffer::addMessage(std::string_view msg) {
     if (closed) {
         return;
     }
-    messageLock.lock();
-    messages.emplace_back(msg.data());
-    messageLock.unlock();
+    Logging::LogQueue::Push(*this, {msg, "\n"});
 }
 
-// Now, we COULD be a lot more reasonable and spawn a thread for each buffer logger
-// However, I think having one should be fine.
-// Flushing while holding the bufferMutex means that new loggers take awhile to create (everything else must be flushed)
-// Flushing itself is pretty quick, new messages aren't allowed to be added while the writing is happening (I'm not sure HOW quick it is)
-class Consumer {
-    public:
-    void operator()() {
-        // Goal here is that we want to iterate over all of the buffers
-        // For each one, we flush our log to the file specified by the path of that buffer.
-        while (true) {
-            // Lock our bufferMutex
-            Logger::bufferMutex.lock();
-            for (auto* buffer : Logger::buffers) {
-                // For each buffer, we want to flush all of the messages.
-                // However, we want to do so in a fashion that isn't terribly unreasonable.
-                buffer->flush();
-                // Ideally, we thread_yield after each buffer flush (may not need to, though)
-                // std::this_thread::yield();
-            }
-            // Also do the get_global() buffer
-            get_global().flush();
-            Logger::bufferMutex.unlock();
-            // Sleep for a bit without the lock to allow other threads to create loggers and add them
-            std::this_thread::sleep_for(std::chrono::microseconds(500));
-        }
-    }
-};
-
 void Logger::flushAll() {
     __android_log_write(Logging::CRITICAL, Logger::get().tag.c_str(), "Flushing all buffers!");
-    Logger::bufferMutex.lock();
-    for (auto* buffer : Logger::buffers) {
-        buffer->flush();
-    }
-    get_global().flush();
-    Logger::bufferMutex.unlock();
+    Logging::LogQueue::Flush();
     __android_log_write(Logging::CRITICAL, Logger::get().tag.c_str(), "All buffers flushed!");
 }
 
 void Logger::closeAll() {
     __android_log_write(Logging::CRITICAL, Logger::get().tag.c_str(), "Closing all buffers!");
+    Logging::LogQueue::Flush();
     Logger::bufferMutex.lock();
     for (auto* buffer : Logger::buffers) {
-        buffer->flush();
         buffer->closed = true;
     }
-    get_global().flush();
     get_global().closed = true;
     Logger::bufferMutex.unlock();
     __android_log_write(Logging::CRITICAL, Logger::get().tag.c_str(), "All buffers closed!");
 }
 
+uint64_t Logger::droppedCount() {
+    return Logging::LogQueue::Dropped();
+}
+
 bool Logger::init() {
+    if (options.silent) {
+        levelMask.fetch_or(silentBit, std::memory_order_relaxed);
+    } else {
+        levelMask.fetch_and(~silentBit, std::memory_order_relaxed);
+    }
     // So, we want to take a look at our options.
     // If we have fileLog set to true, we want to clear the file pointed to by this log.
     // That means that we want to delete the existing file (because storing a bunch is pretty obnoxious)
     if (options.toFile) {
-        if (fileexists(buffer.get_path())) {
-            deletefile(buffer.get_path());
-        }
-        // Now, create the file and paths as necessary.
+        // Now, create the paths as necessary.
         if (!direxists(buffer.get_logDir())) {
             mkpath(buffer.get_logDir());
             __android_log_print(Logging::INFO, tag.c_str(), "Created logger buffer dir: %s", buffer.get_logDir().c_str());
         }
-        std::ofstream str(buffer.get_path());
-        if (!str.is_open()) {
-            __android_log_print(Logging::CRITICAL, tag.c_str(), "Could not open logger buffer file: %s!", buffer.get_path().c_str());
+        // The writer may still have the old file open, and lines for it queued
+        auto path = options.deferred ? buffer.get_binaryPath() : buffer.get_path();
+        if (!Logging::LogQueue::Reconfigure(buffer, path, {options.maxFileSize, options.maxFileCount, options.compressRotated})) {
+            __android_log_print(Logging::CRITICAL, tag.c_str(), "Could not open logger buffer file: %s!", path.c_str());
             return false;
-        } else {
-            str.close();
         }
     }
     return true;
 }
 
 void Logger::flush() {
-    // Flush our buffer.
-    // We do this by locking it and reading all of its messages to completion.
-    Logger::bufferMutex.lock();
-    buffer.flush();
-    get_global().flush();
-    Logger::bufferMutex.unlock();
+    // Lines are queued for all buffers together, so this writes out every buffer.
+    Logging::LogQueue::Flush();
 }
 
 void Logger::close() {
-    Logger::bufferMutex.lock();
-    buffer.flush();
-    get_global().flush();
+    Logging::LogQueue::Flush();
     buffer.closed = true;
-    Logger::bufferMutex.unlock();
-}
-
-void Logger::startConsumer() {
-    if (!Logger::consumerStarted) {
-        consumerStarted = true;
-        __android_log_write(Logging::INFO, Logger::get().tag.c_str(), "Started consumer thread!");
-        std::thread(Consumer()).detach();
-    }
 }
 
 LoggerContextObject Logger::WithContext(std::string_view context) {
+    if (!hasDisabledContexts.load(std::memory_order_acquire)) {
+        // Nothing to match against
+        return LoggerContextObject(*this, context, !options.silent);
+    }
     contextMutex.lock();
     for (auto item : disabledContexts) {
         if (context.starts_with(item)) {
@@ -215,6 +160,13 @@ LoggerContextObject Logger::WithContext(std::string_view context) {
 }
 
 LoggerContextObject Logger::WithContext(LoggerContextObject* parent, std::string_view context) {
+    if (!hasDisabledContexts.load(std::memory_order_acquire)) {
+        // Nothing to match against
+        if (parent) {
+            return LoggerContextObject(parent, parent->context + options.contextSeparator + context.data(), !options.silent);
+        }
+        return LoggerContextObject(*this, context, !options.silent);
+    }
     contextMutex.lock();
     for (auto item : disabledContexts) {
         if (context.starts_with(item)) {
@@ -257,6 +209,7 @@ void Logger::RecurseChangeContext(LoggerContextObject* ctx, std::string_view con
 void Logger::DisableContext(std::string_view context) {
     contextMutex.lock();
     disabledContexts.emplace(context.data());
+    hasDisabledContexts.store(true, std::memory_order_release);
     // We should also iterate over all disabledContexts and determine if any existing contexts need to be disabled.
     // Existing contexts could have parent contexts, though.
     for (auto* ctx : contexts) {
@@ -274,6 +227,7 @@ void Logger::EnableContext(std::string_view context) {
     if (itr != disabledContexts.end()) {
         disabledContexts.erase(itr);
     }
+    hasDisabledContexts.store(!disabledContexts.empty(), std::memory_order_release);
     for (auto* ctx : contexts) {
         // For each context, only check those without parents (top level, recurse down)
         if (ctx->parentContext == nullptr) {
@@ -287,11 +241,33 @@ const std::unordered_set<std::string> Logger::GetDisabledContexts() {
     return disabledContexts;
 }
 
-#define LOG_MAX_CHARS 1000
-void Logger::log(Logging::Level lvl, std::string str) {
-    if (options.silent) {
-        return;
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Writes the time ms (since the epoch) as "MM-DD HH:MM:SS.mmm " to out, returning the length.
+// The date and time are only formatted again when the second changes.
+static std::size_t format_time(char (&out)[20], int64_t ms) {
+    thread_local std::time_t cachedSecond = -1;
+    thread_local char cachedPrefix[16];
+    std::time_t second = ms / 1000;
+    if (second != cachedSecond) {
+        std::tm bt;
+        localtime_r(&second, &bt);
+        std::strftime(cachedPrefix, sizeof(cachedPrefix), "%m-%d %H:%M:%S.", &bt);
+        cachedSecond = second;
     }
+    std::memcpy(out, cachedPrefix, 15);
+    auto millis = static_cast<int>(ms % 1000);
+    out[15] = '0' + millis / 100;
+    out[16] = '0' + millis / 10 % 10;
+    out[17] = '0' + millis % 10;
+    out[18] = ' ';
+    return 19;
+}
+
+#define LOG_MAX_CHARS 1000
+static void write_logcat(Logging::Level lvl, const std::string& tag, const std::string& str) {
     // Chunk string for logcat buffer
     if (str.length() > LOG_MAX_CHARS) {
         std::size_t i = 0;
@@ -309,26 +285,102 @@ void Logger::log(Logging::Level lvl, std::string str) {
     } else {
         __android_log_write(lvl, tag.c_str(), str.c_str());
     }
+}
+
+void Logger::log(Logging::Level lvl, std::string str) {
+    if (!isEnabled(lvl)) {
+        return;
+    }
+    if (options.deferred) {
+        // Keeps the binary log in order with the lines logged through format strings
+        log_deferred(lvl, {}, "%s", str.c_str());
+        return;
+    }
+    write_logcat(lvl, tag, str);
     if (options.toFile) {
-        // If we want to log to file, we want to write to a shared buffer.
-        // This buffer should be consumed by a separate thread (started if we haven't yet started any consumer)
-        // The overhead of this thread should be pretty minimal, all things considered, even if it handles every Logger instance.
-        // The first thing we need to do is create our buffer, and add it to our buffers (lock while doing so)
-        // Then, we need to start our thread if we haven't started it already
-        // Then, we need to add our data to the buffer (lock while doing so)
-        // The thread needs to consume from these buffers (locks while doing so)
-        auto now = std::chrono::system_clock::now();
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-        auto in_time = std::chrono::system_clock::to_time_t(now);
-        std::tm bt = *std::localtime(&in_time);
-        std::ostringstream oss;
-        oss << std::put_time(&bt, "%m-%d %H:%M:%S.") << std::setfill('0') << std::setw(3) << ms.count();
-        auto msg = oss.str() + " " + get_level(lvl) + " " + tag + ": " + str.c_str();
-        // __android_log_print(Logging::DEBUG, tag.c_str(), "Logging message: %s to file!", msg.c_str());
-        Logger::bufferMutex.lock();
-        buffer.addMessage(msg);
-        get_global().addMessage(msg);
-        Logger::bufferMutex.unlock();
-        startConsumer();
+        // If we want to log to file, the line is queued in this thread's ring, without locking or allocating.
+        // A single writer thread (started by the first line) writes it to our file and the global log.
+        if (buffer.closed) {
+            return;
+        }
+        char time[20];
+        auto timeLength = format_time(time, now_ms());
+        Logging::LogQueue::Push(buffer, {std::string_view(time, timeLength), get_level(lvl), " ", tag, ": ", str, "\n"});
+    }
+}
+
+namespace {
+    // The start of a deferred record, which is followed by the context and the captured arguments
+    struct DeferredRecord {
+        Logger* logger;
+        const char* format;
+        int64_t ms;
+        uint32_t argsLength;
+        uint8_t level;
+        uint8_t contextLength;
+    };
+}
+
+void Logger::log_v(Logging::Level lvl, std::string_view context, const char* fmt, va_list lst) {
+    if (!options.deferred) {
+        log(lvl, context.empty() ? string_vformat(fmt, lst) : std::string(context) + string_vformat(fmt, lst));
+        return;
+    }
+    auto contextLength = std::min<std::size_t>(context.size(), UINT8_MAX);
+    auto argsLength = Logging::BinaryLog::ArgsSize(fmt, lst);
+    auto size = sizeof(DeferredRecord) + contextLength + argsLength;
+    if (size > Logging::LogQueue::maxRecordSize) {
+        // Too long to fit in the ring, so format it here and keep what fits
+        auto str = string_vformat(fmt, lst);
+        auto fits = Logging::LogQueue::maxRecordSize - sizeof(DeferredRecord) - contextLength - 2 * sizeof(uint64_t);
+        log_deferred(lvl, context, "%.*s", static_cast<int>(fits), str.c_str());
+        return;
+    }
+    auto* data = Logging::LogQueue::Reserve(size);
+    if (!data) {
+        return;
+    }
+    DeferredRecord record{this, fmt, now_ms(), static_cast<uint32_t>(argsLength), static_cast<uint8_t>(lvl), static_cast<uint8_t>(contextLength)};
+    std::memcpy(data, &record, sizeof(record));
+    if (contextLength > 0) {
+        std::memcpy(data + sizeof(record), context.data(), contextLength);
+    }
+    Logging::BinaryLog::CaptureArgs(fmt, lst, data + sizeof(record) + contextLength);
+    Logging::LogQueue::Commit(buffer, &Logger::format_deferred, size);
+}
+
+void Logger::log_deferred(Logging::Level lvl, std::string_view context, const char* fmt, ...) {
+    va_list lst;
+    va_start(lst, fmt);
+    log_v(lvl, context, fmt, lst);
+    va_end(lst);
+}
+
+void Logger::format_deferred(LoggerBuffer& buffer, std::span<const char> data, std::string& line, std::string& raw) {
+    DeferredRecord record;
+    std::memcpy(&record, data.data(), sizeof(record));
+    std::string_view context(data.data() + sizeof(record), record.contextLength);
+    std::span<const char> args(data.data() + sizeof(record) + record.contextLength, record.argsLength);
+    auto& logger = *record.logger;
+    auto lvl = static_cast<Logging::Level>(record.level);
+    // Only used while draining, which is never done by two threads at once
+    static auto& message = *new std::string();
+    message.assign(context);
+    Logging::BinaryLog::Format(record.format, args, message);
+    write_logcat(lvl, logger.tag, message);
+    if (!logger.options.toFile || buffer.closed) {
+        return;
+    }
+    char time[20];
+    auto timeLength = format_time(time, record.ms);
+    line.append(time, timeLength).append(get_level(lvl)).append(" ").append(logger.tag).append(": ").append(message).append("\n");
+    // The file only gets the raw record, along with the format the first time it is used
+    if (buffer.binaryFormats.empty()) {
+        Logging::BinaryLog::AppendHeader(raw, logger.tag);
+    }
+    auto id = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(record.format));
+    if (buffer.binaryFormats.insert(id).second) {
+        Logging::BinaryLog::AppendFormat(raw, id, record.format);
     }
+    Logging::BinaryLog::AppendRecord(raw, record.ms, record.level, id, context, args);
 }
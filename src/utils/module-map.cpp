@@ -0,0 +1,135 @@
+#include "../../shared/utils/module-map.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    std::mutex currentLock;
+    std::shared_ptr<const ModuleMap> current;
+
+    // Reads the whole file, which procfs generates as it is read (so it has no size to read up to)
+    std::string readMaps() {
+        std::string text;
+        auto* file = fopen("/proc/self/maps", "r");
+        if (!file) return text;
+        char buffer[16 * 1024];
+        std::size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            text.append(buffer, read);
+        }
+        fclose(file);
+        return text;
+    }
+
+    // Parses a hexadecimal number at the start of text, and skips it along with the separator after it
+    uintptr_t parseHex(std::string_view& text) {
+        uintptr_t value = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+        text.remove_prefix(std::min<std::size_t>(end - text.data() + 1, text.size()));
+        return value;
+    }
+
+    // Skips the next field and the spaces after it
+    void skipField(std::string_view& text) {
+        auto space = text.find(' ');
+        text.remove_prefix(space == std::string_view::npos ? text.size() : space);
+        auto field = text.find_first_not_of(' ');
+        text.remove_prefix(field == std::string_view::npos ? text.size() : field);
+    }
+}
+
+ModuleMap ModuleMap::Parse(std::string_view maps) {
+    ModuleMap map;
+    // The module of each path, since a library's segments are not always next to each other
+    std::unordered_map<std::string_view, std::size_t> modulesByPath;
+    while (!maps.empty()) {
+        auto lineEnd = maps.find('\n');
+        auto line = maps.substr(0, lineEnd);
+        maps.remove_prefix(lineEnd == std::string_view::npos ? maps.size() : lineEnd + 1);
+        // start-end perms offset dev inode path
+        if (line.empty()) continue;
+        Segment segment{};
+        segment.start = parseHex(line);
+        segment.end = parseHex(line);
+        if (line.size() < 4) continue;
+        segment.readable = line[0] == 'r';
+        segment.writable = line[1] == 'w';
+        segment.executable = line[2] == 'x';
+        skipField(line);
+        segment.offset = parseHex(line);
+        skipField(line);
+        skipField(line);
+        // Files always have an absolute path, anything else ([stack], [anon:...]) is not a module
+        segment.module = npos;
+        if (line.starts_with('/')) {
+            auto [entry, inserted] = modulesByPath.try_emplace(line, map.modules.size());
+            if (inserted) map.modules.push_back({std::string(line), segment.start, segment.end, map.segments.size(), map.segments.size()});
+            auto& module = map.modules[entry->second];
+            module.end = segment.end;
+            module.lastSegment = map.segments.size();
+            segment.module = entry->second;
+        }
+        map.segments.push_back(segment);
+    }
+    map.byName.resize(map.modules.size());
+    for (std::size_t i = 0; i < map.byName.size(); i++) {
+        map.byName[i] = i;
+    }
+    // Stable, so that of modules with the same name, the one at the lowest address comes first
+    std::stable_sort(map.byName.begin(), map.byName.end(), [&](std::size_t a, std::size_t b) {
+        return map.modules[a].Name() < map.modules[b].Name();
+    });
+    return map;
+}
+
+std::shared_ptr<const ModuleMap> ModuleMap::Get() {
+    std::lock_guard<std::mutex> lock(currentLock);
+    if (!current) current = std::make_shared<const ModuleMap>(Parse(readMaps()));
+    return current;
+}
+
+std::shared_ptr<const ModuleMap> ModuleMap::GetWithModule(std::string_view name) {
+    auto map = Get();
+    if (map->FindModule(name)) return map;
+    auto parsed = std::make_shared<const ModuleMap>(Parse(readMaps()));
+    std::lock_guard<std::mutex> lock(currentLock);
+    current = parsed;
+    return parsed;
+}
+
+void ModuleMap::Invalidate() noexcept {
+    // Freed after unlocking, unless something else still holds it
+    std::shared_ptr<const ModuleMap> old;
+    {
+        std::lock_guard<std::mutex> lock(currentLock);
+        old = std::move(current);
+    }
+}
+
+const ModuleMap::Segment* ModuleMap::FindSegment(uintptr_t address) const noexcept {
+    // The first segment that ends after address
+    auto segment = std::upper_bound(segments.begin(), segments.end(), address, [](uintptr_t address, const Segment& segment) {
+        return address < segment.end;
+    });
+    return segment != segments.end() && segment->Contains(address) ? &*segment : nullptr;
+}
+
+const ModuleMap::Module* ModuleMap::FindModule(uintptr_t address) const noexcept {
+    // By segment, since the segments of different modules can interleave
+    auto* segment = FindSegment(address);
+    return segment && segment->module != npos ? &modules[segment->module] : nullptr;
+}
+
+const ModuleMap::Module* ModuleMap::FindModule(std::string_view name) const noexcept {
+    auto slash = name.find_last_of('/');
+    auto fileName = slash == std::string_view::npos ? name : name.substr(slash + 1);
+    auto index = std::lower_bound(byName.begin(), byName.end(), fileName, [&](std::size_t index, std::string_view fileName) {
+        return modules[index].Name() < fileName;
+    });
+    for (; index != byName.end() && modules[*index].Name() == fileName; index++) {
+        if (slash == std::string_view::npos || modules[*index].path == name) return &modules[*index];
+    }
+    return nullptr;
+}
@@ -0,0 +1,351 @@
+#include "../../shared/utils/pattern-scanner.hpp"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <thread>
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define PATTERN_SCANNER_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PATTERN_SCANNER_SSE2
+#endif
+
+namespace {
+    constexpr std::size_t vectorSize = 16;
+    // Longer runs of fixed bytes hardly rule out more candidates, but make the automaton's tables slower to walk
+    constexpr std::size_t maxAnchorLength = 8;
+    // Set in the transitions into states where an anchor ends (the low byte of a transition is otherwise always 0)
+    constexpr uint32_t outputBit = 1;
+
+    int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 0xA;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 0xA;
+        return 0;
+    }
+
+    #if defined(PATTERN_SCANNER_NEON)
+    // Bits per byte in the mask of matching bytes, see matchMask
+    constexpr int laneBits = 4;
+
+    // The bytes that are set in eq (which are all ones or all zeros), as 4 bits each of a 64 bit mask
+    uint64_t matchMask(uint8x16_t eq) {
+        return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+    }
+
+    bool anySet(uint8x16_t v) {
+        #ifdef __aarch64__
+        return vmaxvq_u8(v) != 0;
+        #else
+        return vget_lane_u64(vreinterpret_u64_u8(vorr_u8(vget_low_u8(v), vget_high_u8(v))), 0) != 0;
+        #endif
+    }
+    #elif defined(PATTERN_SCANNER_SSE2)
+    constexpr int laneBits = 1;
+    #endif
+
+    #if defined(PATTERN_SCANNER_NEON) || defined(PATTERN_SCANNER_SSE2)
+    // The pairs of bytes anchors start with, as vectors of each byte
+    struct PairVectors {
+        #if defined(PATTERN_SCANNER_NEON)
+        using Vector = uint8x16_t;
+        #else
+        using Vector = __m128i;
+        #endif
+        Vector firsts[PatternSet::maxVectorPairs];
+        Vector seconds[PatternSet::maxVectorPairs];
+        std::size_t count = 0;
+
+        explicit PairVectors(const std::vector<uint16_t>& pairs) : count(pairs.size()) {
+            for (std::size_t i = 0; i < count; i++) {
+                #if defined(PATTERN_SCANNER_NEON)
+                firsts[i] = vdupq_n_u8(pairs[i] & 0xFF);
+                seconds[i] = vdupq_n_u8(pairs[i] >> 8);
+                #else
+                firsts[i] = _mm_set1_epi8(static_cast<char>(pairs[i] & 0xFF));
+                seconds[i] = _mm_set1_epi8(static_cast<char>(pairs[i] >> 8));
+                #endif
+            }
+        }
+
+        // Whether any pair starts at p to p + 15, which reads up to p[16]
+        bool AnyIn(const uint8_t* p) const noexcept {
+            #if defined(PATTERN_SCANNER_NEON)
+            auto first = vld1q_u8(p);
+            auto second = vld1q_u8(p + 1);
+            auto any = vdupq_n_u8(0);
+            for (std::size_t i = 0; i < count; i++) {
+                any = vorrq_u8(any, vandq_u8(vceqq_u8(first, firsts[i]), vceqq_u8(second, seconds[i])));
+            }
+            return anySet(any);
+            #else
+            auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            auto second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+            auto any = _mm_setzero_si128();
+            for (std::size_t i = 0; i < count; i++) {
+                any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi8(first, firsts[i]), _mm_cmpeq_epi8(second, seconds[i])));
+            }
+            return _mm_movemask_epi8(any) != 0;
+            #endif
+        }
+    };
+    #endif
+}
+
+CompiledPattern::CompiledPattern(std::string_view pattern) {
+    for (std::size_t i = 0; i < pattern.size();) {
+        if (pattern[i] == ' ') {
+            i++;
+            continue;
+        }
+        if (pattern[i] == '?') {
+            // ? and ?? both skip exactly one byte
+            bytes.push_back(0);
+            mask.push_back(0);
+            i += i + 1 < pattern.size() && pattern[i + 1] == '?' ? 2 : 1;
+            continue;
+        }
+        auto high = hexDigit(pattern[i]);
+        auto low = i + 1 < pattern.size() ? hexDigit(pattern[i + 1]) : 0;
+        if (!anyFixed) first = bytes.size();
+        last = bytes.size();
+        anyFixed = true;
+        bytes.push_back(static_cast<uint8_t>(high << 4 | low));
+        mask.push_back(0xFF);
+        i += 2;
+    }
+    length = bytes.size();
+    auto padded = (length + vectorSize - 1) / vectorSize * vectorSize;
+    bytes.resize(padded, 0);
+    mask.resize(padded, 0);
+}
+
+bool CompiledPattern::Matches(const uint8_t* p) const noexcept {
+    std::size_t i = 0;
+    #if defined(PATTERN_SCANNER_NEON)
+    for (; i + vectorSize <= length; i += vectorSize) {
+        auto diff = vandq_u8(veorq_u8(vld1q_u8(p + i), vld1q_u8(bytes.data() + i)), vld1q_u8(mask.data() + i));
+        if (anySet(diff)) return false;
+    }
+    #elif defined(PATTERN_SCANNER_SSE2)
+    for (; i + vectorSize <= length; i += vectorSize) {
+        auto diff = _mm_and_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes.data() + i))),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask.data() + i)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF) return false;
+    }
+    #endif
+    // The rest (all of it without vectors) a byte at a time, since p may end right after the pattern
+    for (; i < length; i++) {
+        if ((p[i] ^ bytes[i]) & mask[i]) return false;
+    }
+    return true;
+}
+
+const uint8_t* CompiledPattern::Find(const uint8_t* begin, const uint8_t* end) const noexcept {
+    if (begin >= end || static_cast<std::size_t>(end - begin) < length) return nullptr;
+    // The last address the whole pattern fits at
+    auto* lastStart = end - length;
+    if (!anyFixed) return begin;
+    auto firstByte = bytes[first];
+    auto lastByte = bytes[last];
+    auto* candidate = begin;
+    #if defined(PATTERN_SCANNER_NEON) || defined(PATTERN_SCANNER_SSE2)
+    // 16 candidates at a time, whose first and last fixed bytes are both within the range
+    #if defined(PATTERN_SCANNER_NEON)
+    auto firstVector = vdupq_n_u8(firstByte);
+    auto lastVector = vdupq_n_u8(lastByte);
+    #else
+    auto firstVector = _mm_set1_epi8(static_cast<char>(firstByte));
+    auto lastVector = _mm_set1_epi8(static_cast<char>(lastByte));
+    #endif
+    for (; lastStart - candidate >= static_cast<std::ptrdiff_t>(vectorSize); candidate += vectorSize) {
+        #if defined(PATTERN_SCANNER_NEON)
+        auto eq = vandq_u8(vceqq_u8(vld1q_u8(candidate + first), firstVector), vceqq_u8(vld1q_u8(candidate + last), lastVector));
+        uint64_t bits = matchMask(eq);
+        #else
+        auto eq = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(candidate + first)), firstVector),
+                                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(candidate + last)), lastVector));
+        uint64_t bits = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+        #endif
+        while (bits) {
+            auto index = __builtin_ctzll(bits) / laneBits;
+            if (Matches(candidate + index)) return candidate + index;
+            bits &= ~(((uint64_t(1) << laneBits) - 1) << (index * laneBits));
+        }
+    }
+    #endif
+    // What is left (all of it without vectors), finding the first fixed byte with memchr
+    while (candidate <= lastStart) {
+        auto* found = static_cast<const uint8_t*>(memchr(candidate + first, firstByte, lastStart - candidate + 1));
+        if (!found) return nullptr;
+        candidate = found - first;
+        if (candidate[last] == lastByte && Matches(candidate)) return candidate;
+        candidate++;
+    }
+    return nullptr;
+}
+
+PatternSet::PatternSet(std::vector<CompiledPattern> patterns) : patterns(std::move(patterns)), startPairs(65536 / 64) {
+    // The trie of every anchor, as child states per byte (0 for none, since nothing goes back to the root)
+    std::vector<std::vector<uint32_t>> children(1, std::vector<uint32_t>(256));
+    std::vector<std::vector<uint32_t>> ends(1);
+    bool singleByteAnchor = false;
+    for (uint32_t index = 0; index < this->patterns.size(); index++) {
+        auto& pattern = this->patterns[index];
+        longest = std::max(longest, pattern.length);
+        // The longest run of fixed bytes
+        std::pair<std::size_t, std::size_t> anchor{0, 0};
+        for (std::size_t i = 0; i < pattern.length;) {
+            if (!pattern.mask[i]) {
+                i++;
+                continue;
+            }
+            auto runEnd = i;
+            while (runEnd < pattern.length && pattern.mask[runEnd]) runEnd++;
+            if (runEnd - i > anchor.second) anchor = {i, std::min(runEnd - i, maxAnchorLength)};
+            i = runEnd;
+        }
+        anchors.push_back(anchor);
+        if (!anchor.second) {
+            unanchored.push_back(index);
+            continue;
+        }
+        auto firstByte = pattern.bytes[anchor.first];
+        if (anchor.second > 1) {
+            uint16_t pair = firstByte | pattern.bytes[anchor.first + 1] << 8;
+            startPairs[pair / 64] |= uint64_t(1) << pair % 64;
+            if (std::find(vectorPairs.begin(), vectorPairs.end(), pair) == vectorPairs.end()) vectorPairs.push_back(pair);
+        } else {
+            singleByteAnchor = true;
+            // Followed by anything
+            for (int next = 0; next < 256; next++) {
+                auto pair = firstByte | next << 8;
+                startPairs[pair / 64] |= uint64_t(1) << pair % 64;
+            }
+        }
+        uint32_t state = 0;
+        for (auto i = anchor.first; i < anchor.first + anchor.second; i++) {
+            auto& child = children[state][pattern.bytes[i]];
+            if (!child) {
+                child = children.size();
+                children.emplace_back(256);
+                ends.emplace_back();
+            }
+            state = children[state][pattern.bytes[i]];
+        }
+        ends[state].push_back(index);
+    }
+
+    // Breadth first, so that every state's failure state (the longest proper suffix in the trie) is complete before its children's
+    transitions.assign(children.size() * 256, 0);
+    std::vector<uint32_t> failures(children.size());
+    std::deque<uint32_t> queue;
+    for (int byte = 0; byte < 256; byte++) {
+        if (auto child = children[0][byte]) {
+            transitions[byte] = child * 256;
+            queue.push_back(child);
+        }
+    }
+    while (!queue.empty()) {
+        auto state = queue.front();
+        queue.pop_front();
+        auto failure = failures[state];
+        ends[state].insert(ends[state].end(), ends[failure].begin(), ends[failure].end());
+        for (int byte = 0; byte < 256; byte++) {
+            auto fallback = transitions[failure * 256 + byte];
+            if (auto child = children[state][byte]) {
+                failures[child] = fallback / 256;
+                transitions[state * 256 + byte] = child * 256;
+                queue.push_back(child);
+            } else {
+                transitions[state * 256 + byte] = fallback;
+            }
+        }
+    }
+    if (singleByteAnchor || vectorPairs.size() > maxVectorPairs) vectorPairs.clear();
+    // Marks the transitions into states that end an anchor, so that scanning only looks the outputs up for those
+    for (auto& transition : transitions) {
+        if (!ends[transition / 256].empty()) transition |= outputBit;
+    }
+    for (auto& stateEnds : ends) {
+        outputStarts.push_back(outputs.size());
+        outputs.insert(outputs.end(), stateEnds.begin(), stateEnds.end());
+    }
+    outputStarts.push_back(outputs.size());
+}
+
+void PatternSet::Scan(const uint8_t* from, const uint8_t* to, const uint8_t* end, std::vector<std::vector<uintptr_t>>& matches) const {
+    for (auto index : unanchored) {
+        for (auto* p = from; p < to && static_cast<std::size_t>(end - p) >= patterns[index].length; p++) {
+            matches[index].push_back(reinterpret_cast<uintptr_t>(p));
+        }
+    }
+    if (outputs.empty()) return;
+    // A match starting before to has its anchor end before to + longest
+    auto* stop = static_cast<std::size_t>(end - to) > longest ? to + longest : end;
+    #if defined(PATTERN_SCANNER_NEON) || defined(PATTERN_SCANNER_SSE2)
+    PairVectors pairVectors(vectorPairs);
+    #endif
+    uint32_t state = 0;
+    for (auto* p = from; p < stop; p++) {
+        if (!state) {
+            // Nothing is partially matched, so skip (without walking the automaton) to the next place an anchor could start
+            #if defined(PATTERN_SCANNER_NEON) || defined(PATTERN_SCANNER_SSE2)
+            if (pairVectors.count) {
+                while (stop - p > static_cast<std::ptrdiff_t>(vectorSize) && !pairVectors.AnyIn(p)) p += vectorSize;
+            }
+            #endif
+            while (p + 1 < stop && !CouldStartAnchor(p)) p++;
+        }
+        state = transitions[(state & ~outputBit) + *p];
+        if (!(state & outputBit)) [[likely]] continue;
+        auto id = state / 256;
+        for (auto output = outputStarts[id]; output < outputStarts[id + 1]; output++) {
+            auto index = outputs[output];
+            auto& pattern = patterns[index];
+            auto [offset, anchorLength] = anchors[index];
+            // The anchor ends at p
+            auto anchorStart = static_cast<std::size_t>(p - from) + 1 - anchorLength;
+            if (anchorStart < offset) continue;
+            auto* start = from + (anchorStart - offset);
+            if (start >= to || static_cast<std::size_t>(end - start) < pattern.length) continue;
+            if (pattern.Matches(start)) matches[index].push_back(reinterpret_cast<uintptr_t>(start));
+        }
+    }
+}
+
+std::vector<std::vector<uintptr_t>> PatternSet::FindAll(uintptr_t start, std::size_t range, unsigned threads) const {
+    // Below this much memory per thread, starting threads costs more than they save
+    static constexpr std::size_t minChunkSize = 1 << 20;
+    auto* begin = reinterpret_cast<const uint8_t*>(start);
+    auto* end = begin + range;
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t chunks = std::clamp<std::size_t>(range / minChunkSize, 1, threads);
+    auto chunkSize = (range + chunks - 1) / chunks;
+
+    // Every chunk has its own matches, which are already in order
+    std::vector<std::vector<std::vector<uintptr_t>>> chunkMatches(chunks, std::vector<std::vector<uintptr_t>>(patterns.size()));
+    auto scanChunk = [&](std::size_t chunk) {
+        auto* from = begin + std::min(range, chunk * chunkSize);
+        auto* to = begin + std::min(range, (chunk + 1) * chunkSize);
+        Scan(from, to, end, chunkMatches[chunk]);
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t chunk = 1; chunk < chunks; chunk++) {
+        workers.emplace_back(scanChunk, chunk);
+    }
+    scanChunk(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    auto matches = std::move(chunkMatches[0]);
+    for (std::size_t chunk = 1; chunk < chunks; chunk++) {
+        for (std::size_t index = 0; index < patterns.size(); index++) {
+            matches[index].insert(matches[index].end(), chunkMatches[chunk][index].begin(), chunkMatches[chunk][index].end());
+        }
+    }
+    return matches;
+}
@@ -0,0 +1,174 @@
+#include "../../shared/utils/resolution-cache.hpp"
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Bump this whenever the layout of Header or Entry changes
+#define RESOLUTION_CACHE_VERSION 1
+
+struct ResolutionCacheFile::Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t fingerprint;
+    uint32_t capacity;
+    uint32_t count;
+    // Followed by Entry[capacity]
+};
+
+struct ResolutionCacheFile::Entry {
+    // 0 is an empty slot, keys are never 0
+    uint64_t key;
+    Value value;
+};
+
+static constexpr char cacheMagic[4] = {'B', 'S', 'R', 'C'};
+
+static inline uint64_t fixKey(uint64_t key) {
+    return key ? key : 1;
+}
+
+const ResolutionCacheFile::Entry* ResolutionCacheFile::EntriesOf(const Header* header) noexcept {
+    return reinterpret_cast<const Entry*>(header + 1);
+}
+
+ResolutionCacheFile::~ResolutionCacheFile() {
+    if (mapped) {
+        munmap(const_cast<Header*>(mapped), mappedSize);
+    }
+}
+
+const ResolutionCacheFile::Header* ResolutionCacheFile::Map(const std::string& path, uint64_t fingerprint, std::size_t& mappedSize) noexcept {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return nullptr;
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after closing the fd (and after the file is renamed over)
+    close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+    auto* header = static_cast<const Header*>(addr);
+    bool valid = std::memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) == 0
+        && header->version == RESOLUTION_CACHE_VERSION
+        && header->fingerprint == fingerprint
+        && header->capacity != 0 && (header->capacity & (header->capacity - 1)) == 0
+        && size == sizeof(Header) + static_cast<std::size_t>(header->capacity) * sizeof(Entry);
+    if (!valid) {
+        munmap(addr, size);
+        return nullptr;
+    }
+    mappedSize = size;
+    return header;
+}
+
+bool ResolutionCacheFile::Open(std::string_view path_, uint64_t fingerprint_) noexcept {
+    path = path_;
+    fingerprint = fingerprint_;
+    mapped = Map(path, fingerprint, mappedSize);
+    return mapped != nullptr;
+}
+
+std::optional<ResolutionCacheFile::Value> ResolutionCacheFile::FindIn(const Header* header, uint64_t key) noexcept {
+    auto* entries = EntriesOf(header);
+    auto mask = header->capacity - 1;
+    for (auto i = key & mask;; i = (i + 1) & mask) {
+        auto& entry = entries[i];
+        if (entry.key == key) return entry.value;
+        if (entry.key == 0) return std::nullopt;
+    }
+}
+
+std::optional<ResolutionCacheFile::Value> ResolutionCacheFile::Find(uint64_t key) const noexcept {
+    key = fixKey(key);
+    if (mapped) {
+        if (auto res = FindIn(mapped, key)) return res;
+    }
+    std::scoped_lock lock(pendingLock);
+    auto itr = pending.find(key);
+    if (itr != pending.end()) return itr->second;
+    return std::nullopt;
+}
+
+void ResolutionCacheFile::Record(uint64_t key, Value value) noexcept {
+    key = fixKey(key);
+    std::scoped_lock lock(pendingLock);
+    pending.insert_or_assign(key, value);
+}
+
+bool ResolutionCacheFile::Flush() noexcept {
+    std::scoped_lock lock(pendingLock);
+    if (pending.empty() || path.empty()) return true;
+
+    // Someone else (another copy of this library) may have flushed since we opened, keep their entries too.
+    std::size_t otherSize = 0;
+    auto* other = Map(path, fingerprint, otherSize);
+    std::vector<Entry> all;
+    all.reserve(pending.size() + (mapped ? mapped->count : 0) + (other ? other->count : 0));
+    for (auto& [key, value] : pending) {
+        all.push_back({key, value});
+    }
+    for (auto* header : {mapped, other}) {
+        if (!header) continue;
+        auto* entries = EntriesOf(header);
+        for (uint32_t i = 0; i < header->capacity; i++) {
+            if (entries[i].key) all.push_back(entries[i]);
+        }
+    }
+    if (other) munmap(const_cast<Header*>(other), otherSize);
+
+    // Keep the load factor at or below 0.5
+    uint32_t capacity = 16;
+    while (capacity < all.size() * 2) capacity <<= 1;
+    std::vector<Entry> table(capacity, Entry{0, {0, 0}});
+    uint32_t count = 0;
+    // pending entries come first, so they win over stale duplicates from either file
+    for (auto& entry : all) {
+        for (auto i = entry.key & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+            if (table[i].key == entry.key) break;
+            if (table[i].key == 0) {
+                table[i] = entry;
+                count++;
+                break;
+            }
+        }
+    }
+
+    Header header;
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = RESOLUTION_CACHE_VERSION;
+    header.fingerprint = fingerprint;
+    header.capacity = capacity;
+    header.count = count;
+
+    auto tmpPath = path + ".tmp" + std::to_string(getpid());
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+    auto tableBytes = static_cast<ssize_t>(table.size() * sizeof(Entry));
+    ok = ok && write(fd, table.data(), tableBytes) == tableBytes;
+    ok = (close(fd) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    pending.clear();
+    // Our old mapping is still valid (it refers to the old, now unlinked file), so entries we just wrote but were
+    // not pending remain reachable through it. Pending entries are found again on the next launch.
+    return true;
+}
+
+std::size_t ResolutionCacheFile::MappedCount() const noexcept {
+    return mapped ? mapped->count : 0;
+}
+
+std::size_t ResolutionCacheFile::PendingCount() const noexcept {
+    std::scoped_lock lock(pendingLock);
+    return pending.size();
+}
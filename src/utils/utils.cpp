@@ -1,5 +1,7 @@
 // thx https://github.com/jbro129/Unity-Substrate-Hook-Android
 #include "../../shared/utils/utils.h"
+#include "../../shared/utils/module-map.hpp"
+#include "../../shared/utils/pattern-scanner.hpp"
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -111,7 +113,7 @@ uintptr_t getLibil2cppSize() {
         if (!stat(Modloader::getLibIl2CppPath().c_str(), &st)) {
             soSize = st.st_size;
         }
-        contextLogger.debug("libil2cpp.so size: 0x%lx", soSize);
+        BS_LOG_DEBUG(contextLogger, "libil2cpp.so size: 0x%lx", soSize);
     }
     return soSize;
 }
@@ -139,45 +141,10 @@ uintptr_t baseAddr(const char *soname)  // credits to https://github.com/ikoz/An
     if (imagehandle == NULL)
         return (uintptr_t)NULL;
 
-    FILE *f = NULL;
-    char line[200] = {0};
-    char *state = NULL;
-    char *tok = NULL;
-    char * baseAddr = NULL;
-    if ((f = fopen("/proc/self/maps", "r")) == NULL)
-        return (uintptr_t)NULL;
-    while (fgets(line, 199, f) != NULL)
-    {
-        tok = strtok_r(line, "-", &state);
-        baseAddr = tok;
-        tok = strtok_r(NULL, "\t ", &state);
-        tok = strtok_r(NULL, "\t ", &state); // "r-xp" field
-        tok = strtok_r(NULL, "\t ", &state); // "0000000" field
-        tok = strtok_r(NULL, "\t ", &state); // "01:02" field
-        tok = strtok_r(NULL, "\t ", &state); // "133224" field
-        tok = strtok_r(NULL, "\t ", &state); // path field
-
-        if (tok != NULL) {
-            int i;
-            for (i = (int)strlen(tok)-1; i >= 0; --i) {
-                if (!(tok[i] == ' ' || tok[i] == '\r' || tok[i] == '\n' || tok[i] == '\t'))
-                    break;
-                tok[i] = 0;
-            }
-            {
-                size_t toklen = strlen(tok);
-                size_t solen = strlen(soname);
-                if (toklen > 0) {
-                    if (toklen >= solen && strcmp(tok + (toklen - solen), soname) == 0) {
-                        fclose(f);
-                        return (uintptr_t)strtoll(baseAddr,NULL,16);
-                    }
-                }
-            }
-        }
-    }
-    fclose(f);
-    return (uintptr_t)NULL;
+    // dlopen may have just loaded it, in which case the cached map is parsed again
+    auto map = ModuleMap::GetWithModule(soname);
+    auto* module = map->FindModule(soname);
+    return module ? module->base : (uintptr_t)NULL;
 }
 
 uintptr_t location; // save lib.so base address so we do not have to recalculate every time causing lag.
@@ -199,67 +166,23 @@ int mkpath(std::string_view file_path) {
 }
 
 uintptr_t findPattern(uintptr_t dwAddress, const char* pattern, uintptr_t dwSearchRangeLen) {
-    #define in_range(x, a, b) (x >= a && x <= b)
-    #define get_bits(x) (in_range((x & (~0x20)), 'A', 'F') ? ((x & (~0x20)) - 'A' + 0xA): (in_range(x, '0', '9') ? x - '0': 0))
-    #define get_byte(x) (get_bits(x[0]) << 4 | get_bits(x[1]))
-
-    // To avoid a lot of bad match candidates, pre-process wildcards at the front of the pattern
-    uintptr_t skippedStartBytes = 0;
-    while(pattern[0] == '\?') {
-        // see comments below for insight on these numbers
-        pattern += (pattern[1] == '\?') ? 3 : 2;
-        skippedStartBytes++;
-    }
-    uintptr_t match = 0;  // current match candidate
-    uintptr_t len = strlen(CRASH_UNLESS(pattern));
-    if (dwSearchRangeLen < len) {
-        return 0;
-    }
-    const char* pat = pattern;  // current spot in the pattern
-
-    for (uintptr_t pCur = dwAddress + skippedStartBytes; pCur < dwAddress + dwSearchRangeLen; pCur++) {
-        // If pat[0] is null char, we are done, or if pat >= pattern + len
-        if (pat >= pattern + len || !pat[0] || !pat[1]) {
-            return match;
-        }
-        // For each byte, if the pattern starts with a ? or the current byte matches:
-        if (pat[0] == '\?' || *(char *)pCur == get_byte(pat)) {
-            // If we do not have a match, begin it
-            if (!match) {
-                match = pCur - skippedStartBytes;
-            }
-            // If our next character is at the end of our pattern, we have a match
-            if (pat + 1 >= pattern + len) {
-                return match;
-            }
-            if (pat[0] != '\?' || pat[1] == '\?') {
-                pat += 3;  // advance past "xy " or "?? "
-            } else {
-                pat += 2;  // advance past "? "
-            }
-        }
-        else {
-            // reset search position to beginning of the failed match; for loop will begin new search at match + 1
-            if (match) pCur = match + skippedStartBytes;
-            pat = pattern;
-            match = 0;
-        }
-    }
-    return 0;
+    return CompiledPattern(CRASH_UNLESS(pattern)).Find(dwAddress, dwSearchRangeLen);
 }
 
 uintptr_t findUniquePattern(bool& multiple, uintptr_t dwAddress, const char* pattern, const char* label, uintptr_t dwSearchRangeLen) {
-    uintptr_t firstMatchAddr = 0, newMatchAddr, start = dwAddress, dwEnd = dwAddress + dwSearchRangeLen;
+    uintptr_t firstMatchAddr = 0;
     int matches = 0;
-    Logger::get().debug("Sigscan for pattern: %s", pattern);
-    while (start > 0 && start < dwEnd && (newMatchAddr = findPattern(start, pattern, dwEnd - start))) {
+    static auto logger = Logger::get().WithContext("findUniquePattern");
+    BS_LOG_DEBUG(logger, "Sigscan for pattern: %s", pattern);
+    // Parsed once for every candidate
+    CompiledPattern compiled(CRASH_UNLESS(pattern));
+    compiled.ForEach(dwAddress, dwSearchRangeLen, [&](uintptr_t newMatchAddr) {
         if (!firstMatchAddr) firstMatchAddr = newMatchAddr;
         matches++;
-        if (label) Logger::get().debug("Sigscan found possible \"%s\": offset 0x%lX, pointer 0x%lX", label, newMatchAddr - dwAddress, newMatchAddr);
-        start = newMatchAddr + 1;
-        Logger::get().debug("start = 0x%lX, end = 0x%lX", start, dwEnd);
-        usleep(1000);
-    }
+        // Loose patterns can match thousands of times
+        if (label) BS_LOG_PER_SECOND(logger, Logging::DEBUG, 20, "Sigscan found possible \"%s\": offset 0x%lX, pointer 0x%lX", label, newMatchAddr - dwAddress, newMatchAddr);
+        return true;
+    });
     if (matches > 1) {
         multiple = true;
         Logger::get().warning("Multiple sig scan matches for \"%s\"!", label);
@@ -267,34 +190,65 @@ uintptr_t findUniquePattern(bool& multiple, uintptr_t dwAddress, const char* pat
     return firstMatchAddr;
 }
 
+// The readable mappings of libil2cpp.so, as [start, end) pairs
+static std::vector<std::pair<uintptr_t, uintptr_t>> libil2cppSegments() {
+    std::vector<std::pair<uintptr_t, uintptr_t>> segments;
+    auto map = ModuleMap::GetWithModule("libil2cpp.so");
+    auto* module = map->FindModule("libil2cpp.so");
+    if (!module) return segments;
+    for (auto& segment : map->Segments(*module)) {
+        if (segment.readable && segment.module == static_cast<std::size_t>(module - map->Modules().data())) {
+            segments.emplace_back(segment.start, segment.end);
+        }
+    }
+    return segments;
+}
+
 uintptr_t findUniquePatternInLibil2cpp(bool& multiple, const char* pattern, const char* label) {
-    // Essentially call findUniquePattern for each segment listed in /proc/self/maps
-    std::ifstream procMap("/proc/self/maps");
-    std::string line;
+    // Essentially call findUniquePattern for each readable segment of libil2cpp.so
     uintptr_t match = 0;
-    while (std::getline(procMap, line)) {
-        if (line.find("libil2cpp.so") == std::string::npos) {
-            continue;
-        }
-        auto idx = line.find_first_of('-');
-        if (idx == std::string::npos) {
-            CRASH_UNLESS(false);
+    for (auto [startAddr, endAddr] : libil2cppSegments()) {
+        // Search between start and end, keeping the first match of any segment
+        if (auto found = findUniquePattern(multiple, startAddr, pattern, label, endAddr - startAddr)) {
+            if (match) {
+                multiple = true;
+            } else {
+                match = found;
+            }
         }
-        auto startAddr = std::stoul(line.substr(0, idx), nullptr, 16);
-        auto spaceIdx = line.find_first_of(' ');
-        if (spaceIdx == std::string::npos) {
-            CRASH_UNLESS(false);
+    }
+    return match;
+}
+
+std::vector<uintptr_t> findUniquePatternsInLibil2cpp(std::vector<bool>& multiple, std::span<const char* const> patterns, std::span<const char* const> labels) {
+    static auto logger = Logger::get().WithContext("findUniquePatternsInLibil2cpp");
+    std::vector<CompiledPattern> compiled;
+    for (auto* pattern : patterns) {
+        BS_LOG_DEBUG(logger, "Sigscan for pattern: %s", pattern);
+        compiled.emplace_back(CRASH_UNLESS(pattern));
+    }
+    PatternSet set(std::move(compiled));
+    std::vector<uintptr_t> firstMatches(patterns.size());
+    std::vector<int> matchCounts(patterns.size());
+    multiple.assign(patterns.size(), false);
+    for (auto [startAddr, endAddr] : libil2cppSegments()) {
+        auto matches = set.FindAll(startAddr, endAddr - startAddr);
+        for (std::size_t i = 0; i < patterns.size(); i++) {
+            auto* label = i < labels.size() ? labels[i] : nullptr;
+            for (auto match : matches[i]) {
+                if (!firstMatches[i]) firstMatches[i] = match;
+                matchCounts[i]++;
+                if (label) BS_LOG_PER_SECOND(logger, Logging::DEBUG, 20, "Sigscan found possible \"%s\": offset 0x%lX, pointer 0x%lX", label, match - startAddr, match);
+            }
         }
-        auto endAddr = std::stoul(line.substr(idx + 1, spaceIdx - idx - 1), nullptr, 16);
-        // Permissions are 4 characters
-        auto perms = line.substr(spaceIdx + 1, 4);
-        if (perms.find('r') != std::string::npos) {
-            // Search between start and end
-            match = findUniquePattern(multiple, startAddr, pattern, label, endAddr - startAddr);
+    }
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+        if (matchCounts[i] > 1) {
+            multiple[i] = true;
+            Logger::get().warning("Multiple sig scan matches for \"%s\"!", i < labels.size() ? labels[i] : nullptr);
         }
     }
-    procMap.close();
-    return match;
+    return firstMatches;
 }
 
 // C# SPECIFIC
@@ -338,11 +292,11 @@ std::u16string_view csstrtostr(Il2CppString* in)
 
 // Thanks DaNike!
 void dump(int before, int after, void* ptr) {
-    Logger::get().debug("Dumping Immediate Pointer: %p: %08x", ptr, *reinterpret_cast<int*>(ptr));
+    BS_LOG_DEBUG(Logger::get(), "Dumping Immediate Pointer: %p: %08x", ptr, *reinterpret_cast<int*>(ptr));
     auto begin = static_cast<int*>(ptr) - before;
     auto end = static_cast<int*>(ptr) + after;
     for (auto cur = begin; cur != end; ++cur) {
-        Logger::get().debug("%p: %08x", cur, *cur);
+        BS_LOG_DEBUG(Logger::get(), "%p: %08x", cur, *cur);
     }
 }
 
@@ -0,0 +1,31 @@
+// Turns the binary log of a deferred logger (see LoggerOptions::deferred) into the text log it stands for.
+// Built for the host, not the headset:
+//   c++ -std=c++20 -I shared tools/decode-binlog.cpp src/utils/binary-log.cpp -o decode-binlog
+//   adb pull /sdcard/Android/data/<app>/files/logs/<mod>_<version>.binlog
+//   ./decode-binlog <mod>_<version>.binlog [output.log]
+// Rotated binary logs (<mod>_<version>.binlog.1.gz and up) are standalone, once decompressed with gunzip.
+#include "utils/binary-log.hpp"
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s <input.binlog> [output.log]\n", argv[0]);
+        return 2;
+    }
+    auto* in = fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+    auto* out = argc == 3 ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        perror(argv[2]);
+        fclose(in);
+        return 1;
+    }
+    bool ok = Logging::BinaryLog::Decode(in, out);
+    if (!ok) fprintf(stderr, "%s is not a binary log, or is truncated\n", argv[1]);
+    fclose(in);
+    if (out != stdout) fclose(out);
+    return ok ? 0 : 1;
+}